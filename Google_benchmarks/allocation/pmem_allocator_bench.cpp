@@ -0,0 +1,154 @@
+#include "benchmark/benchmark.h"
+#include "../common/bench_utils.h"
+#include "../../Google_tests/common/test_utils.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/allocation/pmem_allocator.h"
+#include "../../code/allocation/heap_collector.h"
+#include "../../code/common/constants_and_types.h"
+#include <memory>
+#include <deque>
+#include <unordered_set>
+
+namespace
+{
+    /*
+     * Heap and allocator are shared by all threads of the benchmark. They are created and destroyed by
+     * the first thread outside of the measured loop, beginning and end of which are barriers for all threads.
+     */
+    std::unique_ptr<temp_file> heap_file;
+    std::unique_ptr<persistent_memory_holder> heap;
+    std::unique_ptr<pmem_allocator> allocator;
+
+    void init_allocator(benchmark::State const& state)
+    {
+        if (state.thread_index() != 0)
+        {
+            return;
+        }
+        const uint32_t block_size = state.range(0);
+        heap_file = std::make_unique<temp_file>(get_temp_file_name("bench_heap"));
+        heap = std::make_unique<persistent_memory_holder>(heap_file->file_name, false, PMEM_HEAP_SIZE);
+        allocator = std::make_unique<pmem_allocator>(
+                heap->get_pmem_ptr(),
+                block_size,
+                PMEM_HEAP_SIZE / (block_size + 1) - 1,
+                true
+        );
+    }
+
+    void destroy_allocator(benchmark::State const& state)
+    {
+        if (state.thread_index() != 0)
+        {
+            return;
+        }
+        allocator.reset();
+        heap.reset();
+        heap_file.reset();
+    }
+
+    /*
+     * Allocates a block and immediately frees it.
+     * Args: block size, flush backend
+     */
+    void pmem_alloc_free_bench(benchmark::State& state)
+    {
+        apply_flush_backend(state, 1);
+        init_allocator(state);
+        for (auto _ : state)
+        {
+            allocator->pmem_free(allocator->pmem_alloc());
+        }
+        state.SetItemsProcessed(state.iterations());
+        destroy_allocator(state);
+    }
+
+    /*
+     * Each thread keeps a window of allocated blocks, freeing the oldest block and allocating
+     * a new one on each iteration. Therefore, freed blocks are reused.
+     * Args: block size, flush backend
+     */
+    void pmem_alloc_window_bench(benchmark::State& state)
+    {
+        const uint32_t window_size = 64;
+        apply_flush_backend(state, 1);
+        init_allocator(state);
+        std::deque<uint8_t*> window;
+        for (auto _ : state)
+        {
+            if (window.size() == window_size)
+            {
+                allocator->pmem_free(window.front());
+                window.pop_front();
+            }
+            window.push_back(allocator->pmem_alloc());
+        }
+        state.SetItemsProcessed(state.iterations());
+        /*
+         * Blocks of the window are not freed: the whole heap is destroyed by the first thread
+         */
+        destroy_allocator(state);
+    }
+
+    /*
+     * Scans the whole heap of 1-byte blocks, all of which are allocated, and finds leaked blocks
+     * (all blocks, except for every LIVE_BLOCKS_STEP-th one), without freeing them.
+     * Args: number of collection threads
+     */
+    void heap_collection_bench(benchmark::State& state)
+    {
+        const uint64_t LIVE_BLOCKS_STEP = 1024;
+        const uint32_t number_of_collection_threads = state.range(0);
+        /*
+         * Heap is filled before the measured loop, flushes are not measured
+         */
+        const flush_backend previous_backend = get_flush_backend();
+        set_flush_backend(flush_backend::NONE);
+        const temp_file file(get_temp_file_name("bench_heap"));
+        persistent_memory_holder collected_heap(file.file_name, false, PMEM_HEAP_SIZE);
+        pmem_allocator collected_allocator(collected_heap.get_pmem_ptr(), 1, PMEM_HEAP_SIZE / 2 - 1, true);
+        std::unordered_set<uint64_t> roots;
+        for (uint64_t block_num = 1; block_num < PMEM_HEAP_SIZE / 2; block_num++)
+        {
+            uint8_t* const block = collected_allocator.pmem_alloc();
+            if (block_num % LIVE_BLOCKS_STEP == 0)
+            {
+                roots.insert(block - collected_heap.get_pmem_ptr());
+            }
+        }
+        set_flush_backend(previous_backend);
+
+        for (auto _ : state)
+        {
+            heap_collector collector(collected_allocator, collected_heap.get_pmem_ptr(), roots, false);
+            collector.run(number_of_collection_threads);
+            benchmark::DoNotOptimize(collector.get_report());
+        }
+        state.SetItemsProcessed(state.iterations() * collected_allocator.get_allocation_border());
+    }
+
+    void heap_collection_args(benchmark::internal::Benchmark* bench)
+    {
+        bench->ArgNames({"collection_threads"});
+        for (int threads : BENCH_THREAD_COUNTS)
+        {
+            bench->Arg(threads);
+        }
+        bench->UseRealTime();
+    }
+
+    void allocator_args(benchmark::internal::Benchmark* bench)
+    {
+        bench->ArgNames({"block_size", "backend"});
+        bench->ArgsProduct({{1, 63, 255}, FLUSH_BACKEND_ARGS});
+        for (int threads : BENCH_THREAD_COUNTS)
+        {
+            bench->Threads(threads);
+        }
+        bench->UseRealTime();
+    }
+}
+
+BENCHMARK(pmem_alloc_free_bench)->Apply(allocator_args);
+BENCHMARK(pmem_alloc_window_bench)->Apply(allocator_args);
+BENCHMARK(heap_collection_bench)->Apply(heap_collection_args);
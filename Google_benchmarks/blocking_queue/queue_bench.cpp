@@ -0,0 +1,44 @@
+#include "benchmark/benchmark.h"
+#include "../../code/blocking_queue/blocking_queue.h"
+#include "../../code/model/tasks.h"
+#include <memory>
+#include <variant>
+
+namespace
+{
+    /*
+     * Queue is shared by all threads of the benchmark. It is created and destroyed by the first
+     * thread outside of the measured loop, beginning and end of which are barriers for all threads.
+     */
+    std::unique_ptr<blocking_queue<task>> queue;
+
+    /*
+     * Each thread pushes a task and takes a task (possibly pushed by another thread),
+     * therefore take never blocks forever.
+     */
+    void queue_push_take_bench(benchmark::State& state)
+    {
+        if (state.thread_index() == 0)
+        {
+            queue = std::make_unique<blocking_queue<task>>();
+        }
+        const task task = cas_task(0, 42, 24, 0, 0);
+        for (auto _ : state)
+        {
+            queue->push(task);
+            benchmark::DoNotOptimize(queue->take());
+        }
+        state.SetItemsProcessed(state.iterations());
+        if (state.thread_index() == 0)
+        {
+            queue.reset();
+        }
+    }
+}
+
+BENCHMARK(queue_push_take_bench)
+        ->Threads(1)
+        ->Threads(2)
+        ->Threads(4)
+        ->Threads(8)
+        ->UseRealTime();
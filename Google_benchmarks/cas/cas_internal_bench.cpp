@@ -0,0 +1,77 @@
+#include "benchmark/benchmark.h"
+#include "../common/bench_utils.h"
+#include "../../Google_tests/common/test_utils.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/common/constants_and_types.h"
+#include "../../code/common/pmem_utils.h"
+#include "../../code/cas/cas.h"
+#include <cstring>
+#include <limits>
+#include <memory>
+
+namespace
+{
+    /*
+     * Heap is shared by all threads of the benchmark. It is created and destroyed by the first
+     * thread outside of the measured loop, beginning and end of which are barriers for all threads.
+     */
+    std::unique_ptr<temp_file> heap_file;
+    std::unique_ptr<persistent_memory_holder> heap;
+
+    /*
+     * Args: flush backend
+     */
+    void cas_internal_bench(benchmark::State& state)
+    {
+        apply_flush_backend(state, 0);
+        const uint32_t total_thread_number = state.threads();
+        const uint32_t cur_thread_number = state.thread_index();
+        if (cur_thread_number == 0)
+        {
+            heap_file = std::make_unique<temp_file>(get_temp_file_name("bench_heap"));
+            heap = std::make_unique<persistent_memory_holder>(heap_file->file_name, false, PMEM_HEAP_SIZE);
+            /*
+             * Initial value is 0, no thread has performed CAS yet
+             */
+            uint64_t initial_thread_number_and_value = 0;
+            const uint32_t initial_thread_number = std::numeric_limits<uint32_t>::max();
+            std::memcpy(&initial_thread_number_and_value, &initial_thread_number, 4);
+            std::memcpy(heap->get_pmem_ptr(), &initial_thread_number_and_value, 8);
+            pmem_do_flush(heap->get_pmem_ptr(), 8);
+        }
+
+        uint64_t successful = 0;
+        for (auto _ : state)
+        {
+            uint64_t* const var = (uint64_t*) heap->get_pmem_ptr();
+            uint32_t* const thread_matrix = (uint32_t*) (heap->get_pmem_ptr() + CACHE_LINE_SIZE);
+            const uint64_t cur_thread_number_and_value = __atomic_load_n(var, __ATOMIC_SEQ_CST);
+            uint32_t cur_value;
+            std::memcpy(&cur_value, (const uint8_t*) &cur_thread_number_and_value + 4, 4);
+            if (cas_internal(var, cur_value, cur_value + 1, cur_thread_number, total_thread_number, thread_matrix))
+            {
+                successful++;
+            }
+        }
+        state.counters["success_rate"] = benchmark::Counter(
+                (double) successful / state.iterations(),
+                benchmark::Counter::kAvgThreads
+        );
+        state.SetItemsProcessed(state.iterations());
+
+        if (cur_thread_number == 0)
+        {
+            heap.reset();
+            heap_file.reset();
+        }
+    }
+}
+
+BENCHMARK(cas_internal_bench)
+        ->ArgNames({"backend"})
+        ->ArgsProduct({FLUSH_BACKEND_ARGS})
+        ->Threads(1)
+        ->Threads(2)
+        ->Threads(4)
+        ->Threads(8)
+        ->UseRealTime();
@@ -0,0 +1,56 @@
+#include "bench_utils.h"
+#include "../../code/common/pmem_utils.h"
+#include "../../code/storage/global_storage.h"
+#include "../../code/model/function_address_holder.h"
+#include "../../code/model/system_mode.h"
+#include "../../code/structures/structures_common.h"
+#include <mutex>
+
+const std::vector<int64_t> FLUSH_BACKEND_ARGS = {
+        (int64_t) flush_backend::MSYNC,
+        (int64_t) flush_backend::PERSIST,
+        (int64_t) flush_backend::NONE
+};
+
+const std::vector<int> BENCH_THREAD_COUNTS = {1, 2, 4, 8};
+
+void apply_flush_backend(benchmark::State& state, uint32_t arg_index)
+{
+    const flush_backend backend = (flush_backend) state.range(arg_index);
+    set_flush_backend(backend);
+    switch (backend)
+    {
+        case flush_backend::MSYNC:
+            state.SetLabel("msync");
+            break;
+        case flush_backend::PERSIST:
+            state.SetLabel("persist");
+            break;
+        case flush_backend::NONE:
+            state.SetLabel("none");
+            break;
+    }
+}
+
+namespace
+{
+    void bench_noop(const uint8_t*)
+    {}
+
+    std::once_flag init_flag;
+}
+
+void init_bench_runtime()
+{
+    std::call_once(
+            init_flag,
+            []()
+            {
+                function_address_holder func_map;
+                func_map.funcs["bench_noop"] = {bench_noop, bench_noop};
+                register_structure_functions(func_map);
+                global_storage<function_address_holder>::set_object(std::move(func_map));
+                global_storage<system_mode>::set_object(system_mode::EXECUTION);
+            }
+    );
+}
@@ -0,0 +1,33 @@
+#ifndef DIPLOM_BENCH_UTILS_H
+#define DIPLOM_BENCH_UTILS_H
+
+#include <vector>
+#include <cstdint>
+#include "benchmark/benchmark.h"
+#include "../../code/model/flush_backend.h"
+
+/**
+ * Values of benchmark argument, that selects flush backend (see apply_flush_backend).
+ */
+extern const std::vector<int64_t> FLUSH_BACKEND_ARGS;
+
+/**
+ * Thread counts, that are used by multi-threaded benchmarks.
+ */
+extern const std::vector<int> BENCH_THREAD_COUNTS;
+
+/**
+ * Sets flush backend, that is selected by benchmark argument with specified index,
+ * and labels the benchmark with the backend name.
+ * @param state - benchmark state.
+ * @param arg_index - index of the argument, that selects flush backend.
+ */
+void apply_flush_backend(benchmark::State& state, uint32_t arg_index);
+
+/**
+ * Registers functions, that are called by benchmarks (bench_noop, which does nothing, and operations
+ * of persistent data structures), and sets system mode to EXECUTION. Can be safely called from multiple threads.
+ */
+void init_bench_runtime();
+
+#endif //DIPLOM_BENCH_UTILS_H
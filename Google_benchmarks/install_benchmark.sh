@@ -0,0 +1,2 @@
+git clone https://github.com/google/benchmark.git
+mv benchmark lib
@@ -0,0 +1,32 @@
+#include "benchmark/benchmark.h"
+#include "../../code/metrics/runtime_metrics.h"
+
+namespace
+{
+    /*
+     * Cost of a single counter update on the hot path
+     */
+    void increment_counter_bench(benchmark::State& state)
+    {
+        for (auto _ : state)
+        {
+            increment_counter(metrics_counter::FLUSHES, 1);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    /*
+     * Cost of measuring and recording a single latency on the hot path
+     */
+    void scoped_latency_bench(benchmark::State& state)
+    {
+        for (auto _ : state)
+        {
+            scoped_latency latency(metrics_histogram::FLUSH);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+}
+
+BENCHMARK(increment_counter_bench)->Threads(1)->Threads(4)->UseRealTime();
+BENCHMARK(scoped_latency_bench)->Threads(1)->Threads(4)->UseRealTime();
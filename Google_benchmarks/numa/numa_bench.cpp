@@ -0,0 +1,128 @@
+#include "benchmark/benchmark.h"
+#include "../common/bench_utils.h"
+#include "../../Google_tests/common/test_utils.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/common/constants_and_types.h"
+#include "../../code/common/pmem_utils.h"
+#include "../../code/numa/numa_topology.h"
+#include "../../code/cas/cas.h"
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <sched.h>
+
+namespace
+{
+    /**
+     * Placement of benchmark threads on NUMA nodes.
+     */
+    enum class thread_placement : int64_t
+    {
+        /*
+         * Threads are not pinned
+         */
+        UNPINNED,
+        /*
+         * All threads are pinned to the first node
+         */
+        COMPACT,
+        /*
+         * Threads are pinned to the nodes in round-robin order
+         */
+        SPREAD
+    };
+
+    /*
+     * Heap is shared by all threads of the benchmark. It is created and destroyed by the first
+     * thread outside of the measured loop, beginning and end of which are barriers for all threads.
+     */
+    std::unique_ptr<temp_file> heap_file;
+    std::unique_ptr<persistent_memory_holder> heap;
+
+    const numa_topology topology = numa_topology::detect();
+
+    uint32_t get_thread_node(thread_placement placement, uint32_t thread_number)
+    {
+        return placement == thread_placement::SPREAD ? thread_number % topology.get_number_of_nodes() : 0;
+    }
+
+    /*
+     * Args: flush backend, thread placement, whether registers are bound to the node of their thread
+     * (otherwise, all registers are bound to the first node).
+     * Each thread performs CAS on it's own register, located in it's own page, therefore threads don't contend
+     * and throughput is limited only by memory placement and flushes.
+     */
+    void numa_cas_bench(benchmark::State& state)
+    {
+        apply_flush_backend(state, 0);
+        const thread_placement placement = (thread_placement) state.range(1);
+        const bool local_registers = state.range(2) == 1;
+        const uint32_t total_thread_number = state.threads();
+        const uint32_t cur_thread_number = state.thread_index();
+        if (cur_thread_number == 0)
+        {
+            heap_file = std::make_unique<temp_file>(get_temp_file_name("bench_heap"));
+            heap = std::make_unique<persistent_memory_holder>(heap_file->file_name, false, PMEM_HEAP_SIZE);
+            for (uint32_t thread_number = 0; thread_number < total_thread_number; thread_number++)
+            {
+                uint8_t* const page = heap->get_pmem_ptr() + (uint64_t) thread_number * PAGE_SIZE;
+                const uint32_t node_index = local_registers ? get_thread_node(placement, thread_number) : 0;
+                bind_memory_to_node(page, PAGE_SIZE, topology.get_node(node_index).id);
+                uint64_t initial_thread_number_and_value = 0;
+                const uint32_t initial_thread_number = std::numeric_limits<uint32_t>::max();
+                std::memcpy(&initial_thread_number_and_value, &initial_thread_number, 4);
+                std::memcpy(page, &initial_thread_number_and_value, 8);
+                pmem_do_flush(page, 8);
+            }
+        }
+
+        /*
+         * First thread is the main thread of the benchmark, therefore it's affinity is restored after the run
+         */
+        cpu_set_t initial_affinity;
+        sched_getaffinity(0, sizeof(initial_affinity), &initial_affinity);
+        if (placement != thread_placement::UNPINNED)
+        {
+            pin_current_thread(topology.get_node(get_thread_node(placement, cur_thread_number)).cpus);
+        }
+
+        for (auto _ : state)
+        {
+            uint8_t* const page = heap->get_pmem_ptr() + (uint64_t) cur_thread_number * PAGE_SIZE;
+            uint64_t* const var = (uint64_t*) page;
+            uint32_t* const thread_matrix = (uint32_t*) (page + CACHE_LINE_SIZE);
+            const uint64_t cur_thread_number_and_value = __atomic_load_n(var, __ATOMIC_SEQ_CST);
+            uint32_t cur_value;
+            std::memcpy(&cur_value, (const uint8_t*) &cur_thread_number_and_value + 4, 4);
+            benchmark::DoNotOptimize(
+                    cas_internal(var, cur_value, cur_value + 1, cur_thread_number, total_thread_number, thread_matrix)
+            );
+        }
+        state.SetItemsProcessed(state.iterations());
+        state.counters["nodes"] = benchmark::Counter(topology.get_number_of_nodes(), benchmark::Counter::kAvgThreads);
+
+        sched_setaffinity(0, sizeof(initial_affinity), &initial_affinity);
+        if (cur_thread_number == 0)
+        {
+            heap.reset();
+            heap_file.reset();
+        }
+    }
+}
+
+BENCHMARK(numa_cas_bench)
+        ->ArgNames({"backend", "placement", "local"})
+        ->ArgsProduct({
+                              {(int64_t) flush_backend::PERSIST, (int64_t) flush_backend::NONE},
+                              {
+                                      (int64_t) thread_placement::UNPINNED,
+                                      (int64_t) thread_placement::COMPACT,
+                                      (int64_t) thread_placement::SPREAD
+                              },
+                              {0, 1}
+                      })
+        ->Threads(1)
+        ->Threads(2)
+        ->Threads(4)
+        ->Threads(8)
+        ->UseRealTime();
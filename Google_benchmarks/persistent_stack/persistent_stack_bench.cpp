@@ -0,0 +1,99 @@
+#include "benchmark/benchmark.h"
+#include "../common/bench_utils.h"
+#include "../../Google_tests/common/test_utils.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/persistent_stack/persistent_stack.h"
+#include "../../code/common/constants_and_types.h"
+#include "../../code/common/pmem_utils.h"
+
+namespace
+{
+    /**
+     * Returns number of frames with args of specified size, that fit into a single persistent stack
+     * together with the first frame.
+     */
+    uint32_t get_stack_capacity(const stack_frame& frame)
+    {
+        const uint64_t aligned_frame_size = get_cache_line_aligned_address(frame.size());
+        const uint64_t first_frame_offset = get_cache_line_aligned_address(STACK_HEADER_SIZE);
+        return (PMEM_STACK_SIZE - first_frame_offset) / aligned_frame_size;
+    }
+
+    /*
+     * Args: args size, flush backend
+     */
+    void add_new_frame_bench(benchmark::State& state)
+    {
+        apply_flush_backend(state, 1);
+        temp_file file(get_temp_file_name("bench_stack_" + std::to_string(state.thread_index())));
+        persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+        ram_stack r_stack;
+        const stack_frame frame("bench_function", std::vector<uint8_t>(state.range(0), 42));
+        const uint32_t capacity = get_stack_capacity(frame);
+        add_new_frame(r_stack, frame, p_stack);
+
+        for (auto _ : state)
+        {
+            if (r_stack.size() == capacity)
+            {
+                /*
+                 * Stack is full: empty it without measuring
+                 */
+                state.PauseTiming();
+                while (r_stack.size() > 1)
+                {
+                    remove_frame(r_stack, p_stack);
+                }
+                state.ResumeTiming();
+            }
+            add_new_frame(r_stack, frame, p_stack);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    /*
+     * Args: args size, flush backend
+     */
+    void remove_frame_bench(benchmark::State& state)
+    {
+        apply_flush_backend(state, 1);
+        temp_file file(get_temp_file_name("bench_stack_" + std::to_string(state.thread_index())));
+        persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+        ram_stack r_stack;
+        const stack_frame frame("bench_function", std::vector<uint8_t>(state.range(0), 42));
+        const uint32_t capacity = get_stack_capacity(frame);
+        add_new_frame(r_stack, frame, p_stack);
+
+        for (auto _ : state)
+        {
+            if (r_stack.size() == 1)
+            {
+                /*
+                 * Stack is empty: fill it without measuring
+                 */
+                state.PauseTiming();
+                while (r_stack.size() < capacity)
+                {
+                    add_new_frame(r_stack, frame, p_stack);
+                }
+                state.ResumeTiming();
+            }
+            remove_frame(r_stack, p_stack);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void stack_args(benchmark::internal::Benchmark* bench)
+    {
+        bench->ArgNames({"args_size", "backend"});
+        bench->ArgsProduct({{0, 8, 64, 256}, FLUSH_BACKEND_ARGS});
+        for (int threads : BENCH_THREAD_COUNTS)
+        {
+            bench->Threads(threads);
+        }
+        bench->UseRealTime();
+    }
+}
+
+BENCHMARK(add_new_frame_bench)->Apply(stack_args);
+BENCHMARK(remove_frame_bench)->Apply(stack_args);
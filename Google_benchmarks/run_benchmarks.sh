@@ -0,0 +1,15 @@
+#!/bin/bash
+# Runs all benchmarks and writes results in JSON format.
+# Usage: run_benchmarks.sh <path to Diplom_bench> <output json> [additional benchmark flags]
+# Results of two builds can be compared using lib/tools/compare.py:
+#   python3 lib/tools/compare.py benchmarks old.json new.json
+set -e
+BENCH=$1
+OUT=$2
+shift 2
+"$BENCH" \
+    --benchmark_out="$OUT" \
+    --benchmark_out_format=json \
+    --benchmark_repetitions=5 \
+    --benchmark_report_aggregates_only=true \
+    "$@"
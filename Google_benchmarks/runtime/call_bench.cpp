@@ -0,0 +1,205 @@
+#include "benchmark/benchmark.h"
+#include "../common/bench_utils.h"
+#include "../../Google_tests/common/test_utils.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/persistent_stack/persistent_stack.h"
+#include "../../code/storage/thread_local_owning_storage.h"
+#include "../../code/storage/thread_local_non_owning_storage.h"
+#include "../../code/common/constants_and_types.h"
+#include "../../code/runtime/call.h"
+#include "../../code/runtime/answer.h"
+#include "../../code/runtime/transaction.h"
+#include "../../code/storage/global_non_owning_storage.h"
+#include "../../code/common/pmem_utils.h"
+#include <cstring>
+#include <memory>
+
+namespace
+{
+    /**
+     * Persistent stack of the benchmark thread with two frames: first frame of the thread and
+     * frame of the function, that is being executed. Is set as the stack of the caller thread.
+     */
+    struct bench_thread_stack
+    {
+        temp_file file;
+        persistent_memory_holder p_stack;
+
+        explicit bench_thread_stack(benchmark::State const& state) :
+                file(get_temp_file_name("bench_stack_" + std::to_string(state.thread_index()))),
+                p_stack(file.file_name, false, PMEM_STACK_SIZE)
+        {
+            ram_stack& r_stack = thread_local_owning_storage<ram_stack>::emplace_object();
+            thread_local_non_owning_storage<persistent_memory_holder>::ptr = &p_stack;
+            add_new_frame(r_stack, stack_frame("main_function", std::vector<uint8_t>()), p_stack);
+            add_new_frame(r_stack, stack_frame("bench_function", std::vector<uint8_t>()), p_stack);
+        }
+    };
+
+    /*
+     * Args: args size, flush backend
+     */
+    void do_call_bench(benchmark::State& state)
+    {
+        init_bench_runtime();
+        apply_flush_backend(state, 1);
+        bench_thread_stack stack(state);
+        const std::vector<uint8_t> args(state.range(0), 42);
+
+        for (auto _ : state)
+        {
+            do_call("bench_noop", args);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    /*
+     * Args: answer size, flush backend
+     */
+    void write_answer_bench(benchmark::State& state)
+    {
+        apply_flush_backend(state, 1);
+        bench_thread_stack stack(state);
+        const std::vector<uint8_t> answer(state.range(0), 42);
+
+        for (auto _ : state)
+        {
+            write_answer(answer);
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    /*
+     * Args: answer size, flush backend
+     */
+    void read_answer_bench(benchmark::State& state)
+    {
+        apply_flush_backend(state, 1);
+        bench_thread_stack stack(state);
+        const uint8_t size = state.range(0);
+
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(read_answer(size));
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    /**
+     * Way, in which several locations are written by single iteration of transaction benchmark.
+     */
+    enum class write_mode : int64_t
+    {
+        /*
+         * Each location is written and flushed separately
+         */
+        FLUSH_EACH,
+        /*
+         * All locations are written by single transaction
+         */
+        TRANSACTION
+    };
+
+    /*
+     * Heap is shared by all threads of the benchmark. It is created and destroyed by the first thread
+     * outside of the measured loop.
+     */
+    std::unique_ptr<temp_file> heap_file;
+    std::unique_ptr<persistent_memory_holder> heap;
+
+    /*
+     * Args: number of written locations, write mode, flush backend.
+     * Each thread writes 8-byte values to it's own locations, each location occupies separate cache line.
+     */
+    void transaction_bench(benchmark::State& state)
+    {
+        const uint32_t number_of_writes = state.range(0);
+        const write_mode mode = (write_mode) state.range(1);
+        apply_flush_backend(state, 2);
+        bench_thread_stack stack(state);
+        if (state.thread_index() == 0)
+        {
+            heap_file = std::make_unique<temp_file>(get_temp_file_name("bench_heap"));
+            heap = std::make_unique<persistent_memory_holder>(heap_file->file_name, false, PMEM_HEAP_SIZE);
+            global_non_owning_storage<persistent_memory_holder>::ptr = heap.get();
+        }
+        const uint64_t first_offset = state.thread_index() * number_of_writes * CACHE_LINE_SIZE;
+        std::vector<uint8_t> value(8, 0);
+        uint64_t counter = 0;
+
+        for (auto _ : state)
+        {
+            counter++;
+            std::memcpy(value.data(), &counter, 8);
+            uint8_t* const heap_ptr = heap->get_pmem_ptr();
+            if (mode == write_mode::FLUSH_EACH)
+            {
+                for (uint32_t i = 0; i < number_of_writes; i++)
+                {
+                    uint8_t* const location = heap_ptr + first_offset + i * CACHE_LINE_SIZE;
+                    std::memcpy(location, value.data(), 8);
+                    pmem_do_flush(location, 8);
+                }
+            }
+            else
+            {
+                tx_begin();
+                for (uint32_t i = 0; i < number_of_writes; i++)
+                {
+                    tx_write(heap_ptr + first_offset + i * CACHE_LINE_SIZE, value);
+                }
+                tx_commit();
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * number_of_writes);
+
+        if (state.thread_index() == 0)
+        {
+            global_non_owning_storage<persistent_memory_holder>::ptr = nullptr;
+            heap.reset();
+            heap_file.reset();
+        }
+    }
+
+    void call_args(benchmark::internal::Benchmark* bench)
+    {
+        bench->ArgNames({"args_size", "backend"});
+        bench->ArgsProduct({{0, 8, 64, 256}, FLUSH_BACKEND_ARGS});
+        for (int threads : BENCH_THREAD_COUNTS)
+        {
+            bench->Threads(threads);
+        }
+        bench->UseRealTime();
+    }
+
+    void answer_args(benchmark::internal::Benchmark* bench)
+    {
+        bench->ArgNames({"answer_size", "backend"});
+        bench->ArgsProduct({{1, 8}, FLUSH_BACKEND_ARGS});
+        for (int threads : BENCH_THREAD_COUNTS)
+        {
+            bench->Threads(threads);
+        }
+        bench->UseRealTime();
+    }
+
+    void transaction_args(benchmark::internal::Benchmark* bench)
+    {
+        bench->ArgNames({"writes", "mode", "backend"});
+        bench->ArgsProduct({
+                {1, 4, 16},
+                {(int64_t) write_mode::FLUSH_EACH, (int64_t) write_mode::TRANSACTION},
+                FLUSH_BACKEND_ARGS
+        });
+        for (int threads : BENCH_THREAD_COUNTS)
+        {
+            bench->Threads(threads);
+        }
+        bench->UseRealTime();
+    }
+}
+
+BENCHMARK(do_call_bench)->Apply(call_args);
+BENCHMARK(write_answer_bench)->Apply(answer_args);
+BENCHMARK(read_answer_bench)->Apply(answer_args);
+BENCHMARK(transaction_bench)->Apply(transaction_args);
@@ -0,0 +1,533 @@
+#include "benchmark/benchmark.h"
+#include "../common/bench_utils.h"
+#include "../../Google_tests/common/test_utils.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/persistent_stack/persistent_stack.h"
+#include "../../code/storage/global_storage.h"
+#include "../../code/storage/global_non_owning_storage.h"
+#include "../../code/storage/thread_local_owning_storage.h"
+#include "../../code/storage/thread_local_non_owning_storage.h"
+#include "../../code/common/constants_and_types.h"
+#include "../../code/model/cur_thread_id_holder.h"
+#include "../../code/model/total_thread_count_holder.h"
+#include "../../code/structures/node_pool.h"
+#include "../../code/structures/epoch_manager.h"
+#include "../../code/structures/treiber_stack.h"
+#include "../../code/structures/ms_queue.h"
+#include "../../code/structures/hash_map.h"
+#include "../../code/structures/skip_list.h"
+#include "../../code/structures/structures_common.h"
+#include "../../code/structures/mcas.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stack>
+#include <unordered_map>
+
+namespace
+{
+    /**
+     * Data structure, that is benchmarked.
+     */
+    enum class structure_kind : int64_t
+    {
+        STACK,
+        QUEUE
+    };
+
+    /**
+     * Way, in which nodes, removed from the structure, are reclaimed.
+     */
+    enum class reclamation_mode : int64_t
+    {
+        /*
+         * Node is freed by the thread, that has removed it
+         */
+        IMMEDIATE,
+        /*
+         * Node is retired and freed by epoch_manager in batches
+         */
+        EPOCH
+    };
+
+    const uint64_t STRUCTURE_OFFSET = 0;
+    const uint64_t NODES_OFFSET = 64 * 1024;
+
+    /*
+     * Map, containing MAP_KEYS keys, is never resized: it's first table has twice as many buckets
+     */
+    const uint64_t MAP_NODES_OFFSET = 1024 * 1024;
+    const uint32_t MAP_KEYS = 512;
+    const uint32_t MAP_CAPACITY = 1024;
+    const uint32_t MAP_TABLES = 4;
+
+    /*
+     * Skip list is filled with LIST_KEYS keys before the benchmark, each scan returns LIST_SCAN_LENGTH keys
+     */
+    const uint32_t LIST_KEYS = 4096;
+    const uint32_t LIST_SCAN_LENGTH = 16;
+
+    /**
+     * Way, in which several registers are changed by single iteration of MCAS benchmark.
+     */
+    enum class mcas_mode : int64_t
+    {
+        /*
+         * All registers are changed atomically by single MCAS
+         */
+        MCAS,
+        /*
+         * Registers are changed one by one by recoverable CAS
+         */
+        CHAINED_CAS
+    };
+
+    /*
+     * Heap and pool of nodes are shared by all threads of the benchmark. They are created and destroyed
+     * by the first thread outside of the measured loop, beginning and end of which are barriers for all threads.
+     */
+    std::unique_ptr<temp_file> heap_file;
+    std::unique_ptr<persistent_memory_holder> heap;
+    std::unique_ptr<node_pool> pool;
+    std::unique_ptr<epoch_manager> reclamation;
+
+    /**
+     * Persistent stack of the benchmark thread, containing only the first frame. Is set as the stack of the
+     * caller thread.
+     */
+    struct bench_thread_stack
+    {
+        temp_file file;
+        persistent_memory_holder p_stack;
+
+        explicit bench_thread_stack(benchmark::State const& state) :
+                file(get_temp_file_name("bench_stack_" + std::to_string(state.thread_index()))),
+                p_stack(file.file_name, false, PMEM_STACK_SIZE)
+        {
+            ram_stack& r_stack = thread_local_owning_storage<ram_stack>::emplace_object();
+            thread_local_non_owning_storage<persistent_memory_holder>::ptr = &p_stack;
+            thread_local_owning_storage<cur_thread_id_holder>::set_object(cur_thread_id_holder(state.thread_index()));
+            add_new_frame(r_stack, stack_frame("main_function", std::vector<uint8_t>()), p_stack);
+        }
+    };
+
+    /*
+     * Args: data structure, flush backend, reclamation mode.
+     * Each iteration inserts value to the structure and removes value from it, therefore number of nodes
+     * in the structure never exceeds number of threads.
+     */
+    void persistent_structure_bench(benchmark::State& state)
+    {
+        init_bench_runtime();
+        const structure_kind kind = (structure_kind) state.range(0);
+        apply_flush_backend(state, 1);
+        if (state.thread_index() == 0)
+        {
+            global_storage<total_thread_count_holder>::emplace_object(state.threads());
+            heap_file = std::make_unique<temp_file>(get_temp_file_name("bench_heap"));
+            heap = std::make_unique<persistent_memory_holder>(heap_file->file_name, false, PMEM_HEAP_SIZE);
+            pool = std::make_unique<node_pool>(
+                    heap->get_pmem_ptr(),
+                    NODES_OFFSET,
+                    std::min((PMEM_HEAP_SIZE - NODES_OFFSET) / node_pool::NODE_SIZE - 1, node_pool::MAX_NODES),
+                    true
+            );
+            global_non_owning_storage<persistent_memory_holder>::ptr = heap.get();
+            global_non_owning_storage<node_pool>::ptr = pool.get();
+            if ((reclamation_mode) state.range(2) == reclamation_mode::EPOCH)
+            {
+                reclamation = std::make_unique<epoch_manager>(*pool, state.threads());
+                global_non_owning_storage<epoch_manager>::ptr = reclamation.get();
+            }
+            if (kind == structure_kind::STACK)
+            {
+                init_treiber_stack(STRUCTURE_OFFSET);
+            }
+            else
+            {
+                init_ms_queue(STRUCTURE_OFFSET);
+            }
+        }
+        bench_thread_stack stack(state);
+        const uint32_t value = state.thread_index();
+
+        for (auto _ : state)
+        {
+            if (kind == structure_kind::STACK)
+            {
+                treiber_stack_push(STRUCTURE_OFFSET, value);
+                benchmark::DoNotOptimize(treiber_stack_pop(STRUCTURE_OFFSET));
+            }
+            else
+            {
+                ms_queue_enqueue(STRUCTURE_OFFSET, value);
+                benchmark::DoNotOptimize(ms_queue_dequeue(STRUCTURE_OFFSET));
+            }
+        }
+        state.SetItemsProcessed(2 * state.iterations());
+
+        if (state.thread_index() == 0)
+        {
+            global_non_owning_storage<epoch_manager>::ptr = nullptr;
+            global_non_owning_storage<node_pool>::ptr = nullptr;
+            global_non_owning_storage<persistent_memory_holder>::ptr = nullptr;
+            reclamation.reset();
+            pool.reset();
+            heap.reset();
+            heap_file.reset();
+        }
+    }
+
+    /*
+     * Volatile baseline: structures in RAM, protected by mutex
+     */
+    std::mutex volatile_mutex;
+    std::stack<uint32_t> volatile_stack;
+    std::queue<uint32_t> volatile_queue;
+
+    /*
+     * Args: data structure
+     */
+    void volatile_structure_bench(benchmark::State& state)
+    {
+        const structure_kind kind = (structure_kind) state.range(0);
+        const uint32_t value = state.thread_index();
+
+        for (auto _ : state)
+        {
+            if (kind == structure_kind::STACK)
+            {
+                {
+                    std::unique_lock lock(volatile_mutex);
+                    volatile_stack.push(value);
+                }
+                std::unique_lock lock(volatile_mutex);
+                benchmark::DoNotOptimize(volatile_stack.top());
+                volatile_stack.pop();
+            }
+            else
+            {
+                {
+                    std::unique_lock lock(volatile_mutex);
+                    volatile_queue.push(value);
+                }
+                std::unique_lock lock(volatile_mutex);
+                benchmark::DoNotOptimize(volatile_queue.front());
+                volatile_queue.pop();
+            }
+        }
+        state.SetItemsProcessed(2 * state.iterations());
+    }
+
+    /*
+     * Args: flush backend.
+     * Each iteration updates key and reads it back. Keys are distributed between threads round-robin.
+     */
+    void persistent_hash_map_bench(benchmark::State& state)
+    {
+        init_bench_runtime();
+        apply_flush_backend(state, 0);
+        if (state.thread_index() == 0)
+        {
+            global_storage<total_thread_count_holder>::emplace_object(state.threads());
+            heap_file = std::make_unique<temp_file>(get_temp_file_name("bench_heap"));
+            heap = std::make_unique<persistent_memory_holder>(heap_file->file_name, false, PMEM_HEAP_SIZE);
+            pool = std::make_unique<node_pool>(
+                    heap->get_pmem_ptr(),
+                    MAP_NODES_OFFSET,
+                    std::min((PMEM_HEAP_SIZE - MAP_NODES_OFFSET) / node_pool::NODE_SIZE - 1, node_pool::MAX_NODES),
+                    true
+            );
+            global_non_owning_storage<persistent_memory_holder>::ptr = heap.get();
+            global_non_owning_storage<node_pool>::ptr = pool.get();
+            init_hash_map(STRUCTURE_OFFSET, MAP_CAPACITY, MAP_TABLES);
+        }
+        bench_thread_stack stack(state);
+        const uint32_t value = state.thread_index();
+        uint64_t key = state.thread_index();
+
+        for (auto _ : state)
+        {
+            /*
+             * Key 0 is reserved
+             */
+            hash_map_put(STRUCTURE_OFFSET, key + 1, value);
+            benchmark::DoNotOptimize(hash_map_get(STRUCTURE_OFFSET, key + 1));
+            key = (key + state.threads()) % MAP_KEYS;
+        }
+        state.SetItemsProcessed(2 * state.iterations());
+
+        if (state.thread_index() == 0)
+        {
+            global_non_owning_storage<node_pool>::ptr = nullptr;
+            global_non_owning_storage<persistent_memory_holder>::ptr = nullptr;
+            pool.reset();
+            heap.reset();
+            heap_file.reset();
+        }
+    }
+
+    /*
+     * Volatile baseline: map in RAM, protected by mutex
+     */
+    std::unordered_map<uint64_t, uint32_t> volatile_map;
+
+    void volatile_hash_map_bench(benchmark::State& state)
+    {
+        const uint32_t value = state.thread_index();
+        uint64_t key = state.thread_index();
+
+        for (auto _ : state)
+        {
+            {
+                std::unique_lock lock(volatile_mutex);
+                volatile_map[key + 1] = value;
+            }
+            std::unique_lock lock(volatile_mutex);
+            benchmark::DoNotOptimize(volatile_map.find(key + 1));
+            key = (key + state.threads()) % MAP_KEYS;
+        }
+        state.SetItemsProcessed(2 * state.iterations());
+    }
+
+    /*
+     * Each iteration reads key and scans range, that starts from it
+     */
+    void persistent_skip_list_bench(benchmark::State& state)
+    {
+        init_bench_runtime();
+        bench_thread_stack stack(state);
+        if (state.thread_index() == 0)
+        {
+            global_storage<total_thread_count_holder>::emplace_object(state.threads());
+            heap_file = std::make_unique<temp_file>(get_temp_file_name("bench_heap"));
+            heap = std::make_unique<persistent_memory_holder>(heap_file->file_name, false, PMEM_HEAP_SIZE);
+            pool = std::make_unique<node_pool>(
+                    heap->get_pmem_ptr(),
+                    NODES_OFFSET,
+                    std::min((PMEM_HEAP_SIZE - NODES_OFFSET) / node_pool::NODE_SIZE - 1, node_pool::MAX_NODES),
+                    true
+            );
+            global_non_owning_storage<persistent_memory_holder>::ptr = heap.get();
+            global_non_owning_storage<node_pool>::ptr = pool.get();
+            init_skip_list(STRUCTURE_OFFSET);
+            for (uint64_t key = 0; key < LIST_KEYS; key++)
+            {
+                skip_list_insert(STRUCTURE_OFFSET, key, (uint32_t) key);
+            }
+        }
+        uint64_t key = state.thread_index();
+
+        for (auto _ : state)
+        {
+            benchmark::DoNotOptimize(skip_list_get(STRUCTURE_OFFSET, key));
+            benchmark::DoNotOptimize(skip_list_scan(STRUCTURE_OFFSET, key, key + LIST_SCAN_LENGTH - 1));
+            key = (key + 997) % LIST_KEYS;
+        }
+        state.SetItemsProcessed(2 * state.iterations());
+
+        if (state.thread_index() == 0)
+        {
+            global_non_owning_storage<node_pool>::ptr = nullptr;
+            global_non_owning_storage<persistent_memory_holder>::ptr = nullptr;
+            pool.reset();
+            heap.reset();
+            heap_file.reset();
+        }
+    }
+
+    /*
+     * Volatile baseline: ordered map in RAM, protected by mutex
+     */
+    std::map<uint64_t, uint32_t> volatile_ordered_map;
+
+    void volatile_skip_list_bench(benchmark::State& state)
+    {
+        if (state.thread_index() == 0)
+        {
+            for (uint64_t key = 0; key < LIST_KEYS; key++)
+            {
+                volatile_ordered_map[key] = (uint32_t) key;
+            }
+        }
+        uint64_t key = state.thread_index();
+
+        for (auto _ : state)
+        {
+            {
+                std::unique_lock lock(volatile_mutex);
+                benchmark::DoNotOptimize(volatile_ordered_map.find(key));
+            }
+            std::vector<std::pair<uint64_t, uint32_t>> entries;
+            {
+                std::unique_lock lock(volatile_mutex);
+                for (auto it = volatile_ordered_map.lower_bound(key);
+                     it != volatile_ordered_map.end() && it->first < key + LIST_SCAN_LENGTH; ++it)
+                {
+                    entries.emplace_back(*it);
+                }
+            }
+            benchmark::DoNotOptimize(entries);
+            key = (key + 997) % LIST_KEYS;
+        }
+        state.SetItemsProcessed(2 * state.iterations());
+    }
+
+    /**
+     * Returns offset of RMW register of MCAS benchmark. Each register occupies a cache line
+     * and is followed by it's thread matrix.
+     * @param var_number - number of the register.
+     * @param number_of_threads - number of threads of the benchmark.
+     * @return offset of the register.
+     */
+    uint64_t get_bench_var_offset(uint32_t var_number, uint32_t number_of_threads)
+    {
+        return var_number * (CACHE_LINE_SIZE + get_thread_matrix_size(number_of_threads));
+    }
+
+    /*
+     * Args: number of registers, mode.
+     * All threads share the same registers, each iteration increments every register by one: either by single MCAS
+     * (retried, if it fails or is aborted), or by a chain of recoverable CASes (each of them is retried, until it
+     * succeeds), which is cheaper, but doesn't change registers atomically.
+     */
+    void persistent_mcas_bench(benchmark::State& state)
+    {
+        init_bench_runtime();
+        const uint32_t number_of_words = state.range(0);
+        const mcas_mode mode = (mcas_mode) state.range(1);
+        const uint32_t number_of_threads = state.threads();
+        bench_thread_stack stack(state);
+        if (state.thread_index() == 0)
+        {
+            global_storage<total_thread_count_holder>::emplace_object(number_of_threads);
+            heap_file = std::make_unique<temp_file>(get_temp_file_name("bench_heap"));
+            heap = std::make_unique<persistent_memory_holder>(heap_file->file_name, false, PMEM_HEAP_SIZE);
+            pool = std::make_unique<node_pool>(
+                    heap->get_pmem_ptr(),
+                    NODES_OFFSET,
+                    std::min((PMEM_HEAP_SIZE - NODES_OFFSET) / node_pool::NODE_SIZE - 1, node_pool::MAX_NODES),
+                    true
+            );
+            global_non_owning_storage<persistent_memory_holder>::ptr = heap.get();
+            global_non_owning_storage<node_pool>::ptr = pool.get();
+            for (uint32_t var_number = 0; var_number < number_of_words; var_number++)
+            {
+                init_register(get_bench_var_offset(var_number, number_of_threads), 0);
+            }
+        }
+
+        for (auto _ : state)
+        {
+            if (mode == mcas_mode::MCAS)
+            {
+                uint8_t result;
+                do
+                {
+                    std::vector<mcas_word> words;
+                    for (uint32_t var_number = 0; var_number < number_of_words; var_number++)
+                    {
+                        const uint64_t var_offset = get_bench_var_offset(var_number, number_of_threads);
+                        const uint32_t value = read_register_value(
+                                (const uint64_t*) (heap->get_pmem_ptr() + var_offset)
+                        );
+                        words.push_back({var_offset, var_offset + CACHE_LINE_SIZE, value, value + 1});
+                    }
+                    result = do_mcas(std::move(words));
+                } while (result != MCAS_SUCCEEDED);
+            }
+            else
+            {
+                for (uint32_t var_number = 0; var_number < number_of_words; var_number++)
+                {
+                    const uint64_t var_offset = get_bench_var_offset(var_number, number_of_threads);
+                    bool result;
+                    do
+                    {
+                        const uint32_t value = read_register_value(
+                                (const uint64_t*) (heap->get_pmem_ptr() + var_offset)
+                        );
+                        result = do_recoverable_cas(var_offset, value, value + 1, var_offset + CACHE_LINE_SIZE, 0, 0);
+                    } while (!result);
+                }
+            }
+        }
+        state.SetItemsProcessed(state.iterations());
+
+        if (state.thread_index() == 0)
+        {
+            global_non_owning_storage<node_pool>::ptr = nullptr;
+            global_non_owning_storage<persistent_memory_holder>::ptr = nullptr;
+            pool.reset();
+            heap.reset();
+            heap_file.reset();
+        }
+    }
+
+    void persistent_hash_map_args(benchmark::internal::Benchmark* bench)
+    {
+        bench->ArgNames({"backend"});
+        bench->ArgsProduct({FLUSH_BACKEND_ARGS});
+        for (int threads : BENCH_THREAD_COUNTS)
+        {
+            bench->Threads(threads);
+        }
+        bench->UseRealTime();
+    }
+
+    void thread_count_args(benchmark::internal::Benchmark* bench)
+    {
+        for (int threads : BENCH_THREAD_COUNTS)
+        {
+            bench->Threads(threads);
+        }
+        bench->UseRealTime();
+    }
+
+    void persistent_structure_args(benchmark::internal::Benchmark* bench)
+    {
+        bench->ArgNames({"structure", "backend", "reclamation"});
+        bench->ArgsProduct({
+                {(int64_t) structure_kind::STACK, (int64_t) structure_kind::QUEUE},
+                FLUSH_BACKEND_ARGS,
+                {(int64_t) reclamation_mode::IMMEDIATE, (int64_t) reclamation_mode::EPOCH}
+        });
+        for (int threads : BENCH_THREAD_COUNTS)
+        {
+            bench->Threads(threads);
+        }
+        bench->UseRealTime();
+    }
+
+    void persistent_mcas_args(benchmark::internal::Benchmark* bench)
+    {
+        bench->ArgNames({"words", "mode"});
+        bench->ArgsProduct({{2, 3}, {(int64_t) mcas_mode::MCAS, (int64_t) mcas_mode::CHAINED_CAS}});
+        for (int threads : BENCH_THREAD_COUNTS)
+        {
+            bench->Threads(threads);
+        }
+        bench->UseRealTime();
+    }
+
+    void volatile_structure_args(benchmark::internal::Benchmark* bench)
+    {
+        bench->ArgNames({"structure"});
+        bench->ArgsProduct({{(int64_t) structure_kind::STACK, (int64_t) structure_kind::QUEUE}});
+        for (int threads : BENCH_THREAD_COUNTS)
+        {
+            bench->Threads(threads);
+        }
+        bench->UseRealTime();
+    }
+}
+
+BENCHMARK(persistent_structure_bench)->Apply(persistent_structure_args);
+BENCHMARK(volatile_structure_bench)->Apply(volatile_structure_args);
+BENCHMARK(persistent_hash_map_bench)->Apply(persistent_hash_map_args);
+BENCHMARK(volatile_hash_map_bench)->Apply(thread_count_args);
+BENCHMARK(persistent_skip_list_bench)->Apply(thread_count_args);
+BENCHMARK(volatile_skip_list_bench)->Apply(thread_count_args);
+BENCHMARK(persistent_mcas_bench)->Apply(persistent_mcas_args);
@@ -0,0 +1,112 @@
+#include "gtest/gtest.h"
+#include "../../code/allocation/heap_collector.h"
+#include "../../code/allocation/pmem_allocator.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/runtime/exec_task.h"
+#include "../common/test_utils.h"
+#include <cstring>
+
+namespace
+{
+    const uint64_t NUMBER_OF_BLOCKS = 10;
+
+    /**
+     * Allocates NUMBER_OF_BLOCKS blocks of 1 byte, block with number n is located at offset 2 * n.
+     * @param allocator - new allocator.
+     */
+    void allocate_blocks(pmem_allocator& allocator)
+    {
+        for (uint64_t i = 0; i < NUMBER_OF_BLOCKS; i++)
+        {
+            allocator.pmem_alloc();
+        }
+    }
+}
+
+TEST(heap_collector, leaked_blocks_freed)
+{
+    temp_file file(get_temp_file_name("heap"));
+    persistent_memory_holder heap(file.file_name, false, PMEM_HEAP_SIZE);
+    pmem_allocator allocator(heap.get_pmem_ptr(), 1, 200, true);
+    allocate_blocks(allocator);
+    allocator.pmem_free(heap.get_pmem_ptr() + 8);
+
+    heap_collector collector(allocator, heap.get_pmem_ptr(), {4, 10, 16}, true, 3);
+    collector.run(4);
+    const heap_collection_report report = collector.get_report();
+    EXPECT_EQ(report.scanned_blocks, NUMBER_OF_BLOCKS);
+    EXPECT_EQ(report.live_blocks, 3);
+    EXPECT_EQ(report.leaked_offsets, std::vector<uint64_t>({2, 6, 12, 14, 18, 20}));
+    EXPECT_TRUE(report.leaked_freed);
+
+    for (uint64_t block_num = 1; block_num <= NUMBER_OF_BLOCKS; block_num++)
+    {
+        const uint64_t offset = 2 * block_num;
+        EXPECT_EQ(allocator.is_allocated(heap.get_pmem_ptr() + offset), offset == 4 || offset == 10 || offset == 16);
+    }
+    /*
+     * Leaked blocks at the end of the heap are not allocated anymore
+     */
+    EXPECT_EQ(allocator.get_allocation_border(), 8);
+
+    /*
+     * Collection is durable
+     */
+    pmem_allocator restored_allocator(heap.get_pmem_ptr(), 1, 200, false);
+    EXPECT_EQ(restored_allocator.get_allocation_border(), 8);
+    EXPECT_EQ(
+            restored_allocator.get_allocated_blocks(0, 9),
+            std::vector<uint8_t*>({heap.get_pmem_ptr() + 4, heap.get_pmem_ptr() + 10, heap.get_pmem_ptr() + 16})
+    );
+}
+
+TEST(heap_collector, incremental_report_only)
+{
+    temp_file file(get_temp_file_name("heap"));
+    persistent_memory_holder heap(file.file_name, false, PMEM_HEAP_SIZE);
+    pmem_allocator allocator(heap.get_pmem_ptr(), 1, 200, true);
+    allocate_blocks(allocator);
+
+    /*
+     * Blocks 0-10 are split into 3 chunks
+     */
+    heap_collector collector(allocator, heap.get_pmem_ptr(), {2}, false, 4);
+    EXPECT_THROW(collector.get_report(), std::runtime_error);
+    EXPECT_TRUE(collector.step());
+    EXPECT_TRUE(collector.step());
+    EXPECT_FALSE(collector.is_finished());
+    EXPECT_FALSE(collector.step());
+    EXPECT_TRUE(collector.is_finished());
+    EXPECT_FALSE(collector.step());
+
+    const heap_collection_report report = collector.get_report();
+    EXPECT_EQ(report.live_blocks, 1);
+    EXPECT_EQ(report.leaked_offsets.size(), NUMBER_OF_BLOCKS - 1);
+    EXPECT_FALSE(report.leaked_freed);
+    EXPECT_EQ(allocator.get_allocated_blocks(0, NUMBER_OF_BLOCKS + 1).size(), NUMBER_OF_BLOCKS);
+}
+
+TEST(heap_collector, empty_heap)
+{
+    temp_file file(get_temp_file_name("heap"));
+    persistent_memory_holder heap(file.file_name, false, PMEM_HEAP_SIZE);
+    pmem_allocator allocator(heap.get_pmem_ptr(), 1, 200, true);
+
+    EXPECT_THROW(heap_collector(allocator, heap.get_pmem_ptr(), {}, true, 0), std::runtime_error);
+    heap_collector collector(allocator, heap.get_pmem_ptr(), {}, true);
+    EXPECT_THROW(collector.run(0), std::runtime_error);
+    collector.run(8);
+    EXPECT_EQ(collector.get_report().scanned_blocks, 0);
+    EXPECT_TRUE(collector.get_report().leaked_offsets.empty());
+    EXPECT_EQ(allocator.pmem_alloc(), heap.get_pmem_ptr() + 2);
+}
+
+TEST(heap_collector, task_answer_roots)
+{
+    const uint64_t answer_offset = 1234;
+    std::vector<uint8_t> args(1 + 8 + 8 + 4 + 4 + 8);
+    args[0] = cas_task::CAS_TYPE;
+    std::memcpy(args.data() + 1, &answer_offset, 8);
+    EXPECT_EQ(get_task_answer_offset(stack_frame("exec_task", args)), std::make_optional(answer_offset));
+    EXPECT_EQ(get_task_answer_offset(stack_frame("main_function", std::vector<uint8_t>())), std::nullopt);
+}
@@ -0,0 +1,153 @@
+#include "gtest/gtest.h"
+#include "../../code/allocation/root_directory.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/common/constants_and_types.h"
+#include "../common/test_utils.h"
+#include <cstring>
+
+TEST(root_directory, create_and_find)
+{
+    temp_file file(get_temp_file_name("heap"));
+    persistent_memory_holder heap(file.file_name, false, PMEM_HEAP_SIZE);
+    const heap_layout layout(2, 4);
+    root_directory directory(heap.get_pmem_ptr(), layout, true);
+
+    EXPECT_FALSE(directory.find("register").has_value());
+    const uint64_t register_offset = directory.get_or_create("register", 8);
+    const uint64_t matrix_offset = directory.get_or_create("matrix", 100);
+    EXPECT_EQ(register_offset, layout.get_named_objects_offset());
+    EXPECT_EQ(matrix_offset % CACHE_LINE_SIZE, 0);
+    EXPECT_GE(matrix_offset, register_offset + CACHE_LINE_SIZE);
+    EXPECT_LE(matrix_offset + 100, layout.get_var_offset(0));
+
+    EXPECT_EQ(directory.get_or_create("register", 8), register_offset);
+    const auto object = directory.find("matrix");
+    ASSERT_TRUE(object.has_value());
+    EXPECT_EQ(object->name, "matrix");
+    EXPECT_EQ(object->offset, matrix_offset);
+    EXPECT_EQ(object->size, 100);
+
+    const std::vector<named_object> objects = directory.get_objects();
+    ASSERT_EQ(objects.size(), 2);
+    EXPECT_EQ(objects[0].name, "register");
+    EXPECT_EQ(objects[1].name, "matrix");
+}
+
+TEST(root_directory, invalid_objects)
+{
+    temp_file file(get_temp_file_name("heap"));
+    persistent_memory_holder heap(file.file_name, false, PMEM_HEAP_SIZE);
+    const heap_layout layout(2, 4);
+    root_directory directory(heap.get_pmem_ptr(), layout, true);
+
+    EXPECT_THROW(directory.get_or_create("", 8), std::runtime_error);
+    EXPECT_THROW(directory.get_or_create(std::string(root_directory::MAX_NAME_LENGTH + 1, 'a'), 8),
+                 std::runtime_error);
+    EXPECT_THROW(directory.get_or_create("empty", 0), std::runtime_error);
+    EXPECT_THROW(directory.get_or_create("huge", heap_layout::NAMED_OBJECTS_SIZE + 1), std::runtime_error);
+
+    directory.get_or_create(std::string(root_directory::MAX_NAME_LENGTH, 'a'), 8);
+    EXPECT_THROW(directory.get_or_create(std::string(root_directory::MAX_NAME_LENGTH, 'a'), 16),
+                 std::runtime_error);
+    EXPECT_EQ(directory.get_objects().size(), 1);
+}
+
+TEST(root_directory, too_many_objects)
+{
+    temp_file file(get_temp_file_name("heap"));
+    persistent_memory_holder heap(file.file_name, false, PMEM_HEAP_SIZE);
+    const heap_layout layout(2, 4);
+    root_directory directory(heap.get_pmem_ptr(), layout, true);
+
+    for (uint64_t i = 0; i < heap_layout::MAX_ROOT_ENTRIES; i++)
+    {
+        directory.get_or_create("object_" + std::to_string(i), 1);
+    }
+    EXPECT_THROW(directory.get_or_create("extra", 1), std::runtime_error);
+}
+
+TEST(root_directory, restore)
+{
+    temp_file file(get_temp_file_name("heap"));
+    uint64_t register_offset;
+    uint64_t matrix_offset;
+    {
+        persistent_memory_holder heap(file.file_name, false, PMEM_HEAP_SIZE);
+        const heap_layout layout(2, 4);
+        root_directory directory(heap.get_pmem_ptr(), layout, true);
+        register_offset = directory.get_or_create("register", 8, [&heap](uint64_t offset)
+        {
+            const uint64_t value = 42;
+            std::memcpy(heap.get_pmem_ptr() + offset, &value, 8);
+        });
+        matrix_offset = directory.get_or_create("matrix", 16);
+    }
+    {
+        persistent_memory_holder heap(file.file_name, true, PMEM_HEAP_SIZE);
+        const heap_layout layout(2, 4);
+        root_directory directory(heap.get_pmem_ptr(), layout, false);
+
+        const auto object = directory.find("register");
+        ASSERT_TRUE(object.has_value());
+        EXPECT_EQ(object->offset, register_offset);
+        EXPECT_EQ(object->size, 8);
+        uint64_t value;
+        std::memcpy(&value, heap.get_pmem_ptr() + register_offset, 8);
+        EXPECT_EQ(value, 42);
+
+        bool initialized = false;
+        EXPECT_EQ(directory.get_or_create("matrix", 16, [&initialized](uint64_t)
+        {
+            initialized = true;
+        }), matrix_offset);
+        EXPECT_FALSE(initialized);
+
+        const uint64_t queue_offset = directory.get_or_create("queue", 8);
+        EXPECT_GE(queue_offset, matrix_offset + CACHE_LINE_SIZE);
+    }
+}
+
+TEST(root_directory, uncommitted_object)
+{
+    temp_file file(get_temp_file_name("heap"));
+    uint64_t register_offset;
+    {
+        persistent_memory_holder heap(file.file_name, false, PMEM_HEAP_SIZE);
+        const heap_layout layout(2, 4);
+        root_directory directory(heap.get_pmem_ptr(), layout, true);
+        register_offset = directory.get_or_create("register", 8);
+        /*
+         * Crash during initialization of the object
+         */
+        EXPECT_THROW(directory.get_or_create("matrix", 16, [&heap](uint64_t offset)
+        {
+            heap.get_pmem_ptr()[offset] = 0xFF;
+            throw std::runtime_error("crash");
+        }), std::runtime_error);
+    }
+    {
+        persistent_memory_holder heap(file.file_name, true, PMEM_HEAP_SIZE);
+        const heap_layout layout(2, 4);
+        root_directory directory(heap.get_pmem_ptr(), layout, false);
+
+        EXPECT_TRUE(directory.find("register").has_value());
+        EXPECT_FALSE(directory.find("matrix").has_value());
+        const uint64_t matrix_offset = directory.get_or_create("matrix", 16);
+        EXPECT_EQ(matrix_offset, register_offset + CACHE_LINE_SIZE);
+        EXPECT_EQ(heap.get_pmem_ptr()[matrix_offset], 0);
+        EXPECT_EQ(directory.get_objects().size(), 2);
+    }
+}
+
+TEST(root_directory, different_layout)
+{
+    temp_file file(get_temp_file_name("heap"));
+    {
+        persistent_memory_holder heap(file.file_name, false, PMEM_HEAP_SIZE);
+        root_directory directory(heap.get_pmem_ptr(), heap_layout(2, 4), true);
+    }
+    persistent_memory_holder heap(file.file_name, true, PMEM_HEAP_SIZE);
+    EXPECT_THROW(root_directory(heap.get_pmem_ptr(), heap_layout(4, 4), false), std::runtime_error);
+    EXPECT_THROW(root_directory(heap.get_pmem_ptr(), heap_layout(2, 8), false), std::runtime_error);
+    EXPECT_NO_THROW(root_directory(heap.get_pmem_ptr(), heap_layout(2, 4), false));
+}
@@ -43,3 +43,32 @@ TEST(queue, two_threads)
     EXPECT_TRUE((thread1_elem == 1 && thread2_elem == 2) ||
                 (thread1_elem == 2 && thread2_elem == 1));
 }
+
+TEST(queue, push_all_and_take_all)
+{
+    blocking_queue<int> queue;
+    queue.push_all(std::vector<int>());
+    EXPECT_EQ(queue.size(), 0);
+    queue.push(1);
+    queue.push_all(std::vector<int>({2, 3, 4}));
+    EXPECT_EQ(queue.size(), 4);
+    EXPECT_EQ(queue.take(), 1);
+    EXPECT_EQ(queue.take_all(), std::vector<int>({2, 3, 4}));
+    EXPECT_EQ(queue.size(), 0);
+}
+
+TEST(queue, take_all_waits_for_elements)
+{
+    blocking_queue<int> queue;
+    std::vector<int> taken;
+    std::thread t(
+            [&taken, &queue]()
+            {
+                taken = queue.take_all();
+            }
+    );
+    sleep(1);
+    queue.push_all(std::vector<int>({5, 6}));
+    t.join();
+    EXPECT_EQ(taken, std::vector<int>({5, 6}));
+}
@@ -274,4 +274,26 @@ TEST(pmem_utils, flush_test_partial_fork)
             close(fd);
         }
     }
-}
\ No newline at end of file
+}
+
+TEST(pmem_utils, flush_backend)
+{
+    const flush_backend initial_backend = get_flush_backend();
+#ifdef REAL_NVRAM
+    EXPECT_EQ(initial_backend, flush_backend::PERSIST);
+#else
+    EXPECT_EQ(initial_backend, flush_backend::MSYNC);
+#endif
+
+    temp_file file(get_temp_file_name("heap"));
+    persistent_memory_holder heap(file.file_name, false, PMEM_HEAP_SIZE);
+    for (flush_backend backend : {flush_backend::NONE, flush_backend::PERSIST, flush_backend::MSYNC})
+    {
+        set_flush_backend(backend);
+        EXPECT_EQ(get_flush_backend(), backend);
+        heap.get_pmem_ptr()[0] = 42;
+        pmem_do_flush(heap.get_pmem_ptr(), 1);
+        EXPECT_EQ(heap.get_pmem_ptr()[0], 42);
+    }
+    set_flush_backend(initial_backend);
+}
@@ -0,0 +1,57 @@
+#include "gtest/gtest.h"
+#include "../../code/common/small_buffer.h"
+#include <vector>
+
+TEST(small_buffer, inline_storage)
+{
+    const std::vector<uint8_t> data({1, 3, 3, 7});
+    const small_buffer<uint8_t, 8> buffer(data.data(), data.size());
+    EXPECT_EQ(buffer.size(), 4);
+    EXPECT_EQ(buffer, data);
+    /*
+     * Short sequence is stored inside the object itself
+     */
+    EXPECT_GE((const uint8_t*) buffer.data(), (const uint8_t*) &buffer);
+    EXPECT_LT((const uint8_t*) buffer.data(), (const uint8_t*) &buffer + sizeof(buffer));
+}
+
+TEST(small_buffer, heap_storage)
+{
+    std::vector<uint8_t> data;
+    for (uint8_t i = 0; i < 100; i++)
+    {
+        data.push_back(i);
+    }
+    const small_buffer<uint8_t, 8> buffer(data.data(), data.size());
+    EXPECT_EQ(buffer.size(), 100);
+    EXPECT_EQ(buffer, data);
+}
+
+TEST(small_buffer, copy_and_move)
+{
+    const std::vector<uint8_t> short_data({2, 5, 1, 7});
+    const std::vector<uint8_t> long_data(20, 42);
+    small_buffer<uint8_t, 8> short_buffer(short_data.data(), short_data.size());
+    small_buffer<uint8_t, 8> long_buffer(long_data.data(), long_data.size());
+
+    const small_buffer<uint8_t, 8> short_copy(short_buffer);
+    const small_buffer<uint8_t, 8> long_copy(long_buffer);
+    EXPECT_EQ(short_copy, short_data);
+    EXPECT_EQ(long_copy, long_data);
+    EXPECT_NE(short_copy.data(), short_buffer.data());
+    EXPECT_NE(long_copy.data(), long_buffer.data());
+
+    const small_buffer<uint8_t, 8> short_moved(std::move(short_buffer));
+    const small_buffer<uint8_t, 8> long_moved(std::move(long_buffer));
+    EXPECT_EQ(short_moved, short_data);
+    EXPECT_EQ(long_moved, long_data);
+}
+
+TEST(small_buffer, empty)
+{
+    const std::vector<uint8_t> data;
+    const small_buffer<uint8_t, 8> buffer(data.data(), data.size());
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(buffer, data);
+    EXPECT_NE(buffer, std::vector<uint8_t>({1}));
+}
@@ -0,0 +1,109 @@
+#include "gtest/gtest.h"
+#include "../../tools/inspect/heap_inspector.h"
+#include "../../code/model/heap_layout.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/common/constants_and_types.h"
+#include "../common/test_utils.h"
+
+namespace
+{
+    const uint32_t NUMBER_OF_THREADS = 2;
+    const uint32_t NUMBER_OF_VARS = 4;
+    const uint64_t MAX_NODES = 100;
+}
+
+TEST(heap_inspector, regions_and_objects)
+{
+    temp_file file(get_temp_file_name("heap"));
+    {
+        persistent_memory_holder heap(file.file_name, false, PMEM_HEAP_SIZE);
+        const heap_layout layout(NUMBER_OF_THREADS, NUMBER_OF_VARS);
+        root_directory directory(heap.get_pmem_ptr(), layout, true);
+        pmem_allocator answers(heap.get_pmem_ptr(), heap_layout::ANSWER_BLOCK_SIZE,
+                               layout.get_allocator_max_border(), true);
+        pmem_allocator nodes(heap.get_pmem_ptr() + layout.get_nodes_offset(), heap_layout::NODE_BLOCK_SIZE,
+                             MAX_NODES, true);
+        directory.get_or_create("register", 8);
+        directory.get_or_create("matrix", 100);
+        answers.pmem_alloc();
+        uint8_t* const freed_answer = answers.pmem_alloc();
+        answers.pmem_alloc();
+        answers.pmem_free(freed_answer);
+        nodes.pmem_retire(nodes.pmem_alloc());
+    }
+
+    const persistent_memory_holder heap(file.file_name, true, PMEM_HEAP_SIZE, true);
+    const heap_inspection inspection = inspect_heap(heap.get_pmem_ptr(), true);
+    EXPECT_TRUE(inspection.violations.empty());
+    ASSERT_TRUE(inspection.header.has_value());
+    EXPECT_EQ(inspection.header->number_of_threads, NUMBER_OF_THREADS);
+    EXPECT_EQ(inspection.header->number_of_vars, NUMBER_OF_VARS);
+
+    ASSERT_EQ(inspection.regions.size(), 3);
+    const region_inspection& answers = inspection.regions[0];
+    EXPECT_EQ(answers.allocation_border, 3);
+    EXPECT_EQ(answers.allocated_blocks, 2);
+    EXPECT_EQ(answers.freed_blocks, 1);
+    ASSERT_EQ(answers.blocks.size(), 2);
+    EXPECT_EQ(answers.blocks[0].offset, heap_layout::ANSWER_BLOCK_SIZE + 1);
+    EXPECT_EQ(answers.blocks[1].block_num, 3);
+    EXPECT_EQ(answers.blocks[1].state, block_state::HEAP_END);
+
+    EXPECT_EQ(inspection.regions[1].allocated_blocks, 2);
+    const region_inspection& nodes = inspection.regions[2];
+    EXPECT_EQ(nodes.allocation_border, 1);
+    EXPECT_EQ(nodes.retired_blocks, 1);
+    ASSERT_EQ(nodes.blocks.size(), 1);
+    EXPECT_EQ(nodes.blocks[0].state, block_state::RETIRED_HEAP_END);
+
+    ASSERT_EQ(inspection.objects.size(), 2);
+    EXPECT_EQ(inspection.objects[0].name, "register");
+    EXPECT_EQ(inspection.objects[1].name, "matrix");
+    EXPECT_EQ(inspection.objects[1].size, 100);
+
+    const std::string output = format_heap_inspection(inspection);
+    EXPECT_NE(output.find("heap: threads=2 vars=4"), std::string::npos);
+    EXPECT_NE(output.find("region answers offset=0 block_size=63"), std::string::npos);
+    EXPECT_NE(output.find("object matrix"), std::string::npos);
+}
+
+TEST(heap_inspector, retired_answer)
+{
+    temp_file file(get_temp_file_name("heap"));
+    persistent_memory_holder heap(file.file_name, false, PMEM_HEAP_SIZE);
+    const heap_layout layout(NUMBER_OF_THREADS, NUMBER_OF_VARS);
+    root_directory directory(heap.get_pmem_ptr(), layout, true);
+    pmem_allocator answers(heap.get_pmem_ptr(), heap_layout::ANSWER_BLOCK_SIZE,
+                           layout.get_allocator_max_border(), true);
+    pmem_allocator nodes(heap.get_pmem_ptr() + layout.get_nodes_offset(), heap_layout::NODE_BLOCK_SIZE,
+                         MAX_NODES, true);
+    answers.pmem_retire(answers.pmem_alloc());
+
+    const heap_inspection inspection = inspect_heap(heap.get_pmem_ptr(), false);
+    EXPECT_TRUE(inspection.regions[0].blocks.empty());
+    EXPECT_EQ(inspection.violations, std::vector<std::string>({"1 answer locations are retired"}));
+}
+
+TEST(heap_inspector, corrupted_heap)
+{
+    temp_file file(get_temp_file_name("heap"));
+    persistent_memory_holder heap(file.file_name, false, PMEM_HEAP_SIZE);
+    EXPECT_EQ(
+            inspect_heap(heap.get_pmem_ptr(), false).violations,
+            std::vector<std::string>({"Heap doesn't contain root directory"})
+    );
+
+    const heap_layout layout(NUMBER_OF_THREADS, NUMBER_OF_VARS);
+    root_directory directory(heap.get_pmem_ptr(), layout, true);
+    pmem_allocator answers(heap.get_pmem_ptr(), heap_layout::ANSWER_BLOCK_SIZE,
+                           layout.get_allocator_max_border(), true);
+    pmem_allocator nodes(heap.get_pmem_ptr() + layout.get_nodes_offset(), heap_layout::NODE_BLOCK_SIZE,
+                         MAX_NODES, true);
+    uint8_t* const answer = answers.pmem_alloc();
+    answer[heap_layout::ANSWER_BLOCK_SIZE] = 0x7;
+
+    const heap_inspection inspection = inspect_heap(heap.get_pmem_ptr(), false);
+    ASSERT_EQ(inspection.violations.size(), 1);
+    EXPECT_EQ(inspection.violations[0], "Block 1 of answers region has invalid marker");
+    EXPECT_FALSE(inspection.regions[0].allocation_border.has_value());
+}
@@ -0,0 +1,134 @@
+#include "gtest/gtest.h"
+#include "../../tools/inspect/stack_inspector.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/persistent_stack/persistent_stack.h"
+#include "../../code/common/constants_and_types.h"
+#include "../common/test_utils.h"
+#include <cstring>
+
+namespace
+{
+    /**
+     * Adds three frames to the new stack.
+     * @param r_stack - empty RAM stack.
+     * @param p_stack - new persistent stack.
+     */
+    void add_frames(ram_stack& r_stack, persistent_memory_holder& p_stack)
+    {
+        add_new_frame(r_stack, stack_frame{"main", std::vector<uint8_t>()}, p_stack);
+        add_new_frame(r_stack, stack_frame{"fib", std::vector<uint8_t>({1, 3, 3, 7})}, p_stack);
+        add_new_frame(r_stack, stack_frame{"fib", std::vector<uint8_t>({2, 5})}, p_stack, std::vector<uint8_t>({42}));
+    }
+}
+
+TEST(stack_inspector, frames_decoded)
+{
+    temp_file file(get_temp_file_name("stack"));
+    persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+    ram_stack r_stack;
+    add_frames(r_stack, p_stack);
+
+    const stack_inspection inspection = inspect_stack(p_stack.get_pmem_ptr());
+    EXPECT_TRUE(inspection.violations.empty());
+    ASSERT_EQ(inspection.frames.size(), 3);
+    EXPECT_EQ(inspection.frames[0].function_name, "main");
+    EXPECT_EQ(inspection.frames[0].args_size, 0);
+    EXPECT_EQ(inspection.frames[0].previous_frame_offset, NO_PREVIOUS_FRAME);
+    EXPECT_EQ(inspection.frames[0].end_marker, FRAME_END_MARKER);
+    EXPECT_EQ(inspection.frames[1].function_name, "fib");
+    EXPECT_EQ(std::vector<uint8_t>(inspection.frames[1].args, inspection.frames[1].args + 4),
+              std::vector<uint8_t>({1, 3, 3, 7}));
+    EXPECT_EQ(inspection.frames[1].previous_frame_offset, inspection.frames[0].offset);
+    EXPECT_EQ(inspection.frames[2].previous_frame_offset, inspection.frames[1].offset);
+    EXPECT_EQ(inspection.frames[2].answer[0], 42);
+    EXPECT_EQ(inspection.frames[2].end_marker, STACK_END_MARKER);
+    for (inspected_frame const& frame : inspection.frames)
+    {
+        EXPECT_EQ(frame.offset % CACHE_LINE_SIZE, 0);
+    }
+
+    /*
+     * The last frame is removed by writing stack end marker to the previous one
+     */
+    remove_frame(r_stack, p_stack);
+    const stack_inspection after_removal = inspect_stack(p_stack.get_pmem_ptr());
+    EXPECT_TRUE(after_removal.violations.empty());
+    EXPECT_EQ(after_removal.frames.size(), 2);
+
+    const std::string output = format_stack_inspection(after_removal, "stack_0");
+    EXPECT_NE(output.find("stack stack_0: 2 frames"), std::string::npos);
+    EXPECT_NE(output.find("function=fib args=01030307"), std::string::npos);
+    EXPECT_NE(output.find("end=stack"), std::string::npos);
+}
+
+TEST(stack_inspector, invalid_end_marker)
+{
+    temp_file file(get_temp_file_name("stack"));
+    persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+    ram_stack r_stack;
+    add_frames(r_stack, p_stack);
+    const stack_inspection inspection = inspect_stack(p_stack.get_pmem_ptr());
+    const inspected_frame& frame = inspection.frames[1];
+    const uint64_t end_marker_offset = frame.offset + 8 + 8 + 2 + frame.function_name.size() + 2 + frame.args_size;
+    p_stack.get_pmem_ptr()[end_marker_offset] = 0x7;
+
+    const stack_inspection corrupted = inspect_stack(p_stack.get_pmem_ptr());
+    EXPECT_EQ(corrupted.frames.size(), 2);
+    ASSERT_EQ(corrupted.violations.size(), 1);
+    EXPECT_NE(corrupted.violations[0].find("invalid end marker"), std::string::npos);
+}
+
+TEST(stack_inspector, broken_link)
+{
+    temp_file file(get_temp_file_name("stack"));
+    persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+    ram_stack r_stack;
+    add_frames(r_stack, p_stack);
+    const uint64_t last_frame_offset = inspect_stack(p_stack.get_pmem_ptr()).frames[2].offset;
+    const uint64_t wrong_offset = 12345;
+    std::memcpy(p_stack.get_pmem_ptr() + last_frame_offset + 8, &wrong_offset, 8);
+
+    const stack_inspection corrupted = inspect_stack(p_stack.get_pmem_ptr());
+    EXPECT_EQ(corrupted.frames.size(), 3);
+    ASSERT_FALSE(corrupted.violations.empty());
+    EXPECT_NE(corrupted.violations[0].find("is linked with frame at 12345"), std::string::npos);
+}
+
+TEST(stack_inspector, stack_header)
+{
+    temp_file file(get_temp_file_name("stack"));
+    persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+    ram_stack r_stack;
+    add_frames(r_stack, p_stack);
+    const stack_inspection inspection = inspect_stack(p_stack.get_pmem_ptr());
+
+    /*
+     * Header, that lags behind the last push, is corrected by read_stack
+     */
+    const uint32_t outdated_header[2] = {2, (uint32_t) inspection.frames[1].offset};
+    std::memcpy(p_stack.get_pmem_ptr(), outdated_header, sizeof(outdated_header));
+    const stack_inspection outdated = inspect_stack(p_stack.get_pmem_ptr());
+    EXPECT_TRUE(outdated.violations.empty());
+    EXPECT_EQ(outdated.notes, std::vector<std::string>({"Stack header is outdated by the last operation"}));
+
+    const uint32_t wrong_header[2] = {1, (uint32_t) inspection.frames[2].offset};
+    std::memcpy(p_stack.get_pmem_ptr(), wrong_header, sizeof(wrong_header));
+    EXPECT_EQ(inspect_stack(p_stack.get_pmem_ptr()).violations.size(), 1);
+}
+
+TEST(stack_inspector, read_only_mapping)
+{
+    temp_file file(get_temp_file_name("stack"));
+    EXPECT_THROW(persistent_memory_holder(file.file_name, false, PMEM_STACK_SIZE, true), std::runtime_error);
+    {
+        persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+        ram_stack r_stack;
+        add_frames(r_stack, p_stack);
+    }
+    const persistent_memory_holder p_stack(file.file_name, true, PMEM_STACK_SIZE, true);
+    EXPECT_EQ(inspect_stack(p_stack.get_pmem_ptr()).frames.size(), 3);
+    /*
+     * File must be long enough to be read through the whole mapping
+     */
+    EXPECT_THROW(persistent_memory_holder(file.file_name, true, 2 * PMEM_STACK_SIZE, true), std::runtime_error);
+}
@@ -0,0 +1,207 @@
+#include "gtest/gtest.h"
+#include "../../code/load/load_generator.h"
+#include "../../code/persistent_stack/persistent_stack.h"
+#include "../../code/storage/global_storage.h"
+#include "../../code/storage/global_non_owning_storage.h"
+#include "../../code/model/system_mode.h"
+#include "../../code/model/total_thread_count_holder.h"
+#include "../../code/common/constants_and_types.h"
+#include "../../code/runtime/exec_task.h"
+#include "../common/test_utils.h"
+
+TEST(heap_layout, no_overlap)
+{
+    const uint32_t number_of_threads = 8;
+    const heap_layout layout(number_of_threads, 16);
+    const uint64_t allocator_end = (heap_layout::MAX_ANSWERS + 1) * (heap_layout::ANSWER_BLOCK_SIZE + 1);
+    EXPECT_GE(heap_layout::get_root_directory_offset(), allocator_end);
+    EXPECT_GE(layout.get_named_objects_offset(), heap_layout::get_root_directory_offset() +
+                                                 (heap_layout::MAX_ROOT_ENTRIES + 1) * CACHE_LINE_SIZE);
+    EXPECT_GE(layout.get_var_offset(0), layout.get_named_objects_offset() + heap_layout::NAMED_OBJECTS_SIZE);
+    for (uint32_t var_number = 0; var_number < layout.get_number_of_vars(); var_number++)
+    {
+        EXPECT_EQ(layout.get_var_offset(var_number) % CACHE_LINE_SIZE, 0);
+        EXPECT_EQ(layout.get_thread_matrix_offset(var_number), layout.get_var_offset(var_number) + CACHE_LINE_SIZE);
+        const uint64_t matrix_end = layout.get_thread_matrix_offset(var_number) +
+                                    number_of_threads * number_of_threads * 4;
+        if (var_number + 1 < layout.get_number_of_vars())
+        {
+            EXPECT_LE(matrix_end, layout.get_var_offset(var_number + 1));
+        }
+        else
+        {
+            EXPECT_LE(matrix_end, PMEM_HEAP_SIZE);
+        }
+    }
+    EXPECT_THROW(heap_layout(number_of_threads, 0), std::runtime_error);
+    EXPECT_THROW(heap_layout(number_of_threads, 1000000), std::runtime_error);
+}
+
+TEST(load_report, quantiles)
+{
+    std::vector<std::chrono::nanoseconds> latencies;
+    for (uint32_t i = 1000; i >= 1; i--)
+    {
+        latencies.emplace_back(i);
+    }
+    const task_type_report report(latencies, std::chrono::seconds(2));
+    EXPECT_EQ(report.completed, 1000);
+    EXPECT_DOUBLE_EQ(report.ops_per_second, 500);
+    EXPECT_EQ(report.p50, std::chrono::nanoseconds(500));
+    EXPECT_EQ(report.p99, std::chrono::nanoseconds(990));
+    EXPECT_EQ(report.p999, std::chrono::nanoseconds(999));
+
+    std::vector<std::chrono::nanoseconds> no_latencies;
+    const task_type_report empty_report(no_latencies, std::chrono::seconds(1));
+    EXPECT_EQ(empty_report.completed, 0);
+    EXPECT_EQ(empty_report.p999, std::chrono::nanoseconds(0));
+}
+
+TEST(load_generator, read_only_load)
+{
+    const uint32_t number_of_threads = 4;
+    global_storage<system_mode>::set_object(system_mode::EXECUTION);
+    global_storage<total_thread_count_holder>::emplace_object(number_of_threads);
+
+    temp_file heap_file(get_temp_file_name("heap"));
+    persistent_memory_holder heap(heap_file.file_name, false, PMEM_HEAP_SIZE);
+    global_non_owning_storage<persistent_memory_holder>::ptr = &heap;
+    const heap_layout layout(number_of_threads, 4);
+    init_vars(layout, heap);
+    pmem_allocator allocator(heap.get_pmem_ptr(), heap_layout::ANSWER_BLOCK_SIZE,
+                             layout.get_allocator_max_border(), true);
+
+    std::vector<temp_file> stack_files;
+    std::vector<persistent_memory_holder> persistent_stacks;
+    std::vector<ram_stack> ram_stacks;
+    for (uint32_t i = 0; i < number_of_threads; i++)
+    {
+        stack_files.emplace_back(get_temp_file_name("stack"));
+        persistent_stacks.emplace_back(stack_files.back().file_name, false, PMEM_STACK_SIZE);
+        ram_stacks.emplace_back();
+        add_new_frame(ram_stacks.back(), stack_frame("main_function", std::vector<uint8_t>()), persistent_stacks.back());
+    }
+
+    load_config config;
+    config.cas_ratio = 0;
+    config.zipf_exponent = 1;
+    config.arrival_rate = 2000;
+    config.duration = std::chrono::milliseconds(500);
+    const load_report report = run_load(config, layout, persistent_stacks, ram_stacks, heap, allocator);
+
+    EXPECT_EQ(report.cas.completed, 0);
+    EXPECT_EQ(report.successful_cas, 0);
+    EXPECT_EQ(report.dropped, 0);
+    EXPECT_GT(report.read.completed, 500);
+    EXPECT_LT(report.read.completed, 1500);
+    EXPECT_LE(report.read.p50, report.read.p99);
+    EXPECT_LE(report.read.p99, report.read.p999);
+    EXPECT_GE(report.elapsed, config.duration);
+    for (uint32_t var_number = 0; var_number < layout.get_number_of_vars(); var_number++)
+    {
+        EXPECT_EQ(read_var(layout.get_var_offset(var_number)), 42);
+    }
+
+    config.arrival_rate = 0;
+    EXPECT_THROW(run_load(config, layout, persistent_stacks, ram_stacks, heap, allocator), std::runtime_error);
+}
+
+TEST(load_generator, read_only_load_with_group_commit)
+{
+    const uint32_t number_of_threads = 4;
+    global_storage<system_mode>::set_object(system_mode::EXECUTION);
+    global_storage<total_thread_count_holder>::emplace_object(number_of_threads);
+
+    temp_file heap_file(get_temp_file_name("heap"));
+    persistent_memory_holder heap(heap_file.file_name, false, PMEM_HEAP_SIZE);
+    global_non_owning_storage<persistent_memory_holder>::ptr = &heap;
+    const heap_layout layout(number_of_threads, 4);
+    init_vars(layout, heap);
+    pmem_allocator allocator(heap.get_pmem_ptr(), heap_layout::ANSWER_BLOCK_SIZE,
+                             layout.get_allocator_max_border(), true);
+
+    std::vector<temp_file> stack_files;
+    std::vector<persistent_memory_holder> persistent_stacks;
+    std::vector<ram_stack> ram_stacks;
+    for (uint32_t i = 0; i < number_of_threads; i++)
+    {
+        stack_files.emplace_back(get_temp_file_name("stack"));
+        persistent_stacks.emplace_back(stack_files.back().file_name, false, PMEM_STACK_SIZE);
+        ram_stacks.emplace_back();
+        add_new_frame(ram_stacks.back(), stack_frame("main_function", std::vector<uint8_t>()), persistent_stacks.back());
+    }
+
+    load_config config;
+    config.cas_ratio = 0;
+    config.arrival_rate = 2000;
+    config.duration = std::chrono::milliseconds(500);
+    config.group_commit_interval = std::chrono::milliseconds(2);
+    config.group_commit_batch_size = 16;
+    const load_report report = run_load(config, layout, persistent_stacks, ram_stacks, heap, allocator);
+
+    EXPECT_EQ(report.cas.completed, 0);
+    EXPECT_EQ(report.dropped, 0);
+    EXPECT_GT(report.read.completed, 500);
+    EXPECT_LT(report.read.completed, 1500);
+    EXPECT_LE(report.read.p50, report.read.p99);
+    EXPECT_GE(report.elapsed, config.duration);
+
+    /*
+     * All answer locations have been freed after acknowledgement, therefore next allocation
+     * returns the first block after the reserved one
+     */
+    EXPECT_EQ(allocator.pmem_alloc(), heap.get_pmem_ptr() + heap_layout::ANSWER_BLOCK_SIZE + 1);
+}
+
+TEST(load_generator, read_only_load_with_numa_routing)
+{
+    const uint32_t number_of_threads = 4;
+    global_storage<system_mode>::set_object(system_mode::EXECUTION);
+    global_storage<total_thread_count_holder>::emplace_object(number_of_threads);
+
+    temp_file heap_file(get_temp_file_name("heap"));
+    persistent_memory_holder heap(heap_file.file_name, false, PMEM_HEAP_SIZE);
+    global_non_owning_storage<persistent_memory_holder>::ptr = &heap;
+    const heap_layout layout(number_of_threads, 4);
+    init_vars(layout, heap);
+    pmem_allocator allocator(heap.get_pmem_ptr(), heap_layout::ANSWER_BLOCK_SIZE,
+                             layout.get_allocator_max_border(), true);
+
+    std::vector<temp_file> stack_files;
+    std::vector<persistent_memory_holder> persistent_stacks;
+    std::vector<ram_stack> ram_stacks;
+    for (uint32_t i = 0; i < number_of_threads; i++)
+    {
+        stack_files.emplace_back(get_temp_file_name("stack"));
+        persistent_stacks.emplace_back(stack_files.back().file_name, false, PMEM_STACK_SIZE);
+        ram_stacks.emplace_back();
+        add_new_frame(ram_stacks.back(), stack_frame("main_function", std::vector<uint8_t>()), persistent_stacks.back());
+    }
+
+    /*
+     * Two nodes with all CPUs of the machine, so that routing is exercised on any machine
+     */
+    const numa_topology machine_topology = numa_topology::detect();
+    std::vector<uint32_t> all_cpus;
+    for (uint32_t node_index = 0; node_index < machine_topology.get_number_of_nodes(); node_index++)
+    {
+        all_cpus.insert(all_cpus.end(),
+                        machine_topology.get_node(node_index).cpus.begin(),
+                        machine_topology.get_node(node_index).cpus.end());
+    }
+    load_config config;
+    config.cas_ratio = 0;
+    config.zipf_exponent = 1;
+    config.arrival_rate = 2000;
+    config.duration = std::chrono::milliseconds(500);
+    config.topology = numa_topology(std::vector<numa_node>({numa_node{0, all_cpus}, numa_node{0, all_cpus}}));
+    const load_report report = run_load(config, layout, persistent_stacks, ram_stacks, heap, allocator);
+
+    EXPECT_EQ(report.dropped, 0);
+    EXPECT_GT(report.read.completed, 500);
+    EXPECT_LT(report.read.completed, 1500);
+    for (uint32_t var_number = 0; var_number < layout.get_number_of_vars(); var_number++)
+    {
+        EXPECT_EQ(read_var(layout.get_var_offset(var_number)), 42);
+    }
+}
@@ -0,0 +1,49 @@
+#include "gtest/gtest.h"
+#include "../../code/load/zipf_distribution.h"
+#include <vector>
+
+TEST(zipf_distribution, uniform)
+{
+    const zipf_distribution distribution(4, 0);
+    for (uint32_t key = 0; key < 4; key++)
+    {
+        EXPECT_DOUBLE_EQ(distribution.get_probability(key), 0.25);
+    }
+}
+
+TEST(zipf_distribution, probabilities)
+{
+    const zipf_distribution distribution(3, 1);
+    /*
+     * 1 : 1/2 : 1/3 == 6 : 3 : 2
+     */
+    EXPECT_DOUBLE_EQ(distribution.get_probability(0), 6.0 / 11);
+    EXPECT_DOUBLE_EQ(distribution.get_probability(1), 3.0 / 11);
+    EXPECT_NEAR(distribution.get_probability(2), 2.0 / 11, 1e-12);
+}
+
+TEST(zipf_distribution, generation)
+{
+    const uint32_t n = 10;
+    const uint32_t samples = 100000;
+    const zipf_distribution distribution(n, 0.99);
+    std::mt19937_64 generator(1337);
+    std::vector<uint32_t> counts(n, 0);
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        const uint32_t key = distribution(generator);
+        ASSERT_LT(key, n);
+        counts[key]++;
+    }
+    for (uint32_t key = 0; key < n; key++)
+    {
+        EXPECT_NEAR((double) counts[key] / samples, distribution.get_probability(key), 0.01);
+    }
+    EXPECT_GT(counts[0], counts[n - 1]);
+}
+
+TEST(zipf_distribution, invalid)
+{
+    EXPECT_THROW(zipf_distribution(0, 1), std::runtime_error);
+    EXPECT_THROW(zipf_distribution(10, -1), std::runtime_error);
+}
@@ -0,0 +1,82 @@
+#include "gtest/gtest.h"
+#include "../../code/metrics/flush_profiler.h"
+#include "../../code/common/constants_and_types.h"
+#include "../common/test_utils.h"
+#include "../../code/persistent_stack/persistent_stack.h"
+
+TEST(flush_profiler, redundant_flushes)
+{
+    reset_flush_profile();
+    alignas(64) uint8_t memory[4 * 64] = {};
+
+    profile_flush(memory, 8, flush_site::CAS_VAR);
+    /*
+     * Line hasn't been changed since the previous flush
+     */
+    profile_flush(memory, 8, flush_site::CAS_VAR);
+    memory[3] = 42;
+    profile_flush(memory, 8, flush_site::CAS_VAR);
+
+    const flush_site_profile profile = get_flush_profile()[(uint32_t) flush_site::CAS_VAR];
+    EXPECT_EQ(profile.flushes, 3);
+    EXPECT_EQ(profile.flushed_bytes, 24);
+    EXPECT_EQ(profile.flushed_lines, 3);
+    EXPECT_EQ(profile.distinct_lines, 1);
+    EXPECT_EQ(profile.redundant_lines, 1);
+}
+
+TEST(flush_profiler, ranges_crossing_cache_lines)
+{
+    reset_flush_profile();
+    alignas(64) uint8_t memory[4 * 64] = {};
+
+    profile_flush(memory + 60, 8, flush_site::FRAME);
+    profile_flush(memory, 3 * 64, flush_site::ANSWER);
+
+    const std::array<flush_site_profile, NUMBER_OF_FLUSH_SITES> profile = get_flush_profile();
+    EXPECT_EQ(profile[(uint32_t) flush_site::FRAME].flushed_lines, 2);
+    EXPECT_EQ(profile[(uint32_t) flush_site::FRAME].distinct_lines, 2);
+    EXPECT_EQ(profile[(uint32_t) flush_site::ANSWER].flushed_lines, 3);
+    EXPECT_EQ(profile[(uint32_t) flush_site::ANSWER].distinct_lines, 3);
+    /*
+     * First two lines have been flushed by another site and haven't been changed since then
+     */
+    EXPECT_EQ(profile[(uint32_t) flush_site::ANSWER].redundant_lines, 2);
+}
+
+TEST(flush_profiler, report)
+{
+    std::array<flush_site_profile, NUMBER_OF_FLUSH_SITES> profile;
+    profile[(uint32_t) flush_site::END_MARKER] = flush_site_profile{10, 10, 10, 2, 5};
+    profile[(uint32_t) flush_site::FRAME] = flush_site_profile{10, 640, 20, 4, 0};
+    const std::string report = format_flush_profile(profile);
+
+    /*
+     * Sites are ordered by number of flushed lines
+     */
+    EXPECT_LT(report.find("frame"), report.find("end_marker"));
+    EXPECT_NE(report.find("50.0"), std::string::npos);
+    EXPECT_NE(report.find("64.00"), std::string::npos);
+    EXPECT_NE(report.find("total"), std::string::npos);
+}
+
+#ifdef FLUSH_PROFILING
+TEST(flush_profiler, frame_operations)
+{
+    temp_file file(get_temp_file_name("stack"));
+    persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+    ram_stack r_stack;
+
+    reset_flush_profile();
+    add_new_frame(r_stack, stack_frame("some_function_name", std::vector<uint8_t>({1, 3, 3, 7})), p_stack);
+    add_new_frame(r_stack, stack_frame("another_function_name", std::vector<uint8_t>({2, 5, 1, 7})), p_stack);
+    remove_frame(r_stack, p_stack);
+
+    const std::array<flush_site_profile, NUMBER_OF_FLUSH_SITES> profile = get_flush_profile();
+    EXPECT_EQ(profile[(uint32_t) flush_site::FRAME].flushes, 2);
+    EXPECT_EQ(profile[(uint32_t) flush_site::END_MARKER].flushes, 2);
+#ifdef PERSISTENT_STACK_HEADER
+    EXPECT_EQ(profile[(uint32_t) flush_site::STACK_HEADER].flushes, 3);
+#endif
+}
+#endif
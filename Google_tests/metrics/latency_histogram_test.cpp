@@ -0,0 +1,67 @@
+#include "gtest/gtest.h"
+#include "../../code/metrics/latency_histogram.h"
+#include <cstdint>
+
+TEST(latency_histogram, small_values_are_exact)
+{
+    for (uint64_t value = 0; value < latency_histogram::SUB_BUCKETS; value++)
+    {
+        const uint32_t bucket = latency_histogram::get_bucket(value);
+        EXPECT_EQ(latency_histogram::get_bucket_lower_bound(bucket), value);
+        EXPECT_EQ(latency_histogram::get_bucket_upper_bound(bucket), value);
+    }
+}
+
+TEST(latency_histogram, bucket_bounds)
+{
+    const std::vector<uint64_t> values({16, 17, 31, 32, 33, 1000, 123456789, UINT64_MAX / 3, UINT64_MAX});
+    for (uint64_t value : values)
+    {
+        const uint32_t bucket = latency_histogram::get_bucket(value);
+        ASSERT_LT(bucket, latency_histogram::NUMBER_OF_BUCKETS);
+        EXPECT_LE(latency_histogram::get_bucket_lower_bound(bucket), value);
+        EXPECT_GE(latency_histogram::get_bucket_upper_bound(bucket), value);
+        /*
+         * Relative error is at most 1 / SUB_BUCKETS
+         */
+        const uint64_t bucket_width = latency_histogram::get_bucket_upper_bound(bucket) -
+                                      latency_histogram::get_bucket_lower_bound(bucket);
+        EXPECT_LE(bucket_width, value / latency_histogram::SUB_BUCKETS);
+    }
+}
+
+TEST(latency_histogram, buckets_are_contiguous)
+{
+    for (uint32_t bucket = 0; bucket + 1 < latency_histogram::NUMBER_OF_BUCKETS; bucket++)
+    {
+        ASSERT_EQ(latency_histogram::get_bucket_upper_bound(bucket) + 1,
+                  latency_histogram::get_bucket_lower_bound(bucket + 1));
+        ASSERT_EQ(latency_histogram::get_bucket(latency_histogram::get_bucket_lower_bound(bucket)), bucket);
+    }
+}
+
+TEST(latency_histogram, quantiles)
+{
+    latency_histogram histogram;
+    for (uint64_t value = 1; value <= 1000; value++)
+    {
+        histogram.record(value);
+    }
+    histogram_snapshot snapshot;
+    histogram.add_to(snapshot);
+
+    EXPECT_EQ(snapshot.count, 1000);
+    EXPECT_EQ(snapshot.sum, 500500);
+    EXPECT_EQ(snapshot.max, 1000);
+    EXPECT_DOUBLE_EQ(snapshot.get_mean(), 500.5);
+    EXPECT_NEAR(snapshot.get_value_at_quantile(0.5), 500, 500 / latency_histogram::SUB_BUCKETS);
+    EXPECT_NEAR(snapshot.get_value_at_quantile(0.99), 990, 990 / latency_histogram::SUB_BUCKETS);
+    EXPECT_EQ(snapshot.get_value_at_quantile(1), 1000);
+}
+
+TEST(latency_histogram, empty)
+{
+    const histogram_snapshot snapshot;
+    EXPECT_EQ(snapshot.get_value_at_quantile(0.5), 0);
+    EXPECT_EQ(snapshot.get_mean(), 0);
+}
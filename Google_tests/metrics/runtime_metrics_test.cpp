@@ -0,0 +1,99 @@
+#include "gtest/gtest.h"
+#include "../../code/metrics/runtime_metrics.h"
+#include "../../code/metrics/metrics_export.h"
+#include "../common/test_utils.h"
+#include "../../code/persistent_stack/persistent_stack.h"
+#include "../../code/common/constants_and_types.h"
+#include <thread>
+#include <vector>
+
+TEST(runtime_metrics, aggregation)
+{
+    const metrics_snapshot before = collect_metrics();
+
+    const uint32_t number_of_threads = 4;
+    const uint32_t number_of_iterations = 1000;
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < number_of_threads; i++)
+    {
+        threads.emplace_back(
+                []()
+                {
+                    for (uint32_t j = 0; j < number_of_iterations; j++)
+                    {
+                        increment_counter(metrics_counter::FREES, 2);
+                        record_latency(metrics_histogram::FREE, std::chrono::nanoseconds(j));
+                    }
+                }
+        );
+    }
+    for (std::thread& cur_thread : threads)
+    {
+        cur_thread.join();
+    }
+
+    /*
+     * Metrics of finished threads are not lost
+     */
+    const metrics_snapshot after = collect_metrics();
+    EXPECT_EQ(after.get_counter(metrics_counter::FREES) - before.get_counter(metrics_counter::FREES),
+              2 * number_of_threads * number_of_iterations);
+    EXPECT_EQ(after.get_histogram(metrics_histogram::FREE).count - before.get_histogram(metrics_histogram::FREE).count,
+              number_of_threads * number_of_iterations);
+    EXPECT_GE(after.get_histogram(metrics_histogram::FREE).max, number_of_iterations - 1);
+}
+
+TEST(runtime_metrics, json)
+{
+    metrics_snapshot snapshot;
+    snapshot.counters[(uint32_t) metrics_counter::FLUSHES] = 17;
+    const std::string json = metrics_to_json(snapshot);
+    EXPECT_EQ(json.front(), '{');
+    EXPECT_EQ(json.back(), '}');
+    EXPECT_NE(json.find("\"flushes\": 17"), std::string::npos);
+    EXPECT_NE(json.find("\"queue_wait\": {\"count\": 0"), std::string::npos);
+}
+
+TEST(runtime_metrics, prometheus)
+{
+    metrics_snapshot snapshot;
+    snapshot.counters[(uint32_t) metrics_counter::SUCCESSFUL_CAS] = 5;
+    for (uint64_t latency : {1000, 2000, 3000})
+    {
+        snapshot.histograms[(uint32_t) metrics_histogram::FLUSH].buckets[latency_histogram::get_bucket(latency)]++;
+        snapshot.histograms[(uint32_t) metrics_histogram::FLUSH].count++;
+        snapshot.histograms[(uint32_t) metrics_histogram::FLUSH].sum += latency;
+        snapshot.histograms[(uint32_t) metrics_histogram::FLUSH].max = latency;
+    }
+    const std::string text = metrics_to_prometheus(snapshot);
+    EXPECT_NE(text.find("# TYPE diplom_successful_cas_total counter\ndiplom_successful_cas_total 5\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("# TYPE diplom_flush_seconds summary\n"), std::string::npos);
+    EXPECT_NE(text.find("diplom_flush_seconds_sum 6e-06\n"), std::string::npos);
+    EXPECT_NE(text.find("diplom_flush_seconds_count 3\n"), std::string::npos);
+}
+
+#ifdef RUNTIME_METRICS
+TEST(runtime_metrics, frame_operations)
+{
+    temp_file file(get_temp_file_name("stack"));
+    persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+    ram_stack r_stack;
+
+    const metrics_snapshot before = collect_metrics();
+    add_new_frame(r_stack, stack_frame("some_function_name", std::vector<uint8_t>({1, 3, 3, 7})), p_stack);
+    add_new_frame(r_stack, stack_frame("another_function_name", std::vector<uint8_t>({2, 5, 1, 7})), p_stack);
+    remove_frame(r_stack, p_stack);
+    const metrics_snapshot after = collect_metrics();
+
+    EXPECT_EQ(after.get_counter(metrics_counter::FRAME_PUSHES) - before.get_counter(metrics_counter::FRAME_PUSHES), 2);
+    EXPECT_EQ(after.get_counter(metrics_counter::FRAME_POPS) - before.get_counter(metrics_counter::FRAME_POPS), 1);
+    EXPECT_EQ(after.get_histogram(metrics_histogram::FRAME_PUSH).count -
+              before.get_histogram(metrics_histogram::FRAME_PUSH).count, 2);
+    /*
+     * Each frame push flushes the frame, the end marker of the previous frame (if any) and the header
+     */
+    EXPECT_GE(after.get_counter(metrics_counter::FLUSHES) - before.get_counter(metrics_counter::FLUSHES), 4);
+    EXPECT_GT(after.get_counter(metrics_counter::FLUSHED_BYTES), before.get_counter(metrics_counter::FLUSHED_BYTES));
+}
+#endif
@@ -0,0 +1,68 @@
+#include "gtest/gtest.h"
+#include "../../code/numa/numa_topology.h"
+#include "../../code/model/heap_layout.h"
+#include <stdexcept>
+#include <sched.h>
+
+TEST(numa_topology, parse_cpu_list)
+{
+    EXPECT_EQ(parse_cpu_list("0-3,8,10-11\n"), std::vector<uint32_t>({0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_EQ(parse_cpu_list("5"), std::vector<uint32_t>({5}));
+    EXPECT_EQ(parse_cpu_list("3,1-2,2"), std::vector<uint32_t>({1, 2, 3}));
+    EXPECT_TRUE(parse_cpu_list("\n").empty());
+    EXPECT_THROW(parse_cpu_list("1-"), std::runtime_error);
+    EXPECT_THROW(parse_cpu_list("3-1"), std::runtime_error);
+    EXPECT_THROW(parse_cpu_list("a"), std::runtime_error);
+    EXPECT_THROW(parse_cpu_list("1,,2"), std::runtime_error);
+    EXPECT_THROW(parse_cpu_list("1x"), std::runtime_error);
+}
+
+TEST(numa_topology, construction)
+{
+    EXPECT_THROW(numa_topology(std::vector<numa_node>()), std::runtime_error);
+    EXPECT_THROW(numa_topology(std::vector<numa_node>({numa_node{0, {0}}, numa_node{1, {}}})), std::runtime_error);
+
+    const numa_topology topology = numa_topology::detect();
+    ASSERT_GE(topology.get_number_of_nodes(), 1);
+    for (uint32_t node_index = 0; node_index < topology.get_number_of_nodes(); node_index++)
+    {
+        EXPECT_FALSE(topology.get_node(node_index).cpus.empty());
+    }
+}
+
+TEST(numa_topology, pin_current_thread)
+{
+    cpu_set_t initial_affinity;
+    ASSERT_EQ(sched_getaffinity(0, sizeof(initial_affinity), &initial_affinity), 0);
+    const int cur_cpu = sched_getcpu();
+    ASSERT_GE(cur_cpu, 0);
+    EXPECT_TRUE(pin_current_thread(std::vector<uint32_t>({(uint32_t) cur_cpu})));
+    EXPECT_EQ(sched_getcpu(), cur_cpu);
+    EXPECT_FALSE(pin_current_thread(std::vector<uint32_t>()));
+
+    EXPECT_EQ(sched_setaffinity(0, sizeof(initial_affinity), &initial_affinity), 0);
+}
+
+TEST(heap_layout, var_nodes)
+{
+    const heap_layout layout(4, 10);
+    const uint32_t number_of_nodes = 3;
+    EXPECT_EQ(layout.get_first_var_of_node(0, number_of_nodes), 0);
+    EXPECT_EQ(layout.get_first_var_of_node(number_of_nodes, number_of_nodes), 10);
+    for (uint32_t var_number = 0; var_number < layout.get_number_of_vars(); var_number++)
+    {
+        const uint32_t node = layout.get_var_node(var_number, number_of_nodes);
+        ASSERT_LT(node, number_of_nodes);
+        EXPECT_LE(layout.get_first_var_of_node(node, number_of_nodes), var_number);
+        EXPECT_LT(var_number, layout.get_first_var_of_node(node + 1, number_of_nodes));
+    }
+    EXPECT_EQ(layout.get_var_offset(10) - layout.get_var_offset(9),
+              layout.get_var_offset(1) - layout.get_var_offset(0));
+
+    /*
+     * More nodes, than registers
+     */
+    const heap_layout small_layout(4, 1);
+    EXPECT_EQ(small_layout.get_var_node(0, 2), 1);
+    EXPECT_EQ(small_layout.get_first_var_of_node(1, 2), 0);
+}
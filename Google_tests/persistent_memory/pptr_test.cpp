@@ -0,0 +1,76 @@
+#include "gtest/gtest.h"
+#include "../../code/persistent_memory/pptr.h"
+#include "../../code/common/constants_and_types.h"
+#include "../common/test_utils.h"
+
+struct pptr_test_object
+{
+    uint64_t key;
+    uint32_t value;
+    pptr<pptr_test_object> next;
+};
+
+TEST(pptr, null)
+{
+    const pptr<uint64_t> null_ptr;
+    EXPECT_FALSE(null_ptr);
+    EXPECT_EQ(null_ptr.get_offset(), 0);
+    EXPECT_EQ(null_ptr, pptr<uint64_t>(0));
+    EXPECT_TRUE(pptr<uint64_t>(64));
+}
+
+TEST(pptr, alignment)
+{
+    static_assert(pptr<uint64_t>::is_aligned(64));
+    static_assert(!pptr<uint64_t>::is_aligned(4));
+    static_assert(pptr<uint32_t>::is_aligned(4));
+    static_assert(pptr<uint8_t>::is_aligned(3));
+    static_assert((pptr<uint32_t>(64) + 3).get_offset() == 76);
+    static_assert(pptr<uint64_t>(64).cast<uint32_t>().get_offset() == 64);
+    EXPECT_EQ(sizeof(pptr<pptr_test_object>), 8);
+}
+
+TEST(pptr, dereference)
+{
+    temp_file file(get_temp_file_name("heap"));
+    persistent_memory_holder heap(file.file_name, false, PMEM_HEAP_SIZE);
+    global_non_owning_storage<persistent_memory_holder>::ptr = &heap;
+
+    const pptr<pptr_test_object> first(128);
+    const pptr<pptr_test_object> second(256);
+    EXPECT_EQ((uint8_t*) first.get(), heap.get_pmem_ptr() + 128);
+    EXPECT_EQ(first.get(heap.get_pmem_ptr()), first.get());
+    first->key = 1;
+    first->value = 10;
+    first->next = second;
+    (*second).key = 2;
+
+    EXPECT_EQ(first->next->key, 2);
+    EXPECT_EQ(pptr<pptr_test_object>::from_address(second.get()), second);
+
+    const pptr<uint32_t> values(512);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        values[i] = i;
+    }
+    EXPECT_EQ(*(values + 3), 3);
+    EXPECT_EQ(*pptr<uint32_t>(128 + 8), 10);
+    global_non_owning_storage<persistent_memory_holder>::ptr = nullptr;
+}
+
+TEST(pptr, remap)
+{
+    temp_file file(get_temp_file_name("heap"));
+    const pptr<pptr_test_object> object(1024);
+    {
+        persistent_memory_holder heap(file.file_name, false, PMEM_HEAP_SIZE);
+        global_non_owning_storage<persistent_memory_holder>::ptr = &heap;
+        object->key = 42;
+        object->next = object;
+    }
+    persistent_memory_holder heap(file.file_name, true, PMEM_HEAP_SIZE);
+    global_non_owning_storage<persistent_memory_holder>::ptr = &heap;
+    EXPECT_EQ(object->next->key, 42);
+    EXPECT_EQ((uint8_t*) object->next.get(), heap.get_pmem_ptr() + 1024);
+    global_non_owning_storage<persistent_memory_holder>::ptr = nullptr;
+}
@@ -3,6 +3,7 @@
 #include "gtest/gtest.h"
 #include "../common/test_utils.h"
 #include "../../code/common/constants_and_types.h"
+#include <cstring>
 
 TEST(persistent_stack, add_frame)
 {
@@ -144,3 +145,209 @@ TEST(persistent_stack, add_and_remove_multiple_frames)
     EXPECT_EQ(another_frame_1.get_args(), std::vector<uint8_t>({1, 3, 3, 7}));
 }
 
+
+namespace
+{
+    void add_three_frames(ram_stack& r_stack, persistent_memory_holder& p_stack)
+    {
+        add_new_frame(r_stack, stack_frame("some_function_name", std::vector<uint8_t>({1, 3, 3, 7})), p_stack);
+        add_new_frame(r_stack, stack_frame("another_function_name", std::vector<uint8_t>({2, 5, 1, 7})), p_stack);
+        add_new_frame(r_stack, stack_frame("one_more_function_name", std::vector<uint8_t>({1, 3, 5, 7, 9})), p_stack);
+    }
+
+    void expect_same_stacks(ram_stack expected, ram_stack actual)
+    {
+        EXPECT_EQ(expected.size(), actual.size());
+        EXPECT_EQ(expected.get_stack_end(), actual.get_stack_end());
+        while (expected.size() > 0 && actual.size() > 0)
+        {
+            EXPECT_EQ(expected.get_last_frame().get_position(), actual.get_last_frame().get_position());
+            EXPECT_EQ(expected.get_last_frame().get_frame().get_function_name(),
+                      actual.get_last_frame().get_frame().get_function_name());
+            EXPECT_EQ(expected.get_last_frame().get_frame().get_args(),
+                      actual.get_last_frame().get_frame().get_args());
+            expected.remove_frame();
+            actual.remove_frame();
+        }
+    }
+}
+
+TEST(persistent_stack, read_without_header)
+{
+    temp_file file(get_temp_file_name("stack"));
+
+    persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+    ram_stack r_stack;
+    add_three_frames(r_stack, p_stack);
+    remove_frame(r_stack, p_stack);
+
+    /*
+     * Stack, written without header, is read frame by frame
+     */
+    std::memset(p_stack.get_pmem_ptr(), 0, STACK_HEADER_SIZE);
+    expect_same_stacks(r_stack, read_stack(p_stack));
+}
+
+TEST(persistent_stack, frames_are_not_moved)
+{
+    temp_file file(get_temp_file_name("stack"));
+
+    persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+    ram_stack r_stack;
+    add_new_frame(r_stack, stack_frame("first_function", std::vector<uint8_t>({1, 3, 3, 7})), p_stack);
+    const positioned_frame* const first_frame = &r_stack.get_last_frame();
+
+    /*
+     * Each frame occupies a single cache line, the first cache line is occupied by the header,
+     * frames region ends at the beginning of redo log
+     */
+    while (r_stack.size() < TX_LOG_OFFSET / CACHE_LINE_SIZE - 1)
+    {
+        add_new_frame(r_stack, stack_frame("f", std::vector<uint8_t>({(uint8_t) r_stack.size()})), p_stack);
+    }
+    EXPECT_EQ(first_frame, &r_stack.get_last_frame() - (r_stack.size() - 1));
+    EXPECT_EQ(first_frame->get_frame().get_function_name(), "first_function");
+    expect_same_stacks(r_stack, read_stack(p_stack));
+}
+
+TEST(persistent_stack, frames_region_overflow)
+{
+    temp_file file(get_temp_file_name("stack"));
+
+    persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+    ram_stack r_stack;
+    add_new_frame(r_stack, stack_frame("first_function", std::vector<uint8_t>({1, 3, 3, 7})), p_stack);
+    while (r_stack.size() < TX_LOG_OFFSET / CACHE_LINE_SIZE - 1)
+    {
+        add_new_frame(r_stack, stack_frame("f", std::vector<uint8_t>({(uint8_t) r_stack.size()})), p_stack);
+    }
+    std::vector<uint8_t> log_before(PMEM_STACK_SIZE - TX_LOG_OFFSET);
+    std::memcpy(log_before.data(), p_stack.get_pmem_ptr() + TX_LOG_OFFSET, log_before.size());
+
+    /*
+     * Neither the next frame, nor the frame, that is larger than the frames region, overwrites the redo log
+     */
+    EXPECT_THROW(add_new_frame(r_stack, stack_frame("f", std::vector<uint8_t>({1})), p_stack), std::runtime_error);
+    temp_file another_file(get_temp_file_name("stack"));
+    persistent_memory_holder another_p_stack(another_file.file_name, false, PMEM_STACK_SIZE);
+    ram_stack another_r_stack;
+    EXPECT_THROW(
+            add_new_frame(another_r_stack, stack_frame("f", std::vector<uint8_t>(TX_LOG_OFFSET, 42)), another_p_stack),
+            std::runtime_error
+    );
+    EXPECT_EQ(another_r_stack.size(), 0);
+
+    EXPECT_EQ(r_stack.size(), TX_LOG_OFFSET / CACHE_LINE_SIZE - 1);
+    EXPECT_EQ(std::memcmp(log_before.data(), p_stack.get_pmem_ptr() + TX_LOG_OFFSET, log_before.size()), 0);
+    expect_same_stacks(r_stack, read_stack(p_stack));
+}
+
+TEST(persistent_stack, long_frame)
+{
+    temp_file file(get_temp_file_name("stack"));
+
+    persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+    ram_stack r_stack;
+    const std::string long_name(stack_frame::INLINE_FUNCTION_NAME_SIZE * 2, 'f');
+    const std::vector<uint8_t> long_args(stack_frame::INLINE_ARGS_SIZE * 2, 42);
+    add_new_frame(r_stack, stack_frame("some_function_name", std::vector<uint8_t>({1, 3, 3, 7})), p_stack);
+    add_new_frame(r_stack, stack_frame(long_name, long_args), p_stack);
+
+    EXPECT_EQ(r_stack.get_last_frame().get_frame().get_function_name(), long_name);
+    EXPECT_EQ(r_stack.get_last_frame().get_frame().get_args(), long_args);
+    expect_same_stacks(r_stack, read_stack(p_stack));
+}
+
+#ifdef PERSISTENT_STACK_HEADER
+TEST(persistent_stack, header_contains_last_frame)
+{
+    temp_file file(get_temp_file_name("stack"));
+
+    persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+    ram_stack r_stack;
+    add_three_frames(r_stack, p_stack);
+
+    uint32_t frame_count;
+    uint32_t top_frame_offset;
+    std::memcpy(&frame_count, p_stack.get_pmem_ptr(), 4);
+    std::memcpy(&top_frame_offset, p_stack.get_pmem_ptr() + 4, 4);
+    EXPECT_EQ(frame_count, 3);
+    EXPECT_EQ(top_frame_offset, r_stack.get_last_frame().get_position());
+
+    remove_frame(r_stack, p_stack);
+    std::memcpy(&frame_count, p_stack.get_pmem_ptr(), 4);
+    std::memcpy(&top_frame_offset, p_stack.get_pmem_ptr() + 4, 4);
+    EXPECT_EQ(frame_count, 2);
+    EXPECT_EQ(top_frame_offset, r_stack.get_last_frame().get_position());
+    expect_same_stacks(r_stack, read_stack(p_stack));
+}
+
+TEST(persistent_stack, crash_before_header_update_on_add)
+{
+    temp_file file(get_temp_file_name("stack"));
+
+    persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+    ram_stack r_stack;
+    add_new_frame(r_stack, stack_frame("some_function_name", std::vector<uint8_t>({1, 3, 3, 7})), p_stack);
+    add_new_frame(r_stack, stack_frame("another_function_name", std::vector<uint8_t>({2, 5, 1, 7})), p_stack);
+    uint8_t old_header[8];
+    std::memcpy(old_header, p_stack.get_pmem_ptr(), 8);
+    add_new_frame(r_stack, stack_frame("one_more_function_name", std::vector<uint8_t>({1, 3, 5, 7, 9})), p_stack);
+
+    /*
+     * Crash after end marker update, but before header update
+     */
+    std::memcpy(p_stack.get_pmem_ptr(), old_header, 8);
+    expect_same_stacks(r_stack, read_stack(p_stack));
+}
+
+TEST(persistent_stack, crash_before_header_update_on_remove)
+{
+    temp_file file(get_temp_file_name("stack"));
+
+    persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+    ram_stack r_stack;
+    add_three_frames(r_stack, p_stack);
+    uint8_t old_header[8];
+    std::memcpy(old_header, p_stack.get_pmem_ptr(), 8);
+    remove_frame(r_stack, p_stack);
+
+    /*
+     * Crash after end marker update, but before header update
+     */
+    std::memcpy(p_stack.get_pmem_ptr(), old_header, 8);
+    expect_same_stacks(r_stack, read_stack(p_stack));
+}
+
+TEST(persistent_stack, crash_before_header_update_during_recovery)
+{
+    temp_file file(get_temp_file_name("stack"));
+
+    persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+    ram_stack r_stack;
+    add_new_frame(r_stack, stack_frame("some_function_name", std::vector<uint8_t>({1, 3, 3, 7})), p_stack);
+    uint8_t old_header[8];
+    std::memcpy(old_header, p_stack.get_pmem_ptr(), 8);
+    add_new_frame(r_stack, stack_frame("another_function_name", std::vector<uint8_t>({2, 5, 1, 7})), p_stack);
+
+    /*
+     * Crash after end marker update, but before header update
+     */
+    std::memcpy(p_stack.get_pmem_ptr(), old_header, 8);
+    ram_stack recovered_stack = read_stack(p_stack);
+    expect_same_stacks(r_stack, recovered_stack);
+
+    /*
+     * Recovery adds new frame and crashes at the same point again
+     */
+    repair_stack_header(recovered_stack, p_stack);
+    std::memcpy(old_header, p_stack.get_pmem_ptr(), 8);
+    add_new_frame(
+            recovered_stack,
+            stack_frame("one_more_function_name", std::vector<uint8_t>({1, 3, 5, 7, 9})),
+            p_stack
+    );
+    std::memcpy(p_stack.get_pmem_ptr(), old_header, 8);
+    expect_same_stacks(recovered_stack, read_stack(p_stack));
+}
+#endif
@@ -23,6 +23,20 @@ namespace
     void h(const uint8_t*)
     {
     }
+
+    void inline_caller(const uint8_t*)
+    {
+        const uint8_t args[] = {4, 5, 6};
+        const uint8_t ans_filler[] = {0xFF};
+        const uint8_t new_ans_filler[] = {1, 3, 3, 7};
+        do_call("inline_callee", args, 3, answer_filler(ans_filler, 1), answer_filler(new_ans_filler, 4));
+    }
+
+    void inline_callee(const uint8_t* args)
+    {
+        EXPECT_EQ(std::vector<uint8_t>(args, args + 3), std::vector<uint8_t>({4, 5, 6}));
+        throw std::runtime_error("Crash inside of callee");
+    }
 }
 
 TEST(call, restoration_after_crash)
@@ -68,4 +82,42 @@ TEST(call, restoration_after_crash)
         EXPECT_EQ(f_frame.get_args(), std::vector<uint8_t>({1, 2, 3}));
     };
     restoration();
-}
\ No newline at end of file
+}
+
+TEST(call, call_with_inline_args_and_fillers)
+{
+    temp_file file(get_temp_file_name("stack"));
+    global_storage<function_address_holder>::set_object(function_address_holder());
+    global_storage<function_address_holder>::get_object().funcs["inline_caller"] =
+            std::make_pair(inline_caller, inline_caller);
+    global_storage<function_address_holder>::get_object().funcs["inline_callee"] =
+            std::make_pair(inline_callee, inline_callee);
+    {
+        persistent_memory_holder p_stack(file.file_name, false, PMEM_STACK_SIZE);
+        thread_local_non_owning_storage<persistent_memory_holder>::ptr = &p_stack;
+        thread_local_owning_storage<ram_stack>::set_object(ram_stack());
+        add_new_frame(
+                thread_local_owning_storage<ram_stack>::get_object(),
+                stack_frame("main", std::vector<uint8_t>()),
+                p_stack
+        );
+        const uint8_t args[] = {1, 2, 3};
+        EXPECT_THROW(do_call("inline_caller", args, 3, std::nullopt, std::nullopt), std::runtime_error);
+    }
+
+    persistent_memory_holder p_stack(file.file_name, true, PMEM_STACK_SIZE);
+    ram_stack r_stack = read_stack(p_stack);
+    ASSERT_EQ(r_stack.size(), 3);
+
+    positioned_frame const callee_frame = r_stack.get_last_frame();
+    EXPECT_EQ(callee_frame.get_frame().get_function_name(), "inline_callee");
+    EXPECT_EQ(callee_frame.get_frame().get_args(), std::vector<uint8_t>({4, 5, 6}));
+    const uint8_t* const callee_answer = p_stack.get_pmem_ptr() + callee_frame.get_position();
+    EXPECT_EQ(std::vector<uint8_t>(callee_answer, callee_answer + 4), std::vector<uint8_t>({1, 3, 3, 7}));
+
+    r_stack.remove_frame();
+    positioned_frame const caller_frame = r_stack.get_last_frame();
+    EXPECT_EQ(caller_frame.get_frame().get_function_name(), "inline_caller");
+    EXPECT_EQ(caller_frame.get_frame().get_args(), std::vector<uint8_t>({1, 2, 3}));
+    EXPECT_EQ(p_stack.get_pmem_ptr()[caller_frame.get_position()], 0xFF);
+}
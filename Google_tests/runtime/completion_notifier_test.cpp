@@ -0,0 +1,49 @@
+#include "gtest/gtest.h"
+#include "../../code/runtime/completion_notifier.h"
+#include <stdexcept>
+
+TEST(completion_notifier, zero_batch_size)
+{
+    blocking_queue<task_completion> completion_queue;
+    EXPECT_THROW(completion_notifier(completion_queue, 0), std::runtime_error);
+}
+
+TEST(completion_notifier, batching)
+{
+    blocking_queue<task_completion> completion_queue;
+    completion_notifier notifier(completion_queue, 3);
+
+    notifier.notify(task_completion(0, 1));
+    notifier.notify(task_completion(1, 0));
+    EXPECT_EQ(notifier.pending_count(), 2);
+    EXPECT_EQ(completion_queue.size(), 0);
+
+    notifier.notify(task_completion(2, 42));
+    EXPECT_EQ(notifier.pending_count(), 0);
+    std::vector<task_completion> completions = completion_queue.take_all();
+    ASSERT_EQ(completions.size(), 3);
+    for (uint64_t i = 0; i < completions.size(); i++)
+    {
+        EXPECT_EQ(completions[i].task_id, i);
+    }
+    EXPECT_EQ(completions[2].result, 42);
+
+    notifier.notify(task_completion(3, 24));
+    notifier.flush();
+    completions = completion_queue.take_all();
+    ASSERT_EQ(completions.size(), 1);
+    EXPECT_EQ(completions[0].task_id, 3);
+    EXPECT_EQ(completions[0].result, 24);
+}
+
+TEST(completion_notifier, flush_on_destruction)
+{
+    blocking_queue<task_completion> completion_queue;
+    {
+        completion_notifier notifier(completion_queue, 100);
+        notifier.notify(task_completion(7, 1));
+    }
+    std::vector<task_completion> completions = completion_queue.take_all();
+    ASSERT_EQ(completions.size(), 1);
+    EXPECT_EQ(completions[0].task_id, 7);
+}
@@ -17,6 +17,8 @@
 #include "../../code/persistent_stack/persistent_stack.h"
 #include "../../code/runtime/exec_task.h"
 #include "../../code/runtime/call.h"
+#include <atomic>
+#include <thread>
 
 TEST(exec_task, cas_single_successful)
 {
@@ -568,4 +570,234 @@ TEST(exec_task, cas_successful_after_failed)
             EXPECT_EQ(cur_value, 0);
         }
     }
-}
\ No newline at end of file
+}
+
+TEST(exec_task, volatile_call_of_unregistered_function)
+{
+    global_storage<function_address_holder>::set_object(function_address_holder());
+    global_storage<function_address_holder>::get_object().funcs["cas"] = {cas, cas};
+
+    EXPECT_THROW(do_volatile_call("cas", std::vector<uint8_t>()), std::runtime_error);
+    EXPECT_THROW(do_volatile_call("snapshot_read", std::vector<uint8_t>(4)), std::runtime_error);
+}
+
+TEST(exec_task, snapshot_read_task_without_persistent_frames)
+{
+    temp_file heap_file(get_temp_file_name("heap"));
+    temp_file stack_file(get_temp_file_name("stack"));
+    persistent_memory_holder heap(heap_file.file_name, false, PMEM_HEAP_SIZE);
+    persistent_memory_holder stack(stack_file.file_name, false, PMEM_STACK_SIZE);
+
+    global_non_owning_storage<persistent_memory_holder>::ptr = &heap;
+    thread_local_non_owning_storage<persistent_memory_holder>::ptr = &stack;
+    thread_local_owning_storage<ram_stack>::set_object(ram_stack());
+    global_storage<function_address_holder>::set_object(function_address_holder());
+    global_storage<function_address_holder>::get_object().volatile_funcs["snapshot_read"] = snapshot_read;
+
+    add_new_frame(
+            thread_local_owning_storage<ram_stack>::get_object(),
+            stack_frame("initial_frame", std::vector<uint8_t>()),
+            stack
+    );
+
+    std::vector<uint64_t> var_offsets = {0, CACHE_LINE_SIZE, 3 * CACHE_LINE_SIZE};
+    std::vector<uint32_t> values = {42, 24, 7};
+    for (uint32_t i = 0; i < var_offsets.size(); i++)
+    {
+        uint64_t thread_number_and_value;
+        uint8_t* thread_number_and_value_ptr = (uint8_t*) &thread_number_and_value;
+        uint32_t thread_number = i;
+        std::memcpy(thread_number_and_value_ptr, &thread_number, 4);
+        std::memcpy(thread_number_and_value_ptr + 4, &values[i], 4);
+        std::memcpy(heap.get_pmem_ptr() + var_offsets[i], &thread_number_and_value, 8);
+    }
+
+    std::vector<uint8_t> stack_before(stack.get_pmem_ptr(), stack.get_pmem_ptr() + PMEM_STACK_SIZE);
+    const uint32_t frames_before = thread_local_owning_storage<ram_stack>::get_const_object().size();
+
+    auto result = std::make_shared<std::promise<std::vector<uint32_t>>>();
+    std::future<std::vector<uint32_t>> future = result->get_future();
+    execute_task(snapshot_read_task(var_offsets, result));
+    EXPECT_EQ(future.get(), values);
+
+    auto volatile_result = std::make_shared<std::promise<std::vector<uint8_t>>>();
+    std::future<std::vector<uint8_t>> volatile_future = volatile_result->get_future();
+    std::vector<uint8_t> args(4 + 8);
+    uint32_t vars_count = 1;
+    std::memcpy(args.data(), &vars_count, 4);
+    std::memcpy(args.data() + 4, &var_offsets[1], 8);
+    execute_task(volatile_task("snapshot_read", args, volatile_result));
+    std::vector<uint8_t> volatile_answer = volatile_future.get();
+    ASSERT_EQ(volatile_answer.size(), 4);
+    uint32_t volatile_value;
+    std::memcpy(&volatile_value, volatile_answer.data(), 4);
+    EXPECT_EQ(volatile_value, values[1]);
+
+    /*
+     * Neither frames, nor answers were written to the persistent stack
+     */
+    std::vector<uint8_t> stack_after(stack.get_pmem_ptr(), stack.get_pmem_ptr() + PMEM_STACK_SIZE);
+    EXPECT_EQ(stack_before, stack_after);
+    EXPECT_EQ(thread_local_owning_storage<ram_stack>::get_const_object().size(), frames_before);
+}
+
+TEST(exec_task, read_task_with_answer_location)
+{
+    temp_file heap_file(get_temp_file_name("heap"));
+    temp_file stack_file(get_temp_file_name("stack"));
+    persistent_memory_holder heap(heap_file.file_name, false, PMEM_HEAP_SIZE);
+    persistent_memory_holder stack(stack_file.file_name, false, PMEM_STACK_SIZE);
+
+    global_non_owning_storage<persistent_memory_holder>::ptr = &heap;
+    thread_local_non_owning_storage<persistent_memory_holder>::ptr = &stack;
+    thread_local_owning_storage<ram_stack>::set_object(ram_stack());
+    thread_local_owning_storage<cur_thread_id_holder>::set_object(cur_thread_id_holder(0));
+
+    add_new_frame(
+            thread_local_owning_storage<ram_stack>::get_object(),
+            stack_frame("initial_frame", std::vector<uint8_t>()),
+            stack
+    );
+
+    uint64_t thread_number_and_value;
+    uint8_t* thread_number_and_value_ptr = (uint8_t*) &thread_number_and_value;
+    uint32_t thread_number = 3;
+    uint32_t value = 42;
+    std::memcpy(thread_number_and_value_ptr, &thread_number, 4);
+    std::memcpy(thread_number_and_value_ptr + 4, &value, 4);
+    std::memcpy(heap.get_pmem_ptr(), &thread_number_and_value, 8);
+
+    std::vector<uint8_t> stack_before(stack.get_pmem_ptr(), stack.get_pmem_ptr() + PMEM_STACK_SIZE);
+
+    uint64_t answer_offset = 200;
+    auto completion = std::make_shared<std::promise<uint32_t>>();
+    std::future<uint32_t> future = completion->get_future();
+    execute_task(read_task(0, answer_offset, completion));
+    EXPECT_EQ(future.get(), value);
+
+    uint32_t answer;
+    std::memcpy(&answer, heap.get_pmem_ptr() + answer_offset, 4);
+    EXPECT_EQ(answer, value);
+
+    /*
+     * Read task without answer location doesn't write to the heap
+     */
+    uint64_t other_answer_offset = 300;
+    auto other_completion = std::make_shared<std::promise<uint32_t>>();
+    std::future<uint32_t> other_future = other_completion->get_future();
+    execute_task(read_task(0, std::nullopt, other_completion));
+    EXPECT_EQ(other_future.get(), value);
+    uint32_t other_answer;
+    std::memcpy(&other_answer, heap.get_pmem_ptr() + other_answer_offset, 4);
+    EXPECT_EQ(other_answer, 0);
+
+    std::vector<uint8_t> stack_after(stack.get_pmem_ptr(), stack.get_pmem_ptr() + PMEM_STACK_SIZE);
+    EXPECT_EQ(stack_before, stack_after);
+}
+
+TEST(exec_task, completions_are_reported_after_answers)
+{
+    temp_file heap_file(get_temp_file_name("heap"));
+    temp_file stack_file(get_temp_file_name("stack"));
+    persistent_memory_holder heap(heap_file.file_name, false, PMEM_HEAP_SIZE);
+    persistent_memory_holder stack(stack_file.file_name, false, PMEM_STACK_SIZE);
+
+    global_non_owning_storage<persistent_memory_holder>::ptr = &heap;
+    thread_local_non_owning_storage<persistent_memory_holder>::ptr = &stack;
+    thread_local_owning_storage<ram_stack>::set_object(ram_stack());
+    global_storage<function_address_holder>::set_object(function_address_holder());
+    global_storage<function_address_holder>::get_object().funcs["exec_task"] = {exec_task, exec_task};
+    global_storage<function_address_holder>::get_object().funcs["cas"] = {cas, cas};
+    global_storage<total_thread_count_holder>::set_object(total_thread_count_holder(4));
+    thread_local_owning_storage<cur_thread_id_holder>::set_object(cur_thread_id_holder(1));
+
+    add_new_frame(
+            thread_local_owning_storage<ram_stack>::get_object(),
+            stack_frame("initial_frame", std::vector<uint8_t>()),
+            stack
+    );
+
+    uint64_t initial_thread_number_and_initial_value;
+    uint8_t* initial_thread_number_and_initial_value_ptr = (uint8_t*) &initial_thread_number_and_initial_value;
+    uint32_t initial_thread_number = std::numeric_limits<uint32_t>::max();
+    uint32_t initial_value = 42;
+    std::memcpy(initial_thread_number_and_initial_value_ptr, &initial_thread_number, 4);
+    std::memcpy(initial_thread_number_and_initial_value_ptr + 4, &initial_value, 4);
+    std::memcpy(heap.get_pmem_ptr(), &initial_thread_number_and_initial_value, 8);
+
+    blocking_queue<task_completion> completion_queue;
+    completion_notifier notifier(completion_queue, 2);
+
+    execute_task(cas_task(0, 42, 24, 200, 8, 10), notifier);
+    EXPECT_EQ(notifier.pending_count(), 1);
+    execute_task(cas_task(0, 42, 53, 201, 8, 11), notifier);
+    EXPECT_EQ(notifier.pending_count(), 0);
+    /*
+     * Tasks without ids are not reported
+     */
+    execute_task(cas_task(0, 24, 53, 202, 8), notifier);
+    execute_task(read_task(0, 300, nullptr, 12), notifier);
+    notifier.flush();
+
+    std::vector<task_completion> completions = completion_queue.take_all();
+    ASSERT_EQ(completions.size(), 3);
+    EXPECT_EQ(completions[0].task_id, 10);
+    EXPECT_EQ(completions[0].result, 0x1);
+    EXPECT_EQ(completions[1].task_id, 11);
+    EXPECT_EQ(completions[1].result, 0x0);
+    EXPECT_EQ(completions[2].task_id, 12);
+    EXPECT_EQ(completions[2].result, 53);
+}
+
+TEST(exec_task, snapshot_read_with_aba_writer)
+{
+    temp_file heap_file(get_temp_file_name("heap"));
+    persistent_memory_holder heap(heap_file.file_name, false, PMEM_HEAP_SIZE);
+    global_non_owning_storage<persistent_memory_holder>::ptr = &heap;
+
+    /*
+     * Writer moves registers through states (A, X), (B, X), (B, Y), (B, X), (A, X), ..., therefore each register
+     * regularly returns to the same <thread_id, value> word
+     */
+    auto make_word = [](uint32_t thread_number, uint32_t value)
+    {
+        uint64_t word;
+        std::memcpy((uint8_t*) &word, &thread_number, 4);
+        std::memcpy((uint8_t*) &word + 4, &value, 4);
+        return word;
+    };
+    uint64_t* const first_var = (uint64_t*) heap.get_pmem_ptr();
+    uint64_t* const second_var = (uint64_t*) (heap.get_pmem_ptr() + CACHE_LINE_SIZE);
+    __atomic_store_n(first_var, make_word(1, 10), __ATOMIC_SEQ_CST);
+    __atomic_store_n(second_var, make_word(1, 20), __ATOMIC_SEQ_CST);
+    std::atomic<bool> stopped(false);
+    std::thread writer([&]()
+                       {
+                           while (!stopped.load())
+                           {
+                               __atomic_store_n(first_var, make_word(2, 11), __ATOMIC_SEQ_CST);
+                               __atomic_store_n(second_var, make_word(2, 21), __ATOMIC_SEQ_CST);
+                               __atomic_store_n(second_var, make_word(1, 20), __ATOMIC_SEQ_CST);
+                               __atomic_store_n(first_var, make_word(1, 10), __ATOMIC_SEQ_CST);
+                           }
+                       });
+
+    std::vector<uint8_t> args(4 + 8 * 2);
+    const uint32_t vars_count = 2;
+    const uint64_t var_offsets[] = {0, CACHE_LINE_SIZE};
+    std::memcpy(args.data(), &vars_count, 4);
+    std::memcpy(args.data() + 4, var_offsets, 16);
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        const std::vector<uint8_t> result = snapshot_read(args.data());
+        uint32_t values[2];
+        std::memcpy(values, result.data(), 8);
+        /*
+         * Pair of values is not guaranteed to be atomic, but each value has been held by it's register
+         */
+        EXPECT_TRUE(values[0] == 10 || values[0] == 11);
+        EXPECT_TRUE(values[1] == 20 || values[1] == 21);
+    }
+    stopped.store(true);
+    writer.join();
+}
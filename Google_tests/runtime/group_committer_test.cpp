@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"
+#include "../common/test_utils.h"
+#include "../../code/runtime/group_committer.h"
+#include "../../code/runtime/exec_task.h"
+#include "../../code/common/constants_and_types.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/storage/global_non_owning_storage.h"
+#include "../../code/storage/thread_local_non_owning_storage.h"
+#include "../../code/storage/thread_local_owning_storage.h"
+#include "../../code/model/cur_thread_id_holder.h"
+#include "../../code/persistent_stack/ram_stack.h"
+#include "../../code/persistent_stack/persistent_stack.h"
+#include <cstring>
+#include <stdexcept>
+
+TEST(group_committer, invalid_parameters)
+{
+    blocking_queue<task_completion> completion_queue;
+    EXPECT_THROW(group_committer(completion_queue, std::chrono::nanoseconds(0), 16), std::runtime_error);
+    EXPECT_THROW(group_committer(completion_queue, std::chrono::milliseconds(1), 0), std::runtime_error);
+}
+
+TEST(group_committer, commit_by_interval_and_by_batch_size)
+{
+    temp_file heap_file(get_temp_file_name("heap"));
+    persistent_memory_holder heap(heap_file.file_name, false, PMEM_HEAP_SIZE);
+    blocking_queue<task_completion> completion_queue;
+
+    {
+        group_committer committer(completion_queue, std::chrono::milliseconds(5), 1000);
+        heap.get_pmem_ptr()[0] = 0x1;
+        committer.enqueue(heap.get_pmem_ptr(), 1, task_completion(0, 0x1));
+        committer.enqueue(heap.get_pmem_ptr() + 100, 0, task_completion(1, 42));
+        /*
+         * Answer without completion is flushed, but nothing is acknowledged
+         */
+        committer.enqueue(heap.get_pmem_ptr() + 200, 4, std::nullopt);
+
+        std::vector<task_completion> completions;
+        while (completions.size() < 2)
+        {
+            std::vector<task_completion> cur_completions = completion_queue.take_all();
+            completions.insert(completions.end(), cur_completions.begin(), cur_completions.end());
+        }
+        ASSERT_EQ(completions.size(), 2);
+        EXPECT_EQ(completions[0].task_id, 0);
+        EXPECT_EQ(completions[1].task_id, 1);
+        EXPECT_EQ(completions[1].result, 42);
+    }
+
+    /*
+     * Commit interval is too long, batch is committed, because it is full
+     */
+    group_committer committer(completion_queue, std::chrono::seconds(100), 2);
+    committer.enqueue(heap.get_pmem_ptr(), 1, task_completion(2, 0x1));
+    committer.enqueue(heap.get_pmem_ptr() + 64, 1, task_completion(3, 0x0));
+    std::vector<task_completion> completions = completion_queue.take_all();
+    ASSERT_EQ(completions.size(), 2);
+    EXPECT_EQ(completions[0].task_id, 2);
+    EXPECT_EQ(completions[1].task_id, 3);
+
+    /*
+     * Stop commits the rest of enqueued answers
+     */
+    committer.enqueue(heap.get_pmem_ptr(), 1, task_completion(4, 0x1));
+    committer.stop();
+    EXPECT_EQ(completion_queue.size(), 1);
+    EXPECT_THROW(committer.enqueue(heap.get_pmem_ptr(), 1, task_completion(5, 0x1)), std::runtime_error);
+    committer.stop();
+}
+
+TEST(group_committer, read_task_answer)
+{
+    temp_file heap_file(get_temp_file_name("heap"));
+    temp_file stack_file(get_temp_file_name("stack"));
+    persistent_memory_holder heap(heap_file.file_name, false, PMEM_HEAP_SIZE);
+    persistent_memory_holder stack(stack_file.file_name, false, PMEM_STACK_SIZE);
+    global_non_owning_storage<persistent_memory_holder>::ptr = &heap;
+    thread_local_non_owning_storage<persistent_memory_holder>::ptr = &stack;
+    thread_local_owning_storage<ram_stack>::set_object(ram_stack());
+    thread_local_owning_storage<cur_thread_id_holder>::set_object(cur_thread_id_holder(0));
+
+    uint64_t thread_number_and_value;
+    uint8_t* thread_number_and_value_ptr = (uint8_t*) &thread_number_and_value;
+    uint32_t thread_number = 1;
+    uint32_t value = 24;
+    std::memcpy(thread_number_and_value_ptr, &thread_number, 4);
+    std::memcpy(thread_number_and_value_ptr + 4, &value, 4);
+    std::memcpy(heap.get_pmem_ptr(), &thread_number_and_value, 8);
+
+    blocking_queue<task_completion> completion_queue;
+    group_committer committer(completion_queue, std::chrono::milliseconds(1), 16);
+    execute_task(read_task(0, 256, nullptr, 7), committer);
+    /*
+     * Task without id is committed, but not acknowledged
+     */
+    execute_task(read_task(0, 320), committer);
+    committer.stop();
+
+    std::vector<task_completion> completions = completion_queue.take_all();
+    ASSERT_EQ(completions.size(), 1);
+    EXPECT_EQ(completions[0].task_id, 7);
+    EXPECT_EQ(completions[0].result, value);
+    uint32_t answer;
+    std::memcpy(&answer, heap.get_pmem_ptr() + 256, 4);
+    EXPECT_EQ(answer, value);
+    std::memcpy(&answer, heap.get_pmem_ptr() + 320, 4);
+    EXPECT_EQ(answer, value);
+    EXPECT_EQ(thread_local_non_owning_storage<group_committer>::ptr, nullptr);
+}
@@ -0,0 +1,138 @@
+#include "gtest/gtest.h"
+#include "../../code/persistent_stack/persistent_stack.h"
+#include "../../code/model/system_mode.h"
+#include "../../code/model/function_address_holder.h"
+#include "../../code/model/cur_thread_id_holder.h"
+#include "../../code/storage/global_storage.h"
+#include "../common/test_utils.h"
+#include "../../code/runtime/parallel_restoration.h"
+#include "../../code/runtime/call.h"
+#include <atomic>
+#include <set>
+
+namespace
+{
+    std::atomic<uint32_t> inner_recovered(0);
+    std::atomic<uint32_t> failing_recovered(0);
+    std::vector<uint32_t> recovered_thread_ids(8, 0);
+
+    void outer(uint8_t const*)
+    {
+        do_call("inner", std::vector<uint8_t>());
+    }
+
+    void inner(uint8_t const*)
+    {
+        throw std::runtime_error("ha-ha, system crash go brrrrr");
+    }
+
+    void outer_recover(uint8_t const*)
+    {}
+
+    void inner_recover(uint8_t const*)
+    {
+        uint32_t cur_thread_id = thread_local_owning_storage<cur_thread_id_holder>::get_const_object().cur_thread_id;
+        recovered_thread_ids[cur_thread_id]++;
+        inner_recovered++;
+    }
+
+    void failing(uint8_t const*)
+    {
+        throw std::runtime_error("ha-ha, system crash go brrrrr");
+    }
+
+    void failing_recover(uint8_t const*)
+    {
+        failing_recovered++;
+        throw std::runtime_error("ha-ha, repeatable crash go brrrr");
+    }
+
+    void crash_stacks(std::vector<persistent_memory_holder>& stacks, std::string const& function_name)
+    {
+        for (persistent_memory_holder& cur_stack: stacks)
+        {
+            thread_local_owning_storage<ram_stack>::set_object(ram_stack());
+            thread_local_non_owning_storage<persistent_memory_holder>::ptr = &cur_stack;
+            add_new_frame(
+                    thread_local_owning_storage<ram_stack>::get_object(),
+                    stack_frame("main_function", std::vector<uint8_t>()),
+                    cur_stack
+            );
+            try
+            {
+                do_call(function_name, std::vector<uint8_t>());
+            }
+            catch (...)
+            {}
+        }
+    }
+}
+
+TEST(parallel_restoration, all_stacks_restored)
+{
+    const uint32_t number_of_stacks = 8;
+    std::vector<temp_file> stack_files;
+    std::vector<persistent_memory_holder> stacks;
+    for (uint32_t i = 0; i < number_of_stacks; ++i)
+    {
+        stack_files.emplace_back(get_temp_file_name("stack-" + std::to_string(i)));
+        stacks.emplace_back(stack_files.back().file_name, false, PMEM_STACK_SIZE);
+    }
+
+    global_storage<function_address_holder>::set_object(function_address_holder());
+    global_storage<function_address_holder>::get_object().funcs["outer"] = {outer, outer_recover};
+    global_storage<function_address_holder>::get_object().funcs["inner"] = {inner, inner_recover};
+    global_storage<system_mode>::set_object(system_mode::EXECUTION);
+    crash_stacks(stacks, "outer");
+
+    global_storage<system_mode>::set_object(system_mode::RECOVERY);
+    std::set<uint32_t> reported_stacks;
+    std::vector<ram_stack> ram_stacks;
+    restoration_report report = do_parallel_restoration(
+            stacks,
+            ram_stacks,
+            3,
+            [&reported_stacks](stack_restoration_report const& stack_report)
+            {
+                reported_stacks.insert(stack_report.stack_number);
+            }
+    );
+
+    EXPECT_EQ(inner_recovered, number_of_stacks);
+    EXPECT_EQ(reported_stacks.size(), number_of_stacks);
+    EXPECT_EQ(report.stacks.size(), number_of_stacks);
+    EXPECT_EQ(report.get_total_restored_frames(), 2 * number_of_stacks);
+    for (uint32_t i = 0; i < number_of_stacks; ++i)
+    {
+        EXPECT_EQ(recovered_thread_ids[i], 1);
+        EXPECT_EQ(report.stacks[i].stack_number, i);
+        EXPECT_EQ(report.stacks[i].restored_frames, 2);
+        EXPECT_LE(report.stacks[i].duration, report.total_duration);
+        EXPECT_EQ(read_stack(stacks[i]).size(), 1);
+        EXPECT_EQ(ram_stacks[i].size(), 1);
+        EXPECT_EQ(ram_stacks[i].get_last_frame().get_frame().get_function_name(), "main_function");
+    }
+}
+
+TEST(parallel_restoration, exception_is_rethrown)
+{
+    const uint32_t number_of_stacks = 4;
+    std::vector<temp_file> stack_files;
+    std::vector<persistent_memory_holder> stacks;
+    for (uint32_t i = 0; i < number_of_stacks; ++i)
+    {
+        stack_files.emplace_back(get_temp_file_name("stack-" + std::to_string(i)));
+        stacks.emplace_back(stack_files.back().file_name, false, PMEM_STACK_SIZE);
+    }
+
+    global_storage<function_address_holder>::set_object(function_address_holder());
+    global_storage<function_address_holder>::get_object().funcs["failing"] = {failing, failing_recover};
+    global_storage<system_mode>::set_object(system_mode::EXECUTION);
+    crash_stacks(stacks, "failing");
+
+    global_storage<system_mode>::set_object(system_mode::RECOVERY);
+    std::vector<ram_stack> ram_stacks;
+    EXPECT_THROW(do_parallel_restoration(stacks, ram_stacks, 2), std::runtime_error);
+    EXPECT_EQ(failing_recovered, number_of_stacks);
+    EXPECT_THROW(do_parallel_restoration(stacks, ram_stacks, 0), std::runtime_error);
+}
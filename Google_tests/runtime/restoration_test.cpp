@@ -6,6 +6,7 @@
 #include "../common/test_utils.h"
 #include "../../code/runtime/restoration.h"
 #include "../../code/runtime/call.h"
+#include "../../code/runtime/answer.h"
 
 namespace
 {
@@ -162,4 +163,54 @@ TEST(restoration, repeatable_crashes)
     EXPECT_EQ(b_executed, 1);
     EXPECT_EQ(c_executed, 1);
     EXPECT_EQ(d_executed, 1);
-}
\ No newline at end of file
+}
+
+namespace
+{
+    bool resumed_function_executed = false;
+
+    void resumed_function(uint8_t const*)
+    {
+        resumed_function_executed = true;
+        write_answer(std::vector<uint8_t>({0x7}));
+    }
+}
+
+TEST(restoration, resume_execution)
+{
+    temp_file stack_file(get_temp_file_name("stack"));
+    persistent_memory_holder stack(stack_file.file_name, false, PMEM_STACK_SIZE);
+
+    global_storage<function_address_holder>::set_object(function_address_holder());
+    global_storage<function_address_holder>::get_object().funcs["g"] = {g, g_recover};
+    global_storage<function_address_holder>::get_object().funcs["h"] = {h, h_recover};
+    global_storage<function_address_holder>::get_object().funcs["resumed"] = {resumed_function, resumed_function};
+
+    thread_local_owning_storage<ram_stack>::set_object(ram_stack());
+    thread_local_non_owning_storage<persistent_memory_holder>::ptr = &stack;
+    add_new_frame(
+            thread_local_owning_storage<ram_stack>::get_object(),
+            stack_frame("main_function", std::vector<uint8_t>()),
+            stack
+    );
+    global_storage<system_mode>::set_object(system_mode::EXECUTION);
+
+    try
+    {
+        do_call("g", std::vector<uint8_t>());
+    }
+    catch (...)
+    {}
+
+    thread_local_owning_storage<ram_stack>::set_object(ram_stack());
+    global_storage<system_mode>::set_object(system_mode::RECOVERY);
+    EXPECT_EQ(do_restoration(stack), 2);
+    EXPECT_EQ(thread_local_owning_storage<ram_stack>::get_const_object().size(), 1);
+
+    global_storage<system_mode>::set_object(system_mode::EXECUTION);
+    do_call("resumed", std::vector<uint8_t>());
+    EXPECT_TRUE(resumed_function_executed);
+    EXPECT_EQ(read_answer(1), std::vector<uint8_t>({0x7}));
+    EXPECT_EQ(thread_local_owning_storage<ram_stack>::get_const_object().size(), 1);
+    EXPECT_EQ(read_stack(stack).size(), 1);
+}
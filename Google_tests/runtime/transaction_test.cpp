@@ -0,0 +1,269 @@
+#include "gtest/gtest.h"
+#include "../common/test_utils.h"
+#include "../../code/common/constants_and_types.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/persistent_stack/persistent_stack.h"
+#include "../../code/storage/global_storage.h"
+#include "../../code/storage/global_non_owning_storage.h"
+#include "../../code/storage/thread_local_non_owning_storage.h"
+#include "../../code/storage/thread_local_owning_storage.h"
+#include "../../code/model/function_address_holder.h"
+#include "../../code/model/system_mode.h"
+#include "../../code/runtime/restoration.h"
+#include "../../code/runtime/call.h"
+#include "../../code/runtime/answer.h"
+#include "../../code/runtime/transaction.h"
+#include "../../code/metrics/runtime_metrics.h"
+#include <cstring>
+
+namespace
+{
+    const uint64_t FROM_OFFSET = 0;
+    const uint64_t TO_OFFSET = 64;
+    const uint32_t INITIAL_BALANCE = 100;
+    const uint32_t AMOUNT = 10;
+
+    const uint8_t NOT_TRANSFERRED = 0x0;
+    const uint8_t TRANSFERRED = 0x1;
+
+    bool crash_before_commit = false;
+    uint32_t transfer_executions = 0;
+
+    uint32_t read_balance(uint64_t offset)
+    {
+        uint32_t balance;
+        std::memcpy(&balance, global_non_owning_storage<persistent_memory_holder>::ptr->get_pmem_ptr() + offset, 4);
+        return balance;
+    }
+
+    std::vector<uint8_t> to_bytes(uint32_t value)
+    {
+        std::vector<uint8_t> bytes(4);
+        std::memcpy(bytes.data(), &value, 4);
+        return bytes;
+    }
+
+    uint32_t from_bytes(std::vector<uint8_t> const& bytes)
+    {
+        uint32_t value;
+        std::memcpy(&value, bytes.data(), 4);
+        return value;
+    }
+
+    /*
+     * Moves AMOUNT from one balance to another and writes TRANSFERRED as answer in a single transaction
+     */
+    void transfer(uint8_t const*)
+    {
+        transfer_executions++;
+        uint8_t* const heap = global_non_owning_storage<persistent_memory_holder>::ptr->get_pmem_ptr();
+        tx_begin();
+        tx_write(heap + FROM_OFFSET, to_bytes(from_bytes(tx_read(heap + FROM_OFFSET, 4)) - AMOUNT));
+        tx_write(heap + TO_OFFSET, to_bytes(from_bytes(tx_read(heap + TO_OFFSET, 4)) + AMOUNT));
+        tx_write_answer({TRANSFERRED});
+        if (crash_before_commit)
+        {
+            throw std::runtime_error("ha-ha, system crash go brrrrr");
+        }
+        tx_commit();
+    }
+
+    void transfer_recover(uint8_t const* args)
+    {
+        if (read_current_answer(1)[0] == TRANSFERRED)
+        {
+            return;
+        }
+        transfer(args);
+    }
+
+    /**
+     * Heap with two balances and stack of the current thread, containing only the first frame.
+     */
+    struct transaction_test_env
+    {
+        temp_file heap_file;
+        temp_file stack_file;
+        persistent_memory_holder heap;
+        persistent_memory_holder stack;
+
+        transaction_test_env() :
+                heap_file(get_temp_file_name("heap")),
+                stack_file(get_temp_file_name("stack")),
+                heap(heap_file.file_name, false, PMEM_HEAP_SIZE),
+                stack(stack_file.file_name, false, PMEM_STACK_SIZE)
+        {
+            global_non_owning_storage<persistent_memory_holder>::ptr = &heap;
+            thread_local_non_owning_storage<persistent_memory_holder>::ptr = &stack;
+            thread_local_owning_storage<ram_stack>::set_object(ram_stack());
+            add_new_frame(
+                    thread_local_owning_storage<ram_stack>::get_object(),
+                    stack_frame("main_function", std::vector<uint8_t>()),
+                    stack
+            );
+            global_storage<function_address_holder>::set_object(function_address_holder());
+            global_storage<function_address_holder>::get_object().funcs["transfer"] = {transfer, transfer_recover};
+            global_storage<system_mode>::set_object(system_mode::EXECUTION);
+            std::memcpy(heap.get_pmem_ptr() + FROM_OFFSET, &INITIAL_BALANCE, 4);
+            std::memcpy(heap.get_pmem_ptr() + TO_OFFSET, &INITIAL_BALANCE, 4);
+            crash_before_commit = false;
+            transfer_executions = 0;
+        }
+
+        ~transaction_test_env()
+        {
+            global_non_owning_storage<persistent_memory_holder>::ptr = nullptr;
+        }
+
+        void restore()
+        {
+            global_storage<system_mode>::set_object(system_mode::RECOVERY);
+            do_restoration(stack);
+            global_storage<system_mode>::set_object(system_mode::EXECUTION);
+        }
+    };
+}
+
+TEST(transaction, writes_applied_on_commit)
+{
+    transaction_test_env env;
+    uint8_t* const heap = env.heap.get_pmem_ptr();
+
+    tx_begin();
+    tx_write(heap + FROM_OFFSET, to_bytes(1));
+    tx_write(heap + FROM_OFFSET + 1, {0x2});
+    EXPECT_EQ(from_bytes(tx_read(heap + FROM_OFFSET, 4)), 0x201);
+    EXPECT_EQ(read_balance(FROM_OFFSET), INITIAL_BALANCE);
+    tx_commit();
+    EXPECT_EQ(read_balance(FROM_OFFSET), 0x201);
+
+    do_call("transfer", std::vector<uint8_t>(), std::vector<uint8_t>({NOT_TRANSFERRED}));
+    EXPECT_EQ(read_answer(1)[0], TRANSFERRED);
+    EXPECT_EQ(read_balance(FROM_OFFSET), 0x201 - AMOUNT);
+    EXPECT_EQ(read_balance(TO_OFFSET), INITIAL_BALANCE + AMOUNT);
+}
+
+#ifdef RUNTIME_METRICS
+TEST(transaction, drains_per_commit)
+{
+    transaction_test_env env;
+    uint8_t* const heap = env.heap.get_pmem_ptr();
+    for (uint32_t number_of_writes : {1, 2, 16})
+    {
+        tx_begin();
+        for (uint32_t i = 0; i < number_of_writes; i++)
+        {
+            tx_write(heap + FROM_OFFSET + 8 * i, to_bytes(i));
+        }
+        const metrics_snapshot before = collect_metrics();
+        tx_commit();
+        const metrics_snapshot after = collect_metrics();
+        /*
+         * Commit of the log, writes to memory and clearing of the log
+         */
+        EXPECT_EQ(after.get_counter(metrics_counter::DRAINS) - before.get_counter(metrics_counter::DRAINS), 3);
+    }
+
+    tx_begin();
+    const metrics_snapshot before = collect_metrics();
+    tx_commit();
+    EXPECT_EQ(collect_metrics().get_counter(metrics_counter::DRAINS), before.get_counter(metrics_counter::DRAINS));
+}
+#endif
+
+TEST(transaction, writes_discarded_on_abort)
+{
+    transaction_test_env env;
+    uint8_t* const heap = env.heap.get_pmem_ptr();
+
+    tx_begin();
+    tx_write(heap + TO_OFFSET, to_bytes(0));
+    tx_abort();
+    EXPECT_EQ(read_balance(TO_OFFSET), INITIAL_BALANCE);
+    EXPECT_FALSE(recover_transaction(env.stack));
+    EXPECT_EQ(read_balance(TO_OFFSET), INITIAL_BALANCE);
+}
+
+TEST(transaction, invalid_usage)
+{
+    transaction_test_env env;
+    uint8_t* const heap = env.heap.get_pmem_ptr();
+    uint8_t outside = 0;
+
+    EXPECT_THROW(tx_write(heap, {0x1}), std::runtime_error);
+    EXPECT_THROW(tx_commit(), std::runtime_error);
+    tx_begin();
+    EXPECT_THROW(tx_begin(), std::runtime_error);
+    EXPECT_THROW(tx_write(heap, std::vector<uint8_t>()), std::runtime_error);
+    EXPECT_THROW(tx_write(heap, std::vector<uint8_t>(9)), std::runtime_error);
+    EXPECT_THROW(tx_write(&outside, {0x1}), std::runtime_error);
+    /*
+     * Redo log itself cannot be written by transaction
+     */
+    EXPECT_THROW(tx_write(env.stack.get_pmem_ptr() + TX_LOG_OFFSET, {0x1}), std::runtime_error);
+    EXPECT_THROW(tx_write_answer({0x1}), std::runtime_error);
+    for (uint32_t i = 0; i < TX_MAX_WRITES; i++)
+    {
+        tx_write(heap + i, {0x1});
+    }
+    EXPECT_THROW(tx_write(heap, {0x1}), std::runtime_error);
+    tx_abort();
+    EXPECT_EQ(read_balance(FROM_OFFSET), INITIAL_BALANCE);
+}
+
+TEST(transaction, uncommitted_rolled_back)
+{
+    transaction_test_env env;
+    crash_before_commit = true;
+    try
+    {
+        do_call("transfer", std::vector<uint8_t>(), std::vector<uint8_t>({NOT_TRANSFERRED}));
+    }
+    catch (...)
+    {}
+    EXPECT_EQ(read_balance(FROM_OFFSET), INITIAL_BALANCE);
+
+    crash_before_commit = false;
+    env.restore();
+    EXPECT_EQ(transfer_executions, 2);
+    EXPECT_EQ(read_answer(1)[0], TRANSFERRED);
+    EXPECT_EQ(read_balance(FROM_OFFSET), INITIAL_BALANCE - AMOUNT);
+    EXPECT_EQ(read_balance(TO_OFFSET), INITIAL_BALANCE + AMOUNT);
+}
+
+TEST(transaction, committed_replayed)
+{
+    transaction_test_env env;
+    do_call("transfer", std::vector<uint8_t>(), std::vector<uint8_t>({NOT_TRANSFERRED}));
+
+    /*
+     * Simulate the crash after the log has become durable, but before the writes have been applied:
+     * restore number of entries of the cleared log (two balances and answer) and old memory
+     */
+    uint8_t* const log = env.stack.get_pmem_ptr() + TX_LOG_OFFSET;
+    const uint32_t number_of_entries = 3;
+    std::memcpy(log + 8, &number_of_entries, 4);
+    std::memcpy(env.heap.get_pmem_ptr() + FROM_OFFSET, &INITIAL_BALANCE, 4);
+    std::memcpy(env.heap.get_pmem_ptr() + TO_OFFSET, &INITIAL_BALANCE, 4);
+    const uint64_t answer_offset = thread_local_owning_storage<ram_stack>::get_object().get_last_frame().get_position();
+    env.stack.get_pmem_ptr()[answer_offset] = NOT_TRANSFERRED;
+
+    EXPECT_TRUE(recover_transaction(env.stack));
+    EXPECT_EQ(read_answer(1)[0], TRANSFERRED);
+    EXPECT_EQ(read_balance(FROM_OFFSET), INITIAL_BALANCE - AMOUNT);
+    EXPECT_EQ(read_balance(TO_OFFSET), INITIAL_BALANCE + AMOUNT);
+    /*
+     * Log is cleared after replay
+     */
+    EXPECT_FALSE(recover_transaction(env.stack));
+
+    /*
+     * Torn log (checksum doesn't match entries) is discarded
+     */
+    std::memcpy(log + 8, &number_of_entries, 4);
+    log[16 + 8] ^= 0xFF;
+    std::memcpy(env.heap.get_pmem_ptr() + FROM_OFFSET, &INITIAL_BALANCE, 4);
+    EXPECT_FALSE(recover_transaction(env.stack));
+    EXPECT_EQ(read_balance(FROM_OFFSET), INITIAL_BALANCE);
+    EXPECT_EQ(transfer_executions, 1);
+}
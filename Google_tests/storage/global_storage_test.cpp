@@ -2,6 +2,8 @@
 #include "../../code/storage/global_storage.h"
 #include <functional>
 #include <thread>
+#include <memory>
+#include <vector>
 
 TEST(global_storage, get_without_set)
 {
@@ -53,4 +55,21 @@ TEST(global_storage, multiple_threads)
     std::thread t2(thread_action);
     t1.join();
     t2.join();
-}
\ No newline at end of file
+}
+
+TEST(global_storage, set_moves_object)
+{
+    std::vector<int> v({1, 3, 3, 7});
+    const int* const data = v.data();
+    global_storage<std::vector<int>>::set_object(std::move(v));
+    EXPECT_EQ(global_storage<std::vector<int>>::get_const_object().data(), data);
+}
+
+TEST(global_storage, emplace)
+{
+    std::unique_ptr<int>& stored = global_storage<std::unique_ptr<int>>::emplace_object(new int(42));
+    EXPECT_EQ(&stored, &global_storage<std::unique_ptr<int>>::get_object());
+    EXPECT_EQ(*global_storage<std::unique_ptr<int>>::get_const_object(), 42);
+    global_storage<std::string>::emplace_object(3, 'a');
+    EXPECT_EQ(global_storage<std::string>::get_const_object(), "aaa");
+}
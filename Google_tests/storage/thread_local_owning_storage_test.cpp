@@ -2,6 +2,8 @@
 #include "../../code/storage/thread_local_owning_storage.h"
 #include <functional>
 #include <thread>
+#include <memory>
+#include <vector>
 
 TEST(thread_local_owning_storage, get_without_set)
 {
@@ -104,4 +106,35 @@ TEST(thread_local_owning_storage, owning)
     );
     t.join();
     EXPECT_EQ(t_correct, 1);
-}
\ No newline at end of file
+}
+
+namespace
+{
+    struct move_only
+    {
+        std::unique_ptr<int> value;
+
+        explicit move_only(int x) : value(std::make_unique<int>(x))
+        {}
+    };
+}
+
+TEST(thread_local_owning_storage, set_moves_object)
+{
+    std::vector<int> v({1, 3, 3, 7});
+    const int* const data = v.data();
+    thread_local_owning_storage<std::vector<int>>::set_object(std::move(v));
+    EXPECT_EQ(thread_local_owning_storage<std::vector<int>>::get_const_object().data(), data);
+
+    thread_local_owning_storage<move_only>::set_object(move_only(42));
+    EXPECT_EQ(*thread_local_owning_storage<move_only>::get_const_object().value, 42);
+}
+
+TEST(thread_local_owning_storage, emplace)
+{
+    move_only& stored = thread_local_owning_storage<move_only>::emplace_object(1337);
+    EXPECT_EQ(&stored, &thread_local_owning_storage<move_only>::get_object());
+    EXPECT_EQ(*thread_local_owning_storage<move_only>::get_const_object().value, 1337);
+    thread_local_owning_storage<std::string>::emplace_object(3, 'a');
+    EXPECT_EQ(thread_local_owning_storage<std::string>::get_object(), "aaa");
+}
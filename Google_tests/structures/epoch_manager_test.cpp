@@ -0,0 +1,167 @@
+#include "gtest/gtest.h"
+#include "../common/test_utils.h"
+#include "../../code/common/constants_and_types.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/storage/global_non_owning_storage.h"
+#include "../../code/storage/thread_local_owning_storage.h"
+#include "../../code/model/cur_thread_id_holder.h"
+#include "../../code/structures/node_pool.h"
+#include "../../code/structures/epoch_manager.h"
+#include <set>
+
+namespace
+{
+    const uint64_t NODES_OFFSET = 4096;
+    const uint64_t MAX_NODES = 1000;
+
+    /**
+     * Heap with pool of nodes and manager for two threads. Both threads are simulated by the current thread,
+     * which switches it's id.
+     */
+    struct epoch_test_env
+    {
+        temp_file heap_file;
+        persistent_memory_holder heap;
+        node_pool pool;
+        epoch_manager manager;
+
+        epoch_test_env() :
+                heap_file(get_temp_file_name("heap")),
+                heap(heap_file.file_name, false, PMEM_HEAP_SIZE),
+                pool(heap.get_pmem_ptr(), NODES_OFFSET, MAX_NODES, true),
+                manager(pool, 2)
+        {
+            global_non_owning_storage<node_pool>::ptr = &pool;
+            global_non_owning_storage<epoch_manager>::ptr = &manager;
+            switch_thread(0);
+        }
+
+        ~epoch_test_env()
+        {
+            global_non_owning_storage<epoch_manager>::ptr = nullptr;
+            global_non_owning_storage<node_pool>::ptr = nullptr;
+        }
+
+        static void switch_thread(uint32_t thread_id)
+        {
+            thread_local_owning_storage<cur_thread_id_holder>::set_object(cur_thread_id_holder(thread_id));
+        }
+    };
+}
+
+TEST(epoch_manager, retired_node_freed_after_readers_leave)
+{
+    epoch_test_env env;
+    const uint32_t node = env.pool.allocate_node();
+
+    env.switch_thread(1);
+    env.manager.enter();
+
+    env.switch_thread(0);
+    reclaim_node(node);
+    EXPECT_TRUE(env.pool.is_allocated(node));
+    EXPECT_EQ(env.manager.reclaim(), 0);
+    EXPECT_EQ(env.manager.reclaim(), 0);
+    EXPECT_EQ(env.manager.get_retired_count(), 1);
+    /*
+     * Thread 1 can still read the node, so it isn't given to other users
+     */
+    EXPECT_NE(env.pool.allocate_node(), node);
+    EXPECT_TRUE(env.pool.is_allocated(node));
+
+    env.switch_thread(1);
+    env.manager.exit();
+
+    env.switch_thread(0);
+    EXPECT_EQ(env.manager.reclaim(), 1);
+    EXPECT_EQ(env.manager.get_retired_count(), 0);
+    EXPECT_FALSE(env.pool.is_allocated(node));
+}
+
+TEST(epoch_manager, nested_guards)
+{
+    epoch_test_env env;
+    const uint32_t node = env.pool.allocate_node();
+
+    env.switch_thread(1);
+    {
+        epoch_guard outer;
+        {
+            epoch_guard inner;
+        }
+        /*
+         * Thread 1 is still in critical section after the inner guard is destroyed
+         */
+        env.switch_thread(0);
+        reclaim_node(node);
+        EXPECT_EQ(env.manager.reclaim(), 0);
+        EXPECT_EQ(env.manager.reclaim(), 0);
+        env.switch_thread(1);
+    }
+
+    env.switch_thread(0);
+    EXPECT_EQ(env.manager.reclaim(), 1);
+    EXPECT_FALSE(env.pool.is_allocated(node));
+}
+
+TEST(epoch_manager, retired_nodes_freed_in_batches)
+{
+    epoch_test_env env;
+    std::vector<uint32_t> nodes;
+    for (uint32_t i = 0; i < 2 * epoch_manager::RETIRE_BATCH_SIZE; i++)
+    {
+        nodes.push_back(env.pool.allocate_node());
+    }
+    for (const uint32_t node : nodes)
+    {
+        reclaim_node(node);
+    }
+    /*
+     * There are no readers, therefore the first batch is freed, while the second one is being retired
+     */
+    EXPECT_LE(env.manager.get_retired_count(), epoch_manager::RETIRE_BATCH_SIZE);
+    EXPECT_FALSE(env.pool.is_allocated(nodes[0]));
+    EXPECT_TRUE(env.pool.is_allocated(nodes.back()));
+}
+
+TEST(epoch_manager, retired_nodes_freed_on_restore)
+{
+    temp_file heap_file(get_temp_file_name("heap"));
+    persistent_memory_holder heap(heap_file.file_name, false, PMEM_HEAP_SIZE);
+    uint32_t first;
+    uint32_t second;
+    uint32_t third;
+    uint32_t fourth;
+    {
+        node_pool pool(heap.get_pmem_ptr(), NODES_OFFSET, MAX_NODES, true);
+        first = pool.allocate_node();
+        second = pool.allocate_node();
+        third = pool.allocate_node();
+        pool.retire_node(first);
+        /*
+         * Retired heap end stays retired, when the heap end is moved forward
+         */
+        pool.retire_node(third);
+        fourth = pool.allocate_node();
+        pool.retire_node(fourth);
+        EXPECT_TRUE(pool.is_allocated(first));
+        EXPECT_TRUE(pool.is_allocated(third));
+        EXPECT_TRUE(pool.is_allocated(fourth));
+    }
+
+    /*
+     * Retirement lists in RAM are lost after the crash, but no thread can access retired nodes anymore
+     */
+    node_pool pool(heap.get_pmem_ptr(), NODES_OFFSET, MAX_NODES, false);
+    EXPECT_FALSE(pool.is_allocated(first));
+    EXPECT_TRUE(pool.is_allocated(second));
+    EXPECT_FALSE(pool.is_allocated(third));
+    EXPECT_FALSE(pool.is_allocated(fourth));
+
+    std::set<uint32_t> reused;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        reused.insert(pool.allocate_node());
+    }
+    EXPECT_EQ(reused, std::set<uint32_t>({first, third, fourth}));
+}
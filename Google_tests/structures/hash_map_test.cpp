@@ -0,0 +1,233 @@
+#include "gtest/gtest.h"
+#include "../common/test_utils.h"
+#include "../../code/cas/cas.h"
+#include "../../code/common/constants_and_types.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/persistent_stack/persistent_stack.h"
+#include "../../code/storage/global_storage.h"
+#include "../../code/storage/global_non_owning_storage.h"
+#include "../../code/storage/thread_local_non_owning_storage.h"
+#include "../../code/storage/thread_local_owning_storage.h"
+#include "../../code/model/function_address_holder.h"
+#include "../../code/model/cur_thread_id_holder.h"
+#include "../../code/model/total_thread_count_holder.h"
+#include "../../code/model/system_mode.h"
+#include "../../code/runtime/restoration.h"
+#include "../../code/runtime/answer.h"
+#include "../../code/structures/node_pool.h"
+#include "../../code/structures/structures_common.h"
+#include "../../code/structures/hash_map.h"
+#include "../../code/runtime/exec_task.h"
+#include "../../code/model/tasks.h"
+#include "../../code/allocation/heap_collector.h"
+#include <cstring>
+#include <future>
+#include <memory>
+#include <unordered_set>
+
+namespace
+{
+    const uint64_t MAP_OFFSET = 0;
+    const uint64_t NODES_OFFSET = 4096;
+    const uint64_t ANSWER_OFFSET = 64 * 1024;
+
+    /**
+     * Heap with pool of nodes and empty map, and stack of the current thread, containing only the first frame.
+     */
+    struct map_test_env
+    {
+        temp_file heap_file;
+        temp_file stack_file;
+        persistent_memory_holder heap;
+        persistent_memory_holder stack;
+        node_pool pool;
+
+        map_test_env(uint64_t max_nodes, uint32_t initial_capacity, uint32_t number_of_tables) :
+                heap_file(get_temp_file_name("heap")),
+                stack_file(get_temp_file_name("stack")),
+                heap(heap_file.file_name, false, PMEM_HEAP_SIZE),
+                stack(stack_file.file_name, false, PMEM_STACK_SIZE),
+                pool(heap.get_pmem_ptr(), NODES_OFFSET, max_nodes, true)
+        {
+            global_non_owning_storage<persistent_memory_holder>::ptr = &heap;
+            global_non_owning_storage<node_pool>::ptr = &pool;
+            thread_local_non_owning_storage<persistent_memory_holder>::ptr = &stack;
+            thread_local_owning_storage<ram_stack>::set_object(ram_stack());
+            add_new_frame(
+                    thread_local_owning_storage<ram_stack>::get_object(),
+                    stack_frame("main_function", std::vector<uint8_t>()),
+                    stack
+            );
+            global_storage<total_thread_count_holder>::set_object(total_thread_count_holder(1));
+            thread_local_owning_storage<cur_thread_id_holder>::set_object(cur_thread_id_holder(0));
+            function_address_holder func_map;
+            register_structure_functions(func_map);
+            func_map.funcs["exec_task"] = {exec_task, exec_task_recover};
+            global_storage<function_address_holder>::set_object(std::move(func_map));
+            global_storage<system_mode>::set_object(system_mode::EXECUTION);
+            init_hash_map(MAP_OFFSET, initial_capacity, number_of_tables);
+        }
+
+        ~map_test_env()
+        {
+            global_non_owning_storage<node_pool>::ptr = nullptr;
+        }
+    };
+
+    /*
+     * Performs CAS and crashes before the answer is written
+     */
+    void cas_and_crash(const uint8_t* args)
+    {
+        uint64_t var_offset;
+        std::memcpy(&var_offset, args, 8);
+        uint32_t expected_value;
+        std::memcpy(&expected_value, args + 8, 4);
+        uint32_t new_value;
+        std::memcpy(&new_value, args + 12, 4);
+        uint64_t thread_matrix_offset;
+        std::memcpy(&thread_matrix_offset, args + 16, 8);
+        uint8_t* pmem_start_address = global_non_owning_storage<persistent_memory_holder>::ptr->get_pmem_ptr();
+        cas_internal(
+                (uint64_t*) (pmem_start_address + var_offset),
+                expected_value,
+                new_value,
+                0,
+                1,
+                (uint32_t*) (pmem_start_address + thread_matrix_offset)
+        );
+        throw std::runtime_error("ha-ha, system crash go brrrrr");
+    }
+
+    void set_cas(function_ptr cas_function)
+    {
+        global_storage<function_address_holder>::get_object().funcs["cas"] = {cas_function, cas_recover};
+    }
+
+    void restore(persistent_memory_holder& stack)
+    {
+        global_storage<system_mode>::set_object(system_mode::RECOVERY);
+        set_cas(cas);
+        do_restoration(stack);
+        global_storage<system_mode>::set_object(system_mode::EXECUTION);
+    }
+}
+
+TEST(hash_map, put_get_remove)
+{
+    map_test_env env(16, 8, 1);
+
+    EXPECT_EQ(hash_map_get(MAP_OFFSET, 1), std::nullopt);
+    EXPECT_EQ(hash_map_put(MAP_OFFSET, 1, 10), MAP_ANSWER_DONE);
+    EXPECT_EQ(hash_map_get(MAP_OFFSET, 1), std::make_optional(10u));
+    EXPECT_EQ(hash_map_put(MAP_OFFSET, 1, 11), MAP_ANSWER_DONE);
+    EXPECT_EQ(hash_map_get(MAP_OFFSET, 1), std::make_optional(11u));
+    EXPECT_EQ(hash_map_get(MAP_OFFSET, 2), std::nullopt);
+    EXPECT_EQ(hash_map_remove(MAP_OFFSET, 1), MAP_ANSWER_DONE);
+    EXPECT_EQ(hash_map_get(MAP_OFFSET, 1), std::nullopt);
+    EXPECT_EQ(hash_map_remove(MAP_OFFSET, 1), MAP_ANSWER_ABSENT);
+    EXPECT_THROW(hash_map_put(MAP_OFFSET, 0, 1), std::runtime_error);
+}
+
+TEST(hash_map, grows_when_table_is_full)
+{
+    map_test_env env(16, 2, 2);
+
+    EXPECT_EQ(hash_map_put(MAP_OFFSET, 1, 10), MAP_ANSWER_DONE);
+    EXPECT_EQ(hash_map_put(MAP_OFFSET, 2, 20), MAP_ANSWER_DONE);
+    /*
+     * First table is full, keys are moved to the second table
+     */
+    EXPECT_EQ(hash_map_put(MAP_OFFSET, 3, 30), MAP_ANSWER_DONE);
+    EXPECT_EQ(hash_map_get(MAP_OFFSET, 1), std::make_optional(10u));
+    EXPECT_EQ(hash_map_get(MAP_OFFSET, 2), std::make_optional(20u));
+    EXPECT_EQ(hash_map_get(MAP_OFFSET, 3), std::make_optional(30u));
+}
+
+TEST(hash_map, put_fails_if_out_of_nodes)
+{
+    map_test_env env(1, 8, 1);
+
+    EXPECT_EQ(hash_map_put(MAP_OFFSET, 1, 10), MAP_ANSWER_DONE);
+    EXPECT_EQ(hash_map_put(MAP_OFFSET, 2, 20), MAP_ANSWER_NO_SPACE);
+    EXPECT_EQ(hash_map_get(MAP_OFFSET, 2), std::nullopt);
+}
+
+TEST(hash_map, put_recovered_after_crash_in_cas)
+{
+    map_test_env env(16, 8, 1);
+
+    set_cas(cas_and_crash);
+    EXPECT_THROW(hash_map_put(MAP_OFFSET, 5, 7), std::runtime_error);
+    restore(env.stack);
+
+    /*
+     * Answer of put has been written during recovery, node has been installed exactly once
+     */
+    EXPECT_EQ(read_answer(1)[0], MAP_ANSWER_DONE);
+    EXPECT_EQ(hash_map_get(MAP_OFFSET, 5), std::make_optional(7u));
+    EXPECT_TRUE(env.pool.is_allocated(1));
+    EXPECT_FALSE(env.pool.is_allocated(2));
+
+    /*
+     * Replaced node is freed
+     */
+    EXPECT_EQ(hash_map_put(MAP_OFFSET, 5, 8), MAP_ANSWER_DONE);
+    EXPECT_FALSE(env.pool.is_allocated(1));
+    EXPECT_EQ(hash_map_get(MAP_OFFSET, 5), std::make_optional(8u));
+}
+
+TEST(hash_map, remove_recovered_after_crash_in_cas)
+{
+    map_test_env env(16, 8, 1);
+
+    EXPECT_EQ(hash_map_put(MAP_OFFSET, 5, 7), MAP_ANSWER_DONE);
+    set_cas(cas_and_crash);
+    EXPECT_THROW(hash_map_remove(MAP_OFFSET, 5), std::runtime_error);
+    restore(env.stack);
+
+    EXPECT_EQ(read_answer(1)[0], MAP_ANSWER_DONE);
+    EXPECT_EQ(hash_map_get(MAP_OFFSET, 5), std::nullopt);
+    EXPECT_EQ(hash_map_remove(MAP_OFFSET, 5), MAP_ANSWER_ABSENT);
+}
+
+TEST(hash_map, tasks_write_answers)
+{
+    map_test_env env(16, 8, 1);
+    const uint8_t* answer = env.heap.get_pmem_ptr() + ANSWER_OFFSET;
+
+    execute_task(map_update_task(MAP_OFFSET, 3, 30, ANSWER_OFFSET));
+    EXPECT_EQ(*answer, MAP_ANSWER_DONE);
+    auto result = std::make_shared<std::promise<std::optional<uint32_t>>>();
+    std::future<std::optional<uint32_t>> value = result->get_future();
+    execute_task(map_get_task(MAP_OFFSET, 3, result));
+    EXPECT_EQ(value.get(), std::make_optional(30u));
+
+    execute_task(map_update_task(MAP_OFFSET, 3, std::nullopt, ANSWER_OFFSET));
+    EXPECT_EQ(*answer, MAP_ANSWER_DONE);
+    execute_task(map_update_task(MAP_OFFSET, 3, std::nullopt, ANSWER_OFFSET));
+    EXPECT_EQ(*answer, MAP_ANSWER_ABSENT);
+    EXPECT_THROW(map_update_task(MAP_OFFSET, 0, 1, ANSWER_OFFSET), std::runtime_error);
+}
+
+TEST(hash_map, leaked_nodes_collected)
+{
+    map_test_env env(16, 8, 1);
+
+    EXPECT_EQ(hash_map_put(MAP_OFFSET, 5, 50), MAP_ANSWER_DONE);
+    const uint32_t leaked_index = env.pool.allocate_node();
+
+    std::unordered_set<uint64_t> roots;
+    const std::vector<uint32_t> map_nodes = get_hash_map_nodes(MAP_OFFSET);
+    EXPECT_EQ(map_nodes.size(), 1);
+    for (const uint32_t node_index : map_nodes)
+    {
+        roots.insert(env.pool.get_node_offset(node_index));
+    }
+    heap_collector collector(env.pool.get_allocator(), env.heap.get_pmem_ptr(), std::move(roots), true);
+    collector.run(1);
+
+    const std::vector<uint64_t> expected_leaked = {env.pool.get_node_offset(leaked_index)};
+    EXPECT_EQ(collector.get_report().leaked_offsets, expected_leaked);
+    EXPECT_EQ(hash_map_get(MAP_OFFSET, 5), std::make_optional(50u));
+}
@@ -0,0 +1,235 @@
+#include "gtest/gtest.h"
+#include "../common/test_utils.h"
+#include "../../code/cas/cas.h"
+#include "../../code/common/constants_and_types.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/persistent_stack/persistent_stack.h"
+#include "../../code/storage/global_storage.h"
+#include "../../code/storage/global_non_owning_storage.h"
+#include "../../code/storage/thread_local_non_owning_storage.h"
+#include "../../code/storage/thread_local_owning_storage.h"
+#include "../../code/model/function_address_holder.h"
+#include "../../code/model/cur_thread_id_holder.h"
+#include "../../code/model/total_thread_count_holder.h"
+#include "../../code/model/system_mode.h"
+#include "../../code/runtime/restoration.h"
+#include "../../code/runtime/answer.h"
+#include "../../code/runtime/exec_task.h"
+#include "../../code/structures/node_pool.h"
+#include "../../code/structures/structures_common.h"
+#include "../../code/structures/mcas.h"
+#include <cstring>
+
+namespace
+{
+    const uint32_t NUMBER_OF_VARS = 3;
+    const uint64_t NODES_OFFSET = 4096;
+
+    /*
+     * Each register occupies a cache line and is followed by it's thread matrix
+     */
+    uint64_t get_var_offset(uint32_t var_number)
+    {
+        return var_number * 2 * CACHE_LINE_SIZE;
+    }
+
+    /**
+     * Heap with pool of nodes and registers with values 1, 2, 3, and stack of the current thread,
+     * containing only the first frame.
+     */
+    struct mcas_test_env
+    {
+        temp_file heap_file;
+        temp_file stack_file;
+        persistent_memory_holder heap;
+        persistent_memory_holder stack;
+        node_pool pool;
+
+        explicit mcas_test_env(uint64_t max_nodes) :
+                heap_file(get_temp_file_name("heap")),
+                stack_file(get_temp_file_name("stack")),
+                heap(heap_file.file_name, false, PMEM_HEAP_SIZE),
+                stack(stack_file.file_name, false, PMEM_STACK_SIZE),
+                pool(heap.get_pmem_ptr(), NODES_OFFSET, max_nodes, true)
+        {
+            global_non_owning_storage<persistent_memory_holder>::ptr = &heap;
+            global_non_owning_storage<node_pool>::ptr = &pool;
+            thread_local_non_owning_storage<persistent_memory_holder>::ptr = &stack;
+            thread_local_owning_storage<ram_stack>::set_object(ram_stack());
+            add_new_frame(
+                    thread_local_owning_storage<ram_stack>::get_object(),
+                    stack_frame("main_function", std::vector<uint8_t>()),
+                    stack
+            );
+            global_storage<total_thread_count_holder>::set_object(total_thread_count_holder(1));
+            thread_local_owning_storage<cur_thread_id_holder>::set_object(cur_thread_id_holder(0));
+            function_address_holder func_map;
+            register_structure_functions(func_map);
+            global_storage<function_address_holder>::set_object(std::move(func_map));
+            global_storage<system_mode>::set_object(system_mode::EXECUTION);
+            for (uint32_t var_number = 0; var_number < NUMBER_OF_VARS; var_number++)
+            {
+                init_register(get_var_offset(var_number), var_number + 1);
+            }
+        }
+
+        ~mcas_test_env()
+        {
+            global_non_owning_storage<node_pool>::ptr = nullptr;
+        }
+    };
+
+    mcas_word make_word(uint32_t var_number, uint32_t expected_value, uint32_t new_value)
+    {
+        return mcas_word{
+                get_var_offset(var_number),
+                get_var_offset(var_number) + CACHE_LINE_SIZE,
+                expected_value,
+                new_value
+        };
+    }
+
+    /*
+     * Initializes descriptor, installs it to the first register of MCAS and crashes
+     */
+    void init_install_and_crash(const uint8_t* args)
+    {
+        mcas_init(args);
+        const operation_state state = parse_operation_state(read_current_answer(8));
+        uint64_t var_offset;
+        std::memcpy(&var_offset, args + 4 + 1, 8);
+        uint64_t descriptor_word;
+        const uint32_t ref = make_node_ref(state.payload, state.node_index);
+        std::memcpy((uint8_t*) &descriptor_word, &MCAS_DESCRIPTOR_THREAD, 4);
+        std::memcpy((uint8_t*) &descriptor_word + 4, &ref, 4);
+        __atomic_store_n((uint64_t*) (global_non_owning_storage<persistent_memory_holder>::ptr->get_pmem_ptr() +
+                                      var_offset), descriptor_word, __ATOMIC_SEQ_CST);
+        throw std::runtime_error("ha-ha, system crash go brrrrr");
+    }
+
+    void set_function(std::string const& name, function_ptr function, function_ptr recover_function)
+    {
+        global_storage<function_address_holder>::get_object().funcs[name] = {function, recover_function};
+    }
+
+    void restore(persistent_memory_holder& stack)
+    {
+        global_storage<system_mode>::set_object(system_mode::RECOVERY);
+        set_function("mcas_init", mcas_init, mcas_init_recover);
+        do_restoration(stack);
+        global_storage<system_mode>::set_object(system_mode::EXECUTION);
+    }
+}
+
+TEST(mcas, succeeds_and_fails)
+{
+    mcas_test_env env(16);
+
+    EXPECT_EQ(do_mcas({make_word(2, 3, 30), make_word(0, 1, 10), make_word(1, 2, 20)}), MCAS_SUCCEEDED);
+    EXPECT_EQ(read_var(get_var_offset(0)), 10);
+    EXPECT_EQ(read_var(get_var_offset(1)), 20);
+    EXPECT_EQ(read_var(get_var_offset(2)), 30);
+
+    EXPECT_EQ(do_mcas({make_word(0, 10, 11), make_word(1, 99, 21)}), MCAS_FAILED);
+    EXPECT_EQ(read_var(get_var_offset(0)), 10);
+    EXPECT_EQ(read_var(get_var_offset(1)), 20);
+
+    /*
+     * Descriptors have been freed
+     */
+    EXPECT_FALSE(env.pool.is_allocated(1));
+}
+
+TEST(mcas, invalid_words)
+{
+    mcas_test_env env(16);
+
+    EXPECT_THROW(do_mcas({}), std::runtime_error);
+    EXPECT_THROW(do_mcas({make_word(0, 1, 2), make_word(0, 1, 3)}), std::runtime_error);
+    EXPECT_THROW(
+            do_mcas({make_word(0, 1, 2), make_word(1, 2, 3), make_word(2, 3, 4), make_word(3, 4, 5)}),
+            std::runtime_error
+    );
+    EXPECT_EQ(read_var(get_var_offset(0)), 1);
+}
+
+TEST(mcas, fails_if_out_of_nodes)
+{
+    mcas_test_env env(0);
+
+    EXPECT_EQ(do_mcas({make_word(0, 1, 10)}), MCAS_OUT_OF_NODES);
+    EXPECT_EQ(read_var(get_var_offset(0)), 1);
+}
+
+TEST(mcas, recovered_after_partial_install)
+{
+    mcas_test_env env(16);
+
+    set_function("mcas_init", init_install_and_crash, mcas_init_recover);
+    EXPECT_THROW(do_mcas({make_word(0, 1, 10), make_word(1, 2, 20)}), std::runtime_error);
+    /*
+     * MCAS is undecided, therefore register has it's old value
+     */
+    EXPECT_EQ(read_var(get_var_offset(0)), 1);
+    restore(env.stack);
+
+    EXPECT_EQ(read_answer(1)[0], MCAS_SUCCEEDED);
+    EXPECT_EQ(read_var(get_var_offset(0)), 10);
+    EXPECT_EQ(read_var(get_var_offset(1)), 20);
+    EXPECT_FALSE(env.pool.is_allocated(1));
+}
+
+TEST(mcas, aborted_by_cas)
+{
+    mcas_test_env env(16);
+
+    set_function("mcas_init", init_install_and_crash, mcas_init_recover);
+    EXPECT_THROW(do_mcas({make_word(0, 1, 10), make_word(1, 2, 20)}), std::runtime_error);
+    /*
+     * Single CAS of the register, containing the descriptor, aborts MCAS
+     */
+    uint8_t* const heap_ptr = env.heap.get_pmem_ptr();
+    EXPECT_TRUE(cas_internal(
+            (uint64_t*) (heap_ptr + get_var_offset(0)),
+            1,
+            5,
+            0,
+            1,
+            (uint32_t*) (heap_ptr + get_var_offset(0) + CACHE_LINE_SIZE)
+    ));
+    restore(env.stack);
+
+    EXPECT_EQ(read_answer(1)[0], MCAS_ABORTED);
+    EXPECT_EQ(read_var(get_var_offset(0)), 5);
+    EXPECT_EQ(read_var(get_var_offset(1)), 2);
+}
+
+TEST(mcas, snapshot_read_does_not_help)
+{
+    mcas_test_env env(16);
+
+    set_function("mcas_init", init_install_and_crash, mcas_init_recover);
+    EXPECT_THROW(do_mcas({make_word(0, 1, 10), make_word(1, 2, 20)}), std::runtime_error);
+    const uint8_t* const heap_ptr = env.heap.get_pmem_ptr();
+    const std::vector<uint8_t> heap_before(heap_ptr, heap_ptr + PMEM_HEAP_SIZE);
+
+    std::vector<uint8_t> args(4 + 8 * 2);
+    const uint32_t vars_count = 2;
+    const uint64_t var_offsets[] = {get_var_offset(0), get_var_offset(1)};
+    std::memcpy(args.data(), &vars_count, 4);
+    std::memcpy(args.data() + 4, var_offsets, 16);
+    const std::vector<uint8_t> result = snapshot_read(args.data());
+    uint32_t values[2];
+    std::memcpy(values, result.data(), 8);
+    /*
+     * MCAS is undecided, therefore registers have their old values, and the descriptor is not aborted
+     */
+    EXPECT_EQ(values[0], 1);
+    EXPECT_EQ(values[1], 2);
+    EXPECT_EQ(std::memcmp(heap_before.data(), heap_ptr, PMEM_HEAP_SIZE), 0);
+    restore(env.stack);
+
+    EXPECT_EQ(read_answer(1)[0], MCAS_SUCCEEDED);
+    EXPECT_EQ(read_var(get_var_offset(0)), 10);
+    EXPECT_EQ(read_var(get_var_offset(1)), 20);
+}
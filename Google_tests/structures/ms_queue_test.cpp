@@ -0,0 +1,193 @@
+#include "gtest/gtest.h"
+#include "../common/test_utils.h"
+#include "../../code/cas/cas.h"
+#include "../../code/common/constants_and_types.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/persistent_stack/persistent_stack.h"
+#include "../../code/storage/global_storage.h"
+#include "../../code/storage/global_non_owning_storage.h"
+#include "../../code/storage/thread_local_non_owning_storage.h"
+#include "../../code/storage/thread_local_owning_storage.h"
+#include "../../code/model/function_address_holder.h"
+#include "../../code/model/cur_thread_id_holder.h"
+#include "../../code/model/total_thread_count_holder.h"
+#include "../../code/model/system_mode.h"
+#include "../../code/runtime/restoration.h"
+#include "../../code/runtime/answer.h"
+#include "../../code/structures/node_pool.h"
+#include "../../code/structures/structures_common.h"
+#include "../../code/structures/ms_queue.h"
+#include "../../code/allocation/heap_collector.h"
+#include <cstring>
+#include <unordered_set>
+
+namespace
+{
+    const uint64_t QUEUE_OFFSET = 0;
+    const uint64_t NODES_OFFSET = 4096;
+
+    /**
+     * Heap with pool of nodes and empty queue, and stack of the current thread, containing only the first frame.
+     */
+    struct queue_test_env
+    {
+        temp_file heap_file;
+        temp_file stack_file;
+        persistent_memory_holder heap;
+        persistent_memory_holder stack;
+        node_pool pool;
+
+        explicit queue_test_env(uint64_t max_nodes) :
+                heap_file(get_temp_file_name("heap")),
+                stack_file(get_temp_file_name("stack")),
+                heap(heap_file.file_name, false, PMEM_HEAP_SIZE),
+                stack(stack_file.file_name, false, PMEM_STACK_SIZE),
+                pool(heap.get_pmem_ptr(), NODES_OFFSET, max_nodes, true)
+        {
+            global_non_owning_storage<persistent_memory_holder>::ptr = &heap;
+            global_non_owning_storage<node_pool>::ptr = &pool;
+            thread_local_non_owning_storage<persistent_memory_holder>::ptr = &stack;
+            thread_local_owning_storage<ram_stack>::set_object(ram_stack());
+            add_new_frame(
+                    thread_local_owning_storage<ram_stack>::get_object(),
+                    stack_frame("main_function", std::vector<uint8_t>()),
+                    stack
+            );
+            global_storage<total_thread_count_holder>::set_object(total_thread_count_holder(1));
+            thread_local_owning_storage<cur_thread_id_holder>::set_object(cur_thread_id_holder(0));
+            function_address_holder func_map;
+            register_structure_functions(func_map);
+            global_storage<function_address_holder>::set_object(std::move(func_map));
+            global_storage<system_mode>::set_object(system_mode::EXECUTION);
+            init_ms_queue(QUEUE_OFFSET);
+        }
+
+        ~queue_test_env()
+        {
+            global_non_owning_storage<node_pool>::ptr = nullptr;
+        }
+    };
+
+    /*
+     * Performs CAS and crashes before the answer is written
+     */
+    void cas_and_crash(const uint8_t* args)
+    {
+        uint64_t var_offset;
+        std::memcpy(&var_offset, args, 8);
+        uint32_t expected_value;
+        std::memcpy(&expected_value, args + 8, 4);
+        uint32_t new_value;
+        std::memcpy(&new_value, args + 12, 4);
+        uint64_t thread_matrix_offset;
+        std::memcpy(&thread_matrix_offset, args + 16, 8);
+        uint8_t* pmem_start_address = global_non_owning_storage<persistent_memory_holder>::ptr->get_pmem_ptr();
+        cas_internal(
+                (uint64_t*) (pmem_start_address + var_offset),
+                expected_value,
+                new_value,
+                0,
+                1,
+                (uint32_t*) (pmem_start_address + thread_matrix_offset)
+        );
+        throw std::runtime_error("ha-ha, system crash go brrrrr");
+    }
+
+    void set_cas(function_ptr cas_function)
+    {
+        global_storage<function_address_holder>::get_object().funcs["cas"] = {cas_function, cas_recover};
+    }
+
+    void restore(persistent_memory_holder& stack)
+    {
+        global_storage<system_mode>::set_object(system_mode::RECOVERY);
+        set_cas(cas);
+        do_restoration(stack);
+        global_storage<system_mode>::set_object(system_mode::EXECUTION);
+    }
+}
+
+TEST(ms_queue, enqueue_dequeue_fifo)
+{
+    queue_test_env env(16);
+
+    EXPECT_TRUE(ms_queue_enqueue(QUEUE_OFFSET, 1));
+    EXPECT_TRUE(ms_queue_enqueue(QUEUE_OFFSET, 2));
+    EXPECT_EQ(ms_queue_dequeue(QUEUE_OFFSET), std::make_optional(1u));
+    EXPECT_EQ(ms_queue_dequeue(QUEUE_OFFSET), std::make_optional(2u));
+    EXPECT_EQ(ms_queue_dequeue(QUEUE_OFFSET), std::nullopt);
+}
+
+TEST(ms_queue, enqueue_fails_if_out_of_nodes)
+{
+    /*
+     * Single node is used as dummy node
+     */
+    queue_test_env env(1);
+
+    EXPECT_FALSE(ms_queue_enqueue(QUEUE_OFFSET, 1));
+    EXPECT_EQ(ms_queue_dequeue(QUEUE_OFFSET), std::nullopt);
+}
+
+TEST(ms_queue, enqueue_recovered_after_crash_in_cas)
+{
+    queue_test_env env(16);
+
+    set_cas(cas_and_crash);
+    EXPECT_THROW(ms_queue_enqueue(QUEUE_OFFSET, 7), std::runtime_error);
+    restore(env.stack);
+
+    /*
+     * Node has been linked exactly once, tail hasn't been moved before the crash and is moved by dequeue
+     */
+    EXPECT_EQ(read_answer(1)[0], 0x1);
+    EXPECT_EQ(ms_queue_dequeue(QUEUE_OFFSET), std::make_optional(7u));
+    EXPECT_EQ(ms_queue_dequeue(QUEUE_OFFSET), std::nullopt);
+}
+
+TEST(ms_queue, dequeue_recovered_after_crash_in_cas)
+{
+    queue_test_env env(16);
+
+    EXPECT_TRUE(ms_queue_enqueue(QUEUE_OFFSET, 7));
+    set_cas(cas_and_crash);
+    EXPECT_THROW(ms_queue_dequeue(QUEUE_OFFSET), std::runtime_error);
+    restore(env.stack);
+
+    /*
+     * Answer of dequeue has been written and previous dummy node has been freed during recovery
+     */
+    const std::vector<uint8_t> answer = read_answer(8);
+    EXPECT_EQ(answer[0], 0x1);
+    uint32_t value;
+    std::memcpy(&value, answer.data() + 4, 4);
+    EXPECT_EQ(value, 7);
+    EXPECT_FALSE(env.pool.is_allocated(1));
+    EXPECT_TRUE(env.pool.is_allocated(2));
+    EXPECT_EQ(ms_queue_dequeue(QUEUE_OFFSET), std::nullopt);
+}
+
+TEST(ms_queue, leaked_nodes_collected)
+{
+    queue_test_env env(16);
+
+    EXPECT_TRUE(ms_queue_enqueue(QUEUE_OFFSET, 1));
+    const uint32_t leaked_index = env.pool.allocate_node();
+
+    std::unordered_set<uint64_t> roots;
+    const std::vector<uint32_t> queue_nodes = get_ms_queue_nodes(QUEUE_OFFSET);
+    /*
+     * Dummy node and node of the value
+     */
+    EXPECT_EQ(queue_nodes.size(), 2);
+    for (const uint32_t node_index : queue_nodes)
+    {
+        roots.insert(env.pool.get_node_offset(node_index));
+    }
+    heap_collector collector(env.pool.get_allocator(), env.heap.get_pmem_ptr(), std::move(roots), true);
+    collector.run(1);
+
+    const std::vector<uint64_t> expected_leaked = {env.pool.get_node_offset(leaked_index)};
+    EXPECT_EQ(collector.get_report().leaked_offsets, expected_leaked);
+    EXPECT_EQ(ms_queue_dequeue(QUEUE_OFFSET), std::make_optional(1u));
+}
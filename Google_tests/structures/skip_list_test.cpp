@@ -0,0 +1,317 @@
+#include "gtest/gtest.h"
+#include "../common/test_utils.h"
+#include "../../code/common/constants_and_types.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/persistent_stack/persistent_stack.h"
+#include "../../code/storage/global_storage.h"
+#include "../../code/storage/global_non_owning_storage.h"
+#include "../../code/storage/thread_local_non_owning_storage.h"
+#include "../../code/storage/thread_local_owning_storage.h"
+#include "../../code/model/function_address_holder.h"
+#include "../../code/model/cur_thread_id_holder.h"
+#include "../../code/model/total_thread_count_holder.h"
+#include "../../code/model/system_mode.h"
+#include "../../code/runtime/restoration.h"
+#include "../../code/runtime/answer.h"
+#include "../../code/structures/node_pool.h"
+#include "../../code/structures/structures_common.h"
+#include "../../code/structures/skip_list.h"
+#include "../../code/structures/epoch_manager.h"
+#include "../../code/allocation/heap_collector.h"
+#include <cstring>
+#include <map>
+#include <random>
+#include <unordered_set>
+
+namespace
+{
+    const uint64_t LIST_OFFSET = 0;
+    const uint64_t NODES_OFFSET = 4096;
+
+    /**
+     * Heap with pool of nodes and empty skip list, and stack of the current thread, containing only the first frame.
+     */
+    struct skip_list_test_env
+    {
+        temp_file heap_file;
+        temp_file stack_file;
+        persistent_memory_holder heap;
+        persistent_memory_holder stack;
+        node_pool pool;
+
+        explicit skip_list_test_env(uint64_t max_nodes) :
+                heap_file(get_temp_file_name("heap")),
+                stack_file(get_temp_file_name("stack")),
+                heap(heap_file.file_name, false, PMEM_HEAP_SIZE),
+                stack(stack_file.file_name, false, PMEM_STACK_SIZE),
+                pool(heap.get_pmem_ptr(), NODES_OFFSET, max_nodes, true)
+        {
+            global_non_owning_storage<persistent_memory_holder>::ptr = &heap;
+            global_non_owning_storage<node_pool>::ptr = &pool;
+            thread_local_non_owning_storage<persistent_memory_holder>::ptr = &stack;
+            thread_local_owning_storage<ram_stack>::set_object(ram_stack());
+            add_new_frame(
+                    thread_local_owning_storage<ram_stack>::get_object(),
+                    stack_frame("main_function", std::vector<uint8_t>()),
+                    stack
+            );
+            global_storage<total_thread_count_holder>::set_object(total_thread_count_holder(1));
+            thread_local_owning_storage<cur_thread_id_holder>::set_object(cur_thread_id_holder(0));
+            function_address_holder func_map;
+            register_structure_functions(func_map);
+            global_storage<function_address_holder>::set_object(std::move(func_map));
+            global_storage<system_mode>::set_object(system_mode::EXECUTION);
+            init_skip_list(LIST_OFFSET);
+        }
+
+        ~skip_list_test_env()
+        {
+            global_non_owning_storage<node_pool>::ptr = nullptr;
+        }
+    };
+
+    /*
+     * Allocates node and crashes after the answer is written
+     */
+    void alloc_and_crash(const uint8_t* args)
+    {
+        pds_alloc(args);
+        throw std::runtime_error("ha-ha, system crash go brrrrr");
+    }
+
+    /*
+     * Marks node and crashes after the answer is written
+     */
+    void mark_and_crash(const uint8_t* args)
+    {
+        skip_mark(args);
+        throw std::runtime_error("ha-ha, system crash go brrrrr");
+    }
+
+    void set_function(std::string const& name, function_ptr function, function_ptr recover_function)
+    {
+        global_storage<function_address_holder>::get_object().funcs[name] = {function, recover_function};
+    }
+
+    void restore(persistent_memory_holder& stack)
+    {
+        global_storage<system_mode>::set_object(system_mode::RECOVERY);
+        set_function("pds_alloc", pds_alloc, pds_alloc_recover);
+        set_function("skip_mark", skip_mark, skip_mark_recover);
+        do_restoration(stack);
+        global_storage<system_mode>::set_object(system_mode::EXECUTION);
+    }
+
+    /**
+     * Epoch manager of the single thread, that is used by the skip list, while the object exists.
+     */
+    struct epoch_manager_env
+    {
+        epoch_manager manager;
+
+        explicit epoch_manager_env(node_pool& pool) :
+                manager(pool, 1)
+        {
+            global_non_owning_storage<epoch_manager>::ptr = &manager;
+        }
+
+        ~epoch_manager_env()
+        {
+            global_non_owning_storage<epoch_manager>::ptr = nullptr;
+        }
+    };
+
+    std::vector<std::pair<uint64_t, uint32_t>> make_entries(std::vector<uint64_t> const& keys)
+    {
+        std::vector<std::pair<uint64_t, uint32_t>> entries;
+        for (uint64_t key : keys)
+        {
+            entries.emplace_back(key, key * 10);
+        }
+        return entries;
+    }
+}
+
+TEST(skip_list, insert_get_scan)
+{
+    skip_list_test_env env(16);
+
+    EXPECT_EQ(skip_list_insert(LIST_OFFSET, 5, 50), SKIP_LIST_DONE);
+    EXPECT_EQ(skip_list_insert(LIST_OFFSET, 1, 10), SKIP_LIST_DONE);
+    EXPECT_EQ(skip_list_insert(LIST_OFFSET, 3, 30), SKIP_LIST_DONE);
+    EXPECT_EQ(skip_list_insert(LIST_OFFSET, 3, 31), SKIP_LIST_KEY_EXISTS);
+
+    EXPECT_EQ(skip_list_get(LIST_OFFSET, 3), std::make_optional(30u));
+    EXPECT_EQ(skip_list_get(LIST_OFFSET, 4), std::nullopt);
+    EXPECT_EQ(skip_list_scan(LIST_OFFSET, 0, 10), make_entries({1, 3, 5}));
+    EXPECT_EQ(skip_list_scan(LIST_OFFSET, 2, 4), make_entries({3}));
+    EXPECT_EQ(skip_list_scan(LIST_OFFSET, 6, 10), make_entries({}));
+
+    /*
+     * Node of the failed insert has been returned to the pool
+     */
+    EXPECT_FALSE(env.pool.is_allocated(4));
+}
+
+TEST(skip_list, remove_keeps_order)
+{
+    skip_list_test_env env(128);
+
+    std::vector<uint64_t> odd_keys;
+    for (uint64_t key = 64; key > 0; key--)
+    {
+        EXPECT_EQ(skip_list_insert(LIST_OFFSET, key, key * 10), SKIP_LIST_DONE);
+    }
+    for (uint64_t key = 1; key <= 64; key++)
+    {
+        if (key % 2 == 0)
+        {
+            EXPECT_EQ(skip_list_remove(LIST_OFFSET, key), SKIP_LIST_DONE);
+        }
+        else
+        {
+            odd_keys.push_back(key);
+        }
+    }
+    EXPECT_EQ(skip_list_scan(LIST_OFFSET, 0, 100), make_entries(odd_keys));
+    EXPECT_EQ(skip_list_remove(LIST_OFFSET, 2), SKIP_LIST_KEY_ABSENT);
+    EXPECT_EQ(skip_list_get(LIST_OFFSET, 2), std::nullopt);
+    EXPECT_EQ(skip_list_get(LIST_OFFSET, 63), std::make_optional(630u));
+
+    EXPECT_EQ(skip_list_insert(LIST_OFFSET, 2, 20), SKIP_LIST_DONE);
+    EXPECT_EQ(skip_list_scan(LIST_OFFSET, 1, 3), make_entries({1, 2, 3}));
+}
+
+TEST(skip_list, insert_fails_if_out_of_nodes)
+{
+    skip_list_test_env env(1);
+
+    EXPECT_EQ(skip_list_insert(LIST_OFFSET, 1, 10), SKIP_LIST_DONE);
+    EXPECT_EQ(skip_list_insert(LIST_OFFSET, 2, 20), SKIP_LIST_OUT_OF_NODES);
+    EXPECT_EQ(skip_list_scan(LIST_OFFSET, 0, 10), make_entries({1}));
+}
+
+TEST(skip_list, removed_nodes_reclaimed)
+{
+    const uint64_t max_nodes = 8;
+    skip_list_test_env env(max_nodes);
+
+    /*
+     * Pool is exhausted by each round, therefore each removed node must be returned to it
+     */
+    for (uint32_t round = 0; round < 20; round++)
+    {
+        for (uint64_t key = 1; key <= max_nodes; key++)
+        {
+            ASSERT_EQ(skip_list_insert(LIST_OFFSET, key, key * 10), SKIP_LIST_DONE);
+        }
+        for (uint64_t key = 1; key <= max_nodes; key++)
+        {
+            ASSERT_EQ(skip_list_remove(LIST_OFFSET, key), SKIP_LIST_DONE);
+        }
+    }
+    for (uint32_t node_index = 1; node_index <= max_nodes; node_index++)
+    {
+        EXPECT_FALSE(env.pool.is_allocated(node_index));
+    }
+    EXPECT_EQ(skip_list_scan(LIST_OFFSET, 0, 100), make_entries({}));
+}
+
+TEST(skip_list, churn_with_epoch_manager)
+{
+    /*
+     * Nodes are reclaimed inside the guard of the remove, therefore up to two batches of nodes can be retired
+     */
+    const uint64_t max_keys = 64;
+    const uint64_t max_nodes = 2 * epoch_manager::RETIRE_BATCH_SIZE + max_keys + 1;
+    skip_list_test_env env(max_nodes);
+    epoch_manager_env manager_env(env.pool);
+
+    /*
+     * Keys are inserted and removed randomly, so that reused nodes are reachable by the stale upper links
+     */
+    std::mt19937 generator(42);
+    std::map<uint64_t, uint32_t> expected;
+    for (uint32_t i = 0; i < 10 * max_nodes; i++)
+    {
+        const uint64_t key = generator() % max_keys;
+        if (expected.count(key) != 0)
+        {
+            ASSERT_EQ(skip_list_remove(LIST_OFFSET, key), SKIP_LIST_DONE);
+            expected.erase(key);
+        }
+        else
+        {
+            ASSERT_EQ(skip_list_insert(LIST_OFFSET, key, i), SKIP_LIST_DONE);
+            expected[key] = i;
+        }
+        ASSERT_EQ(skip_list_get(LIST_OFFSET, key), expected.count(key) != 0 ? std::make_optional(expected[key])
+                                                                             : std::nullopt);
+    }
+    const std::vector<std::pair<uint64_t, uint32_t>> expected_entries(expected.begin(), expected.end());
+    EXPECT_EQ(skip_list_scan(LIST_OFFSET, 0, 100), expected_entries);
+    EXPECT_LE(manager_env.manager.get_retired_count(), 2 * epoch_manager::RETIRE_BATCH_SIZE);
+}
+
+TEST(skip_list, insert_recovered_after_crash_in_alloc)
+{
+    skip_list_test_env env(16);
+
+    set_function("pds_alloc", alloc_and_crash, pds_alloc_recover);
+    EXPECT_THROW(skip_list_insert(LIST_OFFSET, 7, 70), std::runtime_error);
+    restore(env.stack);
+
+    /*
+     * Node, allocated before the crash, has been linked during recovery
+     */
+    EXPECT_EQ(read_answer(1)[0], SKIP_LIST_DONE);
+    EXPECT_EQ(skip_list_scan(LIST_OFFSET, 0, 10), make_entries({7}));
+    EXPECT_TRUE(env.pool.is_allocated(1));
+    EXPECT_FALSE(env.pool.is_allocated(2));
+}
+
+TEST(skip_list, remove_recovered_after_crash_in_mark)
+{
+    skip_list_test_env env(16);
+
+    EXPECT_EQ(skip_list_insert(LIST_OFFSET, 7, 70), SKIP_LIST_DONE);
+    EXPECT_EQ(skip_list_insert(LIST_OFFSET, 8, 80), SKIP_LIST_DONE);
+    set_function("skip_mark", mark_and_crash, skip_mark_recover);
+    EXPECT_THROW(skip_list_remove(LIST_OFFSET, 7), std::runtime_error);
+    restore(env.stack);
+
+    EXPECT_EQ(read_answer(1)[0], SKIP_LIST_DONE);
+    EXPECT_EQ(skip_list_scan(LIST_OFFSET, 0, 10), make_entries({8}));
+    EXPECT_EQ(skip_list_remove(LIST_OFFSET, 7), SKIP_LIST_KEY_ABSENT);
+    /*
+     * Node of the removed key has been reclaimed by the recovery
+     */
+    EXPECT_FALSE(env.pool.is_allocated(1));
+}
+
+TEST(skip_list, leaked_nodes_collected)
+{
+    skip_list_test_env env(16);
+
+    for (uint64_t key = 1; key <= 3; key++)
+    {
+        EXPECT_EQ(skip_list_insert(LIST_OFFSET, key, key * 10), SKIP_LIST_DONE);
+    }
+    EXPECT_EQ(skip_list_remove(LIST_OFFSET, 2), SKIP_LIST_DONE);
+    const uint32_t leaked_index = env.pool.allocate_node();
+
+    std::unordered_set<uint64_t> roots;
+    const std::vector<uint32_t> list_nodes = get_skip_list_nodes(LIST_OFFSET);
+    EXPECT_EQ(list_nodes.size(), 2);
+    for (const uint32_t node_index : list_nodes)
+    {
+        roots.insert(env.pool.get_node_offset(node_index));
+    }
+    heap_collector collector(env.pool.get_allocator(), env.heap.get_pmem_ptr(), std::move(roots), true);
+    collector.run(1);
+
+    const std::vector<uint64_t> expected_leaked = {env.pool.get_node_offset(leaked_index)};
+    EXPECT_EQ(collector.get_report().leaked_offsets, expected_leaked);
+    const std::vector<std::pair<uint64_t, uint32_t>> expected_entries = {{1, 10}, {3, 30}};
+    EXPECT_EQ(skip_list_scan(LIST_OFFSET, 0, 10), expected_entries);
+}
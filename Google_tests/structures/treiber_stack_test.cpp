@@ -0,0 +1,203 @@
+#include "gtest/gtest.h"
+#include "../common/test_utils.h"
+#include "../../code/cas/cas.h"
+#include "../../code/common/constants_and_types.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/persistent_stack/persistent_stack.h"
+#include "../../code/storage/global_storage.h"
+#include "../../code/storage/global_non_owning_storage.h"
+#include "../../code/storage/thread_local_non_owning_storage.h"
+#include "../../code/storage/thread_local_owning_storage.h"
+#include "../../code/model/function_address_holder.h"
+#include "../../code/model/cur_thread_id_holder.h"
+#include "../../code/model/total_thread_count_holder.h"
+#include "../../code/model/system_mode.h"
+#include "../../code/runtime/restoration.h"
+#include "../../code/runtime/answer.h"
+#include "../../code/structures/node_pool.h"
+#include "../../code/structures/structures_common.h"
+#include "../../code/structures/treiber_stack.h"
+#include "../../code/allocation/heap_collector.h"
+#include <cstring>
+#include <unordered_set>
+
+namespace
+{
+    const uint64_t STACK_OFFSET = 0;
+    const uint64_t NODES_OFFSET = 4096;
+
+    /**
+     * Heap with pool of nodes and empty stack, and stack of the current thread, containing only the first frame.
+     */
+    struct stack_test_env
+    {
+        temp_file heap_file;
+        temp_file stack_file;
+        persistent_memory_holder heap;
+        persistent_memory_holder stack;
+        node_pool pool;
+
+        explicit stack_test_env(uint64_t max_nodes) :
+                heap_file(get_temp_file_name("heap")),
+                stack_file(get_temp_file_name("stack")),
+                heap(heap_file.file_name, false, PMEM_HEAP_SIZE),
+                stack(stack_file.file_name, false, PMEM_STACK_SIZE),
+                pool(heap.get_pmem_ptr(), NODES_OFFSET, max_nodes, true)
+        {
+            global_non_owning_storage<persistent_memory_holder>::ptr = &heap;
+            global_non_owning_storage<node_pool>::ptr = &pool;
+            thread_local_non_owning_storage<persistent_memory_holder>::ptr = &stack;
+            thread_local_owning_storage<ram_stack>::set_object(ram_stack());
+            add_new_frame(
+                    thread_local_owning_storage<ram_stack>::get_object(),
+                    stack_frame("main_function", std::vector<uint8_t>()),
+                    stack
+            );
+            global_storage<total_thread_count_holder>::set_object(total_thread_count_holder(1));
+            thread_local_owning_storage<cur_thread_id_holder>::set_object(cur_thread_id_holder(0));
+            function_address_holder func_map;
+            register_structure_functions(func_map);
+            global_storage<function_address_holder>::set_object(std::move(func_map));
+            global_storage<system_mode>::set_object(system_mode::EXECUTION);
+            init_treiber_stack(STACK_OFFSET);
+        }
+
+        ~stack_test_env()
+        {
+            global_non_owning_storage<node_pool>::ptr = nullptr;
+        }
+    };
+
+    /*
+     * Performs CAS and crashes before the answer is written
+     */
+    void cas_and_crash(const uint8_t* args)
+    {
+        uint64_t var_offset;
+        std::memcpy(&var_offset, args, 8);
+        uint32_t expected_value;
+        std::memcpy(&expected_value, args + 8, 4);
+        uint32_t new_value;
+        std::memcpy(&new_value, args + 12, 4);
+        uint64_t thread_matrix_offset;
+        std::memcpy(&thread_matrix_offset, args + 16, 8);
+        uint8_t* pmem_start_address = global_non_owning_storage<persistent_memory_holder>::ptr->get_pmem_ptr();
+        cas_internal(
+                (uint64_t*) (pmem_start_address + var_offset),
+                expected_value,
+                new_value,
+                0,
+                1,
+                (uint32_t*) (pmem_start_address + thread_matrix_offset)
+        );
+        throw std::runtime_error("ha-ha, system crash go brrrrr");
+    }
+
+    void set_cas(function_ptr cas_function)
+    {
+        global_storage<function_address_holder>::get_object().funcs["cas"] = {cas_function, cas_recover};
+    }
+
+    void restore(persistent_memory_holder& stack)
+    {
+        global_storage<system_mode>::set_object(system_mode::RECOVERY);
+        set_cas(cas);
+        do_restoration(stack);
+        global_storage<system_mode>::set_object(system_mode::EXECUTION);
+    }
+}
+
+TEST(treiber_stack, push_pop_lifo)
+{
+    stack_test_env env(16);
+
+    EXPECT_TRUE(treiber_stack_push(STACK_OFFSET, 1));
+    EXPECT_TRUE(treiber_stack_push(STACK_OFFSET, 2));
+    EXPECT_EQ(treiber_stack_pop(STACK_OFFSET), std::make_optional(2u));
+    EXPECT_EQ(treiber_stack_pop(STACK_OFFSET), std::make_optional(1u));
+    EXPECT_EQ(treiber_stack_pop(STACK_OFFSET), std::nullopt);
+}
+
+TEST(treiber_stack, push_fails_if_out_of_nodes)
+{
+    stack_test_env env(1);
+
+    EXPECT_TRUE(treiber_stack_push(STACK_OFFSET, 1));
+    EXPECT_FALSE(treiber_stack_push(STACK_OFFSET, 2));
+}
+
+TEST(treiber_stack, push_recovered_after_crash_in_cas)
+{
+    stack_test_env env(16);
+
+    set_cas(cas_and_crash);
+    EXPECT_THROW(treiber_stack_push(STACK_OFFSET, 7), std::runtime_error);
+    restore(env.stack);
+
+    /*
+     * Answer of push has been written during recovery, value has been pushed exactly once
+     */
+    EXPECT_EQ(read_answer(1)[0], 0x1);
+    EXPECT_EQ(treiber_stack_pop(STACK_OFFSET), std::make_optional(7u));
+    EXPECT_EQ(treiber_stack_pop(STACK_OFFSET), std::nullopt);
+}
+
+TEST(treiber_stack, pop_recovered_after_crash_in_cas)
+{
+    stack_test_env env(16);
+
+    EXPECT_TRUE(treiber_stack_push(STACK_OFFSET, 7));
+    set_cas(cas_and_crash);
+    EXPECT_THROW(treiber_stack_pop(STACK_OFFSET), std::runtime_error);
+    restore(env.stack);
+
+    /*
+     * Answer of pop has been written and popped node has been freed during recovery
+     */
+    const std::vector<uint8_t> answer = read_answer(8);
+    EXPECT_EQ(answer[0], 0x1);
+    uint32_t value;
+    std::memcpy(&value, answer.data() + 4, 4);
+    EXPECT_EQ(value, 7);
+    EXPECT_FALSE(env.pool.is_allocated(1));
+    EXPECT_EQ(treiber_stack_pop(STACK_OFFSET), std::nullopt);
+}
+
+TEST(treiber_stack, leaked_nodes_collected)
+{
+    stack_test_env env(16);
+
+    EXPECT_TRUE(treiber_stack_push(STACK_OFFSET, 1));
+    /*
+     * Node, which answer of pds_alloc has been lost, and node of push, that is still in progress
+     */
+    const uint32_t leaked_index = env.pool.allocate_node();
+    const uint32_t in_flight_index = env.pool.allocate_node();
+    std::vector<uint8_t> push_args(12);
+    add_new_frame(
+            thread_local_owning_storage<ram_stack>::get_object(),
+            stack_frame("treiber_push", push_args),
+            env.stack,
+            make_operation_state(PDS_NODE_ALLOCATED, in_flight_index, 0)
+    );
+    ram_stack const& r_stack = thread_local_owning_storage<ram_stack>::get_const_object();
+    EXPECT_EQ(get_operation_node_index(r_stack.get_last_frame(), env.stack.get_pmem_ptr()), in_flight_index);
+    EXPECT_EQ(get_operation_node_index(r_stack.get_frame(0), env.stack.get_pmem_ptr()), std::nullopt);
+
+    std::unordered_set<uint64_t> roots;
+    const std::vector<uint32_t> stack_nodes = get_treiber_stack_nodes(STACK_OFFSET);
+    EXPECT_EQ(stack_nodes.size(), 1);
+    for (const uint32_t node_index : stack_nodes)
+    {
+        roots.insert(env.pool.get_node_offset(node_index));
+    }
+    roots.insert(env.pool.get_node_offset(in_flight_index));
+    heap_collector collector(env.pool.get_allocator(), env.heap.get_pmem_ptr(), std::move(roots), true);
+    collector.run(1);
+
+    const std::vector<uint64_t> expected_leaked = {env.pool.get_node_offset(leaked_index)};
+    EXPECT_EQ(collector.get_report().leaked_offsets, expected_leaked);
+    EXPECT_FALSE(env.pool.is_allocated(leaked_index));
+    EXPECT_TRUE(env.pool.is_allocated(in_flight_index));
+    EXPECT_TRUE(env.pool.is_allocated(stack_nodes[0]));
+}
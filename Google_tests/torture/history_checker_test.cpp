@@ -0,0 +1,63 @@
+#include "gtest/gtest.h"
+#include "../../tools/torture/history_checker.h"
+
+TEST(history_checker, parse_record)
+{
+    std::optional<cas_record> record = parse_cas_record(
+            "CAS: var_offset = 262208, expected_value = 42, new_value = 43, thread id = 3, result = 1"
+    );
+    ASSERT_TRUE(record.has_value());
+    EXPECT_EQ(record->var_offset, 262208);
+    EXPECT_EQ(record->expected_value, 42);
+    EXPECT_EQ(record->new_value, 43);
+    EXPECT_EQ(record->thread_id, 3);
+    EXPECT_TRUE(record->result);
+
+    EXPECT_FALSE(parse_cas_record("register value = 43, cur thread id = 1").has_value());
+}
+
+TEST(history_checker, linearizable_history)
+{
+    std::vector<cas_record> records({
+            cas_record{64, 42, 43, 0, true},
+            cas_record{64, 42, 44, 1, false},
+            cas_record{64, 43, 45, 1, true},
+            /*
+             * Logged again after the recovery
+             */
+            cas_record{64, 43, 45, 1, true},
+            cas_record{128, 42, 46, 0, false}
+    });
+    std::map<uint64_t, uint32_t> final_values({{64, 45}, {128, 42}});
+    EXPECT_TRUE(check_cas_history(records, final_values, 42).empty());
+}
+
+TEST(history_checker, two_successful_cas_from_the_same_value)
+{
+    std::vector<cas_record> records({
+            cas_record{64, 42, 43, 0, true},
+            cas_record{64, 42, 44, 1, true}
+    });
+    std::map<uint64_t, uint32_t> final_values({{64, 44}});
+    EXPECT_FALSE(check_cas_history(records, final_values, 42).empty());
+}
+
+TEST(history_checker, failed_cas_installed_value)
+{
+    std::vector<cas_record> records({
+            cas_record{64, 42, 43, 0, true},
+            cas_record{64, 43, 44, 1, false}
+    });
+    std::map<uint64_t, uint32_t> final_values({{64, 44}});
+    EXPECT_FALSE(check_cas_history(records, final_values, 42).empty());
+}
+
+TEST(history_checker, different_results_of_the_same_cas)
+{
+    std::vector<cas_record> records({
+            cas_record{64, 42, 43, 0, false},
+            cas_record{64, 42, 43, 0, true}
+    });
+    std::map<uint64_t, uint32_t> final_values({{64, 43}});
+    EXPECT_FALSE(check_cas_history(records, final_values, 42).empty());
+}
@@ -0,0 +1,167 @@
+#include "heap_collector.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+const uint64_t heap_collector::DEFAULT_CHUNK_SIZE = 4096;
+
+namespace
+{
+    uint64_t check_chunk_size(uint64_t chunk_size)
+    {
+        if (chunk_size == 0)
+        {
+            throw std::runtime_error("Chunk of the heap must contain at least one block");
+        }
+        return chunk_size;
+    }
+}
+
+heap_collector::heap_collector(pmem_allocator& _allocator,
+                               uint8_t* _heap_ptr,
+                               std::unordered_set<uint64_t> _roots,
+                               bool _free_leaked,
+                               uint64_t _chunk_size) :
+        allocator(_allocator),
+        heap_ptr(_heap_ptr),
+        roots(std::move(_roots)),
+        free_leaked(_free_leaked),
+        chunk_size(check_chunk_size(_chunk_size)),
+        blocks_end(_allocator.get_allocation_border() + 1),
+        number_of_chunks((blocks_end + chunk_size - 1) / chunk_size),
+        next_chunk(0),
+        live_blocks(0),
+        leaked_blocks(number_of_chunks),
+        finished(false),
+        duration(0)
+{}
+
+void heap_collector::scan_chunk(uint64_t chunk_number)
+{
+    const uint64_t first_block = chunk_number * chunk_size;
+    const uint64_t last_block = std::min(first_block + chunk_size, blocks_end);
+    uint64_t cur_live_blocks = 0;
+    for (uint8_t* const block : allocator.get_allocated_blocks(first_block, last_block))
+    {
+        if (roots.count(block - heap_ptr) == 0)
+        {
+            leaked_blocks[chunk_number].push_back(block);
+        }
+        else
+        {
+            cur_live_blocks++;
+        }
+    }
+    live_blocks.fetch_add(cur_live_blocks);
+}
+
+bool heap_collector::step()
+{
+    if (finished)
+    {
+        return false;
+    }
+    const std::chrono::steady_clock::time_point step_start = std::chrono::steady_clock::now();
+    const uint64_t chunk_number = next_chunk.fetch_add(1);
+    if (chunk_number < number_of_chunks)
+    {
+        scan_chunk(chunk_number);
+    }
+    if (chunk_number + 1 >= number_of_chunks)
+    {
+        finish();
+    }
+    duration += std::chrono::steady_clock::now() - step_start;
+    return !finished;
+}
+
+void heap_collector::run(uint32_t number_of_threads)
+{
+    if (number_of_threads == 0)
+    {
+        throw std::runtime_error("Cannot collect the heap without threads");
+    }
+    if (finished)
+    {
+        return;
+    }
+    const std::chrono::steady_clock::time_point run_start = std::chrono::steady_clock::now();
+    /*
+     * Each of the threads takes chunks, until all of them are taken. Caller thread is one of the threads.
+     */
+    const auto scan_chunks = [this]()
+    {
+        while (true)
+        {
+            const uint64_t chunk_number = next_chunk.fetch_add(1);
+            if (chunk_number >= number_of_chunks)
+            {
+                return;
+            }
+            scan_chunk(chunk_number);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (uint32_t thread_number = 1; thread_number < std::min<uint64_t>(number_of_threads, number_of_chunks);
+         thread_number++)
+    {
+        threads.emplace_back(scan_chunks);
+    }
+    scan_chunks();
+    for (std::thread& cur_thread: threads)
+    {
+        cur_thread.join();
+    }
+    finish();
+    duration += std::chrono::steady_clock::now() - run_start;
+}
+
+void heap_collector::finish()
+{
+    if (free_leaked)
+    {
+        /*
+         * Chunks are freed from the end of the heap, so that allocation border is moved to the left
+         * over blocks, that have been freed already, as few times as possible
+         */
+        for (auto it = leaked_blocks.rbegin(); it != leaked_blocks.rend(); ++it)
+        {
+            if (!it->empty())
+            {
+                allocator.pmem_free_batch(*it);
+            }
+        }
+    }
+    finished = true;
+}
+
+bool heap_collector::is_finished() const
+{
+    return finished;
+}
+
+heap_collection_report heap_collector::get_report() const
+{
+    if (!finished)
+    {
+        throw std::runtime_error("Heap collection hasn't been finished yet");
+    }
+    std::vector<uint64_t> leaked_offsets;
+    for (std::vector<uint8_t*> const& chunk_blocks : leaked_blocks)
+    {
+        for (uint8_t* const block : chunk_blocks)
+        {
+            leaked_offsets.push_back(block - heap_ptr);
+        }
+    }
+    /*
+     * Block 0 is never given to user, therefore it isn't scanned
+     */
+    return heap_collection_report{
+            blocks_end - 1,
+            live_blocks.load(),
+            std::move(leaked_offsets),
+            free_leaked,
+            duration
+    };
+}
@@ -0,0 +1,157 @@
+#ifndef DIPLOM_HEAP_COLLECTOR_H
+#define DIPLOM_HEAP_COLLECTOR_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#include "pmem_allocator.h"
+
+/**
+ * Result of the heap collection.
+ */
+struct heap_collection_report
+{
+    /**
+     * Number of blocks, which allocation markers have been checked.
+     */
+    uint64_t scanned_blocks;
+
+    /**
+     * Number of allocated blocks, that are reachable from the roots.
+     */
+    uint64_t live_blocks;
+
+    /**
+     * Offsets of allocated blocks (from the beginning of the heap), that are unreachable from the roots,
+     * in ascending order.
+     */
+    std::vector<uint64_t> leaked_offsets;
+
+    /**
+     * True, if leaked blocks have been freed.
+     */
+    bool leaked_freed;
+
+    /**
+     * Time, spent on scanning the heap and freeing leaked blocks.
+     */
+    std::chrono::nanoseconds duration;
+};
+
+/**
+ * Leak detector and garbage collector of blocks of pmem_allocator. Allocation markers record only, whether
+ * the block is allocated, therefore block, owner of which has been lost in the crash (e.g. answer location of
+ * the task, that had been allocated by the load generator, but hadn't been executed before the crash), stays
+ * allocated forever. Collector finds allocated blocks, that are not reachable from the roots (offsets of blocks,
+ * that are still used, see get_task_answer_offset), reports them as leaked and frees them, if requested.
+ * Leaked nodes of data structures (node allocated by pds_alloc, which answer has been lost, or node, that has been
+ * removed, but not freed, because the operation has written it's answer before the crash) are collected in the same
+ * way, using allocator of node_pool (see node_pool::get_allocator). Roots are then offsets of nodes of all data
+ * structures in the pool (see get_treiber_stack_nodes and similar functions) and of nodes, used by operations
+ * in frames of the stacks (see get_operation_node_index). Data structures are not registered in the heap, therefore
+ * only their owner can provide these roots: collection of nodes without roots of some structure frees it's nodes.
+ *
+ * Allocation range of the heap is split into chunks of blocks, which are scanned independently of each other:
+ * either incrementally, one chunk per step, or by a pool of threads, each of which repeatedly takes the next chunk,
+ * that hasn't been scanned yet. Leaked blocks are freed after the whole heap has been scanned, using single drain per
+ * chunk. Blocks are checked without acquiring the mutex of the allocator, therefore allocator must not be used
+ * by other threads, until the collection is finished (e.g. collection should be run after restoration, but before
+ * execution is continued).
+ */
+struct heap_collector
+{
+public:
+    /**
+     * Number of blocks in a chunk, if not specified otherwise.
+     */
+    static const uint64_t DEFAULT_CHUNK_SIZE;
+
+    /**
+     * Prepares collection of all blocks, that are allocated by the moment of creation of the collector.
+     * @param _allocator - allocator, blocks of which are collected.
+     * @param _heap_ptr - pointer to the beginning of the heap, from which offsets of the roots are calculated.
+     * @param _roots - offsets of the first bytes of blocks, that are still used.
+     * @param _free_leaked - if true, leaked blocks are freed, otherwise they are only reported.
+     * @param _chunk_size - number of blocks in a chunk, must be positive.
+     * @throws std::runtime_error - if chunk size is zero.
+     */
+    heap_collector(pmem_allocator& _allocator,
+                   uint8_t* _heap_ptr,
+                   std::unordered_set<uint64_t> _roots,
+                   bool _free_leaked,
+                   uint64_t _chunk_size = DEFAULT_CHUNK_SIZE);
+
+    /**
+     * Scans the next chunk, that hasn't been scanned yet. After the last chunk is scanned, leaked blocks
+     * are freed (if requested) and the collection is finished.
+     * @return true, if there are chunks, that haven't been scanned yet, false, if the collection is finished.
+     */
+    bool step();
+
+    /**
+     * Scans all chunks, that haven't been scanned yet, using pool of threads, and finishes the collection.
+     * @param number_of_threads - maximal number of threads, that scan chunks simultaneously, must be positive.
+     * @throws std::runtime_error - if number of threads is zero.
+     */
+    void run(uint32_t number_of_threads);
+
+    [[nodiscard]] bool is_finished() const;
+
+    /**
+     * Returns result of the collection.
+     * @return report of the finished collection.
+     * @throws std::runtime_error - if the collection hasn't been finished yet.
+     */
+    [[nodiscard]] heap_collection_report get_report() const;
+
+private:
+    /**
+     * Finds leaked blocks of the chunk. Can be called by several threads for different chunks simultaneously.
+     * @param chunk_number - number of the chunk.
+     */
+    void scan_chunk(uint64_t chunk_number);
+
+    /**
+     * Frees leaked blocks (if requested) and finishes the collection. Must be called once, after all chunks
+     * have been scanned.
+     */
+    void finish();
+
+    pmem_allocator& allocator;
+
+    uint8_t* const heap_ptr;
+
+    const std::unordered_set<uint64_t> roots;
+
+    const bool free_leaked;
+
+    const uint64_t chunk_size;
+
+    /**
+     * Number of the first block after the last allocated block at the moment of creation of the collector.
+     */
+    const uint64_t blocks_end;
+
+    const uint64_t number_of_chunks;
+
+    /**
+     * Number of the next chunk, that hasn't been taken by any thread yet.
+     */
+    std::atomic<uint64_t> next_chunk;
+
+    std::atomic<uint64_t> live_blocks;
+
+    /**
+     * Leaked blocks of each of the chunks. Each element is written by the single thread, that scanned the chunk.
+     */
+    std::vector<std::vector<uint8_t*>> leaked_blocks;
+
+    bool finished;
+
+    std::chrono::nanoseconds duration;
+};
+
+#endif //DIPLOM_HEAP_COLLECTOR_H
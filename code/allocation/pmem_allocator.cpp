@@ -1,7 +1,11 @@
 #include "pmem_allocator.h"
+#include "../common/crash_injection.h"
+#include "../metrics/runtime_metrics.h"
 
+#include <algorithm>
 #include <cstring>
 #include <cassert>
+#include <vector>
 
 pmem_allocator::pmem_allocator(uint8_t* _heap_ptr, uint32_t _block_size, uint64_t _max_border, bool init_new)
         : heap_ptr(_heap_ptr),
@@ -23,11 +27,17 @@ pmem_allocator::pmem_allocator(uint8_t* _heap_ptr, uint32_t _block_size, uint64_
         /*
          * Traverse heap from beginning to end
          */
+        std::vector<uint64_t> retired_blocks;
         uint64_t cur_block_num = 0;
         while (true)
         {
             uint8_t cur_marker;
             std::memcpy(&cur_marker, heap_ptr + get_block_end(cur_block_num), 1);
+            if ((cur_marker & RETIRED_BLOCK_FLAG) != 0)
+            {
+                retired_blocks.push_back(cur_block_num);
+                cur_marker &= ~RETIRED_BLOCK_FLAG;
+            }
             assert(cur_marker == HEAP_END_MARKER
                    || cur_marker == ALLOCATED_BLOCK_MARKER || cur_marker == FREED_BLOCK_MARKER);
             if (cur_marker == HEAP_END_MARKER)
@@ -36,7 +46,7 @@ pmem_allocator::pmem_allocator(uint8_t* _heap_ptr, uint32_t _block_size, uint64_
                  * Reached heap end, all further blocks are not allocated.
                  */
                 allocation_border = cur_block_num;
-                return;
+                break;
             }
             else if (cur_marker == FREED_BLOCK_MARKER)
             {
@@ -48,6 +58,15 @@ pmem_allocator::pmem_allocator(uint8_t* _heap_ptr, uint32_t _block_size, uint64_
             }
             cur_block_num++;
         }
+        /*
+         * No thread can access retired blocks after the crash. Blocks are freed from the end of the heap,
+         * so that each of them is either before the heap end or is the heap end itself.
+         */
+        for (auto it = retired_blocks.rbegin(); it != retired_blocks.rend(); ++it)
+        {
+            free_block(*it);
+        }
+        pmem_do_drain();
     }
 }
 
@@ -68,8 +87,27 @@ uint64_t pmem_allocator::get_block_num(uint64_t block_offset) const
     return block_offset / (block_size + 1);
 }
 
+uint8_t pmem_allocator::get_marker(uint64_t block_num) const
+{
+    uint8_t marker;
+    std::memcpy(&marker, heap_ptr + get_block_end(block_num), 1);
+    return marker & ~RETIRED_BLOCK_FLAG;
+}
+
+void pmem_allocator::set_allocated_marker(uint64_t block_num, uint8_t marker)
+{
+    uint8_t* const block_end = heap_ptr + get_block_end(block_num);
+    const uint8_t new_marker = marker | (*block_end & RETIRED_BLOCK_FLAG);
+    std::memcpy(block_end, &new_marker, 1);
+    pmem_do_flush_without_drain(block_end, 1, flush_site::ALLOCATOR_MARKER);
+}
+
 uint8_t* pmem_allocator::pmem_alloc()
 {
+    /*
+     * Latency includes waiting for the mutex
+     */
+    METRICS_SCOPED_LATENCY(metrics_histogram::ALLOCATION);
     std::unique_lock lock(mutex);
     if (!freed_blocks.empty())
     {
@@ -84,7 +122,10 @@ uint8_t* pmem_allocator::pmem_alloc()
          */
         uint64_t freed_block_end = get_block_end(freed_block_num);
         std::memcpy(heap_ptr + freed_block_end, &ALLOCATED_BLOCK_MARKER, 1);
-        pmem_do_flush(heap_ptr + freed_block_end, 1);
+        pmem_do_flush(heap_ptr + freed_block_end, 1, flush_site::ALLOCATOR_MARKER);
+        CRASH_POINT("pmem_alloc:after_reuse");
+        METRICS_INCREMENT(metrics_counter::ALLOCATIONS, 1);
+        METRICS_INCREMENT(metrics_counter::ALLOCATIONS_FROM_FREED, 1);
 
         /*
          * Return pointer to block
@@ -93,6 +134,7 @@ uint8_t* pmem_allocator::pmem_alloc()
     }
     if (allocation_border == max_border)
     {
+        METRICS_INCREMENT(metrics_counter::FAILED_ALLOCATIONS, 1);
         throw std::runtime_error("Cannot perform allocation: all blocks have already been allocated");
     }
 
@@ -104,33 +146,64 @@ uint8_t* pmem_allocator::pmem_alloc()
      * Last allocated byte of heap (i.e. last byte of the last allocated block)
      */
     const uint64_t new_heap_end = get_block_end(new_allocation_border);
-    /*
-     * Before current allocation, this byte was the last allocated byte.
-     */
-    const uint64_t old_heap_end = get_block_end(allocation_border);
     /*
      * Marking new heap end as allocated block.
      */
     std::memcpy(heap_ptr + new_heap_end, &HEAP_END_MARKER, 1);
-    pmem_do_flush(heap_ptr + new_heap_end, 1);
+    pmem_do_flush(heap_ptr + new_heap_end, 1, flush_site::ALLOCATOR_MARKER);
+    CRASH_POINT("pmem_alloc:between_heap_end_markers");
     /*
      * Marking previous heap end as ordinary allocated block, i.e. moving heap end forward.
+     * Previous heap end can be retired.
      */
-    std::memcpy(heap_ptr + old_heap_end, &ALLOCATED_BLOCK_MARKER, 1);
-    pmem_do_flush(heap_ptr + old_heap_end, 1);
+    set_allocated_marker(allocation_border, ALLOCATED_BLOCK_MARKER);
+    pmem_do_drain();
 
     /*
      * Increasing allocation border
      */
     allocation_border = new_allocation_border;
+    METRICS_INCREMENT(metrics_counter::ALLOCATIONS, 1);
 
     return heap_ptr + get_block_start(new_allocation_border);
 }
 
 void pmem_allocator::pmem_free(uint8_t* ptr)
 {
+    METRICS_SCOPED_LATENCY(metrics_histogram::FREE);
+    METRICS_INCREMENT(metrics_counter::FREES, 1);
     std::unique_lock lock(mutex);
-    uint64_t block_num = get_block_num(ptr - heap_ptr);
+    free_block(get_block_num(ptr - heap_ptr));
+    pmem_do_drain();
+}
+
+void pmem_allocator::pmem_free_batch(std::vector<uint8_t*> const& ptrs)
+{
+    METRICS_SCOPED_LATENCY(metrics_histogram::FREE);
+    METRICS_INCREMENT(metrics_counter::FREES, ptrs.size());
+    std::unique_lock lock(mutex);
+    for (uint8_t* const ptr : ptrs)
+    {
+        free_block(get_block_num(ptr - heap_ptr));
+    }
+    /*
+     * Markers can become durable in any order: each block is either freed, or is still allocated (or retired)
+     */
+    pmem_do_drain();
+}
+
+void pmem_allocator::pmem_retire(uint8_t* ptr)
+{
+    std::unique_lock lock(mutex);
+    uint8_t* const block_end = heap_ptr + get_block_end(get_block_num(ptr - heap_ptr));
+    assert(*block_end == ALLOCATED_BLOCK_MARKER || *block_end == HEAP_END_MARKER);
+    const uint8_t new_marker = *block_end | RETIRED_BLOCK_FLAG;
+    std::memcpy(block_end, &new_marker, 1);
+    pmem_do_flush(block_end, 1, flush_site::ALLOCATOR_MARKER);
+}
+
+void pmem_allocator::free_block(uint64_t block_num)
+{
     assert(block_num > 0 && block_num <= allocation_border);
 
     if (block_num < allocation_border)
@@ -141,7 +214,7 @@ void pmem_allocator::pmem_free(uint8_t* ptr)
         freed_blocks.insert(block_num);
         uint64_t block_end = get_block_end(block_num);
         std::memcpy(heap_ptr + block_end, &FREED_BLOCK_MARKER, 1);
-        pmem_do_flush(heap_ptr + block_end, 1);
+        pmem_do_flush_without_drain(heap_ptr + block_end, 1, flush_site::ALLOCATOR_MARKER);
         return;
     }
 
@@ -149,11 +222,11 @@ void pmem_allocator::pmem_free(uint8_t* ptr)
      * Freed block is last allocated block. Find previous allocate block.
      * Traversing from heap end to beginning.
      */
+    CRASH_POINT("pmem_free:before_heap_end_move");
     uint64_t previous_allocated_block = block_num - 1;
     while (true)
     {
-        uint8_t cur_marker;
-        std::memcpy(&cur_marker, heap_ptr + get_block_end(previous_allocated_block), 1);
+        const uint8_t cur_marker = get_marker(previous_allocated_block);
         assert(cur_marker == ALLOCATED_BLOCK_MARKER || cur_marker == FREED_BLOCK_MARKER);
         if (cur_marker == FREED_BLOCK_MARKER)
         {
@@ -174,8 +247,7 @@ void pmem_allocator::pmem_free(uint8_t* ptr)
             break;
         }
     }
-    std::memcpy(heap_ptr + get_block_end(previous_allocated_block), &HEAP_END_MARKER, 1);
-    pmem_do_flush(heap_ptr + get_block_end(previous_allocated_block), 1);
+    set_allocated_marker(previous_allocated_block, HEAP_END_MARKER);
     allocation_border = previous_allocated_block;
 }
 
@@ -187,8 +259,43 @@ bool pmem_allocator::is_allocated(uint8_t* ptr)
     {
         return false;
     }
-    uint8_t cur_marker;
-    std::memcpy(&cur_marker, heap_ptr + get_block_end(block_num), 1);
+    const uint8_t cur_marker = get_marker(block_num);
     assert(cur_marker == FREED_BLOCK_MARKER || cur_marker == HEAP_END_MARKER || cur_marker == ALLOCATED_BLOCK_MARKER);
     return cur_marker != FREED_BLOCK_MARKER;
 }
+
+uint64_t pmem_allocator::get_allocation_border()
+{
+    std::unique_lock lock(mutex);
+    return allocation_border;
+}
+
+std::vector<uint8_t*> pmem_allocator::get_allocated_blocks(uint64_t first_block, uint64_t last_block) const
+{
+    std::vector<uint8_t*> result;
+    for (uint64_t block_num = std::max<uint64_t>(first_block, 1); block_num < last_block; block_num++)
+    {
+        if (get_marker(block_num) != FREED_BLOCK_MARKER)
+        {
+            result.push_back(heap_ptr + get_block_start(block_num));
+        }
+    }
+    return result;
+}
+
+block_state pmem_allocator::read_block_state(const uint8_t* heap_ptr, uint32_t block_size, uint64_t block_num)
+{
+    const uint8_t marker = heap_ptr[block_num * (block_size + 1) + block_size];
+    const bool retired = (marker & RETIRED_BLOCK_FLAG) != 0;
+    switch (marker & ~RETIRED_BLOCK_FLAG)
+    {
+        case ALLOCATED_BLOCK_MARKER:
+            return retired ? block_state::RETIRED : block_state::ALLOCATED;
+        case HEAP_END_MARKER:
+            return retired ? block_state::RETIRED_HEAP_END : block_state::HEAP_END;
+        case FREED_BLOCK_MARKER:
+            return retired ? block_state::INVALID : block_state::FREED;
+        default:
+            return block_state::INVALID;
+    }
+}
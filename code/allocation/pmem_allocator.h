@@ -3,9 +3,35 @@
 
 #include <cstdint>
 #include <unordered_set>
+#include <vector>
 #include "../common/pmem_utils.h"
 #include <mutex>
 
+/**
+ * State of the block of pmem_allocator, as it is recorded by the allocation marker of the block.
+ */
+enum class block_state
+{
+    ALLOCATED,
+    /*
+     * Allocated block, that has been retired (see pmem_allocator::pmem_retire)
+     */
+    RETIRED,
+    /*
+     * The last allocated block of the heap
+     */
+    HEAP_END,
+    /*
+     * The last allocated block of the heap, that has been retired
+     */
+    RETIRED_HEAP_END,
+    FREED,
+    /*
+     * Marker, that is never written by the allocator
+     */
+    INVALID
+};
+
 /**
  * Allocator, that allocates and frees blocks of fixed size in persistent memory heap.
  * Allocator doesn't own pointer to persistent memory heap. Also, it doesn't own file,
@@ -41,6 +67,21 @@ public:
      */
     void pmem_free(uint8_t* ptr);
 
+    /**
+     * Frees several blocks, making all allocation markers durable using single drain.
+     * @param ptrs - pointers to the first bytes of the blocks, that should be freed.
+     */
+    void pmem_free_batch(std::vector<uint8_t*> const& ptrs);
+
+    /**
+     * Marks allocated block as retired: block can still be accessed and is not given to other users,
+     * but it will be freed by the allocator after the crash (or end of the work). Is used by safe memory reclamation
+     * (see epoch_manager), which frees retired blocks, when they can no longer be accessed by other threads,
+     * so that blocks, retired before the crash, are not leaked.
+     * @param ptr - pointer to the first byte of allocated block.
+     */
+    void pmem_retire(uint8_t* ptr);
+
     /**
      * Returns true, if ptr is pointer to the beginning of block, that was allocated and hasn't been freed yet,
      * false otherwise. Parameter must be a valid pointer to beginning of some block (possibly not allocated),
@@ -49,6 +90,36 @@ public:
      * @return true, if ptr is pointer to the beginning of allocated block, false otherwise.
      */
     bool is_allocated(uint8_t* ptr);
+
+    /**
+     * Returns current allocation border, i.e. number of the last block, that can be allocated. Blocks
+     * with numbers from 1 to allocation border (inclusively) are either allocated or freed, block 0
+     * is never given to user.
+     * @return allocation border, 0 if no block is allocated.
+     */
+    uint64_t get_allocation_border();
+
+    /**
+     * Finds allocated (or retired) blocks among blocks with numbers [first_block, last_block). Allocation markers
+     * are read without acquiring the mutex, so that several threads can scan different ranges of the heap
+     * simultaneously, therefore this function must not be called concurrently with allocation or freeing of blocks.
+     * @param first_block - number of the first block of the range, blocks before the first one are never returned.
+     * @param last_block - number of the first block after the range, not greater than allocation border + 1.
+     * @return pointers to the first bytes of allocated blocks in ascending order.
+     */
+    std::vector<uint8_t*> get_allocated_blocks(uint64_t first_block, uint64_t last_block) const;
+
+    /**
+     * Reads state of the block directly from persistent memory, without restoring the allocator, therefore
+     * can be used to inspect the heap, which is not used by any allocator (e.g. heap, mapped for reading only).
+     * Blocks after the block with heap end marker have never been allocated (or have been freed), and their
+     * markers are meaningless.
+     * @param heap_ptr - pointer to the beginning of the heap of the allocator.
+     * @param block_size - size of blocks of the allocator (in bytes).
+     * @param block_num - number of the block.
+     * @return state of the block.
+     */
+    static block_state read_block_state(const uint8_t* heap_ptr, uint32_t block_size, uint64_t block_num);
 private:
     /**
      * Retrieves offset of beginning of block. Offset is calculated from the beginning of
@@ -75,6 +146,27 @@ private:
      */
     uint64_t get_block_num(uint64_t block_offset) const;
 
+    /**
+     * Reads allocation marker of the block without RETIRED_BLOCK_FLAG.
+     * @param block_num - number of the block.
+     * @return ALLOCATED_BLOCK_MARKER, HEAP_END_MARKER or FREED_BLOCK_MARKER.
+     */
+    uint8_t get_marker(uint64_t block_num) const;
+
+    /**
+     * Writes allocation marker of allocated block, keeping RETIRED_BLOCK_FLAG, if the block has been retired.
+     * Marker is flushed without drain.
+     * @param block_num - number of the block.
+     * @param marker - ALLOCATED_BLOCK_MARKER or HEAP_END_MARKER.
+     */
+    void set_allocated_marker(uint64_t block_num, uint8_t marker);
+
+    /**
+     * Frees single block, flushing allocation markers without drain. Mutex must be held by the caller.
+     * @param block_num - number of allocated block.
+     */
+    void free_block(uint64_t block_num);
+
     /**
      * Block is allocated. There exists some other allocated blocks with bigger offsets
      * (and therefore bigger block numbers).
@@ -92,6 +184,12 @@ private:
      */
     static const uint8_t FREED_BLOCK_MARKER = 0x2;
 
+    /**
+     * Flag, that is added to marker of allocated block (either ALLOCATED_BLOCK_MARKER or HEAP_END_MARKER),
+     * when the block is retired. Retired blocks are freed, when the allocator is restored.
+     */
+    static const uint8_t RETIRED_BLOCK_FLAG = 0x4;
+
     /**
      * Pointer to the beginning of heap
      */
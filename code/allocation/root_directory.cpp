@@ -0,0 +1,245 @@
+#include "root_directory.h"
+#include "../common/constants_and_types.h"
+#include "../common/crash_injection.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+const uint32_t root_directory::MAX_NAME_LENGTH = 39;
+
+namespace
+{
+    /**
+     * Magic number, which is written to the beginning of heap header ("NVRMROOT").
+     */
+    const uint64_t HEAP_MAGIC = 0x544F4F524D52564EULL;
+
+    const uint8_t ENTRY_NOT_COMMITTED = 0x0;
+
+    const uint8_t ENTRY_COMMITTED = 0x1;
+
+    /*
+     * Layout of the header: 8 bytes of magic, 4 bytes of number of threads, 4 bytes of number of vars
+     */
+    const uint64_t HEADER_THREADS = 8;
+    const uint64_t HEADER_VARS = 12;
+    const uint64_t HEADER_SIZE = 16;
+
+    /*
+     * Layout of the entry
+     */
+    const uint64_t ENTRY_STATE = 0;
+    const uint64_t ENTRY_NAME_LENGTH = 1;
+    const uint64_t ENTRY_OFFSET = 8;
+    const uint64_t ENTRY_SIZE = 16;
+    const uint64_t ENTRY_NAME = 24;
+
+    named_object read_entry(const uint8_t* entry)
+    {
+        named_object object;
+        object.name = std::string((const char*) entry + ENTRY_NAME, entry[ENTRY_NAME_LENGTH]);
+        std::memcpy(&object.offset, entry + ENTRY_OFFSET, 8);
+        std::memcpy(&object.size, entry + ENTRY_SIZE, 8);
+        return object;
+    }
+
+    bool is_earlier(named_object const& a, named_object const& b)
+    {
+        return a.offset < b.offset;
+    }
+}
+
+root_directory::root_directory(uint8_t* _heap_ptr, heap_layout const& _layout, bool init_new) :
+        heap_ptr(_heap_ptr),
+        layout(_layout),
+        entries(
+                _heap_ptr + heap_layout::get_root_directory_offset(),
+                heap_layout::ROOT_ENTRY_BLOCK_SIZE,
+                _layout.get_root_directory_max_border(),
+                init_new
+        ),
+        objects(),
+        objects_end(_layout.get_named_objects_offset()),
+        mutex()
+{
+    uint8_t* const header = heap_ptr + heap_layout::get_root_directory_offset();
+    const uint32_t number_of_threads = layout.get_number_of_threads();
+    const uint32_t number_of_vars = layout.get_number_of_vars();
+    if (init_new)
+    {
+        std::memcpy(header, &HEAP_MAGIC, 8);
+        std::memcpy(header + HEADER_THREADS, &number_of_threads, 4);
+        std::memcpy(header + HEADER_VARS, &number_of_vars, 4);
+        pmem_do_flush(header, HEADER_SIZE);
+        return;
+    }
+
+    const std::optional<heap_header> existing_header = read_header(heap_ptr);
+    if (!existing_header.has_value())
+    {
+        throw std::runtime_error("Persistent heap doesn't contain root directory");
+    }
+    const uint32_t heap_threads = existing_header->number_of_threads;
+    const uint32_t heap_vars = existing_header->number_of_vars;
+    if (heap_threads != number_of_threads || heap_vars != number_of_vars)
+    {
+        throw std::runtime_error(
+                "Persistent heap has been created for " + std::to_string(heap_threads) + " threads and " +
+                std::to_string(heap_vars) + " variables, but " + std::to_string(number_of_threads) +
+                " threads and " + std::to_string(number_of_vars) + " variables are used"
+        );
+    }
+
+    /*
+     * Read committed entries and free entries, which creation has been interrupted by the crash
+     */
+    for (uint64_t block_num = 1; block_num <= layout.get_root_directory_max_border(); block_num++)
+    {
+        uint8_t* const entry = header + block_num * (heap_layout::ROOT_ENTRY_BLOCK_SIZE + 1);
+        if (!entries.is_allocated(entry))
+        {
+            continue;
+        }
+        if (entry[ENTRY_STATE] != ENTRY_COMMITTED)
+        {
+            entries.pmem_free(entry);
+            continue;
+        }
+        const named_object object = read_entry(entry);
+        objects_end = std::max(objects_end, object.offset + get_cache_line_aligned_address(object.size));
+        objects.emplace(object.name, object);
+    }
+}
+
+std::optional<named_object> root_directory::find(std::string const& name)
+{
+    std::unique_lock lock(mutex);
+    const auto it = objects.find(name);
+    if (it == objects.end())
+    {
+        return {};
+    }
+    return it->second;
+}
+
+uint64_t root_directory::get_or_create(std::string const& name,
+                                       uint64_t size,
+                                       std::function<void(uint64_t)> const& init)
+{
+    std::unique_lock lock(mutex);
+    const auto it = objects.find(name);
+    if (it != objects.end())
+    {
+        if (it->second.size != size)
+        {
+            throw std::runtime_error(
+                    "Object " + name + " has size " + std::to_string(it->second.size) + ", but " +
+                    std::to_string(size) + " is requested"
+            );
+        }
+        return it->second.offset;
+    }
+    if (name.empty() || name.size() > MAX_NAME_LENGTH)
+    {
+        throw std::runtime_error("Length of object name must be from 1 to " + std::to_string(MAX_NAME_LENGTH));
+    }
+    if (size == 0)
+    {
+        throw std::runtime_error("Size of object must be positive");
+    }
+    const uint64_t offset = objects_end;
+    const uint64_t aligned_size = get_cache_line_aligned_address(size);
+    if (aligned_size > layout.get_named_objects_offset() + heap_layout::NAMED_OBJECTS_SIZE - offset)
+    {
+        throw std::runtime_error("Object " + name + " doesn't fit into the region of named objects");
+    }
+
+    /*
+     * Throws, if all entries have been allocated
+     */
+    uint8_t* const entry = entries.pmem_alloc();
+    const uint8_t name_length = name.size();
+    entry[ENTRY_STATE] = ENTRY_NOT_COMMITTED;
+    entry[ENTRY_NAME_LENGTH] = name_length;
+    std::memcpy(entry + ENTRY_OFFSET, &offset, 8);
+    std::memcpy(entry + ENTRY_SIZE, &size, 8);
+    std::memcpy(entry + ENTRY_NAME, name.data(), name_length);
+    pmem_do_flush(entry, heap_layout::ROOT_ENTRY_BLOCK_SIZE);
+
+    /*
+     * Space can contain uncommitted object, created before the crash
+     */
+    std::memset(heap_ptr + offset, 0, aligned_size);
+    pmem_do_flush(heap_ptr + offset, aligned_size);
+    if (init)
+    {
+        init(offset);
+    }
+    CRASH_POINT("root_directory:before_commit");
+
+    entry[ENTRY_STATE] = ENTRY_COMMITTED;
+    pmem_do_flush(entry + ENTRY_STATE, 1);
+
+    objects_end = offset + aligned_size;
+    objects.emplace(name, named_object{name, offset, size});
+    return offset;
+}
+
+std::vector<named_object> root_directory::get_objects()
+{
+    std::unique_lock lock(mutex);
+    std::vector<named_object> result;
+    result.reserve(objects.size());
+    for (auto const& [name, object] : objects)
+    {
+        result.push_back(object);
+    }
+    std::sort(result.begin(), result.end(), is_earlier);
+    return result;
+}
+
+std::optional<heap_header> root_directory::read_header(const uint8_t* heap_ptr)
+{
+    const uint8_t* const header = heap_ptr + heap_layout::get_root_directory_offset();
+    uint64_t magic;
+    std::memcpy(&magic, header, 8);
+    if (magic != HEAP_MAGIC)
+    {
+        return {};
+    }
+    heap_header result{};
+    std::memcpy(&result.number_of_threads, header + HEADER_THREADS, 4);
+    std::memcpy(&result.number_of_vars, header + HEADER_VARS, 4);
+    return result;
+}
+
+std::vector<named_object> root_directory::read_objects(const uint8_t* heap_ptr, heap_layout const& layout)
+{
+    const uint8_t* const region = heap_ptr + heap_layout::get_root_directory_offset();
+    std::vector<named_object> result;
+    for (uint64_t block_num = 1; block_num <= layout.get_root_directory_max_border(); block_num++)
+    {
+        const uint8_t* const entry = region + block_num * (heap_layout::ROOT_ENTRY_BLOCK_SIZE + 1);
+        const block_state state = pmem_allocator::read_block_state(
+                region,
+                heap_layout::ROOT_ENTRY_BLOCK_SIZE,
+                block_num
+        );
+        if (state == block_state::ALLOCATED || state == block_state::HEAP_END)
+        {
+            if (entry[ENTRY_STATE] == ENTRY_COMMITTED)
+            {
+                result.push_back(read_entry(entry));
+            }
+        }
+        if (state != block_state::ALLOCATED && state != block_state::FREED)
+        {
+            /*
+             * Blocks after the heap end have never been allocated
+             */
+            break;
+        }
+    }
+    std::sort(result.begin(), result.end(), is_earlier);
+    return result;
+}
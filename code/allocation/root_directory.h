@@ -0,0 +1,157 @@
+#ifndef DIPLOM_ROOT_DIRECTORY_H
+#define DIPLOM_ROOT_DIRECTORY_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+#include "pmem_allocator.h"
+#include "../model/heap_layout.h"
+
+/**
+ * Object of the persistent heap, that can be found by it's name after restart.
+ */
+struct named_object
+{
+    std::string name;
+    /**
+     * Offset of the object from the beginning of the heap, aligned by cache line size.
+     */
+    uint64_t offset;
+    /**
+     * Size of the object in bytes, as requested by the creator of the object.
+     */
+    uint64_t size;
+};
+
+/**
+ * Header of the persistent heap, written by the root directory, when the heap is created.
+ */
+struct heap_header
+{
+    uint32_t number_of_threads;
+    uint32_t number_of_vars;
+};
+
+/**
+ * Root directory of the persistent heap, which maps names of objects (RMW registers, thread matrices, persistent
+ * data structures, etc.) to their locations in the region of named objects (see heap_layout).
+ * Directory doesn't own pointer to persistent memory heap.
+ *
+ * Each entry of the directory occupies a single block of pmem_allocator, located in the root directory region,
+ * and contains:
+ * <ul>
+ *  <li>
+ *      1 byte of state (0x1, if the entry has been committed, 0x0 otherwise) and 1 byte of length of the name
+ *  </li>
+ *  <li>
+ *      8 bytes of offset and 8 bytes of size of the object
+ *  </li>
+ *  <li>
+ *      Name of the object (at most MAX_NAME_LENGTH bytes)
+ *  </li>
+ * </ul>
+ * First block of the allocator (which is never given to user) contains heap header: magic number, number of
+ * threads and number of variables, with which the heap has been created.
+ *
+ * Object is created in the following way: entry is allocated and written with state 0x0, object is zero-filled and
+ * initialized by the creator, and then the entry is committed. After the crash, uncommitted entries are freed,
+ * therefore object either exists and is fully initialized, or doesn't exist at all. Objects are allocated
+ * sequentially from the region of named objects and are never removed, therefore space of uncommitted objects
+ * is reused after restart.
+ */
+struct root_directory
+{
+public:
+    /**
+     * Maximal length of the name of the object.
+     */
+    static const uint32_t MAX_NAME_LENGTH;
+
+    /**
+     * Initializes directory. If init_new is true, writes heap header and initializes empty directory,
+     * otherwise, checks heap header and reads committed entries of the directory.
+     * @param _heap_ptr - pointer to the beginning of the heap.
+     * @param _layout - layout of the heap.
+     * @param init_new - if true, initializes directory from the ground up, otherwise restores it.
+     * @throws std::runtime_error - if heap doesn't contain root directory or it has been created with different
+     *                              number of threads or variables.
+     */
+    root_directory(uint8_t* _heap_ptr, heap_layout const& _layout, bool init_new);
+
+    /**
+     * Returns object with the specified name.
+     * @param name - name of the object.
+     * @return the object, or empty optional, if it doesn't exist.
+     */
+    std::optional<named_object> find(std::string const& name);
+
+    /**
+     * Returns offset of the object with the specified name. If the object doesn't exist, creates it:
+     * allocates size bytes, zero-fills them and calls init, which must make initial state of the object durable.
+     * init is called under the lock of the directory, therefore it must not access the directory.
+     * If crash occurs before get_or_create returns, the object can be either created or not, and in the latter case
+     * it will be created (and initialized again) by the next call.
+     * @param name - name of the object, at most MAX_NAME_LENGTH bytes, must not be empty.
+     * @param size - size of the object in bytes, must be positive.
+     * @param init - function, that receives offset of the new object and initializes it.
+     * @return offset of the object from the beginning of the heap, aligned by cache line size.
+     * @throws std::runtime_error - if name or size is invalid, existing object has different size, or the object
+     *                              doesn't fit into the region of named objects or into the directory.
+     */
+    uint64_t get_or_create(std::string const& name,
+                           uint64_t size,
+                           std::function<void(uint64_t)> const& init = std::function<void(uint64_t)>());
+
+    /**
+     * Returns all objects of the directory.
+     * @return objects in ascending order of their offsets.
+     */
+    std::vector<named_object> get_objects();
+
+    /**
+     * Reads heap header without restoring the directory, so that layout of the heap can be computed.
+     * @param heap_ptr - pointer to the beginning of the heap.
+     * @return header of the heap, or empty optional, if the heap doesn't contain root directory.
+     */
+    static std::optional<heap_header> read_header(const uint8_t* heap_ptr);
+
+    /**
+     * Reads committed entries of the directory without restoring it, therefore the heap isn't modified
+     * (uncommitted entries are ignored instead of being freed).
+     * @param heap_ptr - pointer to the beginning of the heap.
+     * @param layout - layout of the heap, computed from it's header.
+     * @return objects in ascending order of their offsets.
+     */
+    static std::vector<named_object> read_objects(const uint8_t* heap_ptr, heap_layout const& layout);
+
+private:
+    uint8_t* const heap_ptr;
+
+    const heap_layout layout;
+
+    /**
+     * Allocator of entries of the directory.
+     */
+    pmem_allocator entries;
+
+    /**
+     * Committed entries by names of objects.
+     */
+    std::map<std::string, named_object> objects;
+
+    /**
+     * Offset of the first byte of the region of named objects, that doesn't belong to any object.
+     */
+    uint64_t objects_end;
+
+    /**
+     * Mutex, that prevents concurrent creation of objects.
+     */
+    std::mutex mutex;
+};
+
+#endif //DIPLOM_ROOT_DIRECTORY_H
@@ -4,6 +4,7 @@
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 
 /**
  * Queue, that stores element of some type.
@@ -26,6 +27,13 @@ public:
      */
     void push(const T& elem);
 
+    /**
+     * Adds several elements to the back of the queue, in the same order, acquiring the mutex only once.
+     * All threads, waiting for elements, are woken up.
+     * @param elems - elements to add to queue.
+     */
+    void push_all(std::vector<T> const& elems);
+
     /**
      * Returns single element from the top of the queue and removes
      * element, that was returned. If there are no elements in the queue,
@@ -34,6 +42,13 @@ public:
      */
     T take();
 
+    /**
+     * Returns all elements of the queue (in order from the top of the queue to the back) and removes them.
+     * If there are no elements in the queue, thread is blocked until at least one element is pushed in the queue.
+     * @return - nonempty vector of elements, that were stored in the queue.
+     */
+    std::vector<T> take_all();
+
     /**
      * Returns size of the queue.
      * @return size of the queue.
@@ -62,6 +77,39 @@ T blocking_queue<T>::take()
     return result;
 }
 
+template <typename T>
+void blocking_queue<T>::push_all(std::vector<T> const& elems)
+{
+    if (elems.empty())
+    {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    for (T const& elem: elems)
+    {
+        queue.push(elem);
+    }
+    cv.notify_all();
+}
+
+template <typename T>
+std::vector<T> blocking_queue<T>::take_all()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (queue.empty())
+    {
+        cv.wait(lock);
+    }
+    std::vector<T> result;
+    result.reserve(queue.size());
+    while (!queue.empty())
+    {
+        result.push_back(std::move(queue.front()));
+        queue.pop();
+    }
+    return result;
+}
+
 template <typename T>
 uint32_t blocking_queue<T>::size()
 {
@@ -2,20 +2,21 @@
 #include <limits>
 #include <cstring>
 #include "../common/pmem_utils.h"
+#include "../common/crash_injection.h"
+#include "../metrics/runtime_metrics.h"
 #include <cassert>
 #include "../storage/global_storage.h"
 #include "../storage/global_non_owning_storage.h"
 #include "../storage/thread_local_owning_storage.h"
 #include "../persistent_memory/persistent_memory_holder.h"
+#include "../persistent_memory/pptr.h"
 #include "../model/cur_thread_id_holder.h"
 #include "../model/total_thread_count_holder.h"
 #include "../runtime/answer.h"
+#include "../structures/mcas.h"
 #include <iostream>
 #include <unistd.h>
 
-#define CAS_TEST
-#define CAS_TEST_DELAY
-
 bool cas_internal(uint64_t* var,
                   uint32_t expected_value,
                   uint32_t new_value,
@@ -36,6 +37,15 @@ bool cas_internal(uint64_t* var,
      */
     uint32_t last_thread_number;
     std::memcpy(&last_thread_number, last_thread_number_and_cur_value_ptr, 4);
+    /*
+     * Register contains descriptor of MCAS instead of value: MCAS is completed (or aborted) before the CAS
+     */
+    while (last_thread_number == MCAS_DESCRIPTOR_THREAD)
+    {
+        help_mcas(var, last_thread_number_and_cur_value);
+        last_thread_number_and_cur_value = __atomic_load_n(var, __ATOMIC_SEQ_CST);
+        std::memcpy(&last_thread_number, last_thread_number_and_cur_value_ptr, 4);
+    }
     /*
      * Read value (last 4 bytes). No other threads can interfere this load, because load is done
      * from per-thread local variable.
@@ -60,6 +70,8 @@ bool cas_internal(uint64_t* var,
      */
     if (last_thread_number != std::numeric_limits<uint32_t>::max())
     {
+        METRICS_SCOPED_LATENCY(metrics_histogram::CAS_NOTIFICATION);
+        METRICS_INCREMENT(metrics_counter::CAS_NOTIFICATIONS, 1);
         /*
          * Notify thread, that performed last successful CAS, that it's CAS was successful.
          * Notification is done using SRSW register.
@@ -73,15 +85,21 @@ bool cas_internal(uint64_t* var,
         /*
          * [thread_matrix + index .. thread_matrix + index + 3] belongs to single cache line
          */
-        assert(((uint64_t) thread_matrix + index) / CACHE_LINE_SIZE ==
-               ((uint64_t) thread_matrix + index + 3) / CACHE_LINE_SIZE);
-        pmem_do_flush(thread_matrix + index, 4);
+        assert(((uint64_t) (thread_matrix + index)) / CACHE_LINE_SIZE ==
+               ((uint64_t) (thread_matrix + index) + 3) / CACHE_LINE_SIZE);
+        pmem_do_flush(thread_matrix + index, 4, flush_site::CAS_NOTIFICATION);
     }
+    CRASH_POINT("cas_internal:between_notification_and_cas");
 
 #ifdef CAS_TEST_DELAY
     usleep(1000000);
 #endif
 
+    /*
+     * Latency of CAS itself and of flush of the register
+     */
+    METRICS_SCOPED_LATENCY(metrics_histogram::CAS_UPDATE);
+
     /*
      * Collects 8 bytes of <thread_id, value> from thread_id and value
      */
@@ -123,7 +141,9 @@ bool cas_internal(uint64_t* var,
          * Flush 8 bytes to NVRAM. Note, that for atomicity of flush,
          * CAS'ed variable should be aligned by cache line.
          */
-        pmem_do_flush(var, 8);
+        CRASH_POINT("cas_internal:before_flush");
+        pmem_do_flush(var, 8, flush_site::CAS_VAR);
+        CRASH_POINT("cas_internal:after_flush");
         return true;
     }
     else
@@ -232,12 +252,12 @@ void cas_common(const uint8_t* args, bool call_recover)
     uint32_t total_thread_count = global_storage<total_thread_count_holder>::get_const_object().total_thread_count;
     uint32_t cur_thread_id = thread_local_owning_storage<cur_thread_id_holder>::get_const_object().cur_thread_id;
 
-    uint8_t* pmem_start_address = global_non_owning_storage<persistent_memory_holder>::ptr->get_pmem_ptr();
-    uint64_t* var = (uint64_t*) (pmem_start_address + var_offset);
-    uint32_t* thread_matrix = (uint32_t*) (pmem_start_address + thread_matrix_offset);
+    uint8_t* const heap_base = get_heap_base();
+    uint64_t* var = pptr<uint64_t>(var_offset).get(heap_base);
+    uint32_t* thread_matrix = pptr<uint32_t>(thread_matrix_offset).get(heap_base);
 
     bool result;
-    if (call_recover)
+    if (!call_recover)
     {
         result = cas_internal(
                 var,
@@ -263,6 +283,8 @@ void cas_common(const uint8_t* args, bool call_recover)
 #ifdef CAS_TEST_DELAY
     usleep(1000000);
 #endif
+    METRICS_INCREMENT(result ? metrics_counter::SUCCESSFUL_CAS : metrics_counter::FAILED_CAS, 1);
+    CRASH_POINT("cas:before_answer");
     if (result)
     {
         write_answer(std::vector<uint8_t>({0x1}));
@@ -1,7 +1,10 @@
 #include "constants_and_types.h"
 #include <unistd.h>
+#include <limits>
 
-const uint32_t PMEM_STACK_SIZE = 2048;
+const uint32_t PMEM_STACK_SIZE = 4096;
+
+const uint32_t TX_LOG_OFFSET = 2048;
 
 const uint64_t PMEM_HEAP_SIZE = 2L * 1024L * 1024L;
 
@@ -11,4 +14,8 @@ const uint32_t PAGE_SIZE = getpagesize();
 
 const uint8_t STACK_END_MARKER = 0x0;
 
-const uint8_t FRAME_END_MARKER = 0x1;
\ No newline at end of file
+const uint8_t FRAME_END_MARKER = 0x1;
+
+const uint32_t STACK_HEADER_SIZE = 8;
+
+const uint64_t NO_PREVIOUS_FRAME = std::numeric_limits<uint64_t>::max();
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define DIPLOM_CONSTANTS_AND_TYPES_H
 
 #include <cstdint>
+#include <vector>
 
 /**
  * All user functions must have this type.
@@ -9,10 +10,22 @@
 using function_ptr = void (*)(const uint8_t *);
 
 /**
- * Size of persistent stack - 2 KB.
+ * All volatile functions (functions, that don't modify persistent memory and therefore don't need
+ * persistent frames and recovery) must have this type. Result of the function is returned in RAM.
+ */
+using volatile_function_ptr = std::vector<uint8_t> (*)(const uint8_t *);
+
+/**
+ * Size of file with persistent stack - 4 KB. Frames of the stack occupy first TX_LOG_OFFSET bytes of the file,
+ * the rest of the file is occupied by redo log of transactions (see transaction.h).
  */
 extern const uint32_t PMEM_STACK_SIZE;
 
+/**
+ * Offset of redo log of transactions from the beginning of file with persistent stack - 2 KB.
+ */
+extern const uint32_t TX_LOG_OFFSET;
+
 /**
  * Size of persistent heap - 2 MB.
  */
@@ -33,6 +46,18 @@ extern const uint8_t STACK_END_MARKER;
  */
 extern const uint8_t FRAME_END_MARKER;
 
+/**
+ * Size of persistent stack header in bytes. Header is located at the beginning of the persistent stack
+ * and contains 4 bytes of number of frames in the stack and 4 bytes of offset of the last frame.
+ * First frame of the stack starts at the first cache line aligned offset after the header.
+ */
+extern const uint32_t STACK_HEADER_SIZE;
+
+/*
+ * First frame of persistent stack stores this value instead of offset of the previous frame
+ */
+extern const uint64_t NO_PREVIOUS_FRAME;
+
 /**
  * Size of page on the current architecture - approximately 4 KB.
  */
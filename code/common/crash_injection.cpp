@@ -0,0 +1,58 @@
+#include "crash_injection.h"
+
+#ifdef CRASH_INJECTION
+
+#include <atomic>
+#include <cstdlib>
+#include <csignal>
+#include <string>
+#include <unistd.h>
+
+/*
+ * Number of crash points to pass before the crash, 0 if crash injection is disarmed
+ */
+std::atomic<uint64_t> crash_countdown(0);
+
+void arm_crash_injection(uint64_t countdown)
+{
+    crash_countdown.store(countdown);
+}
+
+void arm_crash_injection_from_env()
+{
+    const char* const countdown = std::getenv("DIPLOM_CRASH_AFTER");
+    if (countdown != nullptr)
+    {
+        arm_crash_injection(std::stoull(countdown));
+    }
+}
+
+void crash_point(const char* site)
+{
+    uint64_t cur_countdown = crash_countdown.load();
+    while (cur_countdown != 0)
+    {
+        if (crash_countdown.compare_exchange_weak(cur_countdown, cur_countdown - 1))
+        {
+            if (cur_countdown == 1)
+            {
+                /*
+                 * Single write, so the message is not interleaved with output of other threads
+                 */
+                const std::string message = std::string("crash_injection site=") + site + "\n";
+                write(STDERR_FILENO, message.data(), message.size());
+                kill(getpid(), SIGKILL);
+                /*
+                 * Current thread must not continue execution after the crash point
+                 */
+                while (true)
+                {
+                    pause();
+                }
+            }
+            return;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef DIPLOM_CRASH_INJECTION_H
+#define DIPLOM_CRASH_INJECTION_H
+
+#include <cstdint>
+
+/*
+ * Crash injection is compiled in only if CRASH_INJECTION is defined. Otherwise, crash points
+ * don't generate any code.
+ */
+#ifdef CRASH_INJECTION
+
+/**
+ * Arms crash injection: process will be killed by SIGKILL, when it passes the specified number of
+ * crash points (counting crash points, passed by all threads). Before the crash, name of crash point
+ * is printed to stderr. If countdown is 0, crash injection is disarmed.
+ * @param countdown - number of crash points to pass before the crash.
+ */
+void arm_crash_injection(uint64_t countdown);
+
+/**
+ * Arms crash injection using countdown from DIPLOM_CRASH_AFTER environment variable.
+ * If the variable is not set, crash injection stays disarmed.
+ */
+void arm_crash_injection_from_env();
+
+/**
+ * Crash point: kills the process, if crash injection is armed and countdown reaches zero.
+ * @param site - name of crash point, must be a string literal.
+ */
+void crash_point(const char* site);
+
+#define CRASH_POINT(site) crash_point(site)
+
+#else
+
+#define CRASH_POINT(site)
+
+#endif
+
+#endif //DIPLOM_CRASH_INJECTION_H
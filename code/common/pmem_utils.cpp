@@ -1,18 +1,86 @@
 #include "pmem_utils.h"
 #include <libpmem.h>
 #include <cassert>
+#include <atomic>
 #include "../storage/thread_local_non_owning_storage.h"
 #include "../storage/global_non_owning_storage.h"
 #include "../persistent_memory/persistent_memory_holder.h"
+#include "../metrics/runtime_metrics.h"
+#include "../metrics/flush_profiler.h"
 
-// TODO: remove dependency from PMDK using msync(2)
-void pmem_do_flush(const void* ptr, size_t len)
-{
+/*
+ * Flush backend is read on each flush, therefore it is stored in a plain atomic variable
+ * instead of global_storage, which checks presence of the object on each access.
+ */
 #ifdef REAL_NVRAM
-    pmem_persist(ptr, len);
+std::atomic<flush_backend> current_flush_backend(flush_backend::PERSIST);
 #else
-    pmem_msync(ptr, len);
+std::atomic<flush_backend> current_flush_backend(flush_backend::MSYNC);
+#endif
+
+// TODO: remove dependency from PMDK using msync(2)
+void pmem_do_flush(const void* ptr, size_t len, [[maybe_unused]] flush_site site)
+{
+    METRICS_SCOPED_LATENCY(metrics_histogram::FLUSH);
+    METRICS_INCREMENT(metrics_counter::FLUSHES, 1);
+    METRICS_INCREMENT(metrics_counter::FLUSHED_BYTES, len);
+#ifdef FLUSH_PROFILING
+    /*
+     * Content of the range is compared with it's content at the moment of the previous flush
+     */
+    profile_flush(ptr, len, site);
+#endif
+    METRICS_INCREMENT(metrics_counter::DRAINS, 1);
+    switch (current_flush_backend.load(std::memory_order_relaxed))
+    {
+        case flush_backend::MSYNC:
+            pmem_msync(ptr, len);
+            break;
+        case flush_backend::PERSIST:
+            pmem_persist(ptr, len);
+            break;
+        case flush_backend::NONE:
+            break;
+    }
+}
+
+void pmem_do_flush_without_drain(const void* ptr, size_t len, [[maybe_unused]] flush_site site)
+{
+    METRICS_INCREMENT(metrics_counter::FLUSHES, 1);
+    METRICS_INCREMENT(metrics_counter::FLUSHED_BYTES, len);
+#ifdef FLUSH_PROFILING
+    profile_flush(ptr, len, site);
 #endif
+    switch (current_flush_backend.load(std::memory_order_relaxed))
+    {
+        case flush_backend::MSYNC:
+            pmem_msync(ptr, len);
+            break;
+        case flush_backend::PERSIST:
+            pmem_flush(ptr, len);
+            break;
+        case flush_backend::NONE:
+            break;
+    }
+}
+
+void pmem_do_drain()
+{
+    METRICS_INCREMENT(metrics_counter::DRAINS, 1);
+    if (current_flush_backend.load(std::memory_order_relaxed) == flush_backend::PERSIST)
+    {
+        pmem_drain();
+    }
+}
+
+void set_flush_backend(flush_backend backend)
+{
+    current_flush_backend.store(backend, std::memory_order_relaxed);
+}
+
+flush_backend get_flush_backend()
+{
+    return current_flush_backend.load(std::memory_order_relaxed);
 }
 
 uint64_t get_cache_line_aligned_address(uint64_t address)
@@ -4,6 +4,8 @@
 #include <cstdint>
 #include <cstddef>
 #include "constants_and_types.h"
+#include "../model/flush_backend.h"
+#include "../model/flush_site.h"
 
 /**
  * Forces all memory in the range [addr, addr+len) to be stored durably
@@ -12,10 +14,42 @@
  * atomically. Otherwise, crash can occur when part of data has already been
  * flushed, but the rest of the range has not been flushed yet. Note, that on
  * non_NVRAM systems flush of more than one byte can be non-atomic operation.
+ * If FLUSH_PROFILING is defined, flush is recorded by flush profiler.
  * @param ptr - beginning of the range.
  * @param len - length of the range.
+ * @param site - place in the runtime, from which flush is performed.
  */
-void pmem_do_flush(const void* ptr, size_t len);
+void pmem_do_flush(const void* ptr, size_t len, flush_site site = flush_site::OTHER);
+
+/**
+ * Starts flushing all memory in the range [addr, addr+len) to persistent memory, but doesn't wait
+ * for the flush to complete. Data is durable only after subsequent pmem_do_drain. Allows to make
+ * several ranges durable using single drain. Note, that with MSYNC backend flush is synchronous.
+ * If FLUSH_PROFILING is defined, flush is recorded by flush profiler.
+ * @param ptr - beginning of the range.
+ * @param len - length of the range.
+ * @param site - place in the runtime, from which flush is performed.
+ */
+void pmem_do_flush_without_drain(const void* ptr, size_t len, flush_site site = flush_site::OTHER);
+
+/**
+ * Waits for all flushes, started by pmem_do_flush_without_drain in the caller thread, to complete.
+ */
+void pmem_do_drain();
+
+/**
+ * Sets the way, in which pmem_do_flush makes data durable. By default, PERSIST is used,
+ * if REAL_NVRAM is defined, and MSYNC is used otherwise.
+ * Should be called before worker threads are started.
+ * @param backend - new flush backend.
+ */
+void set_flush_backend(flush_backend backend);
+
+/**
+ * Returns the way, in which pmem_do_flush makes data durable.
+ * @return current flush backend.
+ */
+flush_backend get_flush_backend();
 
 /**
  * Returns minimal possible x, such that x >= addr and x % CACHE_LINE_SIZE == 0.
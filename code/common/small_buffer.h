@@ -0,0 +1,102 @@
+#ifndef DIPLOM_SMALL_BUFFER_H
+#define DIPLOM_SMALL_BUFFER_H
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Sequence of trivially copyable elements, that stores up to INLINE_CAPACITY elements
+ * inside the object itself and falls back to heap memory only for longer sequences.
+ * Therefore, constructing, copying and destroying short sequences doesn't allocate memory.
+ * Length of the sequence is fixed at construction.
+ * @tparam T - type of elements. Must be trivially copyable.
+ * @tparam INLINE_CAPACITY - maximal number of elements, that can be stored without heap allocation.
+ */
+template <typename T, uint32_t INLINE_CAPACITY>
+struct small_buffer
+{
+    static_assert(std::is_trivially_copyable_v<T>, "small_buffer elements must be trivially copyable");
+
+public:
+    using value_type = T;
+    using iterator = const T*;
+    using const_iterator = const T*;
+
+    small_buffer() : length(0)
+    {}
+
+    /**
+     * Creates sequence, containing copy of specified elements.
+     * @param _data - pointer to the first element to copy.
+     * @param _length - number of elements to copy.
+     */
+    small_buffer(const T* const _data, const uint64_t _length) : length(_length)
+    {
+        if (length <= INLINE_CAPACITY)
+        {
+            std::copy(_data, _data + length, inline_data.begin());
+        }
+        else
+        {
+            heap_data.assign(_data, _data + length);
+        }
+    }
+
+    [[nodiscard]] const T* data() const
+    {
+        return length <= INLINE_CAPACITY ? inline_data.data() : heap_data.data();
+    }
+
+    [[nodiscard]] uint64_t size() const
+    {
+        return length;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return length == 0;
+    }
+
+    [[nodiscard]] const T* begin() const
+    {
+        return data();
+    }
+
+    [[nodiscard]] const T* end() const
+    {
+        return data() + length;
+    }
+
+    const T& operator[](const uint64_t index) const
+    {
+        return data()[index];
+    }
+
+    template <typename Sequence>
+    bool operator==(Sequence const& other) const
+    {
+        return length == other.size() && std::equal(begin(), end(), other.begin());
+    }
+
+    template <typename Sequence>
+    bool operator!=(Sequence const& other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    /*
+     * Is used, when the sequence is short enough
+     */
+    std::array<T, INLINE_CAPACITY> inline_data;
+    /*
+     * Is used otherwise. Empty vector doesn't allocate memory
+     */
+    std::vector<T> heap_data;
+    uint64_t length;
+};
+
+#endif //DIPLOM_SMALL_BUFFER_H
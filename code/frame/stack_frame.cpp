@@ -6,26 +6,31 @@ uint64_t stack_frame::size() const
 {
     /*
      * 8 bytes for answer
+     * 8 bytes of previous frame offset
      * 2 bytes of function name size
      * function name
      * 2 bytes of arguments size
      * arguments
      * 1 byte of end marker
      */
-    return args.size() + function_name.size() + 13;
+    return args.size() + function_name.size() + 21;
 }
 
-stack_frame::stack_frame(std::string _function_name, std::vector<uint8_t> _args) :
-        function_name(std::move(_function_name)),
-        args(std::move(_args))
+stack_frame::stack_frame(std::string_view _function_name, std::vector<uint8_t> const& _args) :
+        stack_frame(_function_name, _args.data(), _args.size())
 {}
 
-const std::string& stack_frame::get_function_name() const
+stack_frame::stack_frame(std::string_view _function_name, const uint8_t* const _args, const uint64_t _args_size) :
+        function_name(_function_name.data(), _function_name.size()),
+        args(_args, _args_size)
+{}
+
+std::string_view stack_frame::get_function_name() const
 {
-    return function_name;
+    return std::string_view(function_name.data(), function_name.size());
 }
 
-const std::vector<uint8_t>& stack_frame::get_args() const
+const stack_frame::args_buffer& stack_frame::get_args() const
 {
     return args;
 }
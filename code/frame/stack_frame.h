@@ -1,23 +1,40 @@
 #ifndef DIPLOM_STACK_FRAME_H
 #define DIPLOM_STACK_FRAME_H
 
-#include <string>
+#include <string_view>
 #include <vector>
+#include "../common/small_buffer.h"
 
 /**
  * Single frame of the stack.
+ * Function name and args are stored inside the frame, if they are short enough
+ * (which is true for all functions of the runtime), therefore creating, copying and
+ * destroying frames doesn't allocate memory.
  */
 struct stack_frame
 {
+public:
+    /**
+     * Maximal length of function name, that is stored without heap allocation.
+     */
+    static constexpr uint32_t INLINE_FUNCTION_NAME_SIZE = 32;
+    /**
+     * Maximal size of args, that are stored without heap allocation.
+     */
+    static constexpr uint32_t INLINE_ARGS_SIZE = 64;
+
+    using function_name_buffer = small_buffer<char, INLINE_FUNCTION_NAME_SIZE>;
+    using args_buffer = small_buffer<uint8_t, INLINE_ARGS_SIZE>;
+
 private:
     /**
      * Name of the function, that was called.
      */
-    std::string function_name;
+    function_name_buffer function_name;
     /**
      * Args of the function, marshalled to array of bytes.
      */
-    std::vector<uint8_t> args;
+    args_buffer args;
 
 public:
     /**
@@ -28,15 +45,29 @@ public:
      */
     [[nodiscard]] uint64_t size() const;
 
-    stack_frame(std::string _function_name, std::vector<uint8_t> _args);
+    stack_frame(std::string_view _function_name, std::vector<uint8_t> const& _args);
+
+    /**
+     * Creates frame, copying args from the specified memory (for example, from persistent stack).
+     * @param _function_name - name of the function.
+     * @param _args - pointer to the first byte of marshalled args.
+     * @param _args_size - size of marshalled args in bytes.
+     */
+    stack_frame(std::string_view _function_name, const uint8_t* _args, uint64_t _args_size);
 
     stack_frame(stack_frame&& other) noexcept;
 
     stack_frame(stack_frame const& other);
 
-    [[nodiscard]] const std::string& get_function_name() const;
+    [[nodiscard]] std::string_view get_function_name() const;
 
-    [[nodiscard]] const std::vector<uint8_t>& get_args() const;
+    [[nodiscard]] const args_buffer& get_args() const;
 };
 
+/**
+ * Value, that is written to answer memory of a frame before the answer itself (see add_new_frame and do_call).
+ * Since answer memory of a frame is 8 bytes long, valid fillers are always stored without heap allocation.
+ */
+using answer_filler = small_buffer<uint8_t, 8>;
+
 #endif //DIPLOM_STACK_FRAME_H
@@ -0,0 +1,448 @@
+#include "load_generator.h"
+#include "zipf_distribution.h"
+#include "../blocking_queue/blocking_queue.h"
+#include "../model/tasks.h"
+#include "../model/cur_thread_id_holder.h"
+#include "../storage/thread_local_owning_storage.h"
+#include "../storage/thread_local_non_owning_storage.h"
+#include "../runtime/exec_task.h"
+#include "../runtime/group_committer.h"
+#include "../model/task_completion.h"
+#include "../common/pmem_utils.h"
+#include "../metrics/runtime_metrics.h"
+#include "../numa/numa_topology.h"
+#include <thread>
+#include <optional>
+#include <random>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * Task together with the moment, when it should have arrived according to the arrival schedule.
+ */
+struct scheduled_task
+{
+    task cur_task;
+    std::chrono::steady_clock::time_point arrival_time;
+    /**
+     * Moment, when the task was put to the tasks queue.
+     */
+    std::chrono::steady_clock::time_point enqueue_time;
+};
+
+/**
+ * Results of a single worker thread. Each worker thread updates only it's own statistics.
+ */
+struct worker_statistics
+{
+    std::vector<std::chrono::nanoseconds> cas_latencies;
+    std::vector<std::chrono::nanoseconds> read_latencies;
+    uint64_t successful_cas = 0;
+};
+
+/**
+ * Task, which answer hasn't been acknowledged by group committer yet.
+ */
+struct in_flight_task
+{
+    std::chrono::steady_clock::time_point arrival_time;
+    uint8_t* answer_address;
+    bool is_cas;
+};
+
+/**
+ * Task id, that marks the end of the completions stream.
+ */
+const uint64_t END_OF_COMPLETIONS = std::numeric_limits<uint64_t>::max();
+
+void init_vars(heap_layout const& layout, persistent_memory_holder& heap_holder)
+{
+    uint64_t initial_thread_number_and_initial_value;
+    uint8_t* initial_thread_number_and_initial_value_ptr = (uint8_t*) &initial_thread_number_and_initial_value;
+    uint32_t initial_thread_number = std::numeric_limits<uint32_t>::max();
+    uint32_t initial_value = 42;
+    std::memcpy(initial_thread_number_and_initial_value_ptr, &initial_thread_number, 4);
+    std::memcpy(initial_thread_number_and_initial_value_ptr + 4, &initial_value, 4);
+
+    for (uint32_t var_number = 0; var_number < layout.get_number_of_vars(); var_number++)
+    {
+        uint8_t* const var = heap_holder.get_pmem_ptr() + layout.get_var_offset(var_number);
+        std::memcpy(var, &initial_thread_number_and_initial_value, 8);
+        pmem_do_flush(var, 8);
+    }
+}
+
+load_report run_load(load_config const& config,
+                     heap_layout const& layout,
+                     std::vector<persistent_memory_holder>& persistent_stacks,
+                     std::vector<ram_stack>& ram_stacks,
+                     persistent_memory_holder& heap_holder,
+                     pmem_allocator& allocator)
+{
+    if (config.arrival_rate <= 0)
+    {
+        throw std::runtime_error("Arrival rate must be positive");
+    }
+    if (config.cas_ratio < 0 || config.cas_ratio > 1)
+    {
+        throw std::runtime_error("CAS ratio must be between 0 and 1");
+    }
+    const uint32_t number_of_threads = persistent_stacks.size();
+
+    /*
+     * In NUMA-aware mode, each node, that has at least one worker, has it's own tasks queue.
+     * Workers of the node are pinned to the CPUs of the node, persistent stacks of the workers and
+     * registers of the node are bound to the memory of the node.
+     */
+    const uint32_t number_of_nodes = config.topology.has_value() ?
+                                     std::min(config.topology->get_number_of_nodes(), number_of_threads) : 1;
+    if (config.topology.has_value())
+    {
+        for (uint32_t node_index = 0; node_index < number_of_nodes; node_index++)
+        {
+            const uint32_t first_var = layout.get_first_var_of_node(node_index, number_of_nodes);
+            const uint32_t last_var = layout.get_first_var_of_node(node_index + 1, number_of_nodes);
+            if (first_var == last_var)
+            {
+                continue;
+            }
+            /*
+             * Thread matrix of the last register of the node ends before the first register of the next node
+             */
+            const uint64_t segment_begin = layout.get_var_offset(first_var);
+            const uint64_t segment_end = layout.get_var_offset(last_var);
+            bind_memory_to_node(
+                    heap_holder.get_pmem_ptr() + segment_begin,
+                    segment_end - segment_begin,
+                    config.topology->get_node(node_index).id
+            );
+        }
+    }
+    /*
+     * Workers are split between nodes into contiguous ranges
+     */
+    auto get_worker_node = [number_of_nodes, number_of_threads](uint32_t thread_number) -> uint32_t
+    {
+        return (uint64_t) thread_number * number_of_nodes / number_of_threads;
+    };
+
+    /*
+     * Empty task means, that worker thread should finish
+     */
+    std::vector<blocking_queue<std::optional<scheduled_task>>> tasks_queues(number_of_nodes);
+    std::vector<worker_statistics> statistics(number_of_threads);
+
+    /*
+     * In group commit mode, latency of the task is measured by the collector thread at the moment,
+     * when answer of the task becomes durable, and answer location is freed only after that.
+     */
+    const bool group_commit = config.group_commit_interval.count() > 0;
+    blocking_queue<task_completion> completion_queue;
+    std::optional<group_committer> committer;
+    if (group_commit)
+    {
+        committer.emplace(completion_queue, config.group_commit_interval, config.group_commit_batch_size);
+    }
+    std::mutex in_flight_mutex;
+    std::unordered_map<uint64_t, in_flight_task> in_flight;
+    worker_statistics collector_statistics;
+    std::thread collector;
+    if (group_commit)
+    {
+        collector = std::thread(
+                [&completion_queue, &in_flight_mutex, &in_flight, &allocator, &collector_statistics]()
+                {
+                    while (true)
+                    {
+                        const std::vector<task_completion> completions = completion_queue.take_all();
+                        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                        for (task_completion const& cur_completion: completions)
+                        {
+                            if (cur_completion.task_id == END_OF_COMPLETIONS)
+                            {
+                                return;
+                            }
+                            in_flight_task cur_in_flight_task;
+                            {
+                                std::unique_lock lock(in_flight_mutex);
+                                auto it = in_flight.find(cur_completion.task_id);
+                                assert(it != in_flight.end());
+                                cur_in_flight_task = it->second;
+                                in_flight.erase(it);
+                            }
+                            const std::chrono::nanoseconds latency = now - cur_in_flight_task.arrival_time;
+                            if (cur_in_flight_task.is_cas)
+                            {
+                                if (cur_completion.result == 0x1)
+                                {
+                                    collector_statistics.successful_cas++;
+                                }
+                                collector_statistics.cas_latencies.push_back(latency);
+                            }
+                            else
+                            {
+                                collector_statistics.read_latencies.push_back(latency);
+                            }
+                            /*
+                             * Answer is durable and has been read, answer location can be reused by other tasks
+                             */
+                            allocator.pmem_free(cur_in_flight_task.answer_address);
+                        }
+                    }
+                }
+        );
+    }
+
+    /*
+     * Init worker threads
+     */
+    std::vector<std::thread> threads;
+    for (uint32_t cur_thread_number = 0; cur_thread_number < number_of_threads; cur_thread_number++)
+    {
+        threads.emplace_back(
+                [
+                        cur_thread_number,
+                        &config,
+                        cur_node = get_worker_node(cur_thread_number),
+                        &persistent_stacks,
+                        &ram_stacks,
+                        &tasks_queue = tasks_queues[get_worker_node(cur_thread_number)],
+                        &heap_holder,
+                        &allocator,
+                        &committer,
+                        &cur_statistics = statistics[cur_thread_number]
+                ]()
+                {
+                    /*
+                     * Each stack is used only by its worker thread, therefore it is moved, not copied
+                     */
+                    thread_local_owning_storage<ram_stack>::set_object(std::move(ram_stacks[cur_thread_number]));
+                    thread_local_non_owning_storage<persistent_memory_holder>::ptr =
+                            &persistent_stacks[cur_thread_number];
+                    thread_local_owning_storage<cur_thread_id_holder>::emplace_object(cur_thread_number);
+                    if (config.topology.has_value())
+                    {
+                        /*
+                         * Pinning and binding are best effort: load is still correct, if they fail
+                         */
+                        numa_node const& node = config.topology->get_node(cur_node);
+                        pin_current_thread(node.cpus);
+                        bind_memory_to_node(persistent_stacks[cur_thread_number].get_pmem_ptr(),
+                                            PMEM_STACK_SIZE, node.id);
+                    }
+
+                    /*
+                     * Main loop: get task from queue and execute it
+                     */
+                    while (true)
+                    {
+                        const std::optional<scheduled_task> cur_scheduled_task = tasks_queue.take();
+                        if (!cur_scheduled_task.has_value())
+                        {
+                            return;
+                        }
+                        METRICS_RECORD_LATENCY(
+                                metrics_histogram::QUEUE_WAIT,
+                                std::chrono::steady_clock::now() - cur_scheduled_task->enqueue_time
+                        );
+                        if (committer.has_value())
+                        {
+                            /*
+                             * Latency and answer are processed by the collector thread
+                             */
+                            execute_task(cur_scheduled_task->cur_task, committer.value());
+                            continue;
+                        }
+                        execute_task(cur_scheduled_task->cur_task);
+                        const std::chrono::nanoseconds latency =
+                                std::chrono::steady_clock::now() - cur_scheduled_task->arrival_time;
+
+                        if (std::holds_alternative<cas_task>(cur_scheduled_task->cur_task))
+                        {
+                            uint8_t* const answer_address = heap_holder.get_pmem_ptr() +
+                                    std::get<cas_task>(cur_scheduled_task->cur_task).answer_offset;
+                            if (*answer_address == 0x1)
+                            {
+                                cur_statistics.successful_cas++;
+                            }
+                            /*
+                             * Answer has been read, answer location can be reused by other tasks
+                             */
+                            allocator.pmem_free(answer_address);
+                            cur_statistics.cas_latencies.push_back(latency);
+                        }
+                        else if (std::holds_alternative<read_task>(cur_scheduled_task->cur_task))
+                        {
+                            /*
+                             * Read value has been written to the answer location, which can now be reused
+                             */
+                            allocator.pmem_free(
+                                    heap_holder.get_pmem_ptr() +
+                                    std::get<read_task>(cur_scheduled_task->cur_task).answer_offset.value()
+                            );
+                            cur_statistics.read_latencies.push_back(latency);
+                        }
+                    }
+                }
+        );
+    }
+
+    /*
+     * Each CAS expects the value, set by the previous CAS on the same register.
+     * All new values are unique and greater than current values of all registers.
+     */
+    std::vector<uint32_t> last_values;
+    for (uint32_t var_number = 0; var_number < layout.get_number_of_vars(); var_number++)
+    {
+        last_values.push_back(read_var(layout.get_var_offset(var_number)));
+    }
+    uint32_t next_value = *std::max_element(last_values.begin(), last_values.end()) + 1;
+
+    std::mt19937_64 generator(config.seed);
+    std::exponential_distribution<double> interarrival_distribution(config.arrival_rate);
+    std::uniform_real_distribution<double> type_distribution(0, 1);
+    const zipf_distribution var_distribution(layout.get_number_of_vars(), config.zipf_exponent);
+
+    uint64_t dropped = 0;
+    uint64_t next_task_id = 0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point next_arrival = start;
+    while (true)
+    {
+        next_arrival += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::duration<double>(interarrival_distribution(generator))
+        );
+        if (next_arrival - start >= config.duration)
+        {
+            break;
+        }
+        /*
+         * If generator is late, task is pushed immediately, but it's latency is still measured
+         * from the scheduled arrival time
+         */
+        std::this_thread::sleep_until(next_arrival);
+
+        const uint32_t var_number = var_distribution(generator);
+        const uint64_t var_offset = layout.get_var_offset(var_number);
+        const bool is_cas = type_distribution(generator) < config.cas_ratio;
+        /*
+         * Both CAS and read write their answers to the allocated answer location
+         */
+        uint8_t* answer_address;
+        try
+        {
+            answer_address = allocator.pmem_alloc();
+        }
+        catch (std::runtime_error const&)
+        {
+            /*
+             * Too many tasks are in progress
+             */
+            dropped++;
+            continue;
+        }
+        /*
+         * Task is registered before it is pushed, since it can be completed immediately after that
+         */
+        std::optional<uint64_t> task_id;
+        if (group_commit)
+        {
+            task_id = next_task_id++;
+            std::unique_lock lock(in_flight_mutex);
+            in_flight.emplace(task_id.value(), in_flight_task{next_arrival, answer_address, is_cas});
+        }
+        /*
+         * Task is executed by the workers of the node, that owns the register
+         */
+        auto& tasks_queue = tasks_queues[
+                config.topology.has_value() ? layout.get_var_node(var_number, number_of_nodes) : 0
+        ];
+        if (is_cas)
+        {
+            tasks_queue.push(
+                    scheduled_task{
+                            cas_task(
+                                    var_offset,
+                                    last_values[var_number],
+                                    next_value,
+                                    answer_address - heap_holder.get_pmem_ptr(),
+                                    layout.get_thread_matrix_offset(var_number),
+                                    task_id
+                            ),
+                            next_arrival,
+                            std::chrono::steady_clock::now()
+                    }
+            );
+            last_values[var_number] = next_value;
+            next_value++;
+        }
+        else
+        {
+            tasks_queue.push(
+                    scheduled_task{
+                            read_task(var_offset, answer_address - heap_holder.get_pmem_ptr(), nullptr, task_id),
+                            next_arrival,
+                            std::chrono::steady_clock::now()
+                    }
+            );
+        }
+    }
+
+    /*
+     * Load lasts for the whole duration, even if there are no arrivals at the end of it
+     */
+    std::this_thread::sleep_until(start + config.duration);
+
+    /*
+     * Tasks queues are FIFO, therefore worker threads finish after all generated tasks are completed
+     */
+    for (uint32_t cur_thread_number = 0; cur_thread_number < number_of_threads; cur_thread_number++)
+    {
+        tasks_queues[get_worker_node(cur_thread_number)].push(std::optional<scheduled_task>());
+    }
+    for (std::thread& cur_thread: threads)
+    {
+        cur_thread.join();
+    }
+    if (group_commit)
+    {
+        /*
+         * Commits answers of the last tasks, then stops the collector
+         */
+        committer->stop();
+        completion_queue.push(task_completion(END_OF_COMPLETIONS, 0));
+        collector.join();
+        statistics.push_back(collector_statistics);
+    }
+    const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+
+    std::vector<std::chrono::nanoseconds> cas_latencies;
+    std::vector<std::chrono::nanoseconds> read_latencies;
+    uint64_t successful_cas = 0;
+    for (worker_statistics const& cur_statistics : statistics)
+    {
+        cas_latencies.insert(
+                cas_latencies.end(),
+                cur_statistics.cas_latencies.begin(),
+                cur_statistics.cas_latencies.end()
+        );
+        read_latencies.insert(
+                read_latencies.end(),
+                cur_statistics.read_latencies.begin(),
+                cur_statistics.read_latencies.end()
+        );
+        successful_cas += cur_statistics.successful_cas;
+    }
+    return load_report(
+            task_type_report(cas_latencies, elapsed),
+            task_type_report(read_latencies, elapsed),
+            successful_cas,
+            dropped,
+            elapsed
+    );
+}
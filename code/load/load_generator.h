@@ -0,0 +1,51 @@
+#ifndef DIPLOM_LOAD_GENERATOR_H
+#define DIPLOM_LOAD_GENERATOR_H
+
+#include <vector>
+#include "../model/load_config.h"
+#include "../model/load_report.h"
+#include "../model/heap_layout.h"
+#include "../persistent_memory/persistent_memory_holder.h"
+#include "../persistent_stack/ram_stack.h"
+#include "../allocation/pmem_allocator.h"
+
+/**
+ * Writes initial values of all RMW registers, described by heap layout, to the persistent heap.
+ * Initially, each register contains value 42 and wasn't changed by any thread.
+ * Should be called only for new (zero-filled) heap.
+ * @param layout - layout of the heap.
+ * @param heap_holder - persistent heap.
+ */
+void init_vars(heap_layout const& layout, persistent_memory_holder& heap_holder);
+
+/**
+ * Starts worker threads, that take tasks from the tasks queue and execute them, using
+ * specified persistent and RAM stacks, and generates tasks according to the load config.
+ * Each of the stacks should contain the first frame (frame of the main function of the worker thread) only.
+ * RAM stacks are moved to worker threads. System should be running in execution mode.
+ * Tasks are generated by the caller thread during the load duration. Arrival times of the tasks
+ * don't depend on the task completion. When the load duration is over, waits for completion
+ * of all generated tasks and stops worker threads.
+ * CAS tasks set unique new values: each CAS expects the value, that was set by the previous
+ * CAS task on the same register, and sets value, that is greater than all values, set before.
+ * Answer location of each task (both CAS and read) is allocated using the allocator and freed
+ * after the task completion.
+ * If group commit interval of the config is positive, answers are made durable by group committer and
+ * latency of the task is measured till the moment, when completion of the task is acknowledged.
+ * @param config - parameters of the load.
+ * @param layout - layout of the heap.
+ * @param persistent_stacks - persistent stacks of worker threads.
+ * @param ram_stacks - RAM representations of persistent stacks.
+ * @param heap_holder - persistent heap.
+ * @param allocator - allocator of answer locations.
+ * @return throughput and latency of the tasks.
+ * @throws std::runtime_error - if arrival rate is not positive or CAS ratio is not between 0 and 1.
+ */
+load_report run_load(load_config const& config,
+                     heap_layout const& layout,
+                     std::vector<persistent_memory_holder>& persistent_stacks,
+                     std::vector<ram_stack>& ram_stacks,
+                     persistent_memory_holder& heap_holder,
+                     pmem_allocator& allocator);
+
+#endif //DIPLOM_LOAD_GENERATOR_H
@@ -0,0 +1,41 @@
+#include "zipf_distribution.h"
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+
+zipf_distribution::zipf_distribution(uint32_t n, double s) : cdf(n)
+{
+    if (n == 0)
+    {
+        throw std::runtime_error("Zipfian distribution must contain at least one key");
+    }
+    if (s < 0)
+    {
+        throw std::runtime_error("Exponent of Zipfian distribution must be non-negative");
+    }
+    double sum = 0;
+    for (uint32_t k = 0; k < n; k++)
+    {
+        sum += 1 / std::pow(k + 1, s);
+        cdf[k] = sum;
+    }
+    for (double& cur_probability : cdf)
+    {
+        cur_probability /= sum;
+    }
+    /*
+     * Protect from rounding errors: the last key must always be found by binary search
+     */
+    cdf.back() = 1;
+}
+
+uint32_t zipf_distribution::operator()(std::mt19937_64& generator) const
+{
+    const double x = std::uniform_real_distribution<double>(0, 1)(generator);
+    return std::upper_bound(cdf.begin(), cdf.end() - 1, x) - cdf.begin();
+}
+
+double zipf_distribution::get_probability(uint32_t key) const
+{
+    return key == 0 ? cdf[0] : cdf[key] - cdf[key - 1];
+}
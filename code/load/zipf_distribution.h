@@ -0,0 +1,45 @@
+#ifndef DIPLOM_ZIPF_DISTRIBUTION_H
+#define DIPLOM_ZIPF_DISTRIBUTION_H
+
+#include <cstdint>
+#include <vector>
+#include <random>
+
+/**
+ * Zipfian distribution over integers [0, n): probability of k is proportional to 1 / (k + 1)^s.
+ * If s is 0, distribution is uniform. The bigger s is, the more often small numbers are generated,
+ * i.e. the higher contention on the first keys is.
+ * Cumulative distribution function is computed once, therefore each generation takes O(log n).
+ */
+struct zipf_distribution
+{
+public:
+    /**
+     * @param n - number of keys, must be positive.
+     * @param s - exponent of the distribution, must be non-negative.
+     * @throws std::runtime_error - if n is zero or s is negative.
+     */
+    zipf_distribution(uint32_t n, double s);
+
+    /**
+     * Generates next key.
+     * @param generator - source of randomness.
+     * @return key from [0, n).
+     */
+    uint32_t operator()(std::mt19937_64& generator) const;
+
+    /**
+     * Returns probability of the specified key.
+     * @param key - key from [0, n).
+     * @return probability of the key.
+     */
+    [[nodiscard]] double get_probability(uint32_t key) const;
+
+private:
+    /**
+     * cdf[k] is probability of generating key, which is not greater than k
+     */
+    std::vector<double> cdf;
+};
+
+#endif //DIPLOM_ZIPF_DISTRIBUTION_H
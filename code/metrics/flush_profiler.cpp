@@ -0,0 +1,226 @@
+#include "flush_profiler.h"
+#include "../common/constants_and_types.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+
+namespace
+{
+    /**
+     * Saved cache lines are split between shards by line address, so that flushes of different
+     * lines by different threads rarely contend for the same mutex.
+     */
+    const uint32_t NUMBER_OF_SHARDS = 64;
+
+    struct site_counters
+    {
+        std::atomic<uint64_t> flushes{0};
+        std::atomic<uint64_t> flushed_bytes{0};
+        std::atomic<uint64_t> flushed_lines{0};
+        std::atomic<uint64_t> redundant_lines{0};
+    };
+
+    struct lines_shard
+    {
+        std::mutex mutex;
+        /**
+         * Content of each cache line at the moment of it's last flush, by line address.
+         */
+        std::unordered_map<uint64_t, std::vector<uint8_t>> saved_lines;
+        /**
+         * Addresses of cache lines, flushed by each site.
+         */
+        std::array<std::unordered_set<uint64_t>, NUMBER_OF_FLUSH_SITES> site_lines;
+    };
+
+    struct flush_profiler_state
+    {
+        std::array<site_counters, NUMBER_OF_FLUSH_SITES> counters;
+        std::array<lines_shard, NUMBER_OF_SHARDS> shards;
+    };
+
+    /**
+     * State is created on the first use, so that flushes can be profiled during initialization
+     * of other global variables.
+     */
+    flush_profiler_state& get_state()
+    {
+        static flush_profiler_state state;
+        return state;
+    }
+}
+
+const char* get_flush_site_name(flush_site site)
+{
+    switch (site)
+    {
+        case flush_site::FRAME:
+            return "frame";
+        case flush_site::END_MARKER:
+            return "end_marker";
+        case flush_site::STACK_HEADER:
+            return "stack_header";
+        case flush_site::ANSWER:
+            return "answer";
+        case flush_site::ALLOCATOR_MARKER:
+            return "allocator_marker";
+        case flush_site::CAS_NOTIFICATION:
+            return "cas_notification";
+        case flush_site::CAS_VAR:
+            return "cas_var";
+        case flush_site::TX_LOG:
+            return "tx_log";
+        case flush_site::TX_DATA:
+            return "tx_data";
+        case flush_site::OTHER:
+            return "other";
+        default:
+            return "unknown";
+    }
+}
+
+void profile_flush(const void* ptr, size_t len, flush_site site)
+{
+    flush_profiler_state& state = get_state();
+    site_counters& counters = state.counters[(uint32_t) site];
+    counters.flushes.fetch_add(1, std::memory_order_relaxed);
+    counters.flushed_bytes.fetch_add(len, std::memory_order_relaxed);
+    if (len == 0)
+    {
+        return;
+    }
+
+    const uint64_t first_line = (uint64_t) ptr / CACHE_LINE_SIZE;
+    const uint64_t last_line = ((uint64_t) ptr + len - 1) / CACHE_LINE_SIZE;
+    uint64_t redundant_lines = 0;
+    for (uint64_t line = first_line; line <= last_line; line++)
+    {
+        /*
+         * Whole cache line belongs to the mapping, since mapping is aligned by page size
+         */
+        const uint8_t* const line_ptr = (const uint8_t*) (line * CACHE_LINE_SIZE);
+        lines_shard& shard = state.shards[line % NUMBER_OF_SHARDS];
+        std::unique_lock lock(shard.mutex);
+        shard.site_lines[(uint32_t) site].insert(line);
+        auto it = shard.saved_lines.find(line);
+        if (it == shard.saved_lines.end())
+        {
+            shard.saved_lines.emplace(line, std::vector<uint8_t>(line_ptr, line_ptr + CACHE_LINE_SIZE));
+        }
+        else if (std::memcmp(it->second.data(), line_ptr, CACHE_LINE_SIZE) == 0)
+        {
+            redundant_lines++;
+        }
+        else
+        {
+            std::memcpy(it->second.data(), line_ptr, CACHE_LINE_SIZE);
+        }
+    }
+    counters.flushed_lines.fetch_add(last_line - first_line + 1, std::memory_order_relaxed);
+    counters.redundant_lines.fetch_add(redundant_lines, std::memory_order_relaxed);
+}
+
+std::array<flush_site_profile, NUMBER_OF_FLUSH_SITES> get_flush_profile()
+{
+    flush_profiler_state& state = get_state();
+    std::array<flush_site_profile, NUMBER_OF_FLUSH_SITES> profile;
+    for (uint32_t site = 0; site < NUMBER_OF_FLUSH_SITES; site++)
+    {
+        profile[site].flushes = state.counters[site].flushes.load(std::memory_order_relaxed);
+        profile[site].flushed_bytes = state.counters[site].flushed_bytes.load(std::memory_order_relaxed);
+        profile[site].flushed_lines = state.counters[site].flushed_lines.load(std::memory_order_relaxed);
+        profile[site].redundant_lines = state.counters[site].redundant_lines.load(std::memory_order_relaxed);
+    }
+    for (lines_shard& shard : state.shards)
+    {
+        std::unique_lock lock(shard.mutex);
+        for (uint32_t site = 0; site < NUMBER_OF_FLUSH_SITES; site++)
+        {
+            profile[site].distinct_lines += shard.site_lines[site].size();
+        }
+    }
+    return profile;
+}
+
+void reset_flush_profile()
+{
+    flush_profiler_state& state = get_state();
+    for (site_counters& counters : state.counters)
+    {
+        counters.flushes.store(0);
+        counters.flushed_bytes.store(0);
+        counters.flushed_lines.store(0);
+        counters.redundant_lines.store(0);
+    }
+    for (lines_shard& shard : state.shards)
+    {
+        std::unique_lock lock(shard.mutex);
+        shard.saved_lines.clear();
+        for (std::unordered_set<uint64_t>& lines : shard.site_lines)
+        {
+            lines.clear();
+        }
+    }
+}
+
+std::string format_flush_profile(std::array<flush_site_profile, NUMBER_OF_FLUSH_SITES> const& profile)
+{
+    std::vector<uint32_t> sites;
+    flush_site_profile total;
+    for (uint32_t site = 0; site < NUMBER_OF_FLUSH_SITES; site++)
+    {
+        sites.push_back(site);
+        total.flushes += profile[site].flushes;
+        total.flushed_bytes += profile[site].flushed_bytes;
+        total.flushed_lines += profile[site].flushed_lines;
+        total.distinct_lines += profile[site].distinct_lines;
+        total.redundant_lines += profile[site].redundant_lines;
+    }
+    /*
+     * The biggest sources of persistence traffic first
+     */
+    std::stable_sort(
+            sites.begin(),
+            sites.end(),
+            [&profile](uint32_t first, uint32_t second)
+            {
+                return profile[first].flushed_lines > profile[second].flushed_lines;
+            }
+    );
+
+    std::ostringstream out;
+    out << std::left << std::setw(18) << "site" << std::right
+        << std::setw(12) << "flushes"
+        << std::setw(14) << "bytes"
+        << std::setw(12) << "lines"
+        << std::setw(16) << "distinct_lines"
+        << std::setw(17) << "redundant_lines"
+        << std::setw(13) << "redundant_%"
+        << std::setw(21) << "write_amplification" << "\n";
+    const auto print_row = [&out](std::string const& name, flush_site_profile const& row)
+    {
+        const double redundant_share = row.flushed_lines == 0 ? 0 : 100.0 * row.redundant_lines / row.flushed_lines;
+        const double write_amplification =
+                row.flushed_bytes == 0 ? 0 : (double) row.flushed_lines * CACHE_LINE_SIZE / row.flushed_bytes;
+        out << std::left << std::setw(18) << name << std::right
+            << std::setw(12) << row.flushes
+            << std::setw(14) << row.flushed_bytes
+            << std::setw(12) << row.flushed_lines
+            << std::setw(16) << row.distinct_lines
+            << std::setw(17) << row.redundant_lines
+            << std::setw(13) << std::fixed << std::setprecision(1) << redundant_share
+            << std::setw(21) << std::fixed << std::setprecision(2) << write_amplification << "\n";
+    };
+    for (uint32_t site : sites)
+    {
+        print_row(get_flush_site_name((flush_site) site), profile[site]);
+    }
+    print_row("total", total);
+    return out.str();
+}
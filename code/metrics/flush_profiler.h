@@ -0,0 +1,82 @@
+#ifndef DIPLOM_FLUSH_PROFILER_H
+#define DIPLOM_FLUSH_PROFILER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <string>
+#include "../model/flush_site.h"
+
+/*
+ * pmem_do_flush reports flushes to the profiler only if FLUSH_PROFILING is defined.
+ * Functions below are always compiled.
+ */
+
+const uint32_t NUMBER_OF_FLUSH_SITES = (uint32_t) flush_site::NUMBER_OF_FLUSH_SITES;
+
+/**
+ * Persistence traffic, generated by a single flush site.
+ */
+struct flush_site_profile
+{
+    /**
+     * Number of pmem_do_flush calls.
+     */
+    uint64_t flushes = 0;
+    /**
+     * Total length of flushed ranges.
+     */
+    uint64_t flushed_bytes = 0;
+    /**
+     * Total number of flushed cache lines. Line, that is flushed several times, is counted several times.
+     */
+    uint64_t flushed_lines = 0;
+    /**
+     * Number of different cache lines, that have ever been flushed.
+     */
+    uint64_t distinct_lines = 0;
+    /**
+     * Number of flushed cache lines, which content hasn't changed since the previous flush
+     * of the line (by any site), i.e. flushes of clean lines.
+     */
+    uint64_t redundant_lines = 0;
+};
+
+/**
+ * Returns name of the flush site in snake case, e.g. end_marker.
+ */
+const char* get_flush_site_name(flush_site site);
+
+/**
+ * Records single flush. Content of each flushed cache line is saved and compared with the content
+ * at the moment of the next flush of the line, so that flushes of lines, that haven't been changed,
+ * are detected. Note, that profiler works with cache lines even if flushes are performed by msync(2).
+ * Can be called concurrently by different threads.
+ * @param ptr - beginning of the flushed range.
+ * @param len - length of the flushed range.
+ * @param site - place in the runtime, from which flush is performed.
+ */
+void profile_flush(const void* ptr, size_t len, flush_site site);
+
+/**
+ * Returns persistence traffic, recorded since the start of the program or the last reset.
+ * @return profiles of all flush sites, indexed by flush site.
+ */
+std::array<flush_site_profile, NUMBER_OF_FLUSH_SITES> get_flush_profile();
+
+/**
+ * Forgets all recorded flushes and saved content of cache lines. Should be called, when
+ * no flushes are performed concurrently.
+ */
+void reset_flush_profile();
+
+/**
+ * Formats summary report: one line per flush site, ordered by number of flushed cache lines,
+ * with share of redundant flushes and write amplification (flushed cache line bytes per requested byte),
+ * followed by totals.
+ * @param profile - profiles of all flush sites.
+ * @return text of the report.
+ */
+std::string format_flush_profile(std::array<flush_site_profile, NUMBER_OF_FLUSH_SITES> const& profile);
+
+#endif //DIPLOM_FLUSH_PROFILER_H
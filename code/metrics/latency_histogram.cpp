@@ -0,0 +1,100 @@
+#include "latency_histogram.h"
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    /**
+     * Increments variable, that is written by a single thread only.
+     */
+    void add_single_writer(std::atomic<uint64_t>& variable, uint64_t value)
+    {
+        variable.store(variable.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+}
+
+histogram_snapshot::histogram_snapshot() : buckets(latency_histogram::NUMBER_OF_BUCKETS, 0), count(0), sum(0), max(0)
+{}
+
+uint64_t histogram_snapshot::get_value_at_quantile(double q) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(std::ceil(q * count), 1);
+    uint64_t seen = 0;
+    for (uint32_t bucket = 0; bucket < buckets.size(); bucket++)
+    {
+        seen += buckets[bucket];
+        if (seen >= rank)
+        {
+            /*
+             * Bucket bound can be greater, than the largest recorded value
+             */
+            return std::min(latency_histogram::get_bucket_upper_bound(bucket), max);
+        }
+    }
+    return max;
+}
+
+double histogram_snapshot::get_mean() const
+{
+    return count == 0 ? 0 : (double) sum / count;
+}
+
+uint32_t latency_histogram::get_bucket(uint64_t value)
+{
+    if (value < SUB_BUCKETS)
+    {
+        return value;
+    }
+    /*
+     * Position of the highest set bit is at least SUB_BUCKET_BITS
+     */
+    const uint32_t highest_bit = 63 - __builtin_clzll(value);
+    const uint32_t sub_bucket = (value >> (highest_bit - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return (highest_bit - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub_bucket;
+}
+
+uint64_t latency_histogram::get_bucket_lower_bound(uint32_t bucket)
+{
+    if (bucket < SUB_BUCKETS)
+    {
+        return bucket;
+    }
+    const uint32_t highest_bit = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    const uint64_t sub_bucket = bucket % SUB_BUCKETS;
+    return (SUB_BUCKETS + sub_bucket) << (highest_bit - SUB_BUCKET_BITS);
+}
+
+uint64_t latency_histogram::get_bucket_upper_bound(uint32_t bucket)
+{
+    if (bucket + 1 == NUMBER_OF_BUCKETS)
+    {
+        return UINT64_MAX;
+    }
+    return get_bucket_lower_bound(bucket + 1) - 1;
+}
+
+void latency_histogram::record(uint64_t value)
+{
+    add_single_writer(buckets[get_bucket(value)], 1);
+    add_single_writer(count, 1);
+    add_single_writer(sum, value);
+    if (value > max.load(std::memory_order_relaxed))
+    {
+        max.store(value, std::memory_order_relaxed);
+    }
+}
+
+void latency_histogram::add_to(histogram_snapshot& snapshot) const
+{
+    for (uint32_t bucket = 0; bucket < NUMBER_OF_BUCKETS; bucket++)
+    {
+        snapshot.buckets[bucket] += buckets[bucket].load(std::memory_order_relaxed);
+    }
+    snapshot.count += count.load(std::memory_order_relaxed);
+    snapshot.sum += sum.load(std::memory_order_relaxed);
+    snapshot.max = std::max(snapshot.max, max.load(std::memory_order_relaxed));
+}
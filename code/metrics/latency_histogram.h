@@ -0,0 +1,100 @@
+#ifndef DIPLOM_LATENCY_HISTOGRAM_H
+#define DIPLOM_LATENCY_HISTOGRAM_H
+
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <vector>
+
+/**
+ * Aggregated copy of one or several latency histograms.
+ */
+struct histogram_snapshot
+{
+    /**
+     * Number of recorded values in each bucket of latency_histogram.
+     */
+    std::vector<uint64_t> buckets;
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+
+    /**
+     * Creates empty snapshot.
+     */
+    histogram_snapshot();
+
+    /**
+     * Returns q-th quantile of recorded values, using nearest-rank method. Since values are
+     * grouped into buckets, the largest value of the bucket, containing the quantile, is returned.
+     * @param q - quantile, between 0 and 1.
+     * @return q-th quantile of recorded values, 0 if no values have been recorded.
+     */
+    [[nodiscard]] uint64_t get_value_at_quantile(double q) const;
+
+    /**
+     * Returns mean of recorded values, 0 if no values have been recorded.
+     */
+    [[nodiscard]] double get_mean() const;
+};
+
+/**
+ * Histogram of latencies (in nanoseconds) with log-linear buckets: each power of two is split into
+ * SUB_BUCKETS equal buckets, therefore relative error of each recorded value is at most 1 / SUB_BUCKETS.
+ * Values less than SUB_BUCKETS are recorded exactly.
+ * Histogram must be updated by a single thread only (which is not checked), but can be read
+ * concurrently by any number of threads. Therefore, recording a value doesn't need atomic
+ * read-modify-write operations.
+ */
+struct latency_histogram
+{
+public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 4;
+    static constexpr uint32_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    /**
+     * Values below SUB_BUCKETS occupy first SUB_BUCKETS buckets, each of the remaining 64 - SUB_BUCKET_BITS
+     * powers of two occupies SUB_BUCKETS buckets.
+     */
+    static constexpr uint32_t NUMBER_OF_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    /**
+     * Returns number of the bucket, in which value is recorded.
+     * @param value - value to record.
+     * @return number of the bucket, less than NUMBER_OF_BUCKETS.
+     */
+    static uint32_t get_bucket(uint64_t value);
+
+    /**
+     * Returns the smallest value, that is recorded in the bucket.
+     * @param bucket - number of the bucket, less than NUMBER_OF_BUCKETS.
+     * @return the smallest value of the bucket.
+     */
+    static uint64_t get_bucket_lower_bound(uint32_t bucket);
+
+    /**
+     * Returns the largest value, that is recorded in the bucket.
+     * @param bucket - number of the bucket, less than NUMBER_OF_BUCKETS.
+     * @return the largest value of the bucket.
+     */
+    static uint64_t get_bucket_upper_bound(uint32_t bucket);
+
+    /**
+     * Records single value. Must be called by the owning thread only.
+     * @param value - value to record.
+     */
+    void record(uint64_t value);
+
+    /**
+     * Adds all values, recorded in the histogram, to the snapshot. Can be called by any thread.
+     * @param snapshot - snapshot, to which values are added.
+     */
+    void add_to(histogram_snapshot& snapshot) const;
+
+private:
+    std::array<std::atomic<uint64_t>, NUMBER_OF_BUCKETS> buckets{};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max{0};
+};
+
+#endif //DIPLOM_LATENCY_HISTOGRAM_H
@@ -0,0 +1,78 @@
+#include "metrics_export.h"
+#include <sstream>
+#include <iomanip>
+
+namespace
+{
+    /**
+     * Quantiles, that are exported for each histogram, together with their names in JSON.
+     */
+    const std::array<std::pair<double, const char*>, 4> EXPORTED_QUANTILES = {{
+            {0.5, "p50"},
+            {0.9, "p90"},
+            {0.99, "p99"},
+            {0.999, "p999"}
+    }};
+
+    /**
+     * Converts nanoseconds to seconds.
+     */
+    double to_seconds(double nanoseconds)
+    {
+        return nanoseconds / 1e9;
+    }
+}
+
+std::string metrics_to_json(metrics_snapshot const& snapshot)
+{
+    std::ostringstream out;
+    out << "{\"counters\": {";
+    for (uint32_t i = 0; i < NUMBER_OF_COUNTERS; i++)
+    {
+        out << (i == 0 ? "" : ", ")
+            << "\"" << get_counter_name((metrics_counter) i) << "\": " << snapshot.counters[i];
+    }
+    out << "}, \"histograms\": {";
+    for (uint32_t i = 0; i < NUMBER_OF_HISTOGRAMS; i++)
+    {
+        histogram_snapshot const& histogram = snapshot.histograms[i];
+        out << (i == 0 ? "" : ", ")
+            << "\"" << get_histogram_name((metrics_histogram) i) << "\": {"
+            << "\"count\": " << histogram.count
+            << ", \"sum_ns\": " << histogram.sum
+            << ", \"mean_ns\": " << std::fixed << std::setprecision(1) << histogram.get_mean();
+        for (auto const& [q, name] : EXPORTED_QUANTILES)
+        {
+            out << ", \"" << name << "_ns\": " << histogram.get_value_at_quantile(q);
+        }
+        out << ", \"max_ns\": " << histogram.max << "}";
+    }
+    out << "}}";
+    return out.str();
+}
+
+std::string metrics_to_prometheus(metrics_snapshot const& snapshot)
+{
+    std::ostringstream out;
+    for (uint32_t i = 0; i < NUMBER_OF_COUNTERS; i++)
+    {
+        const std::string name = std::string("diplom_") + get_counter_name((metrics_counter) i) + "_total";
+        out << "# TYPE " << name << " counter\n"
+            << name << " " << snapshot.counters[i] << "\n";
+    }
+    out << std::setprecision(9);
+    for (uint32_t i = 0; i < NUMBER_OF_HISTOGRAMS; i++)
+    {
+        histogram_snapshot const& histogram = snapshot.histograms[i];
+        const std::string name = std::string("diplom_") + get_histogram_name((metrics_histogram) i) + "_seconds";
+        out << "# TYPE " << name << " summary\n";
+        for (auto const& quantile : EXPORTED_QUANTILES)
+        {
+            out << name << "{quantile=\"" << quantile.first << "\"} "
+                << to_seconds(histogram.get_value_at_quantile(quantile.first)) << "\n";
+        }
+        out << name << "_sum " << to_seconds(histogram.sum) << "\n"
+            << name << "_count " << histogram.count << "\n";
+    }
+    return out.str();
+}
@@ -0,0 +1,26 @@
+#ifndef DIPLOM_METRICS_EXPORT_H
+#define DIPLOM_METRICS_EXPORT_H
+
+#include <string>
+#include "runtime_metrics.h"
+
+/**
+ * Formats metrics as a single JSON object of the form
+ * {"counters": {"<counter>": <value>, ...},
+ *  "histograms": {"<histogram>": {"count": ..., "sum_ns": ..., "mean_ns": ..., "p50_ns": ..., "p90_ns": ...,
+ *                                 "p99_ns": ..., "p999_ns": ..., "max_ns": ...}, ...}}
+ * @param snapshot - aggregated metrics.
+ * @return JSON representation of the metrics.
+ */
+std::string metrics_to_json(metrics_snapshot const& snapshot);
+
+/**
+ * Formats metrics in Prometheus text exposition format. Counters are exported as
+ * diplom_<counter>_total, histograms are exported as summaries diplom_<histogram>_seconds
+ * with 0.5, 0.9, 0.99 and 0.999 quantiles.
+ * @param snapshot - aggregated metrics.
+ * @return Prometheus representation of the metrics.
+ */
+std::string metrics_to_prometheus(metrics_snapshot const& snapshot);
+
+#endif //DIPLOM_METRICS_EXPORT_H
@@ -0,0 +1,165 @@
+#include "runtime_metrics.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    /**
+     * Metrics of a single thread. Updated by the owning thread only.
+     */
+    struct thread_metrics
+    {
+        std::array<std::atomic<uint64_t>, NUMBER_OF_COUNTERS> counters{};
+        std::array<latency_histogram, NUMBER_OF_HISTOGRAMS> histograms;
+    };
+
+    /**
+     * Metrics of all threads. Metrics of finished threads are never removed, so that they are
+     * included in aggregated metrics.
+     */
+    struct metrics_registry
+    {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<thread_metrics>> threads;
+    };
+
+    /**
+     * Registry is created on the first use, so that metrics can be updated during initialization
+     * of other global variables.
+     */
+    metrics_registry& get_registry()
+    {
+        static metrics_registry registry;
+        return registry;
+    }
+
+    thread_local thread_metrics* cur_thread_metrics = nullptr;
+
+    /**
+     * Returns metrics of the current thread, registering them on the first call.
+     */
+    thread_metrics& get_thread_metrics()
+    {
+        if (cur_thread_metrics == nullptr)
+        {
+            metrics_registry& registry = get_registry();
+            std::unique_lock lock(registry.mutex);
+            registry.threads.push_back(std::make_unique<thread_metrics>());
+            cur_thread_metrics = registry.threads.back().get();
+        }
+        return *cur_thread_metrics;
+    }
+}
+
+const char* get_counter_name(metrics_counter counter)
+{
+    switch (counter)
+    {
+        case metrics_counter::FRAME_PUSHES:
+            return "frame_pushes";
+        case metrics_counter::FRAME_POPS:
+            return "frame_pops";
+        case metrics_counter::FLUSHES:
+            return "flushes";
+        case metrics_counter::FLUSHED_BYTES:
+            return "flushed_bytes";
+        case metrics_counter::SUCCESSFUL_CAS:
+            return "successful_cas";
+        case metrics_counter::FAILED_CAS:
+            return "failed_cas";
+        case metrics_counter::CAS_NOTIFICATIONS:
+            return "cas_notifications";
+        case metrics_counter::ALLOCATIONS:
+            return "allocations";
+        case metrics_counter::ALLOCATIONS_FROM_FREED:
+            return "allocations_from_freed";
+        case metrics_counter::FAILED_ALLOCATIONS:
+            return "failed_allocations";
+        case metrics_counter::FREES:
+            return "frees";
+        case metrics_counter::DRAINS:
+            return "drains";
+        case metrics_counter::GROUP_COMMITS:
+            return "group_commits";
+        default:
+            return "unknown";
+    }
+}
+
+const char* get_histogram_name(metrics_histogram histogram)
+{
+    switch (histogram)
+    {
+        case metrics_histogram::FRAME_PUSH:
+            return "frame_push";
+        case metrics_histogram::FRAME_POP:
+            return "frame_pop";
+        case metrics_histogram::FLUSH:
+            return "flush";
+        case metrics_histogram::CAS_NOTIFICATION:
+            return "cas_notification";
+        case metrics_histogram::CAS_UPDATE:
+            return "cas_update";
+        case metrics_histogram::ALLOCATION:
+            return "allocation";
+        case metrics_histogram::FREE:
+            return "free";
+        case metrics_histogram::QUEUE_WAIT:
+            return "queue_wait";
+        default:
+            return "unknown";
+    }
+}
+
+uint64_t metrics_snapshot::get_counter(metrics_counter counter) const
+{
+    return counters[(uint32_t) counter];
+}
+
+histogram_snapshot const& metrics_snapshot::get_histogram(metrics_histogram histogram) const
+{
+    return histograms[(uint32_t) histogram];
+}
+
+void increment_counter(metrics_counter counter, uint64_t value)
+{
+    std::atomic<uint64_t>& cur_counter = get_thread_metrics().counters[(uint32_t) counter];
+    /*
+     * Counter is updated by the current thread only, therefore atomic increment is not needed
+     */
+    cur_counter.store(cur_counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void record_latency(metrics_histogram histogram, std::chrono::nanoseconds latency)
+{
+    get_thread_metrics().histograms[(uint32_t) histogram].record(latency.count() < 0 ? 0 : latency.count());
+}
+
+metrics_snapshot collect_metrics()
+{
+    metrics_snapshot snapshot;
+    metrics_registry& registry = get_registry();
+    std::unique_lock lock(registry.mutex);
+    for (std::unique_ptr<thread_metrics> const& cur_thread : registry.threads)
+    {
+        for (uint32_t i = 0; i < NUMBER_OF_COUNTERS; i++)
+        {
+            snapshot.counters[i] += cur_thread->counters[i].load(std::memory_order_relaxed);
+        }
+        for (uint32_t i = 0; i < NUMBER_OF_HISTOGRAMS; i++)
+        {
+            cur_thread->histograms[i].add_to(snapshot.histograms[i]);
+        }
+    }
+    return snapshot;
+}
+
+scoped_latency::scoped_latency(metrics_histogram _histogram) :
+        histogram(_histogram), start(std::chrono::steady_clock::now())
+{}
+
+scoped_latency::~scoped_latency()
+{
+    record_latency(histogram, std::chrono::steady_clock::now() - start);
+}
@@ -0,0 +1,155 @@
+#ifndef DIPLOM_RUNTIME_METRICS_H
+#define DIPLOM_RUNTIME_METRICS_H
+
+#include <cstdint>
+#include <array>
+#include <chrono>
+#include "latency_histogram.h"
+
+/*
+ * Hot paths of the runtime are instrumented only if RUNTIME_METRICS is defined. Otherwise,
+ * METRICS_* macros don't generate any code (and don't evaluate their arguments).
+ * Functions below are always compiled, so that metrics can be collected and exported by any build.
+ */
+
+/**
+ * Counters of runtime events.
+ */
+enum class metrics_counter : uint32_t
+{
+    FRAME_PUSHES,
+    FRAME_POPS,
+    FLUSHES,
+    FLUSHED_BYTES,
+    SUCCESSFUL_CAS,
+    FAILED_CAS,
+    CAS_NOTIFICATIONS,
+    ALLOCATIONS,
+    /**
+     * Allocations, that reused previously freed block.
+     */
+    ALLOCATIONS_FROM_FREED,
+    FAILED_ALLOCATIONS,
+    FREES,
+    /**
+     * Store fences (or synchronous msyncs), after which flushed data is durable.
+     */
+    DRAINS,
+    /**
+     * Batches of answers, committed by group committer.
+     */
+    GROUP_COMMITS,
+    NUMBER_OF_COUNTERS
+};
+
+/**
+ * Latencies of runtime operations.
+ */
+enum class metrics_histogram : uint32_t
+{
+    FRAME_PUSH,
+    FRAME_POP,
+    FLUSH,
+    /**
+     * Notification of the thread, that performed previous successful CAS.
+     */
+    CAS_NOTIFICATION,
+    /**
+     * Atomic CAS of the register and flush of the register.
+     */
+    CAS_UPDATE,
+    ALLOCATION,
+    FREE,
+    /**
+     * Time between putting task to the tasks queue and taking it from the queue.
+     */
+    QUEUE_WAIT,
+    NUMBER_OF_HISTOGRAMS
+};
+
+const uint32_t NUMBER_OF_COUNTERS = (uint32_t) metrics_counter::NUMBER_OF_COUNTERS;
+const uint32_t NUMBER_OF_HISTOGRAMS = (uint32_t) metrics_histogram::NUMBER_OF_HISTOGRAMS;
+
+/**
+ * Returns name of the counter in snake case, e.g. frame_pushes.
+ */
+const char* get_counter_name(metrics_counter counter);
+
+/**
+ * Returns name of the histogram in snake case, e.g. frame_push.
+ */
+const char* get_histogram_name(metrics_histogram histogram);
+
+/**
+ * Metrics of all threads, aggregated at some moment.
+ */
+struct metrics_snapshot
+{
+    std::array<uint64_t, NUMBER_OF_COUNTERS> counters{};
+    std::array<histogram_snapshot, NUMBER_OF_HISTOGRAMS> histograms;
+
+    [[nodiscard]] uint64_t get_counter(metrics_counter counter) const;
+
+    [[nodiscard]] histogram_snapshot const& get_histogram(metrics_histogram histogram) const;
+};
+
+/**
+ * Increments counter of the current thread. Each thread owns it's own counters, therefore no
+ * synchronization between threads is performed.
+ * @param counter - counter to increment.
+ * @param value - value to add to the counter.
+ */
+void increment_counter(metrics_counter counter, uint64_t value);
+
+/**
+ * Records latency to the histogram of the current thread.
+ * @param histogram - histogram, to which latency is recorded.
+ * @param latency - latency to record. Negative latencies are recorded as zero.
+ */
+void record_latency(metrics_histogram histogram, std::chrono::nanoseconds latency);
+
+/**
+ * Aggregates metrics of all threads, that have ever updated any metrics (including finished threads).
+ * Can be called concurrently with updates: each counter and each bucket is read atomically,
+ * but the snapshot as a whole is not.
+ * @return aggregated metrics.
+ */
+metrics_snapshot collect_metrics();
+
+/**
+ * Records time from construction till destruction to the histogram.
+ */
+struct scoped_latency
+{
+public:
+    explicit scoped_latency(metrics_histogram _histogram);
+
+    scoped_latency(scoped_latency const& other) = delete;
+
+    scoped_latency& operator=(scoped_latency const& other) = delete;
+
+    ~scoped_latency();
+
+private:
+    metrics_histogram histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+#ifdef RUNTIME_METRICS
+
+#define METRICS_CONCAT_IMPL(a, b) a##b
+#define METRICS_CONCAT(a, b) METRICS_CONCAT_IMPL(a, b)
+
+#define METRICS_INCREMENT(counter, value) increment_counter(counter, value)
+#define METRICS_RECORD_LATENCY(histogram, latency) record_latency(histogram, latency)
+#define METRICS_SCOPED_LATENCY(histogram) scoped_latency METRICS_CONCAT(scoped_latency_, __LINE__)(histogram)
+
+#else
+
+#define METRICS_INCREMENT(counter, value)
+#define METRICS_RECORD_LATENCY(histogram, latency)
+#define METRICS_SCOPED_LATENCY(histogram)
+
+#endif
+
+#endif //DIPLOM_RUNTIME_METRICS_H
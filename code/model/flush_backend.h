@@ -0,0 +1,25 @@
+#ifndef DIPLOM_FLUSH_BACKEND_H
+#define DIPLOM_FLUSH_BACKEND_H
+
+/**
+ * Way, in which pmem_do_flush makes data durable.
+ */
+enum class flush_backend
+{
+    /*
+     * pmem_msync: msync(2) of the pages, containing the range. Is used, when persistent memory
+     * is emulated by memory-mapped files.
+     */
+    MSYNC,
+    /*
+     * pmem_persist: cache line flushes and a store fence. Is used on real NVRAM.
+     */
+    PERSIST,
+    /*
+     * No flush at all. Data is not durable, therefore is used only for measuring
+     * costs of the runtime itself.
+     */
+    NONE
+};
+
+#endif //DIPLOM_FLUSH_BACKEND_H
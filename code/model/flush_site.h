@@ -0,0 +1,55 @@
+#ifndef DIPLOM_FLUSH_SITE_H
+#define DIPLOM_FLUSH_SITE_H
+
+#include <cstdint>
+
+/**
+ * Place in the runtime, from which pmem_do_flush is called. Is used by flush profiler
+ * (when FLUSH_PROFILING is defined) to attribute persistence traffic to it's sources.
+ */
+enum class flush_site : uint32_t
+{
+    /*
+     * New frame of persistent stack.
+     */
+    FRAME,
+    /*
+     * End marker of a frame, i.e. the commit point of adding or removing a frame.
+     */
+    END_MARKER,
+    /*
+     * Header of persistent stack.
+     */
+    STACK_HEADER,
+    /*
+     * Answer of a function or it's default value.
+     */
+    ANSWER,
+    /*
+     * Allocation marker of the heap block.
+     */
+    ALLOCATOR_MARKER,
+    /*
+     * Notification of the thread, that performed previous successful CAS.
+     */
+    CAS_NOTIFICATION,
+    /*
+     * RMW register, changed by CAS.
+     */
+    CAS_VAR,
+    /*
+     * Redo log of a transaction (entries and header).
+     */
+    TX_LOG,
+    /*
+     * Location, written by a committed transaction.
+     */
+    TX_DATA,
+    /*
+     * Any other place (initialization, tests, etc).
+     */
+    OTHER,
+    NUMBER_OF_FLUSH_SITES
+};
+
+#endif //DIPLOM_FLUSH_SITE_H
@@ -1,4 +1,15 @@
 #include "function_address_holder.h"
+#include <stdexcept>
 
-function_address_holder::function_address_holder() : funcs()
+function_address_holder::function_address_holder() : funcs(), volatile_funcs()
 {}
+
+std::pair<function_ptr, function_ptr> const& function_address_holder::get_funcs(std::string_view function_name) const
+{
+    auto it = funcs.find(function_name);
+    if (it == funcs.end())
+    {
+        throw std::runtime_error("Function " + std::string(function_name) + " is not registered");
+    }
+    return it->second;
+}
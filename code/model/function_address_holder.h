@@ -1,7 +1,10 @@
 #ifndef DIPLOM_FUNCTION_ADDRESS_HOLDER_H
 #define DIPLOM_FUNCTION_ADDRESS_HOLDER_H
 
-#include <unordered_map>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
 #include "../common/constants_and_types.h"
 
 /**
@@ -10,12 +13,28 @@
  * should be registered in this mapping before starting execution or restoration.
  * Since there should be only only instance of such mapping, it is proposed to use
  * this class with global_storage<T>.
+ * Mappings support lookup by std::string_view, so that looking up a function doesn't allocate memory.
  */
 struct function_address_holder
 {
-    std::unordered_map<std::string, std::pair<function_ptr, function_ptr>> funcs;
+    std::map<std::string, std::pair<function_ptr, function_ptr>, std::less<>> funcs;
+
+    /**
+     * Mapping from function name to pointer to volatile function. Volatile functions must not modify
+     * persistent memory: they are called using do_volatile_call, without persistent frames,
+     * and are never recovered.
+     */
+    std::map<std::string, volatile_function_ptr, std::less<>> volatile_funcs;
 
     function_address_holder();
+
+    /**
+     * Looks up pointers to the function with specified name and to it's recovery version.
+     * @param function_name - name of the function.
+     * @return pair of pointers to function and to it's recovery version.
+     * @throws std::runtime_error - if function with specified name is not registered.
+     */
+    [[nodiscard]] std::pair<function_ptr, function_ptr> const& get_funcs(std::string_view function_name) const;
 };
 
 #endif //DIPLOM_FUNCTION_ADDRESS_HOLDER_H
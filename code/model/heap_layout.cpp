@@ -0,0 +1,115 @@
+#include "heap_layout.h"
+#include "../common/constants_and_types.h"
+#include "../common/pmem_utils.h"
+#include <stdexcept>
+#include <string>
+
+const uint32_t heap_layout::ANSWER_BLOCK_SIZE = 63;
+
+const uint64_t heap_layout::MAX_ANSWERS = 4096;
+
+const uint32_t heap_layout::NODE_BLOCK_SIZE = 63;
+
+const uint32_t heap_layout::ROOT_ENTRY_BLOCK_SIZE = 63;
+
+const uint64_t heap_layout::MAX_ROOT_ENTRIES = 255;
+
+const uint64_t heap_layout::NAMED_OBJECTS_SIZE = 256 * 1024;
+
+heap_layout::heap_layout(uint32_t _number_of_threads, uint32_t _number_of_vars) :
+        number_of_threads(_number_of_threads),
+        number_of_vars(_number_of_vars)
+{
+    if (number_of_vars == 0)
+    {
+        throw std::runtime_error("Number of variables must be positive");
+    }
+    vars_offset = get_named_objects_offset() + NAMED_OBJECTS_SIZE;
+    /*
+     * Register occupies single cache line, thread matrix contains 4 bytes for each pair of threads
+     */
+    var_size = CACHE_LINE_SIZE +
+               get_cache_line_aligned_address((uint64_t) _number_of_threads * _number_of_threads * 4);
+    /*
+     * Region of nodes contains at least the first node, which is never given to user
+     */
+    if (vars_offset + var_size * number_of_vars + NODE_BLOCK_SIZE + 1 > PMEM_HEAP_SIZE)
+    {
+        throw std::runtime_error(
+                std::to_string(number_of_vars) + " variables for " + std::to_string(_number_of_threads) +
+                " threads don't fit into persistent heap"
+        );
+    }
+}
+
+uint64_t heap_layout::get_var_offset(uint32_t var_number) const
+{
+    return vars_offset + var_size * var_number;
+}
+
+uint64_t heap_layout::get_thread_matrix_offset(uint32_t var_number) const
+{
+    return get_var_offset(var_number) + CACHE_LINE_SIZE;
+}
+
+uint32_t heap_layout::get_number_of_threads() const
+{
+    return number_of_threads;
+}
+
+uint32_t heap_layout::get_number_of_vars() const
+{
+    return number_of_vars;
+}
+
+uint32_t heap_layout::get_var_node(uint32_t var_number, uint32_t number_of_nodes) const
+{
+    /*
+     * Maximal node, such that get_first_var_of_node(node) <= var_number
+     */
+    return ((uint64_t) (var_number + 1) * number_of_nodes - 1) / number_of_vars;
+}
+
+uint32_t heap_layout::get_first_var_of_node(uint32_t node_index, uint32_t number_of_nodes) const
+{
+    return (uint64_t) node_index * number_of_vars / number_of_nodes;
+}
+
+uint64_t heap_layout::get_allocator_max_border() const
+{
+    return MAX_ANSWERS;
+}
+
+uint64_t heap_layout::get_root_directory_offset()
+{
+    /*
+     * First block of the allocator is never given to user, therefore MAX_ANSWERS + 1 blocks are used
+     */
+    return get_cache_line_aligned_address((MAX_ANSWERS + 1) * (ANSWER_BLOCK_SIZE + 1));
+}
+
+uint64_t heap_layout::get_root_directory_max_border() const
+{
+    return MAX_ROOT_ENTRIES;
+}
+
+uint64_t heap_layout::get_named_objects_offset() const
+{
+    /*
+     * First block of the directory allocator contains heap header, therefore MAX_ROOT_ENTRIES + 1 blocks are used
+     */
+    return get_cache_line_aligned_address(
+            get_root_directory_offset() + (MAX_ROOT_ENTRIES + 1) * (ROOT_ENTRY_BLOCK_SIZE + 1)
+    );
+}
+
+uint64_t heap_layout::get_nodes_offset() const
+{
+    return get_var_offset(number_of_vars);
+}
+
+uint64_t heap_layout::get_nodes_max_border() const
+{
+    const uint64_t number_of_nodes = (PMEM_HEAP_SIZE - get_nodes_offset()) / (NODE_BLOCK_SIZE + 1);
+    return number_of_nodes == 0 ? 0 : number_of_nodes - 1;
+}
@@ -0,0 +1,167 @@
+#ifndef DIPLOM_HEAP_LAYOUT_H
+#define DIPLOM_HEAP_LAYOUT_H
+
+#include <cstdint>
+
+/**
+ * Layout of the persistent heap, used by the runtime. Heap is divided into five regions:
+ * <ul>
+ *  <li>
+ *      Region of the allocator, from which answer locations of tasks are allocated.
+ *      Each block with it's allocation marker occupies exactly one cache line, therefore
+ *      answers of different tasks are never flushed together.
+ *  </li>
+ *  <li>
+ *      Region of the root directory (see root_directory), which starts at the first cache line after
+ *      the allocator region. Entries of the directory are allocated by it's own allocator, the first block
+ *      of which (never given to user) contains heap header. Offset of the region doesn't depend
+ *      on the number of threads and variables.
+ *  </li>
+ *  <li>
+ *      Region of named objects, which starts right after the root directory region and has fixed size.
+ *  </li>
+ *  <li>
+ *      Region of variables, which starts at the first cache line after the named objects region.
+ *      Each variable consists of RMW register, occupying single cache line, and thread matrix
+ *      of the register, which starts at the next cache line.
+ *  </li>
+ *  <li>
+ *      Region of nodes of persistent data structures, which starts right after the variables region
+ *      and occupies the rest of the heap. Each node with it's allocation marker occupies exactly one cache line.
+ *  </li>
+ * </ul>
+ * Layout depends only on number of threads and number of variables, therefore the same layout
+ * is computed after restart, if both numbers are the same.
+ */
+struct heap_layout
+{
+public:
+    /**
+     * Size of allocator block. Together with allocation marker, each block occupies a single cache line.
+     */
+    static const uint32_t ANSWER_BLOCK_SIZE;
+
+    /**
+     * Maximal number of answer locations, that can be allocated simultaneously.
+     */
+    static const uint64_t MAX_ANSWERS;
+
+    /**
+     * Size of node of persistent data structures. Together with allocation marker, each node occupies
+     * a single cache line.
+     */
+    static const uint32_t NODE_BLOCK_SIZE;
+
+    /**
+     * Size of entry of the root directory. Together with allocation marker, each entry occupies
+     * a single cache line.
+     */
+    static const uint32_t ROOT_ENTRY_BLOCK_SIZE;
+
+    /**
+     * Maximal number of named objects in the root directory.
+     */
+    static const uint64_t MAX_ROOT_ENTRIES;
+
+    /**
+     * Size of the region of named objects in bytes, multiple of cache line size.
+     */
+    static const uint64_t NAMED_OBJECTS_SIZE;
+
+    /**
+     * Computes layout of the heap.
+     * @param _number_of_threads - number of worker threads.
+     * @param _number_of_vars - number of RMW registers.
+     * @throws std::runtime_error - if number of vars is zero or variables don't fit into the heap.
+     */
+    heap_layout(uint32_t _number_of_threads, uint32_t _number_of_vars);
+
+    /**
+     * Returns offset of RMW register from the beginning of the heap.
+     * @param var_number - number of the register, not greater than number of vars.
+     * @return offset of the register. If var_number is equal to number of vars, returns offset of the end
+     * of the variables region.
+     */
+    [[nodiscard]] uint64_t get_var_offset(uint32_t var_number) const;
+
+    /**
+     * Returns offset of thread matrix of RMW register from the beginning of the heap.
+     * @param var_number - number of the register, less than number of vars.
+     * @return offset of the thread matrix.
+     */
+    [[nodiscard]] uint64_t get_thread_matrix_offset(uint32_t var_number) const;
+
+    [[nodiscard]] uint32_t get_number_of_threads() const;
+
+    [[nodiscard]] uint32_t get_number_of_vars() const;
+
+    /**
+     * Returns index of NUMA node, that owns RMW register, if registers are split between nodes
+     * into contiguous ranges of (almost) equal size.
+     * @param var_number - number of the register, less than number of vars.
+     * @param number_of_nodes - number of NUMA nodes.
+     * @return index of the node, less than number of nodes.
+     */
+    [[nodiscard]] uint32_t get_var_node(uint32_t var_number, uint32_t number_of_nodes) const;
+
+    /**
+     * Returns number of the first RMW register, owned by NUMA node (see get_var_node). Registers of the node
+     * are [get_first_var_of_node(node_index), get_first_var_of_node(node_index + 1)).
+     * @param node_index - index of the node, not greater than number of nodes.
+     * @param number_of_nodes - number of NUMA nodes.
+     * @return number of the first register of the node, or number of vars, if node_index == number_of_nodes.
+     */
+    [[nodiscard]] uint32_t get_first_var_of_node(uint32_t node_index, uint32_t number_of_nodes) const;
+
+    /**
+     * Returns maximal allocation border of the allocator of answer locations.
+     * @return maximal allocation border, that should be passed to pmem_allocator.
+     */
+    [[nodiscard]] uint64_t get_allocator_max_border() const;
+
+    /**
+     * Returns offset of the region of the root directory from the beginning of the heap. Offset is the same
+     * for all layouts, therefore heap header can be read before number of threads and variables are known.
+     * @return offset of the region, aligned by cache line size.
+     */
+    static uint64_t get_root_directory_offset();
+
+    /**
+     * Returns maximal allocation border of the allocator of entries of the root directory.
+     * @return maximal allocation border, that should be passed to pmem_allocator.
+     */
+    [[nodiscard]] uint64_t get_root_directory_max_border() const;
+
+    /**
+     * Returns offset of the region of named objects from the beginning of the heap.
+     * @return offset of the region, aligned by cache line size.
+     */
+    [[nodiscard]] uint64_t get_named_objects_offset() const;
+
+    /**
+     * Returns offset of the region of nodes of persistent data structures from the beginning of the heap.
+     * @return offset of the region, aligned by cache line size.
+     */
+    [[nodiscard]] uint64_t get_nodes_offset() const;
+
+    /**
+     * Returns maximal allocation border of the allocator of nodes, i.e. number of nodes, that fit into
+     * the region of nodes (first node of the region is never given to user).
+     * @return maximal allocation border, can be zero, if region of nodes contains at most one node.
+     */
+    [[nodiscard]] uint64_t get_nodes_max_border() const;
+
+private:
+    uint32_t number_of_threads;
+    uint32_t number_of_vars;
+    /**
+     * Offset of the first variable.
+     */
+    uint64_t vars_offset;
+    /**
+     * Size of register with it's thread matrix, aligned by cache line size.
+     */
+    uint64_t var_size;
+};
+
+#endif //DIPLOM_HEAP_LAYOUT_H
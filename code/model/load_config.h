@@ -0,0 +1,61 @@
+#ifndef DIPLOM_LOAD_CONFIG_H
+#define DIPLOM_LOAD_CONFIG_H
+
+#include <cstdint>
+#include <chrono>
+#include <optional>
+#include "../numa/numa_topology.h"
+
+/**
+ * Parameters of the load, generated by load generator.
+ */
+struct load_config
+{
+    /**
+     * Fraction of CAS tasks, from 0 to 1. All other tasks are read tasks.
+     */
+    double cas_ratio = 0.5;
+
+    /**
+     * Exponent of Zipfian distribution of variables, to which tasks are applied.
+     * 0 means uniform distribution, bigger values mean higher contention on the first variables.
+     */
+    double zipf_exponent = 0;
+
+    /**
+     * Mean number of tasks, arriving each second. Arrivals form Poisson process and don't depend on
+     * completion of previous tasks (i.e. load is open-loop).
+     */
+    double arrival_rate = 1000;
+
+    /**
+     * Time, during which tasks are generated.
+     */
+    std::chrono::nanoseconds duration = std::chrono::seconds(10);
+
+    /**
+     * Seed of random generator, used to generate tasks and arrival times.
+     */
+    uint64_t seed = 0;
+
+    /**
+     * Maximal time between two consecutive group commits of task answers. 0 means, that group commit is
+     * disabled and each answer is flushed by the worker thread, that executed the task. With group commit,
+     * task, which completion hasn't been acknowledged before the crash, may have been applied (see group_committer).
+     */
+    std::chrono::nanoseconds group_commit_interval = std::chrono::nanoseconds(0);
+
+    /**
+     * Number of answers, after which group commit is done without waiting for the end of commit interval.
+     */
+    uint32_t group_commit_batch_size = 64;
+
+    /**
+     * If present, worker threads are split between NUMA nodes and pinned to CPUs of their nodes,
+     * registers are split between nodes (see heap_layout::get_var_node), and each task is routed to the queue
+     * of the node, that owns it's register. Otherwise, all workers share single queue and are not pinned.
+     */
+    std::optional<numa_topology> topology;
+};
+
+#endif //DIPLOM_LOAD_CONFIG_H
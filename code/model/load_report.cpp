@@ -0,0 +1,39 @@
+#include "load_report.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    /**
+     * Returns q-th quantile of sorted latencies, using nearest-rank method.
+     */
+    std::chrono::nanoseconds get_quantile(std::vector<std::chrono::nanoseconds> const& sorted_latencies, double q)
+    {
+        if (sorted_latencies.empty())
+        {
+            return std::chrono::nanoseconds(0);
+        }
+        const uint64_t rank = std::ceil(q * sorted_latencies.size());
+        return sorted_latencies[std::max<uint64_t>(rank, 1) - 1];
+    }
+}
+
+task_type_report::task_type_report(std::vector<std::chrono::nanoseconds>& latencies, std::chrono::nanoseconds elapsed) :
+        completed(latencies.size()),
+        ops_per_second(elapsed.count() == 0
+                       ? 0
+                       : latencies.size() / std::chrono::duration<double>(elapsed).count())
+{
+    std::sort(latencies.begin(), latencies.end());
+    p50 = get_quantile(latencies, 0.5);
+    p99 = get_quantile(latencies, 0.99);
+    p999 = get_quantile(latencies, 0.999);
+}
+
+load_report::load_report(task_type_report _cas,
+                         task_type_report _read,
+                         uint64_t _successful_cas,
+                         uint64_t _dropped,
+                         std::chrono::nanoseconds _elapsed) :
+        cas(_cas), read(_read), successful_cas(_successful_cas), dropped(_dropped), elapsed(_elapsed)
+{}
@@ -0,0 +1,71 @@
+#ifndef DIPLOM_LOAD_REPORT_H
+#define DIPLOM_LOAD_REPORT_H
+
+#include <cstdint>
+#include <chrono>
+#include <vector>
+
+/**
+ * Throughput and latency of tasks of a single type.
+ * Latency of task is measured from the moment, when the task should have arrived according to the
+ * arrival schedule, till the end of it's execution, therefore time, spent in the queue, is included.
+ */
+struct task_type_report
+{
+    /**
+     * Number of completed tasks.
+     */
+    uint64_t completed;
+
+    /**
+     * Number of completed tasks per second of the load.
+     */
+    double ops_per_second;
+
+    std::chrono::nanoseconds p50;
+
+    std::chrono::nanoseconds p99;
+
+    std::chrono::nanoseconds p999;
+
+    /**
+     * Computes report from latencies of all completed tasks of some type.
+     * @param latencies - latencies of all completed tasks, in arbitrary order. Vector is sorted in place.
+     * @param elapsed - time from the beginning of the load till completion of the last task.
+     */
+    task_type_report(std::vector<std::chrono::nanoseconds>& latencies, std::chrono::nanoseconds elapsed);
+};
+
+/**
+ * Result of the whole load.
+ */
+struct load_report
+{
+    task_type_report cas;
+
+    task_type_report read;
+
+    /**
+     * Number of CAS tasks, that changed the value of register.
+     */
+    uint64_t successful_cas;
+
+    /**
+     * Number of tasks, that were not issued, because too many tasks were in progress
+     * (i.e. answer location couldn't be allocated).
+     */
+    uint64_t dropped;
+
+    /**
+     * Time from the beginning of the load till completion of the last task.
+     */
+    std::chrono::nanoseconds elapsed;
+
+    load_report(task_type_report _cas,
+                task_type_report _read,
+                uint64_t _successful_cas,
+                uint64_t _dropped,
+                std::chrono::nanoseconds _elapsed);
+};
+
+#endif //DIPLOM_LOAD_REPORT_H
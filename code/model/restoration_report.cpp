@@ -0,0 +1,27 @@
+#include "restoration_report.h"
+
+#include <utility>
+
+stack_restoration_report::stack_restoration_report(uint32_t _stack_number,
+                                                   uint32_t _restored_frames,
+                                                   std::chrono::nanoseconds _duration) :
+        stack_number(_stack_number),
+        restored_frames(_restored_frames),
+        duration(_duration)
+{}
+
+restoration_report::restoration_report(std::vector<stack_restoration_report> _stacks,
+                                       std::chrono::nanoseconds _total_duration) :
+        stacks(std::move(_stacks)),
+        total_duration(_total_duration)
+{}
+
+uint64_t restoration_report::get_total_restored_frames() const
+{
+    uint64_t result = 0;
+    for (stack_restoration_report const& cur_report: stacks)
+    {
+        result += cur_report.restored_frames;
+    }
+    return result;
+}
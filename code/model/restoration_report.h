@@ -0,0 +1,56 @@
+#ifndef DIPLOM_RESTORATION_REPORT_H
+#define DIPLOM_RESTORATION_REPORT_H
+
+#include <cstdint>
+#include <chrono>
+#include <vector>
+
+/**
+ * Result of restoration of single persistent stack.
+ */
+struct stack_restoration_report
+{
+    /**
+     * Number of the stack (i.e. id of the thread, that owned the stack before the crash).
+     */
+    uint32_t stack_number;
+
+    /**
+     * Number of frames, for which recovery operation has been called.
+     */
+    uint32_t restored_frames;
+
+    /**
+     * Time, spent on reading the stack and running all recovery operations.
+     */
+    std::chrono::nanoseconds duration;
+
+    stack_restoration_report(uint32_t _stack_number, uint32_t _restored_frames, std::chrono::nanoseconds _duration);
+};
+
+/**
+ * Result of restoration of the whole system, i.e. of all persistent stacks.
+ */
+struct restoration_report
+{
+    /**
+     * Reports for each of the stacks, ordered by stack number.
+     */
+    std::vector<stack_restoration_report> stacks;
+
+    /**
+     * Wall-clock time from the beginning of restoration of the first stack
+     * till the end of restoration of the last stack.
+     */
+    std::chrono::nanoseconds total_duration;
+
+    restoration_report(std::vector<stack_restoration_report> _stacks, std::chrono::nanoseconds _total_duration);
+
+    /**
+     * Returns total number of frames, for which recovery operation has been called.
+     * @return sum of restored frames over all stacks.
+     */
+    [[nodiscard]] uint64_t get_total_restored_frames() const;
+};
+
+#endif //DIPLOM_RESTORATION_REPORT_H
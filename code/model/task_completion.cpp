@@ -0,0 +1,6 @@
+#include "task_completion.h"
+
+task_completion::task_completion(uint64_t _task_id, uint32_t _result) :
+        task_id(_task_id),
+        result(_result)
+{}
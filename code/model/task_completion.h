@@ -0,0 +1,26 @@
+#ifndef DIPLOM_TASK_COMPLETION_H
+#define DIPLOM_TASK_COMPLETION_H
+
+#include <cstdint>
+
+/**
+ * Notification about completion of the task, that was pushed to the tasks queue with task id.
+ * Notification is sent only after the answer of the task has been written to NVRAM.
+ */
+struct task_completion
+{
+public:
+    task_completion(uint64_t _task_id, uint32_t _result);
+
+    /**
+     * Id of the task, assigned by the producer.
+     */
+    uint64_t task_id;
+
+    /**
+     * Result of the task: 0x1 or 0x0 for successful or failed CAS, value of the register for read.
+     */
+    uint32_t result;
+};
+
+#endif //DIPLOM_TASK_COMPLETION_H
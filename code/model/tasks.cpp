@@ -1,16 +1,66 @@
 #include "tasks.h"
+#include <utility>
+#include <stdexcept>
 
 cas_task::cas_task(uint64_t _var_offset,
                    uint32_t _expected_value,
                    uint32_t _new_value,
                    uint64_t _answer_offset,
-                   uint64_t _thread_matrix_offset) :
+                   uint64_t _thread_matrix_offset,
+                   std::optional<uint64_t> _task_id) :
         var_offset(_var_offset),
         expected_value(_expected_value),
         new_value(_new_value),
         answer_offset(_answer_offset),
-        thread_matrix_offset(_thread_matrix_offset)
+        thread_matrix_offset(_thread_matrix_offset),
+        task_id(_task_id)
 {}
 
-read_task::read_task(uint64_t _var_offset) : var_offset(_var_offset)
+read_task::read_task(uint64_t _var_offset,
+                     std::optional<uint64_t> _answer_offset,
+                     std::shared_ptr<std::promise<uint32_t>> _completion,
+                     std::optional<uint64_t> _task_id) :
+        var_offset(_var_offset),
+        answer_offset(_answer_offset),
+        completion(std::move(_completion)),
+        task_id(_task_id)
+{}
+
+volatile_task::volatile_task(std::string _function_name,
+                             std::vector<uint8_t> _args,
+                             std::shared_ptr<std::promise<std::vector<uint8_t>>> _result) :
+        function_name(std::move(_function_name)),
+        args(std::move(_args)),
+        result(std::move(_result))
+{}
+
+snapshot_read_task::snapshot_read_task(std::vector<uint64_t> _var_offsets,
+                                       std::shared_ptr<std::promise<std::vector<uint32_t>>> _result) :
+        var_offsets(std::move(_var_offsets)),
+        result(std::move(_result))
+{}
+
+map_update_task::map_update_task(uint64_t _map_offset,
+                                 uint64_t _key,
+                                 std::optional<uint32_t> _value,
+                                 uint64_t _answer_offset,
+                                 std::optional<uint64_t> _task_id) :
+        map_offset(_map_offset),
+        key(_key),
+        value(_value),
+        answer_offset(_answer_offset),
+        task_id(_task_id)
+{
+    if (key == 0)
+    {
+        throw std::runtime_error("Key 0 is reserved for empty buckets of hash map");
+    }
+}
+
+map_get_task::map_get_task(uint64_t _map_offset,
+                           uint64_t _key,
+                           std::shared_ptr<std::promise<std::optional<uint32_t>>> _result) :
+        map_offset(_map_offset),
+        key(_key),
+        result(std::move(_result))
 {}
@@ -2,6 +2,12 @@
 #define DIPLOM_TASKS_H
 
 #include <cstdint>
+#include <variant>
+#include <string>
+#include <vector>
+#include <memory>
+#include <future>
+#include <optional>
 
 struct cas_task
 {
@@ -10,7 +16,8 @@ public:
              uint32_t _expected_value,
              uint32_t _new_value,
              uint64_t _answer_offset,
-             uint64_t _thread_matrix_offset);
+             uint64_t _thread_matrix_offset,
+             std::optional<uint64_t> _task_id = std::nullopt);
 
     const uint64_t var_offset;
 
@@ -22,15 +29,153 @@ public:
 
     const uint64_t thread_matrix_offset;
 
-    static const uint8_t CAS_TYPE = 0x0;
+    /**
+     * If present, completion of the task is reported to the completion queue with this id
+     * (see completion_notifier).
+     */
+    const std::optional<uint64_t> task_id;
+
+    static constexpr uint8_t CAS_TYPE = 0x0;
 };
 
+/**
+ * Task, that reads current value of RMW register. Read task is executed without persistent frames.
+ */
 struct read_task
 {
 public:
-    explicit read_task(uint64_t _var_offset);
+    explicit read_task(uint64_t _var_offset,
+                       std::optional<uint64_t> _answer_offset = std::nullopt,
+                       std::shared_ptr<std::promise<uint32_t>> _completion = nullptr,
+                       std::optional<uint64_t> _task_id = std::nullopt);
 
     const uint64_t var_offset;
+
+    /**
+     * If present, offset of memory location (from the beginning of the persistent heap), where 4 bytes of
+     * read value are written and flushed. Since read task is not restored after the crash, answer location
+     * contains read value only if completion of the task was observed.
+     */
+    const std::optional<uint64_t> answer_offset;
+
+    /**
+     * If not null, read value is passed to the promise after it has been written to the answer location.
+     */
+    const std::shared_ptr<std::promise<uint32_t>> completion;
+
+    /**
+     * If present, completion of the task is reported to the completion queue with this id
+     * (see completion_notifier).
+     */
+    const std::optional<uint64_t> task_id;
 };
 
+/**
+ * Task, that calls volatile function (function, that doesn't modify persistent memory).
+ * Such task is executed without persistent frames and is not recovered after the crash.
+ */
+struct volatile_task
+{
+public:
+    volatile_task(std::string _function_name,
+                  std::vector<uint8_t> _args,
+                  std::shared_ptr<std::promise<std::vector<uint8_t>>> _result = nullptr);
+
+    /**
+     * Name of the function, registered as volatile function.
+     */
+    const std::string function_name;
+
+    const std::vector<uint8_t> args;
+
+    /**
+     * If not null, result of the function is passed to the promise.
+     */
+    const std::shared_ptr<std::promise<std::vector<uint8_t>>> result;
+};
+
+/**
+ * Task, that reads values of several RMW registers at once. Values are read using double collect
+ * (see snapshot_read, which describes, when they are atomic) and without persistent frames.
+ */
+struct snapshot_read_task
+{
+public:
+    explicit snapshot_read_task(std::vector<uint64_t> _var_offsets,
+                                std::shared_ptr<std::promise<std::vector<uint32_t>>> _result = nullptr);
+
+    const std::vector<uint64_t> var_offsets;
+
+    /**
+     * If not null, values of the registers (in the same order, as register offsets) are passed to the promise.
+     */
+    const std::shared_ptr<std::promise<std::vector<uint32_t>>> result;
+};
+
+/**
+ * Task, that sets or removes key of the recoverable hash map (see hash_map.h). Task is executed using
+ * do_call of exec_task, therefore it is recoverable.
+ */
+struct map_update_task
+{
+public:
+    /**
+     * @param _map_offset - offset of the map from the beginning of the persistent heap.
+     * @param _key - key, must not be 0.
+     * @param _value - new value of the key, or empty optional, if the key should be removed.
+     * @param _answer_offset - offset of memory location, where 1 byte of answer of the map operation is written.
+     * @param _task_id - id of the task in the completion queue.
+     * @throws std::runtime_error - if key is 0.
+     */
+    map_update_task(uint64_t _map_offset,
+                    uint64_t _key,
+                    std::optional<uint32_t> _value,
+                    uint64_t _answer_offset,
+                    std::optional<uint64_t> _task_id = std::nullopt);
+
+    const uint64_t map_offset;
+
+    const uint64_t key;
+
+    const std::optional<uint32_t> value;
+
+    const uint64_t answer_offset;
+
+    /**
+     * If present, completion of the task is reported to the completion queue with this id
+     * (see completion_notifier).
+     */
+    const std::optional<uint64_t> task_id;
+
+    static constexpr uint8_t MAP_PUT_TYPE = 0x1;
+
+    static constexpr uint8_t MAP_REMOVE_TYPE = 0x2;
+};
+
+/**
+ * Task, that reads value of the key of the recoverable hash map. Task is executed without persistent frames
+ * and writes nothing to NVRAM.
+ */
+struct map_get_task
+{
+public:
+    explicit map_get_task(uint64_t _map_offset,
+                          uint64_t _key,
+                          std::shared_ptr<std::promise<std::optional<uint32_t>>> _result = nullptr);
+
+    const uint64_t map_offset;
+
+    const uint64_t key;
+
+    /**
+     * If not null, value of the key (or empty optional, if the key is absent) is passed to the promise.
+     */
+    const std::shared_ptr<std::promise<std::optional<uint32_t>>> result;
+};
+
+/**
+ * Task, that can be executed by worker thread.
+ */
+using task = std::variant<cas_task, read_task, volatile_task, snapshot_read_task, map_update_task, map_get_task>;
+
 #endif //DIPLOM_TASKS_H
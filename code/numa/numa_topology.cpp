@@ -0,0 +1,164 @@
+#include "numa_topology.h"
+#include "../common/constants_and_types.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <thread>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+/*
+ * Values from linux/mempolicy.h, which is not always installed
+ */
+const int MPOL_BIND_MODE = 2;
+const unsigned MPOL_MF_MOVE_FLAG = 1 << 1;
+
+numa_topology::numa_topology(std::vector<numa_node> _nodes) : nodes(std::move(_nodes))
+{
+    if (nodes.empty())
+    {
+        throw std::runtime_error("NUMA topology must contain at least one node");
+    }
+    for (numa_node const& cur_node: nodes)
+    {
+        if (cur_node.cpus.empty())
+        {
+            throw std::runtime_error("NUMA node " + std::to_string(cur_node.id) + " has no CPUs");
+        }
+    }
+}
+
+numa_topology numa_topology::detect()
+{
+    std::vector<numa_node> nodes;
+    /*
+     * Node ids can be sparse, therefore all possible ids are checked
+     */
+    std::ifstream possible_nodes("/sys/devices/system/node/possible");
+    std::string possible_nodes_list;
+    if (possible_nodes && std::getline(possible_nodes, possible_nodes_list))
+    {
+        for (uint32_t node_id: parse_cpu_list(possible_nodes_list))
+        {
+            std::ifstream cpu_list_file("/sys/devices/system/node/node" + std::to_string(node_id) + "/cpulist");
+            std::string cpu_list;
+            if (!cpu_list_file || !std::getline(cpu_list_file, cpu_list))
+            {
+                continue;
+            }
+            std::vector<uint32_t> cpus = parse_cpu_list(cpu_list);
+            if (!cpus.empty())
+            {
+                nodes.push_back(numa_node{node_id, std::move(cpus)});
+            }
+        }
+    }
+    if (nodes.empty())
+    {
+        std::vector<uint32_t> cpus;
+        for (uint32_t cpu = 0; cpu < std::max(std::thread::hardware_concurrency(), 1u); cpu++)
+        {
+            cpus.push_back(cpu);
+        }
+        nodes.push_back(numa_node{0, std::move(cpus)});
+    }
+    return numa_topology(std::move(nodes));
+}
+
+uint32_t numa_topology::get_number_of_nodes() const
+{
+    return nodes.size();
+}
+
+numa_node const& numa_topology::get_node(uint32_t node_index) const
+{
+    return nodes.at(node_index);
+}
+
+std::vector<uint32_t> parse_cpu_list(std::string const& cpu_list)
+{
+    std::vector<uint32_t> cpus;
+    const std::string trimmed = cpu_list.substr(0, cpu_list.find_last_not_of(" \t\n") + 1);
+    if (trimmed.empty())
+    {
+        return cpus;
+    }
+    std::stringstream stream(trimmed);
+    std::string range;
+    while (std::getline(stream, range, ','))
+    {
+        const size_t dash = range.find('-');
+        try
+        {
+            size_t parsed;
+            const uint32_t first = std::stoul(range, &parsed);
+            uint32_t last = first;
+            if (dash != std::string::npos)
+            {
+                if (parsed != dash)
+                {
+                    throw std::invalid_argument(range);
+                }
+                last = std::stoul(range.substr(dash + 1), &parsed);
+                parsed += dash + 1;
+            }
+            if (parsed != range.size() || last < first)
+            {
+                throw std::invalid_argument(range);
+            }
+            for (uint32_t cpu = first; cpu <= last; cpu++)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        catch (std::logic_error const&)
+        {
+            throw std::runtime_error("Malformed CPU list: " + cpu_list);
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+bool pin_current_thread(std::vector<uint32_t> const& cpus)
+{
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (uint32_t cpu: cpus)
+    {
+        if (cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+}
+
+bool bind_memory_to_node(const void* address, size_t length, uint32_t node_id)
+{
+    /*
+     * mbind requires page-aligned address
+     */
+    const uint64_t begin = (uint64_t) address / PAGE_SIZE * PAGE_SIZE;
+    const uint64_t end = (uint64_t) address + length;
+    const uint64_t bits_per_word = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> node_mask(node_id / bits_per_word + 1, 0);
+    node_mask[node_id / bits_per_word] |= 1ul << (node_id % bits_per_word);
+    /*
+     * Kernel ignores the last bit of the mask, therefore maxnode is one greater than the number of bits
+     */
+    const long result = syscall(
+            SYS_mbind,
+            begin,
+            end - begin,
+            MPOL_BIND_MODE,
+            node_mask.data(),
+            node_mask.size() * bits_per_word + 1,
+            MPOL_MF_MOVE_FLAG
+    );
+    return result == 0;
+}
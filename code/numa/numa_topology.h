@@ -0,0 +1,84 @@
+#ifndef DIPLOM_NUMA_TOPOLOGY_H
+#define DIPLOM_NUMA_TOPOLOGY_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * NUMA node, on which worker threads can run.
+ */
+struct numa_node
+{
+    /**
+     * Id of the node in the system (i.e. N in /sys/devices/system/node/nodeN).
+     */
+    uint32_t id;
+
+    /**
+     * CPUs, belonging to the node.
+     */
+    std::vector<uint32_t> cpus;
+};
+
+/**
+ * NUMA nodes of the machine, that have CPUs. Nodes without CPUs (e.g. memory-only nodes) are not included.
+ */
+struct numa_topology
+{
+public:
+    /**
+     * Creates topology from the list of nodes.
+     * @param _nodes - nodes of the topology.
+     * @throws std::runtime_error - if there are no nodes or some node has no CPUs.
+     */
+    explicit numa_topology(std::vector<numa_node> _nodes);
+
+    /**
+     * Reads topology of the machine from /sys/devices/system/node. If sysfs doesn't contain
+     * NUMA information, the whole machine is considered single node with id 0.
+     * @return topology of the machine.
+     */
+    static numa_topology detect();
+
+    [[nodiscard]] uint32_t get_number_of_nodes() const;
+
+    /**
+     * Returns node by it's index in the topology (not by system id).
+     * @param node_index - index of the node, less than number of nodes.
+     * @return node with the specified index.
+     */
+    [[nodiscard]] numa_node const& get_node(uint32_t node_index) const;
+
+private:
+    std::vector<numa_node> nodes;
+};
+
+/**
+ * Parses list of CPUs in the sysfs format, e.g. "0-3,8,10-11".
+ * @param cpu_list - list of CPUs. Trailing whitespace is ignored.
+ * @return numbers of CPUs in ascending order.
+ * @throws std::runtime_error - if list is malformed.
+ */
+std::vector<uint32_t> parse_cpu_list(std::string const& cpu_list);
+
+/**
+ * Restricts the caller thread to run only on the specified CPUs.
+ * @param cpus - CPUs, on which thread can run.
+ * @return true, if affinity was set, false otherwise (e.g. if none of the CPUs is available to the process).
+ */
+bool pin_current_thread(std::vector<uint32_t> const& cpus);
+
+/**
+ * Binds pages, containing the range [address, address + length), to the NUMA node, moving already allocated
+ * pages. Binding is best effort: it doesn't affect pages of files on DAX file systems (placement of such pages
+ * is fixed by the device) and may be ignored by the kernel for other file-backed mappings.
+ * @param address - beginning of the range.
+ * @param length - length of the range.
+ * @param node_id - system id of the node.
+ * @return true, if memory policy was set, false otherwise.
+ */
+bool bind_memory_to_node(const void* address, size_t length, uint32_t node_id);
+
+#endif //DIPLOM_NUMA_TOPOLOGY_H
@@ -2,6 +2,7 @@
 #include <fcntl.h>
 #include <stdexcept>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include "../common/constants_and_types.h"
 #include <iostream>
 #include <utility>
@@ -9,12 +10,19 @@
 #include <cassert>
 #include <unistd.h>
 
-persistent_memory_holder::persistent_memory_holder(std::string _file_name, bool open_existing, uint64_t _size)
+persistent_memory_holder::persistent_memory_holder(std::string _file_name,
+                                                   bool open_existing,
+                                                   uint64_t _size,
+                                                   bool read_only)
         : fd(-1),
           pmem_ptr(nullptr),
           file_name(std::move(_file_name)),
           size(_size)
 {
+    if (read_only && !open_existing)
+    {
+        throw std::runtime_error("New file cannot be opened for reading only: " + file_name);
+    }
     /*
      * New file should be created
      */
@@ -58,19 +66,28 @@ persistent_memory_holder::persistent_memory_holder(std::string _file_name, bool
         /*
          * Open existsing file
          */
-        fd = open(file_name.c_str(), O_RDWR, 0666);
+        fd = open(file_name.c_str(), read_only ? O_RDONLY : O_RDWR, 0666);
         if (fd < 0)
         {
             throw std::runtime_error("Error while opening file " + file_name);
         }
+        /*
+         * Reading beyond the end of the file through the mapping raises SIGBUS
+         */
+        struct stat file_stat{};
+        if (read_only && (fstat(fd, &file_stat) != 0 || (uint64_t) file_stat.st_size < size))
+        {
+            close(fd);
+            throw std::runtime_error("File " + file_name + " is shorter than " + std::to_string(size) + " bytes");
+        }
     }
 
     /*
      * Memory-map opened file into virtual memory
      */
-    void* pmemaddr = mmap(nullptr, size,PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    void* pmemaddr = mmap(nullptr, size, read_only ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
 
-    if (pmemaddr == nullptr)
+    if (pmemaddr == MAP_FAILED)
     {
         if (close(fd) == -1)
         {
@@ -107,16 +124,6 @@ persistent_memory_holder::~persistent_memory_holder()
     }
 }
 
-const uint8_t* persistent_memory_holder::get_pmem_ptr() const
-{
-    return pmem_ptr;
-}
-
-uint8_t* persistent_memory_holder::get_pmem_ptr()
-{
-    return pmem_ptr;
-}
-
 persistent_memory_holder::persistent_memory_holder(persistent_memory_holder&& other) noexcept
         : fd(other.fd), pmem_ptr(other.pmem_ptr), file_name(std::move(other.file_name)), size(other.size)
 {
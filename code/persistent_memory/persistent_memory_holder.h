@@ -33,8 +33,13 @@ struct persistent_memory_holder
      *                        existing file will be opened.
      * @param _size - number of bytes in file. It is recommended to use PMEM_STACK_SIZE for
      *               stack and PMEM_HEAP_SIZE for heap.
+     * @param read_only - if true, existing file is opened and mapped for reading only (e.g. for inspection
+     *                    of the files of the system, that is not running), therefore persistent memory
+     *                    mustn't be written. File must contain at least _size bytes.
+     * @throws std::runtime_error - if file cannot be opened or mapped, or read_only is true and either
+     *                              open_existing is false or file is shorter than _size bytes.
      */
-    persistent_memory_holder(std::string _file_name, bool open_existing, uint64_t _size);
+    persistent_memory_holder(std::string _file_name, bool open_existing, uint64_t _size, bool read_only = false);
 
     /**
      * Constructs persistent memory bolder from other persistent memory holder,
@@ -74,9 +79,13 @@ struct persistent_memory_holder
      * Returns constant pointer to beginning of the memory-mapping
      * of the file, in which persistent memory is stored. Returned pointer can be used for
      * reading persistent memory, but not for writing.
+     * Getter is defined in the header, since it is called on each access to the heap.
      * @return constant pointer to the beginning of the persistent memory mapping.
      */
-    [[nodiscard]] const uint8_t* get_pmem_ptr() const;
+    [[nodiscard]] const uint8_t* get_pmem_ptr() const
+    {
+        return pmem_ptr;
+    }
 
     /**
      * Returns pointer to beginning of the memory-mapping
@@ -84,7 +93,10 @@ struct persistent_memory_holder
      * can be used both for reading and writing persistent memory.
      * @return pointer to the beginning of the persistent memory mapping.
      */
-    [[nodiscard]] uint8_t* get_pmem_ptr();
+    [[nodiscard]] uint8_t* get_pmem_ptr()
+    {
+        return pmem_ptr;
+    }
 
 private:
     int fd;
@@ -0,0 +1,160 @@
+#ifndef DIPLOM_PPTR_H
+#define DIPLOM_PPTR_H
+
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+#include "persistent_memory_holder.h"
+#include "../storage/global_non_owning_storage.h"
+
+/**
+ * Returns pointer to the beginning of the persistent heap, stored in
+ * global_non_owning_storage<persistent_memory_holder>. Function is inlined, therefore computing address of heap object
+ * costs two dependent loads and an addition.
+ * @return pointer to the beginning of the heap mapping.
+ */
+inline uint8_t* get_heap_base()
+{
+    return global_non_owning_storage<persistent_memory_holder>::ptr->get_pmem_ptr();
+}
+
+/**
+ * Typed pointer to object, located in the persistent heap. Pointer stores offset of the object from the beginning
+ * of the heap, therefore it remains valid, if the heap is mapped to other address after restart, and it can itself
+ * be stored in the persistent heap (it occupies 8 bytes and is trivially copyable).
+ * Offset 0 is used as null pointer, since the first block of the allocator, located at offset 0,
+ * is never given to user.
+ * @tparam T - type of the object. Since object is located in the memory-mapped file, type must be trivially copyable
+ *             (checked, when the pointer is dereferenced).
+ */
+template <typename T>
+struct pptr
+{
+public:
+    /**
+     * Constructs null pointer.
+     */
+    constexpr pptr() : offset(0)
+    {
+    }
+
+    /**
+     * Constructs pointer to object, located at the specified offset.
+     * @param _offset - offset of the object from the beginning of the heap, must be aligned by alignof(T).
+     */
+    constexpr explicit pptr(uint64_t _offset) : offset(_offset)
+    {
+        assert(is_aligned(offset));
+    }
+
+    /**
+     * Constructs pointer from address of the object in the current mapping of the heap.
+     * @param address - address of the object, must belong to the heap.
+     * @return pointer to the object.
+     */
+    static pptr from_address(const T* address)
+    {
+        const uint8_t* const heap_base = get_heap_base();
+        assert((const uint8_t*) address >= heap_base);
+        return pptr((const uint8_t*) address - heap_base);
+    }
+
+    /**
+     * Checks, that object of type T can be located at the offset.
+     * @param offset - offset from the beginning of the heap.
+     * @return true, if offset is aligned by alignof(T), false otherwise.
+     */
+    static constexpr bool is_aligned(uint64_t offset)
+    {
+        return offset % alignof(T) == 0;
+    }
+
+    [[nodiscard]] constexpr uint64_t get_offset() const
+    {
+        return offset;
+    }
+
+    /**
+     * Returns address of the object in the current mapping of the heap.
+     * @return address of the object (undefined for null pointer).
+     */
+    [[nodiscard]] T* get() const
+    {
+        return get(get_heap_base());
+    }
+
+    /**
+     * Returns address of the object, using already known beginning of the heap. Should be used in loops,
+     * that access multiple objects of the heap.
+     * @param heap_base - pointer to the beginning of the heap mapping.
+     * @return address of the object.
+     */
+    [[nodiscard]] T* get(uint8_t* heap_base) const
+    {
+        /*
+         * Checked here rather than at class scope, since T can be incomplete there (e.g. pptr to node inside node)
+         */
+        static_assert(std::is_trivially_copyable_v<T>, "Objects of persistent heap must be trivially copyable");
+        static_assert(alignof(T) <= 64, "Objects of persistent heap cannot be aligned by more than cache line size");
+        return (T*) (heap_base + offset);
+    }
+
+    T& operator*() const
+    {
+        return *get();
+    }
+
+    T* operator->() const
+    {
+        return get();
+    }
+
+    T& operator[](uint64_t index) const
+    {
+        return get()[index];
+    }
+
+    /**
+     * Returns pointer to the object, located count objects after the current one.
+     * @param count - number of objects.
+     * @return pointer to the object.
+     */
+    constexpr pptr operator+(uint64_t count) const
+    {
+        return pptr(offset + count * sizeof(T));
+    }
+
+    /**
+     * Reinterprets the pointer as pointer to object of other type, located at the same offset.
+     * @tparam U - type of the object.
+     * @return pointer to the object of type U.
+     */
+    template <typename U>
+    constexpr pptr<U> cast() const
+    {
+        return pptr<U>(offset);
+    }
+
+    constexpr explicit operator bool() const
+    {
+        return offset != 0;
+    }
+
+    constexpr bool operator==(pptr const& other) const
+    {
+        return offset == other.offset;
+    }
+
+    constexpr bool operator!=(pptr const& other) const
+    {
+        return offset != other.offset;
+    }
+
+private:
+    uint64_t offset;
+};
+
+static_assert(sizeof(pptr<uint64_t>) == 8 && std::is_trivially_copyable_v<pptr<uint64_t>>,
+              "Persistent pointer must be storable in the persistent heap");
+
+#endif //DIPLOM_PPTR_H
@@ -2,28 +2,59 @@
 #include <cstring>
 #include <utility>
 #include "../common/pmem_utils.h"
+#include "../common/crash_injection.h"
+#include "../metrics/runtime_metrics.h"
 #include "../storage/global_storage.h"
 #include "../model/function_address_holder.h"
 #include "../model/system_mode.h"
 #include <cassert>
 
+/**
+ * Single frame of the stack, read from persistent memory, together with it's service information.
+ */
+struct persisted_frame
+{
+    /**
+     * Frame itself.
+     */
+    stack_frame frame;
+
+    /**
+     * Offset of the previous frame or NO_PREVIOUS_FRAME, if frame is the first frame of the stack.
+     */
+    uint64_t previous_frame_offset;
+
+    /**
+     * True, if frame is terminated with stack end marker, false otherwise (i.e. if frame is terminated with
+     * frame end marker).
+     */
+    bool is_last;
+};
+
 /**
  * Reads single frame from persistent memory.
  * @param stack_ptr - pointer to the beginning of mapping of persistent memory to the virtual memory.
  * @param frame_offset - offset of the frame, that should be read. Offset is calculated from the beginning of
  *        of mapping of persistent memory to the virtual memory. Therefore, address of beginning
  *        of current stack frame is stack_ptr + frame_offset.
- * @return pair. First element of pair is shack frame, that has just been read. Second element of pair is true,
+ * @return stack frame, that has just been read, offset of the previous frame and flag, that is true,
  *         if current frame is the last frame in the stack (i.e. it is terminated with stack end marker),
  *         false otherwise (i.e. it is terminated with frame end marker).
  */
-std::pair<stack_frame, bool> read_frame(const uint8_t* const stack_ptr, const uint64_t frame_offset)
+persisted_frame read_frame(const uint8_t* const stack_ptr, const uint64_t frame_offset)
 {
     /*
     * Skip 8 bytes of answer
     */
     uint64_t cur_offset = frame_offset + 8;
 
+    /*
+     * Read 8 bytes of previous frame offset
+     */
+    uint64_t previous_frame_offset;
+    std::memcpy(&previous_frame_offset, stack_ptr + cur_offset, 8);
+    cur_offset += 8;
+
     /*
      * Read 2 bytes of function name len
      */
@@ -34,8 +65,7 @@ std::pair<stack_frame, bool> read_frame(const uint8_t* const stack_ptr, const ui
     /*
      * Read function_name_len bytes of function name
      */
-    std::string function_name(function_name_len, '#');
-    std::memcpy(function_name.data(), stack_ptr + cur_offset, function_name_len);
+    const std::string_view function_name((const char*) stack_ptr + cur_offset, function_name_len);
     cur_offset += function_name_len;
 
     /*
@@ -48,8 +78,7 @@ std::pair<stack_frame, bool> read_frame(const uint8_t* const stack_ptr, const ui
     /*
      * Read args_len bytes of args
      */
-    std::vector<uint8_t> args(args_len);
-    std::memcpy(args.data(), stack_ptr + cur_offset, args_len);
+    const uint8_t* const args = stack_ptr + cur_offset;
     cur_offset += args_len;
 
     /*
@@ -59,23 +88,27 @@ std::pair<stack_frame, bool> read_frame(const uint8_t* const stack_ptr, const ui
     std::memcpy(&end_marker, stack_ptr + cur_offset, 1);
     const bool is_last = end_marker == STACK_END_MARKER;
 
-    return std::make_pair(stack_frame(function_name, args), is_last);
+    return persisted_frame{stack_frame(function_name, args, args_len), previous_frame_offset, is_last};
 }
 
-ram_stack read_stack(const persistent_memory_holder& persistent_stack)
+/**
+ * Reads stack from persistent memory, decoding frames from the first one to the last one.
+ * Is used, when stack header doesn't contain information about the stack.
+ * @param stack_mem - pointer to the beginning of mapping of persistent stack.
+ * @return representation of persistent stack, that is stored in RAM.
+ */
+ram_stack read_stack_forward(const uint8_t* const stack_mem)
 {
     ram_stack stack;
-    uint64_t cur_offset = 0;
-    const uint8_t* const stack_mem = persistent_stack.get_pmem_ptr();
+    uint64_t cur_offset = get_cache_line_aligned_address(STACK_HEADER_SIZE);
 
     while (true)
     {
-        const std::pair<stack_frame, bool> read_result = read_frame(stack_mem, cur_offset);
-        const bool is_last = read_result.second;
-        const positioned_frame pos_frame = positioned_frame(read_result.first, cur_offset);
+        const persisted_frame read_result = read_frame(stack_mem, cur_offset);
+        const positioned_frame pos_frame = positioned_frame(read_result.frame, cur_offset);
         stack.add_frame(pos_frame);
 
-        if (is_last)
+        if (read_result.is_last)
         {
             return stack;
         }
@@ -90,11 +123,133 @@ ram_stack read_stack(const persistent_memory_holder& persistent_stack)
     }
 }
 
+/**
+ * Reads stack from persistent memory, starting from the last frame, which offset is stored in the stack header,
+ * and following links to previous frames.
+ * End markers are the commit point of both adding and removing frames, and the header is updated
+ * after end marker. Therefore, if the crash occurred after end marker update, but before header update,
+ * the header describes the stack before the last operation. Such situation is detected
+ * and corrected using end markers of the last frame from the header and of the frame before it.
+ * @param stack_mem - pointer to the beginning of mapping of persistent stack.
+ * @param header_top_offset - offset of the last frame, according to the stack header.
+ * @return representation of persistent stack, that is stored in RAM.
+ */
+ram_stack read_stack_backward(const uint8_t* const stack_mem, const uint64_t header_top_offset)
+{
+    uint64_t top_offset = header_top_offset;
+    const persisted_frame header_top = read_frame(stack_mem, header_top_offset);
+
+    if (!header_top.is_last)
+    {
+        /*
+         * Crash after adding new frame, but before header update: new frame
+         * is located just after the last frame from the header
+         */
+        top_offset = get_cache_line_aligned_address(header_top_offset + header_top.frame.size());
+    }
+    else if (header_top.previous_frame_offset != NO_PREVIOUS_FRAME &&
+             read_frame(stack_mem, header_top.previous_frame_offset).is_last)
+    {
+        /*
+         * Crash after removing the last frame, but before header update: frame before the last
+         * frame from the header is the actual last frame
+         */
+        top_offset = header_top.previous_frame_offset;
+    }
+
+    /*
+     * Collect frames from the last one to the first one
+     */
+    std::vector<positioned_frame> reversed_frames;
+    uint64_t cur_offset = top_offset;
+    while (cur_offset != NO_PREVIOUS_FRAME)
+    {
+        persisted_frame cur_frame = read_frame(stack_mem, cur_offset);
+        assert(cur_offset != top_offset || cur_frame.is_last);
+        reversed_frames.emplace_back(std::move(cur_frame.frame), cur_offset);
+        cur_offset = cur_frame.previous_frame_offset;
+    }
+
+    ram_stack stack;
+    for (auto it = reversed_frames.rbegin(); it != reversed_frames.rend(); ++it)
+    {
+        stack.add_frame(*it);
+    }
+    return stack;
+}
+
+ram_stack read_stack(const persistent_memory_holder& persistent_stack)
+{
+    const uint8_t* const stack_mem = persistent_stack.get_pmem_ptr();
+    /*
+     * Read 4 bytes of frame count and 4 bytes of last frame offset
+     */
+    uint32_t frame_count;
+    uint32_t top_frame_offset;
+    std::memcpy(&frame_count, stack_mem, 4);
+    std::memcpy(&top_frame_offset, stack_mem + 4, 4);
+
+    if (frame_count == 0)
+    {
+        /*
+         * Header is not maintained (or the crash occurred before it was written for the first time)
+         */
+        return read_stack_forward(stack_mem);
+    }
+    return read_stack_backward(stack_mem, top_frame_offset);
+}
+
+#ifdef PERSISTENT_STACK_HEADER
+/**
+ * Atomically writes stack header and flushes it to persistent memory. Since header is 8 bytes long,
+ * is aligned by 8 bytes and lies in a single cache line, it is written with the same atomicity
+ * as end markers.
+ * @param stack_mem - pointer to the beginning of mapping of persistent stack.
+ * @param stack - stack, that is stored in RAM, after the last operation.
+ */
+void update_stack_header(uint8_t* const stack_mem, ram_stack const& stack)
+{
+    const uint32_t frame_count = stack.size();
+    const uint32_t top_frame_offset = stack.get_last_frame().get_position();
+    uint64_t header;
+    uint8_t* const header_ptr = (uint8_t*) &header;
+    std::memcpy(header_ptr, &frame_count, 4);
+    std::memcpy(header_ptr + 4, &top_frame_offset, 4);
+    __atomic_store_n((uint64_t*) stack_mem, header, __ATOMIC_SEQ_CST);
+    pmem_do_flush(stack_mem, STACK_HEADER_SIZE, flush_site::STACK_HEADER);
+}
+#endif
+
+void repair_stack_header([[maybe_unused]] ram_stack const& stack,
+                         [[maybe_unused]] persistent_memory_holder& persistent_stack)
+{
+#ifdef PERSISTENT_STACK_HEADER
+    update_stack_header(persistent_stack.get_pmem_ptr(), stack);
+#endif
+}
+
 void add_new_frame(ram_stack& stack,
                    stack_frame const& frame,
                    persistent_memory_holder& persistent_stack,
                    std::optional<std::vector<uint8_t>> const& new_ans_filler)
 {
+    add_new_frame(
+            stack,
+            frame,
+            persistent_stack,
+            new_ans_filler.has_value()
+            ? std::make_optional(answer_filler(new_ans_filler->data(), new_ans_filler->size()))
+            : std::optional<answer_filler>()
+    );
+}
+
+void add_new_frame(ram_stack& stack,
+                   stack_frame const& frame,
+                   persistent_memory_holder& persistent_stack,
+                   std::optional<answer_filler> const& new_ans_filler)
+{
+    METRICS_SCOPED_LATENCY(metrics_histogram::FRAME_PUSH);
+    METRICS_INCREMENT(metrics_counter::FRAME_PUSHES, 1);
     uint8_t* const stack_mem = persistent_stack.get_pmem_ptr();
     /*
      * First free byte of the stack
@@ -105,6 +260,22 @@ void add_new_frame(ram_stack& stack,
      */
     const uint64_t new_frame_offset = get_cache_line_aligned_address(stack_end);
     assert(new_frame_offset % CACHE_LINE_SIZE == 0);
+    /*
+     * Bytes from TX_LOG_OFFSET belong to the redo log of transactions
+     */
+    if (new_frame_offset + frame.size() > TX_LOG_OFFSET)
+    {
+        throw std::runtime_error(
+                "Frame of size " + std::to_string(frame.size()) + " doesn't fit into the stack at offset " +
+                std::to_string(new_frame_offset)
+        );
+    }
+    /*
+     * Each frame, except the first one, is linked with the previous frame
+     */
+    const uint64_t previous_frame_offset = stack.size() == 0
+                                           ? NO_PREVIOUS_FRAME
+                                           : stack.get_last_frame().get_position();
     stack.add_frame(positioned_frame{frame, new_frame_offset});
 
     uint64_t cur_offset = new_frame_offset;
@@ -133,6 +304,12 @@ void add_new_frame(ram_stack& stack,
      */
     cur_offset += 8;
 
+    /*
+     * Write 8 bytes of previous frame offset
+     */
+    std::memcpy(stack_mem + cur_offset, &previous_frame_offset, 8);
+    cur_offset += 8;
+
     /*
      * Write 2 bytes of function name len
      */
@@ -172,16 +349,25 @@ void add_new_frame(ram_stack& stack,
      * flushing is done by cache lines and first 8 bytes of the frame will be
      * flushed in all cases.
      */
-    pmem_do_flush(stack_mem + new_frame_offset, frame.size());
+    pmem_do_flush(stack_mem + new_frame_offset, frame.size(), flush_site::FRAME);
+    CRASH_POINT("add_new_frame:before_commit");
 
-    if (stack_end != 0)
+    if (previous_frame_offset != NO_PREVIOUS_FRAME)
     {
         /*
          * Stack end marker is just before first free byte of the stack
          */
         std::memcpy(stack_mem + stack_end - 1, &FRAME_END_MARKER, 1);
-        pmem_do_flush(stack_mem + stack_end - 1, 1);
+        pmem_do_flush(stack_mem + stack_end - 1, 1, flush_site::END_MARKER);
     }
+    CRASH_POINT("add_new_frame:after_commit");
+
+#ifdef PERSISTENT_STACK_HEADER
+    /*
+     * Header is updated after the commit point (end marker of the previous frame)
+     */
+    update_stack_header(stack_mem, stack);
+#endif
 }
 
 void remove_frame(ram_stack& stack, persistent_memory_holder& persistent_stack)
@@ -190,6 +376,8 @@ void remove_frame(ram_stack& stack, persistent_memory_holder& persistent_stack)
     {
         throw std::runtime_error("Cannot remove first frame of the stack");
     }
+    METRICS_SCOPED_LATENCY(metrics_histogram::FRAME_POP);
+    METRICS_INCREMENT(metrics_counter::FRAME_POPS, 1);
 
     stack.remove_frame();
 
@@ -199,6 +387,14 @@ void remove_frame(ram_stack& stack, persistent_memory_holder& persistent_stack)
      */
     const uint64_t end_marker_offset = stack.get_stack_end() - 1;
     std::memcpy(stack_mem + end_marker_offset, &STACK_END_MARKER, 1);
-    pmem_do_flush(stack_mem + end_marker_offset, 1);
+    pmem_do_flush(stack_mem + end_marker_offset, 1, flush_site::END_MARKER);
+    CRASH_POINT("remove_frame:after_commit");
+
+#ifdef PERSISTENT_STACK_HEADER
+    /*
+     * Header is updated after the commit point (end marker of the new last frame)
+     */
+    update_stack_header(stack_mem, stack);
+#endif
 }
 
@@ -15,15 +15,32 @@
  * Reads stack from persistent memory to RAM. This function can be used
  * just after the crash, to read stack of functions, that
  * were being executed, when the crash occurred.
+ * If the stack header contains information about the stack (i.e. stack was written with
+ * PERSISTENT_STACK_HEADER defined), reading starts from the last frame, which offset is stored
+ * in the header, and follows links to previous frames. Otherwise, frames are decoded one by one,
+ * starting from the first frame, until frame with stack end marker is found.
  * @param persistent_stack - instance of class, that owns file,
  *                           in which persistent stack is stored.
  * @return representation of persistent stack, that is stored in RAM.
  */
 ram_stack read_stack(const persistent_memory_holder& persistent_stack);
 
+/**
+ * Rewrites stack header, so that it describes the stack, that has just been read by read_stack.
+ * Header can be outdated by a single operation (if the crash occurred after the operation was committed,
+ * but before the header was updated), and read_stack corrects only such single-operation lag.
+ * Therefore, the header must be repaired before the stack is modified by the recovery, otherwise
+ * the next crash can leave the header outdated by two operations.
+ * Does nothing, if PERSISTENT_STACK_HEADER is not defined.
+ * @param stack - stack, that has just been read from persistent stack.
+ * @param persistent_stack - stack, that is stored in file.
+ */
+void repair_stack_header(ram_stack const& stack, persistent_memory_holder& persistent_stack);
+
 /**
  * Adds new frame to the top of the stack. Frame is added to both
- * persistent and RAM stack. Can write new_ans_filler to the beginning of new frame.
+ * persistent and RAM stack. New frame stores offset of the previous frame. If PERSISTENT_STACK_HEADER is defined,
+ * stack header (number of frames and offset of the last frame) is updated after the new frame is committed. Can write new_ans_filler to the beginning of new frame.
  * If new_ans_filler size is not between 1 and 8 bytes inclusively, std::runtime_error
  * will be thrown. This parameter can be used to write some default value
  * (that cannot be return value of the function) to a place, where
@@ -34,7 +51,8 @@ ram_stack read_stack(const persistent_memory_holder& persistent_stack);
  * @param persistent_stack - stack, that is stored in file.
  * @param new_ans_filler - if option contains value, it's value will be written to the beginning
  *                         of new stack frame. Otherwise, won't be used.
- * @throws std::runtime_error - if new_ans_filler size is not between 1 and 8 bytes inclusively.
+ * @throws std::runtime_error - if new_ans_filler size is not between 1 and 8 bytes inclusively, or if the frame
+ *                              doesn't fit into the frames region of the stack (first TX_LOG_OFFSET bytes).
  */
 void add_new_frame(
         ram_stack& stack,
@@ -43,6 +61,24 @@ void add_new_frame(
         std::optional<std::vector<uint8_t>> const& new_ans_filler = std::optional<std::vector<uint8_t>>()
 );
 
+/**
+ * Same as add_new_frame above, but takes answer filler, that is stored without heap allocation.
+ * Is used on the hot path of do_call.
+ * @param stack - stack, that is stored in RAM.
+ * @param frame - frame to add to the top of the stack.
+ * @param persistent_stack - stack, that is stored in file.
+ * @param new_ans_filler - if option contains value, it's value will be written to the beginning
+ *                         of new stack frame. Otherwise, won't be used.
+ * @throws std::runtime_error - if new_ans_filler size is not between 1 and 8 bytes inclusively, or if the frame
+ *                              doesn't fit into the frames region of the stack (first TX_LOG_OFFSET bytes).
+ */
+void add_new_frame(
+        ram_stack& stack,
+        stack_frame const& frame,
+        persistent_memory_holder& persistent_stack,
+        std::optional<answer_filler> const& new_ans_filler
+);
+
 /**
  * Removes single frame from the top of the stack. Frame is removed from both
  * persistent and RAM stack. Note, that since removing stack frame from persistent stack
@@ -53,6 +89,7 @@ void add_new_frame(
  * finish it's execution only by exception or system crash. But, since according to the
  * system architecture, each worker thread should take and execute tasks from
  * tasks queue in an infinite loop, this limitation shouldn't be considered a drawback.
+ * If PERSISTENT_STACK_HEADER is defined, stack header is updated after the frame is removed.
  * @param stack - stack, that is stored in RAM. Should be representation
  *                (i.e. contain the same data) of persistent stack.
  * @param persistent_stack - stack, that is stored in file.
@@ -1,13 +1,39 @@
 #include "ram_stack.h"
+#include <algorithm>
+#include "../common/constants_and_types.h"
+
+/**
+ * Maximal number of frames in the stack: each frame is cache line aligned, frames occupy the beginning
+ * of the stack file (up to the redo log) and the first cache line of the stack is occupied by the stack header.
+ * @return maximal number of frames in the stack.
+ */
+uint32_t get_max_stack_depth()
+{
+    return TX_LOG_OFFSET / CACHE_LINE_SIZE;
+}
+
+ram_stack::ram_stack()
+{
+    frames.reserve(get_max_stack_depth());
+}
+
+ram_stack::ram_stack(ram_stack const& other)
+{
+    frames.reserve(std::max<uint64_t>(get_max_stack_depth(), other.frames.size()));
+    for (positioned_frame const& frame : other.frames)
+    {
+        frames.push_back(frame);
+    }
+}
 
 uint64_t ram_stack::get_stack_end() const
 {
     if (frames.empty())
     {
         /*
-         * First frame of the stack has zero offset
+         * First frame of the stack is placed after the stack header
          */
-        return 0;
+        return STACK_HEADER_SIZE;
     }
     const positioned_frame& last_frame = frames.back();
     /*
@@ -45,3 +71,8 @@ positioned_frame const& ram_stack::get_last_frame() const
 {
     return frames.back();
 }
+
+positioned_frame const& ram_stack::get_frame(uint32_t frame_number) const
+{
+    return frames[frame_number];
+}
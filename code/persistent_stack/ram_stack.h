@@ -16,6 +16,22 @@
 struct ram_stack
 {
 public:
+    /**
+     * Creates empty stack. Memory for the deepest possible stack is reserved at once
+     * (each frame occupies at least one cache line of persistent stack), therefore
+     * adding and removing frames never allocates memory and never moves frames,
+     * that are already in the stack.
+     */
+    ram_stack();
+
+    /**
+     * Copies the stack, reserving memory for the deepest possible stack for the copy.
+     * @param other - stack to copy.
+     */
+    ram_stack(ram_stack const& other);
+
+    ram_stack(ram_stack&& other) noexcept = default;
+
     /**
      * Returns address of stack end, i.e. offset of first free byte.
      * Offset is calculated from the beginning of memory-mapping of the stack.
@@ -47,6 +63,13 @@ public:
      */
     [[nodiscard]] positioned_frame const& get_last_frame() const;
 
+    /**
+     * Returns frame of the stack by it's number (the first frame of the stack has number 0).
+     * @param frame_number - number of the frame, less than size of the stack.
+     * @return the frame.
+     */
+    [[nodiscard]] positioned_frame const& get_frame(uint32_t frame_number) const;
+
     /**
      * Retrieves position, where function, that is currently being executed, should
      * write it's answer. Since function, that was called first, cannot return answer,
@@ -20,7 +20,7 @@ void write_answer(std::vector<uint8_t> const& answer)
     const uint64_t answer_offset = r_stack.get_answer_position();
     assert(answer_offset % CACHE_LINE_SIZE == 0);
     memcpy(p_stack->get_pmem_ptr() + answer_offset, answer.data(), answer.size());
-    pmem_do_flush(p_stack->get_pmem_ptr() + answer_offset, answer.size());
+    pmem_do_flush(p_stack->get_pmem_ptr() + answer_offset, answer.size(), flush_site::ANSWER);
 }
 
 std::vector<uint8_t> read_answer(uint8_t size)
@@ -17,6 +17,28 @@ void do_call(std::string const& function_name,
              std::optional<std::vector<uint8_t>> const& ans_filler,
              std::optional<std::vector<uint8_t>> const& new_ans_filler,
              bool call_recover)
+{
+    auto to_answer_filler = [](std::optional<std::vector<uint8_t>> const& filler) {
+        return filler.has_value()
+               ? std::make_optional(answer_filler(filler->data(), filler->size()))
+               : std::optional<answer_filler>();
+    };
+    do_call(
+            function_name,
+            args.data(),
+            args.size(),
+            to_answer_filler(ans_filler),
+            to_answer_filler(new_ans_filler),
+            call_recover
+    );
+}
+
+void do_call(std::string_view function_name,
+             const uint8_t* args,
+             uint64_t args_size,
+             std::optional<answer_filler> const& ans_filler,
+             std::optional<answer_filler> const& new_ans_filler,
+             bool call_recover)
 {
     ram_stack& r_stack = thread_local_owning_storage<ram_stack>::get_object();
     persistent_memory_holder* p_stack = thread_local_non_owning_storage<persistent_memory_holder>::ptr;
@@ -29,15 +51,16 @@ void do_call(std::string const& function_name,
         const __uint64_t last_frame_offset = r_stack.get_last_frame().get_position();
         assert(last_frame_offset % CACHE_LINE_SIZE == 0);
         std::memcpy(p_stack->get_pmem_ptr() + last_frame_offset, ans_filler->data(), ans_filler->size());
-        pmem_do_flush(p_stack->get_pmem_ptr() + last_frame_offset, ans_filler->size());
+        pmem_do_flush(p_stack->get_pmem_ptr() + last_frame_offset, ans_filler->size(), flush_site::ANSWER);
     }
-    add_new_frame(r_stack, stack_frame(function_name, args), *p_stack, new_ans_filler);
+    add_new_frame(r_stack, stack_frame(function_name, args, args_size), *p_stack, new_ans_filler);
+    auto const& f_ptrs = global_storage<function_address_holder>::get_const_object().get_funcs(function_name);
     function_ptr f_ptr;
     if (call_recover)
     {
         if (global_storage<system_mode>::get_const_object() == system_mode::RECOVERY)
         {
-            f_ptr = global_storage<function_address_holder>::get_const_object().funcs.at(function_name).second;
+            f_ptr = f_ptrs.second;
         }
         else
         {
@@ -46,8 +69,19 @@ void do_call(std::string const& function_name,
     }
     else
     {
-        f_ptr = global_storage<function_address_holder>::get_const_object().funcs.at(function_name).first;
+        f_ptr = f_ptrs.first;
     }
-    f_ptr(args.data());
+    f_ptr(args);
     remove_frame(r_stack, *p_stack);
-}
\ No newline at end of file
+}
+
+std::vector<uint8_t> do_volatile_call(std::string const& function_name, std::vector<uint8_t> const& args)
+{
+    auto const& volatile_funcs = global_storage<function_address_holder>::get_const_object().volatile_funcs;
+    auto it = volatile_funcs.find(function_name);
+    if (it == volatile_funcs.end())
+    {
+        throw std::runtime_error("Function " + function_name + " is not registered as volatile function");
+    }
+    return it->second(args.data());
+}
@@ -1,8 +1,11 @@
 #ifndef DIPLOM_CALL_H
 #define DIPLOM_CALL_H
 
+#include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
+#include "../frame/stack_frame.h"
 
 /**
  * Performs call of function with specified name and args. Performs sequence of actions:
@@ -48,7 +51,8 @@
  *                       version will be called.
  * @throws std::runtime_error - if ans_filler size is not between 1 and 8 bytes inclusively or
  *                              if new_ans_filler size is not between 1 and 8 bytes inclusively or
- *                              if call_recover is true and system is not running in recovery mode.
+ *                              if call_recover is true and system is not running in recovery mode or
+ *                              if function with specified name is not registered.
  */
 void do_call(std::string const& function_name,
              std::vector<uint8_t> const& args,
@@ -56,5 +60,44 @@ void do_call(std::string const& function_name,
              std::optional<std::vector<uint8_t>> const& new_ans_filler = std::optional<std::vector<uint8_t>>(),
              bool call_recover = false);
 
+/**
+ * Same as do_call above, but takes args as pointer and size and answer fillers, that are stored
+ * without heap allocation. If function name and args are short enough to be stored inside the frame
+ * (see stack_frame), the call itself doesn't allocate memory, therefore this version should be used by
+ * frequently called functions.
+ * @param function_name - name of the function to call. Must be a valid key of the map with
+ *                        addresses of the function.
+ * @param args - pointer to the first byte of arguments of function to call with.
+ * @param args_size - size of arguments in bytes.
+ * @param ans_filler - if option contains value, it's value will be written to an answer memory
+ *                     of current stack frame. Otherwise, won't be used.
+ * @param new_ans_filler - if option contains value, it's value will be written to answer memory of
+ *                         new stack frame. Otherwise, won't be used.
+ * @param call_recover - if true, recover version of function will be called. Otherwise, ordinary
+ *                       version will be called.
+ * @throws std::runtime_error - if ans_filler size is not between 1 and 8 bytes inclusively or
+ *                              if new_ans_filler size is not between 1 and 8 bytes inclusively or
+ *                              if call_recover is true and system is not running in recovery mode or
+ *                              if function with specified name is not registered.
+ */
+void do_call(std::string_view function_name,
+             const uint8_t* args,
+             uint64_t args_size,
+             std::optional<answer_filler> const& ans_filler,
+             std::optional<answer_filler> const& new_ans_filler,
+             bool call_recover = false);
+
+/**
+ * Calls volatile function with specified name and args. Neither persistent, nor RAM stack is modified,
+ * and nothing is written to persistent memory by the call itself, therefore the call cannot be
+ * recovered and is not visible after the crash. Can be called both in execution and recovery mode.
+ * @param function_name - name of the function to call. Must be registered as volatile function
+ *                        in the map with addresses of functions.
+ * @param args - arguments of function to call with.
+ * @return result of the function.
+ * @throws std::runtime_error - if function with specified name is not registered as volatile function.
+ */
+std::vector<uint8_t> do_volatile_call(std::string const& function_name, std::vector<uint8_t> const& args);
+
 
 #endif //DIPLOM_CALL_H
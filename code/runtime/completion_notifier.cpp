@@ -0,0 +1,39 @@
+#include "completion_notifier.h"
+#include <stdexcept>
+
+completion_notifier::completion_notifier(blocking_queue<task_completion>& _completion_queue, uint32_t _batch_size) :
+        completion_queue(_completion_queue),
+        batch_size(_batch_size),
+        pending()
+{
+    if (batch_size == 0)
+    {
+        throw std::runtime_error("Batch size of completion notifier should be positive");
+    }
+    pending.reserve(batch_size);
+}
+
+void completion_notifier::notify(task_completion const& completion)
+{
+    pending.push_back(completion);
+    if (pending.size() >= batch_size)
+    {
+        flush();
+    }
+}
+
+void completion_notifier::flush()
+{
+    completion_queue.push_all(pending);
+    pending.clear();
+}
+
+uint32_t completion_notifier::pending_count() const
+{
+    return pending.size();
+}
+
+completion_notifier::~completion_notifier()
+{
+    flush();
+}
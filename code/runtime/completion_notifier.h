@@ -0,0 +1,58 @@
+#ifndef DIPLOM_COMPLETION_NOTIFIER_H
+#define DIPLOM_COMPLETION_NOTIFIER_H
+
+#include <cstdint>
+#include <vector>
+#include "../blocking_queue/blocking_queue.h"
+#include "../model/task_completion.h"
+
+/**
+ * Batches notifications about task completions of single worker thread and publishes them to the
+ * completion queue, shared by worker threads and producers. Batching allows to acquire the mutex of
+ * the completion queue once per batch instead of once per task. Object should be used by single thread only.
+ */
+struct completion_notifier
+{
+private:
+    blocking_queue<task_completion>& completion_queue;
+    const uint32_t batch_size;
+    std::vector<task_completion> pending;
+
+public:
+    /**
+     * Creates notifier, that publishes completions to the specified queue.
+     * @param _completion_queue - queue, from which producers take completions.
+     * @param _batch_size - number of completions, after accumulating which the batch is published.
+     * @throws std::runtime_error - if batch size is zero.
+     */
+    completion_notifier(blocking_queue<task_completion>& _completion_queue, uint32_t _batch_size);
+
+    completion_notifier(completion_notifier const&) = delete;
+
+    completion_notifier& operator=(completion_notifier const&) = delete;
+
+    /**
+     * Adds completion to the current batch. If the batch is full, publishes it.
+     * @param completion - completion of the task.
+     */
+    void notify(task_completion const& completion);
+
+    /**
+     * Publishes all accumulated completions. Should be called before worker thread blocks
+     * waiting for new tasks, otherwise producers may wait for completions indefinitely.
+     */
+    void flush();
+
+    /**
+     * Returns number of completions, that were accumulated, but not published yet.
+     * @return number of accumulated completions.
+     */
+    [[nodiscard]] uint32_t pending_count() const;
+
+    /**
+     * Publishes all accumulated completions.
+     */
+    ~completion_notifier();
+};
+
+#endif //DIPLOM_COMPLETION_NOTIFIER_H
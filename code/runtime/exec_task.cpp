@@ -5,11 +5,25 @@
 #include <cstring>
 #include "../persistent_stack/persistent_stack.h"
 #include "../storage/global_non_owning_storage.h"
+#include "../persistent_memory/pptr.h"
 #include <cassert>
 #include "../common/pmem_utils.h"
+#include "../common/crash_injection.h"
 #include "answer.h"
 #include "call.h"
 #include <optional>
+#include "../common/variant_utils.h"
+#include "../model/cur_thread_id_holder.h"
+#include "../storage/thread_local_owning_storage.h"
+#include "../storage/thread_local_non_owning_storage.h"
+#include "../structures/hash_map.h"
+#include "../structures/structures_common.h"
+#include "../structures/mcas.h"
+
+/**
+ * Returns true, if answers of tasks, executed by the caller thread, are flushed by the group committer.
+ */
+bool is_answer_flush_deferred();
 
 void exec_task_common(const uint8_t* args, bool call_recover)
 {
@@ -35,8 +49,7 @@ void exec_task_common(const uint8_t* args, bool call_recover)
             std::memcpy(&answer_offset, args + cur_offset, 8);
             cur_offset += 8;
 
-            uint8_t* answer_address =
-                    global_non_owning_storage<persistent_memory_holder>::ptr->get_pmem_ptr() + answer_offset;
+            uint8_t* answer_address = pptr<uint8_t>(answer_offset).get();
 
             /*
              * System is running in recovery mode
@@ -53,7 +66,7 @@ void exec_task_common(const uint8_t* args, bool call_recover)
                 if (cas_answer[0] == 0x0 || cas_answer[0] == 0x1)
                 {
                     std::memcpy(answer_address, &cas_answer[0], 1);
-                    pmem_do_flush(answer_address, 1);
+                    pmem_do_flush(answer_address, 1, flush_site::ANSWER);
                     return;
                 }
             }
@@ -62,30 +75,80 @@ void exec_task_common(const uint8_t* args, bool call_recover)
              * ordinary (not recover) operation is called OR answer hasn't been written to pmem
              */
 
-            std::vector<uint8_t> cas_args(24);
             /*
              * 8 bytes of var offset
              * 4 bytes of expected value
              * 4 bytes of new value
              * 8 bytes of thread matrix offset
              */
-            std::memcpy(cas_args.data(), args + cur_offset, 24);
-
-            do_call(
-                    "cas",
-                    cas_args,
-                    std::optional<std::vector<uint8_t>>(),
-                    std::optional<std::vector<uint8_t>>(),
-                    call_recover
-            );
+            do_call("cas", args + cur_offset, 24, std::nullopt, std::nullopt, call_recover);
             std::vector<uint8_t> cas_answer = read_answer(1);
             assert(cas_answer.size() == 1 && (cas_answer[0] == 0x0 || cas_answer[0] == 0x1));
+            CRASH_POINT("exec_task:before_answer");
 
             /*
-             * Write answer to pmem
+             * Write answer to pmem. In group commit mode, answer is flushed by the group committer, after the frame
+             * has been removed: if it is lost, CAS can't be detected anymore (see group_committer).
              */
             std::memcpy(answer_address, &cas_answer[0], 1);
-            pmem_do_flush(answer_address, 1);
+            if (!is_answer_flush_deferred())
+            {
+                pmem_do_flush(answer_address, 1, flush_site::ANSWER);
+            }
+
+            break;
+        }
+        /*
+         * Task is update or remove of the key of the hash map
+         */
+        case 0x1:
+        case 0x2:
+        {
+            /*
+             * Read 8 bytes of answer offset
+             */
+            uint64_t answer_offset;
+            std::memcpy(&answer_offset, args + cur_offset, 8);
+            cur_offset += 8;
+
+            uint8_t* answer_address = pptr<uint8_t>(answer_offset).get();
+
+            if (call_recover)
+            {
+                std::vector<uint8_t> map_answer = read_answer(1);
+                /*
+                 * If map operation has already written it's answer, retrieve it
+                 */
+                if (map_answer[0] != PDS_NOT_COMPLETED)
+                {
+                    std::memcpy(answer_address, &map_answer[0], 1);
+                    pmem_do_flush(answer_address, 1, flush_site::ANSWER);
+                    return;
+                }
+            }
+
+            /*
+             * 8 bytes of map offset
+             * 8 bytes of key
+             * 4 bytes of value (only if task is update)
+             */
+            const bool is_put = task_type == map_update_task::MAP_PUT_TYPE;
+            do_call(
+                    is_put ? "map_put" : "map_remove",
+                    args + cur_offset,
+                    is_put ? 20 : 16,
+                    answer_filler(&PDS_NOT_COMPLETED, 1),
+                    make_operation_filler(PDS_NOT_COMPLETED, 0, 0),
+                    call_recover
+            );
+            std::vector<uint8_t> map_answer = read_answer(1);
+            assert(map_answer.size() == 1 && map_answer[0] != PDS_NOT_COMPLETED);
+
+            std::memcpy(answer_address, &map_answer[0], 1);
+            if (!is_answer_flush_deferred())
+            {
+                pmem_do_flush(answer_address, 1, flush_site::ANSWER);
+            }
 
             break;
         }
@@ -105,4 +168,386 @@ void exec_task(const uint8_t* args)
 void exec_task_recover(const uint8_t* args)
 {
     exec_task_common(args, true);
-}
\ No newline at end of file
+}
+
+std::optional<uint64_t> get_task_answer_offset(stack_frame const& frame)
+{
+    if (frame.get_function_name() != "exec_task" || frame.get_args().size() < 9)
+    {
+        return std::nullopt;
+    }
+    /*
+     * Answer offset follows 1 byte of task type for all types of tasks
+     */
+    uint64_t answer_offset;
+    std::memcpy(&answer_offset, frame.get_args().data() + 1, 8);
+    return answer_offset;
+}
+
+void execute_cas_task(cas_task const& cur_cas_task)
+{
+    /*
+     * Serialize CAS args
+     */
+    uint8_t args[33];
+    uint64_t cur_offset = 0;
+
+    /*
+     * Write 1 byte of task type
+     */
+    std::memcpy(args + cur_offset, &cas_task::CAS_TYPE, 1);
+    cur_offset += 1;
+
+    /*
+     * Write 8 bytes of answer offset
+     */
+    std::memcpy(args + cur_offset, &cur_cas_task.answer_offset, 8);
+    cur_offset += 8;
+
+    /*
+     * Write 8 bytes of variable offset
+     */
+    std::memcpy(args + cur_offset, &cur_cas_task.var_offset, 8);
+    cur_offset += 8;
+
+    /*
+     * Write 4 bytes of expected value
+     */
+    std::memcpy(args + cur_offset, &cur_cas_task.expected_value, 4);
+    cur_offset += 4;
+
+    /*
+     * Write 4 bytes of new value
+     */
+    std::memcpy(args + cur_offset, &cur_cas_task.new_value, 4);
+    cur_offset += 4;
+
+    /*
+     * Write 8 bytes of thread matrix offset
+     */
+    std::memcpy(args + cur_offset, &cur_cas_task.thread_matrix_offset, 8);
+
+    /*
+     * Wait for CAS completion and continue
+     */
+    const uint8_t not_completed = 0xFF;
+    do_call("exec_task", args, 33, std::nullopt, answer_filler(&not_completed, 1));
+}
+
+void execute_map_update_task(map_update_task const& cur_map_update_task)
+{
+    /*
+     * Serialize map operation args
+     */
+    const uint64_t args_size = cur_map_update_task.value.has_value() ? 29 : 25;
+    uint8_t args[29];
+    uint64_t cur_offset = 0;
+
+    /*
+     * Write 1 byte of task type
+     */
+    std::memcpy(
+            args + cur_offset,
+            cur_map_update_task.value.has_value() ? &map_update_task::MAP_PUT_TYPE : &map_update_task::MAP_REMOVE_TYPE,
+            1
+    );
+    cur_offset += 1;
+
+    /*
+     * Write 8 bytes of answer offset
+     */
+    std::memcpy(args + cur_offset, &cur_map_update_task.answer_offset, 8);
+    cur_offset += 8;
+
+    /*
+     * Write 8 bytes of map offset
+     */
+    std::memcpy(args + cur_offset, &cur_map_update_task.map_offset, 8);
+    cur_offset += 8;
+
+    /*
+     * Write 8 bytes of key
+     */
+    std::memcpy(args + cur_offset, &cur_map_update_task.key, 8);
+    cur_offset += 8;
+
+    /*
+     * Write 4 bytes of value
+     */
+    if (cur_map_update_task.value.has_value())
+    {
+        const uint32_t value = cur_map_update_task.value.value();
+        std::memcpy(args + cur_offset, &value, 4);
+    }
+
+    const uint8_t not_completed = 0xFF;
+    do_call("exec_task", args, args_size, std::nullopt, answer_filler(&not_completed, 1));
+}
+
+uint32_t execute_read_task(read_task const& cur_read_task)
+{
+    const uint32_t cur_value = read_var(cur_read_task.var_offset);
+    if (cur_read_task.answer_offset.has_value())
+    {
+        uint8_t* answer_address = pptr<uint8_t>(cur_read_task.answer_offset.value()).get();
+        /*
+         * Write 4 bytes of read value to pmem
+         */
+        std::memcpy(answer_address, &cur_value, 4);
+        if (!is_answer_flush_deferred())
+        {
+            pmem_do_flush(answer_address, 4, flush_site::ANSWER);
+        }
+    }
+    if (cur_read_task.completion != nullptr)
+    {
+        cur_read_task.completion->set_value(cur_value);
+    }
+#ifdef CAS_TEST
+    /*
+     * Value is printed only if it cannot be retrieved by the producer
+     */
+    if (!cur_read_task.answer_offset.has_value() && cur_read_task.completion == nullptr)
+    {
+        const uint32_t cur_thread_id =
+                thread_local_owning_storage<cur_thread_id_holder>::get_const_object().cur_thread_id;
+        std::string msg = "register value = " + std::to_string(cur_value) +
+                          ", cur thread id = " + std::to_string(cur_thread_id) + "\n";
+        std::cerr << msg;
+    }
+#endif
+    return cur_value;
+}
+
+void execute_snapshot_read_task(snapshot_read_task const& cur_snapshot_read_task)
+{
+    const uint32_t vars_count = cur_snapshot_read_task.var_offsets.size();
+    /*
+     * Serialize snapshot args: 4 bytes of registers count and 8 bytes of each register offset
+     */
+    std::vector<uint8_t> args(4 + 8 * vars_count);
+    std::memcpy(args.data(), &vars_count, 4);
+    if (vars_count > 0)
+    {
+        std::memcpy(args.data() + 4, cur_snapshot_read_task.var_offsets.data(), 8 * vars_count);
+    }
+
+    std::vector<uint8_t> result = do_volatile_call("snapshot_read", args);
+    assert(result.size() == 4 * vars_count);
+
+    /*
+     * Deserialize 4 bytes of each register value
+     */
+    std::vector<uint32_t> values(vars_count);
+    if (vars_count > 0)
+    {
+        std::memcpy(values.data(), result.data(), 4 * vars_count);
+    }
+    if (cur_snapshot_read_task.result != nullptr)
+    {
+        cur_snapshot_read_task.result->set_value(std::move(values));
+    }
+}
+
+void execute_task(task const& cur_task)
+{
+    std::visit(
+            make_visitor(
+                    [](cas_task const& cur_cas_task)
+                    {
+                        execute_cas_task(cur_cas_task);
+                    },
+                    [](read_task const& cur_read_task)
+                    {
+                        execute_read_task(cur_read_task);
+                    },
+                    [](volatile_task const& cur_volatile_task)
+                    {
+                        std::vector<uint8_t> result = do_volatile_call(
+                                cur_volatile_task.function_name,
+                                cur_volatile_task.args
+                        );
+                        if (cur_volatile_task.result != nullptr)
+                        {
+                            cur_volatile_task.result->set_value(std::move(result));
+                        }
+                    },
+                    [](snapshot_read_task const& cur_snapshot_read_task)
+                    {
+                        execute_snapshot_read_task(cur_snapshot_read_task);
+                    },
+                    [](map_update_task const& cur_map_update_task)
+                    {
+                        execute_map_update_task(cur_map_update_task);
+                    },
+                    [](map_get_task const& cur_map_get_task)
+                    {
+                        std::optional<uint32_t> value = hash_map_get(cur_map_get_task.map_offset, cur_map_get_task.key);
+                        if (cur_map_get_task.result != nullptr)
+                        {
+                            cur_map_get_task.result->set_value(value);
+                        }
+                    }
+            ),
+            cur_task
+    );
+}
+
+/**
+ * Answer of the executed task: location of the answer in the persistent heap (or nullptr, if task has no
+ * answer location) and completion, that should be reported (if task has task id).
+ */
+struct executed_task_answer
+{
+    const uint8_t* address;
+    size_t length;
+    std::optional<task_completion> completion;
+};
+
+executed_task_answer execute_task_and_get_answer(task const& cur_task)
+{
+    const uint8_t* pmem_start_address = get_heap_base();
+    if (std::holds_alternative<read_task>(cur_task))
+    {
+        read_task const& cur_read_task = std::get<read_task>(cur_task);
+        const uint32_t cur_value = execute_read_task(cur_read_task);
+        return executed_task_answer{
+                cur_read_task.answer_offset.has_value() ?
+                pmem_start_address + cur_read_task.answer_offset.value() : nullptr,
+                cur_read_task.answer_offset.has_value() ? 4u : 0u,
+                cur_read_task.task_id.has_value() ?
+                std::make_optional(task_completion(cur_read_task.task_id.value(), cur_value)) : std::nullopt
+        };
+    }
+    execute_task(cur_task);
+    if (std::holds_alternative<cas_task>(cur_task))
+    {
+        cas_task const& cur_cas_task = std::get<cas_task>(cur_task);
+        /*
+         * Answer has already been written by exec_task
+         */
+        const uint8_t* answer_address = pmem_start_address + cur_cas_task.answer_offset;
+        return executed_task_answer{
+                answer_address,
+                1,
+                cur_cas_task.task_id.has_value() ?
+                std::make_optional(task_completion(cur_cas_task.task_id.value(), *answer_address)) : std::nullopt
+        };
+    }
+    if (std::holds_alternative<map_update_task>(cur_task))
+    {
+        map_update_task const& cur_map_update_task = std::get<map_update_task>(cur_task);
+        const uint8_t* answer_address = pmem_start_address + cur_map_update_task.answer_offset;
+        return executed_task_answer{
+                answer_address,
+                1,
+                cur_map_update_task.task_id.has_value() ?
+                std::make_optional(task_completion(cur_map_update_task.task_id.value(), *answer_address)) :
+                std::nullopt
+        };
+    }
+    return executed_task_answer{nullptr, 0, std::nullopt};
+}
+
+void execute_task(task const& cur_task, completion_notifier& notifier)
+{
+    const executed_task_answer answer = execute_task_and_get_answer(cur_task);
+    if (answer.completion.has_value())
+    {
+        notifier.notify(answer.completion.value());
+    }
+}
+
+void execute_task(task const& cur_task, group_committer& committer)
+{
+    /*
+     * Answers are written, but not flushed, while committer is set
+     */
+    thread_local_non_owning_storage<group_committer>::ptr = &committer;
+    const executed_task_answer answer = execute_task_and_get_answer(cur_task);
+    thread_local_non_owning_storage<group_committer>::ptr = nullptr;
+    if (answer.length > 0 || answer.completion.has_value())
+    {
+        committer.enqueue(answer.address, answer.length, answer.completion);
+    }
+}
+
+bool is_answer_flush_deferred()
+{
+    return thread_local_non_owning_storage<group_committer>::ptr != nullptr;
+}
+
+uint32_t read_var(uint64_t var_offset)
+{
+    /*
+     * Register can contain descriptor of MCAS
+     */
+    return read_register_value(pptr<uint64_t>(var_offset).get());
+}
+
+std::vector<uint8_t> snapshot_read(const uint8_t* args)
+{
+    /*
+     * Read 4 bytes of registers count
+     */
+    uint32_t vars_count;
+    std::memcpy(&vars_count, args, 4);
+
+    uint8_t* const heap_base = get_heap_base();
+    std::vector<uint64_t*> vars(vars_count);
+    for (uint32_t i = 0; i < vars_count; i++)
+    {
+        /*
+         * Read 8 bytes of register offset
+         */
+        uint64_t var_offset;
+        std::memcpy(&var_offset, args + 4 + 8 * i, 8);
+        vars[i] = pptr<uint64_t>(var_offset).get(heap_base);
+    }
+
+    /*
+     * Collect full <thread_id, value> words: value alone is not enough to detect concurrent A -> B -> A updates
+     * (restored word is still not detected, see exec_task.h). Logical value of register, containing descriptor
+     * of MCAS, can change without change of the word, therefore status word of the descriptor is collected too.
+     * MCAS is not helped, since snapshot must not write to NVRAM: logical value is read by read_register_value.
+     */
+    struct collected_register
+    {
+        uint64_t word;
+        uint64_t descriptor_status;
+        uint32_t value;
+
+        bool operator==(collected_register const& other) const
+        {
+            return word == other.word && descriptor_status == other.descriptor_status && value == other.value;
+        }
+    };
+    auto collect = [&vars](std::vector<collected_register>& registers)
+    {
+        for (uint64_t i = 0; i < vars.size(); i++)
+        {
+            registers[i].word = __atomic_load_n(vars[i], __ATOMIC_SEQ_CST);
+            registers[i].descriptor_status = read_descriptor_status(registers[i].word);
+            registers[i].value = read_register_value(vars[i]);
+        }
+    };
+    std::vector<collected_register> old_registers(vars_count);
+    std::vector<collected_register> new_registers(vars_count);
+    collect(old_registers);
+    while (true)
+    {
+        collect(new_registers);
+        if (new_registers == old_registers)
+        {
+            break;
+        }
+        std::swap(old_registers, new_registers);
+    }
+
+    std::vector<uint8_t> result(4 * vars_count);
+    for (uint32_t i = 0; i < vars_count; i++)
+    {
+        std::memcpy(result.data() + 4 * i, &new_registers[i].value, 4);
+    }
+    return result;
+}
@@ -2,14 +2,22 @@
 #define DIPLOM_EXEC_TASK_H
 
 #include <cstdint>
+#include <vector>
+#include <optional>
+#include "../model/tasks.h"
+#include "../frame/stack_frame.h"
+#include "completion_notifier.h"
+#include "group_committer.h"
 
 /**
  * Executes task of some type and writes it's result to NVRAM.
- * By now, only CAS is supported and can be executed, but in future, more type of tasks can be added.
+ * By now, CAS and updates of the recoverable hash map are supported, but in future, more type of tasks
+ * can be added.
  * Args has the following structure:
  * <ul>
  *  <li>
- *      1 byte, containing type of task, that should be executed. By now, only 0x0 (CAS) is supported
+ *      1 byte, containing type of task, that should be executed: 0x0 (CAS), 0x1 (update of the key
+ *      of the hash map) or 0x2 (remove of the key of the hash map)
  *  </li>
  *  <li>
  *      8 bytes of result offset (i.e. offset of memory location, where answer of task should be written).
@@ -31,6 +39,20 @@
  *      8 bytes of thread matrix offset
  *  </li>
  * </ul>
+ * If type of task is 0x1 or 0x2, subsequent args has the following structure:
+ * <ul>
+ *  <li>
+ *      8 bytes of map offset
+ *  </li>
+ *  <li>
+ *      8 bytes of key
+ *  </li>
+ *  <li>
+ *      4 bytes of value (only if type of task is 0x1)
+ *  </li>
+ * </ul>
+ * Answer of CAS is 1 byte (0x0 or 0x1), answer of map operation is 1 byte of answer of map_put or map_remove
+ * (see hash_map.h).
  * @param args - arguments of function, marshalled to byte array.
  */
 void exec_task(const uint8_t* args);
@@ -43,4 +65,80 @@ void exec_task(const uint8_t* args);
  */
 void exec_task_recover(const uint8_t* args);
 
+/**
+ * Returns answer location of the task, which is being executed in the frame. Answer location of such task
+ * is still used, therefore it is a root for the heap collector (see heap_collector).
+ * @param frame - frame of the persistent stack.
+ * @return offset of the answer location from the beginning of the persistent heap, if the frame is frame
+ *         of exec_task, empty optional otherwise.
+ */
+std::optional<uint64_t> get_task_answer_offset(stack_frame const& frame);
+
+/**
+ * Executes task, taken from the tasks queue, in the caller worker thread. CAS task and map update task are
+ * marshalled and executed using do_call of exec_task, therefore they are recoverable. Read task, volatile task,
+ * snapshot read task and map get task are executed without using the persistent stack, since they don't modify
+ * persistent memory: they write nothing to NVRAM and are not restored after the crash.
+ * Results of volatile task, snapshot read task and map get task are passed to their promises (if any).
+ * Caller thread must have persistent stack with the first frame on the top, and system
+ * must be running in execution mode.
+ * @param cur_task - task to execute.
+ */
+void execute_task(task const& cur_task);
+
+/**
+ * Executes task in the same way, as execute_task(cur_task), and, if the task is CAS task, map update task
+ * or read task with task id, reports it's completion to the notifier. Completion is reported only after
+ * the answer of the task has been written to NVRAM. Completion is only added to the current batch of the notifier,
+ * caller is responsible for flushing the notifier.
+ * @param cur_task - task to execute.
+ * @param notifier - notifier of the caller worker thread.
+ */
+void execute_task(task const& cur_task, completion_notifier& notifier);
+
+/**
+ * Executes task in group commit mode. Answer of CAS task, map update task or read task is written to the answer
+ * location without flush, and answer location (together with completion, if the task has task id) is enqueued to the
+ * group committer, which flushes it and acknowledges the completion later. Task execution itself
+ * (persistent frames, CAS of the register) is as durable, as in execute_task(cur_task), but frame of exec_task
+ * is removed before the answer is durable, so unacknowledged task may have been applied, while it's answer has been
+ * lost after the crash (see group_committer). Recovery of exec_task always flushes the answer.
+ * @param cur_task - task to execute.
+ * @param committer - group committer, that makes answer durable.
+ */
+void execute_task(task const& cur_task, group_committer& committer);
+
+/**
+ * Atomically reads current value of RMW register, located in the persistent heap. If register contains
+ * descriptor of MCAS, returns it's logical value (see read_register_value).
+ * @param var_offset - offset of RMW register from the beginning of the persistent heap.
+ * @return current value of the register.
+ */
+uint32_t read_var(uint64_t var_offset);
+
+/**
+ * Volatile function, that reads values of several RMW registers, located in the persistent heap.
+ * Registers are read using double collect: all registers are read twice, until none of the 8-byte
+ * <thread_id, value> words has changed between two collects. Each returned value is a value, that the register
+ * has had during the call. Values are atomic (can be linearized at the moment between the collects) only if no
+ * register has returned to the same word between the collects: successful CAS always changes the word, but
+ * sequence of CASes (for example, <t1, A> -> <t2, B> -> <t1, A>) can restore it, and such change is not detected,
+ * since registers have no version. For register, containing descriptor of MCAS, status word of the descriptor
+ * and logical value (see read_register_value) are collected too, and MCAS is never helped, so the function
+ * writes nothing to NVRAM. It is obstruction-free: collect may be retried indefinitely under constant concurrent
+ * updates of the registers.
+ * Args has the following structure:
+ * <ul>
+ *  <li>
+ *      4 bytes of number of registers
+ *  </li>
+ *  <li>
+ *      8 bytes of offset of each register (from the beginning of the persistent heap)
+ *  </li>
+ * </ul>
+ * @param args - arguments of function, marshalled to byte array.
+ * @return 4 bytes of value of each register, in the same order, as offsets in args.
+ */
+std::vector<uint8_t> snapshot_read(const uint8_t* args);
+
 #endif //DIPLOM_EXEC_TASK_H
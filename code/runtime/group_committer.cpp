@@ -0,0 +1,137 @@
+#include "group_committer.h"
+#include "../common/pmem_utils.h"
+#include "../metrics/runtime_metrics.h"
+#include <algorithm>
+#include <stdexcept>
+
+group_committer::group_committer(blocking_queue<task_completion>& _completion_queue,
+                                 std::chrono::nanoseconds _commit_interval,
+                                 uint32_t _max_batch_size) :
+        completion_queue(_completion_queue),
+        commit_interval(_commit_interval),
+        max_batch_size(_max_batch_size),
+        pending(),
+        mutex(),
+        cv(),
+        stopped(false),
+        commit_thread()
+{
+    if (commit_interval.count() <= 0)
+    {
+        throw std::runtime_error("Commit interval must be positive");
+    }
+    if (max_batch_size == 0)
+    {
+        throw std::runtime_error("Max batch size of group committer should be positive");
+    }
+    /*
+     * Thread is started after all fields are initialized
+     */
+    commit_thread = std::thread(&group_committer::commit_loop, this);
+}
+
+void group_committer::enqueue(const uint8_t* address, size_t length, std::optional<task_completion> completion)
+{
+    std::unique_lock lock(mutex);
+    if (stopped)
+    {
+        throw std::runtime_error("Cannot enqueue answer: group committer has been stopped");
+    }
+    pending.push_back(pending_commit{address, length, completion});
+    if (pending.size() >= max_batch_size)
+    {
+        cv.notify_one();
+    }
+}
+
+void group_committer::commit_loop()
+{
+    std::unique_lock lock(mutex);
+    while (true)
+    {
+        cv.wait_for(
+                lock,
+                commit_interval,
+                [this]()
+                {
+                    return stopped || pending.size() >= max_batch_size;
+                }
+        );
+        if (pending.empty())
+        {
+            if (stopped)
+            {
+                return;
+            }
+            continue;
+        }
+        std::vector<pending_commit> batch;
+        batch.swap(pending);
+        /*
+         * Workers can enqueue answers to the next batch, while current batch is being committed
+         */
+        lock.unlock();
+        commit_batch(batch);
+        lock.lock();
+    }
+}
+
+void group_committer::commit_batch(std::vector<pending_commit> const& batch)
+{
+    /*
+     * msync flushes whole pages, therefore each dirty page is flushed once. Otherwise, each dirty cache line
+     * is flushed once. Note, that several answers are often located in the same cache line or page.
+     */
+    const uint64_t flush_unit = get_flush_backend() == flush_backend::MSYNC ? PAGE_SIZE : CACHE_LINE_SIZE;
+    std::vector<uint64_t> dirty_units;
+    std::vector<task_completion> completions;
+    for (pending_commit const& cur_commit: batch)
+    {
+        if (cur_commit.length > 0)
+        {
+            const uint64_t first_unit = (uint64_t) cur_commit.address / flush_unit;
+            const uint64_t last_unit = ((uint64_t) cur_commit.address + cur_commit.length - 1) / flush_unit;
+            for (uint64_t cur_unit = first_unit; cur_unit <= last_unit; cur_unit++)
+            {
+                dirty_units.push_back(cur_unit);
+            }
+        }
+        if (cur_commit.completion.has_value())
+        {
+            completions.push_back(cur_commit.completion.value());
+        }
+    }
+    std::sort(dirty_units.begin(), dirty_units.end());
+    dirty_units.erase(std::unique(dirty_units.begin(), dirty_units.end()), dirty_units.end());
+
+    for (uint64_t cur_unit: dirty_units)
+    {
+        pmem_do_flush_without_drain((const void*) (cur_unit * flush_unit), flush_unit, flush_site::ANSWER);
+    }
+    pmem_do_drain();
+    METRICS_INCREMENT(metrics_counter::GROUP_COMMITS, 1);
+
+    /*
+     * All answers of the batch are durable, completions can be acknowledged
+     */
+    completion_queue.push_all(completions);
+}
+
+void group_committer::stop()
+{
+    {
+        std::unique_lock lock(mutex);
+        if (stopped)
+        {
+            return;
+        }
+        stopped = true;
+        cv.notify_one();
+    }
+    commit_thread.join();
+}
+
+group_committer::~group_committer()
+{
+    stop();
+}
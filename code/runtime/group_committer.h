@@ -0,0 +1,90 @@
+#ifndef DIPLOM_GROUP_COMMITTER_H
+#define DIPLOM_GROUP_COMMITTER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <optional>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "../blocking_queue/blocking_queue.h"
+#include "../model/task_completion.h"
+
+/**
+ * Makes answers of tasks durable in batches (group commit). Worker threads write answers without
+ * flushing them and enqueue answer locations to the committer. Commit thread periodically takes all
+ * enqueued locations, flushes each dirty cache line once, issues single drain for the whole batch and
+ * only then acknowledges completions of all tasks of the batch. Therefore, number of drains is reduced
+ * at the cost of latency, which is increased by at most commit interval (plus time of the commit itself).
+ * Note, that group commit weakens detectability: frame of exec_task is removed before the batch is committed,
+ * therefore if the crash occurs in between, the effect of the task (e.g. successful CAS) is durable, but it's
+ * answer is lost, and recovery has no frame to restore it from. Task, which completion hasn't been acknowledged,
+ * may have been applied or not, and the answer location can't tell which.
+ */
+struct group_committer
+{
+private:
+    /**
+     * Answer location, that should be made durable, and completion, that should be acknowledged after that.
+     */
+    struct pending_commit
+    {
+        const uint8_t* address;
+        size_t length;
+        std::optional<task_completion> completion;
+    };
+
+    blocking_queue<task_completion>& completion_queue;
+    const std::chrono::nanoseconds commit_interval;
+    const uint32_t max_batch_size;
+    std::vector<pending_commit> pending;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopped;
+    std::thread commit_thread;
+
+    void commit_loop();
+
+    void commit_batch(std::vector<pending_commit> const& batch);
+
+public:
+    /**
+     * Creates committer and starts commit thread.
+     * @param _completion_queue - queue, to which completions are published after their answers become durable.
+     * @param _commit_interval - maximal time between two consecutive commits.
+     * @param _max_batch_size - number of enqueued answers, after which the batch is committed without
+     * waiting for the end of commit interval.
+     * @throws std::runtime_error - if commit interval is not positive or max batch size is zero.
+     */
+    group_committer(blocking_queue<task_completion>& _completion_queue,
+                    std::chrono::nanoseconds _commit_interval,
+                    uint32_t _max_batch_size);
+
+    group_committer(group_committer const&) = delete;
+
+    group_committer& operator=(group_committer const&) = delete;
+
+    /**
+     * Enqueues answer location to the next batch. Answer should have already been written, but not flushed.
+     * @param address - beginning of the answer location in the persistent memory.
+     * @param length - length of the answer. If 0, nothing is flushed, but completion is still acknowledged
+     * together with the batch.
+     * @param completion - completion, that should be published after the answer becomes durable.
+     * @throws std::runtime_error - if committer has been stopped.
+     */
+    void enqueue(const uint8_t* address, size_t length, std::optional<task_completion> completion);
+
+    /**
+     * Commits all enqueued answers and stops commit thread. Subsequent calls have no effect.
+     */
+    void stop();
+
+    /**
+     * Stops the committer.
+     */
+    ~group_committer();
+};
+
+#endif //DIPLOM_GROUP_COMMITTER_H
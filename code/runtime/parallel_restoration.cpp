@@ -0,0 +1,124 @@
+#include "parallel_restoration.h"
+#include "restoration.h"
+#include "../storage/thread_local_non_owning_storage.h"
+#include "../storage/thread_local_owning_storage.h"
+#include "../model/cur_thread_id_holder.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <optional>
+#include <exception>
+#include <algorithm>
+#include <stdexcept>
+
+restoration_report do_parallel_restoration(
+        std::vector<persistent_memory_holder>& persistent_stacks,
+        std::vector<ram_stack>& ram_stacks,
+        uint32_t number_of_restoration_threads,
+        std::function<void(stack_restoration_report const&)> const& on_stack_restored)
+{
+    if (number_of_restoration_threads == 0)
+    {
+        throw std::runtime_error("Cannot perform restoration without restoration threads");
+    }
+    const uint32_t number_of_stacks = persistent_stacks.size();
+
+    /*
+     * Number of the next stack, that hasn't been taken by any of the pool threads yet
+     */
+    std::atomic<uint32_t> next_stack_number(0);
+    /*
+     * Protects reports, first exception and calls of the callback
+     */
+    std::mutex mutex;
+    std::vector<std::optional<stack_restoration_report>> reports(number_of_stacks);
+    /*
+     * Each element is written by the single pool thread, that restored corresponding stack
+     */
+    std::vector<std::optional<ram_stack>> restored_stacks(number_of_stacks);
+    std::exception_ptr first_exception;
+
+    const std::chrono::steady_clock::time_point restoration_start = std::chrono::steady_clock::now();
+
+    std::function<void()> pool_thread_function = [
+            &persistent_stacks,
+            &restored_stacks,
+            &next_stack_number,
+            &mutex,
+            &reports,
+            &first_exception,
+            &on_stack_restored,
+            number_of_stacks
+    ]()
+    {
+        while (true)
+        {
+            const uint32_t cur_stack_number = next_stack_number.fetch_add(1);
+            if (cur_stack_number >= number_of_stacks)
+            {
+                return;
+            }
+            /*
+             * Pool thread impersonates worker thread, that owned current stack before the crash
+             */
+            thread_local_non_owning_storage<persistent_memory_holder>::ptr = &persistent_stacks[cur_stack_number];
+            thread_local_owning_storage<cur_thread_id_holder>::emplace_object(cur_stack_number);
+
+            const std::chrono::steady_clock::time_point stack_start = std::chrono::steady_clock::now();
+            try
+            {
+                const uint32_t restored_frames = do_restoration(persistent_stacks[cur_stack_number]);
+                const std::chrono::nanoseconds stack_duration = std::chrono::steady_clock::now() - stack_start;
+                /*
+                 * Restored stack is not used by the pool thread anymore
+                 */
+                restored_stacks[cur_stack_number].emplace(
+                        std::move(thread_local_owning_storage<ram_stack>::get_object())
+                );
+
+                std::unique_lock lock(mutex);
+                reports[cur_stack_number].emplace(cur_stack_number, restored_frames, stack_duration);
+                if (on_stack_restored)
+                {
+                    on_stack_restored(*reports[cur_stack_number]);
+                }
+            }
+            catch (...)
+            {
+                std::unique_lock lock(mutex);
+                if (!first_exception)
+                {
+                    first_exception = std::current_exception();
+                }
+            }
+        }
+    };
+
+    const uint32_t number_of_pool_threads = std::min(number_of_restoration_threads, number_of_stacks);
+    std::vector<std::thread> pool_threads;
+    for (uint32_t i = 0; i < number_of_pool_threads; ++i)
+    {
+        pool_threads.emplace_back(pool_thread_function);
+    }
+    for (std::thread& cur_thread: pool_threads)
+    {
+        cur_thread.join();
+    }
+
+    if (first_exception)
+    {
+        std::rethrow_exception(first_exception);
+    }
+
+    const std::chrono::nanoseconds total_duration = std::chrono::steady_clock::now() - restoration_start;
+    std::vector<stack_restoration_report> stack_reports;
+    stack_reports.reserve(number_of_stacks);
+    ram_stacks.clear();
+    ram_stacks.reserve(number_of_stacks);
+    for (uint32_t i = 0; i < number_of_stacks; ++i)
+    {
+        stack_reports.push_back(*reports[i]);
+        ram_stacks.push_back(std::move(*restored_stacks[i]));
+    }
+    return restoration_report(std::move(stack_reports), total_duration);
+}
@@ -0,0 +1,44 @@
+#ifndef DIPLOM_PARALLEL_RESTORATION_H
+#define DIPLOM_PARALLEL_RESTORATION_H
+
+#include <vector>
+#include <functional>
+#include "../persistent_memory/persistent_memory_holder.h"
+#include "../persistent_stack/ram_stack.h"
+#include "../model/restoration_report.h"
+
+/**
+ * Runs restoration procedure (see do_restoration) for all persistent stacks of the system.
+ * Stacks are restored independently of each other by a bounded pool of restoration threads:
+ * each of the pool threads repeatedly takes next stack, that hasn't been restored yet, and restores it,
+ * so the number of OS threads doesn't depend on the number of stacks.
+ * Before restoring i-th stack, pool thread sets thread-local persistent stack and thread id
+ * (thread_local_non_owning_storage<persistent_memory_holder> and thread_local_owning_storage<cur_thread_id_holder>)
+ * to the i-th stack and to i respectively, therefore recovery functions observe the same environment, as
+ * i-th worker thread did before the crash.
+ * After restoration, RAM representation of i-th restored stack is stored as i-th element of ram_stacks,
+ * so the system can be switched to execution mode and continue execution with restored stacks without
+ * reading them from persistent memory once again.
+ * Restoration can be started if only system is running in recovery mode.
+ * If restoration of some stack throws an exception, other stacks are still restored, and the first
+ * of the thrown exceptions is rethrown in the caller thread after all pool threads finish.
+ * @param persistent_stacks - persistent stacks of all worker threads. Stack of i-th worker thread
+ *                            should be i-th element of the vector.
+ * @param ram_stacks - vector, where RAM representations of restored stacks will be stored. Previous content
+ *                     of the vector is discarded.
+ * @param number_of_restoration_threads - maximal number of threads, that will restore stacks simultaneously.
+ *                                        Must be positive.
+ * @param on_stack_restored - callback, that is called after restoration of each of the stacks.
+ *                            Calls of the callback are serialized, so it doesn't need any synchronization.
+ * @return timings and number of restored frames for each of the stacks and total restoration time.
+ * @throws std::runtime_error - if number_of_restoration_threads is zero.
+ */
+restoration_report do_parallel_restoration(
+        std::vector<persistent_memory_holder>& persistent_stacks,
+        std::vector<ram_stack>& ram_stacks,
+        uint32_t number_of_restoration_threads,
+        std::function<void(stack_restoration_report const&)> const& on_stack_restored =
+                std::function<void(stack_restoration_report const&)>()
+);
+
+#endif //DIPLOM_PARALLEL_RESTORATION_H
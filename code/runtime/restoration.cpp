@@ -1,18 +1,32 @@
 #include "restoration.h"
+#include "transaction.h"
 #include "../persistent_stack/ram_stack.h"
 #include "../persistent_stack/persistent_stack.h"
 #include "../storage/global_storage.h"
 #include "../model/system_mode.h"
 #include "../model/function_address_holder.h"
 
-void do_restoration(persistent_memory_holder& persistent_stack)
+uint32_t do_restoration(persistent_memory_holder& persistent_stack)
 {
     if(global_storage<system_mode>::get_const_object() != system_mode::RECOVERY)
     {
         throw std::runtime_error("Cannot perform system restoration, when system is not in recovery mode");
     }
-    ram_stack r_stack = read_stack(persistent_stack);
-    thread_local_owning_storage<ram_stack>::set_object(r_stack);
+    thread_local_owning_storage<ram_stack>::set_object(read_stack(persistent_stack));
+    /*
+     * Recovery functions use stored stack (for example, in do_call), therefore
+     * stored stack itself (not its copy) should be modified after each frame recovery
+     */
+    ram_stack& r_stack = thread_local_owning_storage<ram_stack>::get_object();
+    /*
+     * Recovery modifies the stack, therefore header must describe the stack, that has just been read
+     */
+    repair_stack_header(r_stack, persistent_stack);
+    /*
+     * Recovery functions must see memory either with all writes of the last transaction of the stack or without them
+     */
+    recover_transaction(persistent_stack);
+    uint32_t restored_frames = 0;
     while (r_stack.size() > 1)
     {
         stack_frame const& top_frame = r_stack.get_last_frame().get_frame();
@@ -20,13 +34,14 @@ void do_restoration(persistent_memory_holder& persistent_stack)
          * Retrieve pointer to recovery version of function, using function name from persistent stack frame.
          */
         function_ptr f_recover = global_storage<function_address_holder>::get_const_object()
-                .funcs
-                .at(top_frame.get_function_name())
+                .get_funcs(top_frame.get_function_name())
                 .second;
         f_recover(top_frame.get_args().data());
         /*
          * reference to top_frame becomes dangling, but it isn't used anymore
          */
         remove_frame(r_stack, persistent_stack);
+        restored_frames++;
     }
+    return restored_frames;
 }
@@ -11,10 +11,16 @@
  * for the first frame isn't called.
  * Persistent stack should contain at least one frame. If persistent stack doesn't contain
  * any frames, behaviour of function is undefined.
+ * Before recovery of the frames, redo log of the stack is recovered (see recover_transaction).
  * Restoration can be started if only system is running in recovery mode.
+ * After restoration, thread_local_owning_storage<ram_stack> of the caller thread holds RAM representation
+ * of the restored persistent stack (containing only the first frame), so the caller thread can continue
+ * execution with the same stack.
  * @param persistent_stack - object, that holds file with persistent stack.
+ * @return number of frames, for which recovery operation has been called
+ *         (i.e. number of frames in persistent stack, except the first one).
  * @throws std::runtime error - if system is not running in restoration mode
  */
-void do_restoration(persistent_memory_holder& persistent_stack);
+uint32_t do_restoration(persistent_memory_holder& persistent_stack);
 
 #endif //DIPLOM_RESTORATION_H
@@ -0,0 +1,302 @@
+#include "transaction.h"
+#include "../common/constants_and_types.h"
+#include "../common/pmem_utils.h"
+#include "../persistent_stack/ram_stack.h"
+#include "../storage/global_non_owning_storage.h"
+#include "../storage/thread_local_non_owning_storage.h"
+#include "../storage/thread_local_owning_storage.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    /*
+     * Layout of the log
+     */
+    const uint64_t HEADER_CHECKSUM = 0;
+    const uint64_t HEADER_NUMBER_OF_ENTRIES = 8;
+    const uint64_t HEADER_SIZE = 16;
+    const uint64_t ENTRY_SIZE = 16;
+
+    /*
+     * Layout of the entry
+     */
+    const uint64_t ENTRY_OFFSET = 0;
+    const uint64_t ENTRY_TARGET = 4;
+    const uint64_t ENTRY_VALUE_SIZE = 5;
+    const uint64_t ENTRY_VALUE = 8;
+
+    const uint8_t TARGET_HEAP = 0x0;
+    const uint8_t TARGET_STACK = 0x1;
+
+    /*
+     * Transaction of the caller thread exists only in RAM until commit, therefore it is forgotten after the crash
+     */
+    thread_local bool tx_active = false;
+    thread_local uint32_t tx_number_of_entries = 0;
+
+    /**
+     * Location of written value: target and offset from the beginning of the target.
+     */
+    struct tx_location
+    {
+        uint8_t target;
+        uint32_t offset;
+    };
+
+    uint8_t* get_log(persistent_memory_holder& persistent_stack)
+    {
+        return persistent_stack.get_pmem_ptr() + TX_LOG_OFFSET;
+    }
+
+    uint8_t* get_entry(uint8_t* log, uint32_t entry_number)
+    {
+        return log + HEADER_SIZE + entry_number * ENTRY_SIZE;
+    }
+
+    /**
+     * Returns pointer to the beginning of the memory, to which entries with the specified target are applied.
+     * @param target - TARGET_HEAP or TARGET_STACK.
+     * @param persistent_stack - stack of the caller thread.
+     * @return pointer to the beginning of the heap or the stack.
+     */
+    uint8_t* get_target_memory(uint8_t target, persistent_memory_holder& persistent_stack)
+    {
+        if (target == TARGET_STACK)
+        {
+            return persistent_stack.get_pmem_ptr();
+        }
+        return global_non_owning_storage<persistent_memory_holder>::ptr->get_pmem_ptr();
+    }
+
+    /**
+     * Checksum (FNV-1a) of number of entries and entries of the log.
+     * @param log - pointer to the beginning of the log.
+     * @param number_of_entries - number of entries.
+     * @return checksum of the log.
+     */
+    uint64_t get_checksum(const uint8_t* log, uint32_t number_of_entries)
+    {
+        uint64_t checksum = 0xCBF29CE484222325ULL;
+        const auto add_byte = [&checksum](uint8_t byte)
+        {
+            checksum ^= byte;
+            checksum *= 0x100000001B3ULL;
+        };
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            add_byte((number_of_entries >> (8 * i)) & 0xFF);
+        }
+        const uint8_t* const entries = log + HEADER_SIZE;
+        for (uint64_t i = 0; i < number_of_entries * ENTRY_SIZE; i++)
+        {
+            add_byte(entries[i]);
+        }
+        return checksum;
+    }
+
+    /**
+     * Applies entries of the log to memory, makes them durable and clears the log.
+     * @param log - pointer to the beginning of the log.
+     * @param number_of_entries - number of entries.
+     * @param persistent_stack - stack, that contains the log.
+     */
+    void apply_log(uint8_t* log, uint32_t number_of_entries, persistent_memory_holder& persistent_stack)
+    {
+        for (uint32_t entry_number = 0; entry_number < number_of_entries; entry_number++)
+        {
+            const uint8_t* const entry = get_entry(log, entry_number);
+            uint32_t offset;
+            std::memcpy(&offset, entry + ENTRY_OFFSET, 4);
+            uint8_t* const location = get_target_memory(entry[ENTRY_TARGET], persistent_stack) + offset;
+            std::memcpy(location, entry + ENTRY_VALUE, entry[ENTRY_VALUE_SIZE]);
+            pmem_do_flush_without_drain(location, entry[ENTRY_VALUE_SIZE], flush_site::TX_DATA);
+        }
+        pmem_do_drain();
+        /*
+         * Log mustn't be replayed after the crash, since locations can be changed by subsequent operations.
+         * Clearing is drained separately, after the writes are durable
+         */
+        const uint32_t empty = 0;
+        std::memcpy(log + HEADER_NUMBER_OF_ENTRIES, &empty, 4);
+        pmem_do_flush(log + HEADER_NUMBER_OF_ENTRIES, 4, flush_site::TX_LOG);
+    }
+
+    void check_active()
+    {
+        if (!tx_active)
+        {
+            throw std::runtime_error("Transaction hasn't been begun");
+        }
+    }
+
+    /**
+     * Finds location of the value of the specified size.
+     * @param address - address of the value.
+     * @param size - size of the value, from 1 to 8 bytes.
+     * @return location of the value.
+     * @throws std::runtime_error - if the value doesn't belong to the heap or to the frames region of the stack.
+     */
+    tx_location get_location(const uint8_t* address, uint8_t size)
+    {
+        const uint8_t* const stack_begin =
+                thread_local_non_owning_storage<persistent_memory_holder>::ptr->get_pmem_ptr();
+        if (address >= stack_begin && address + size <= stack_begin + TX_LOG_OFFSET)
+        {
+            return tx_location{TARGET_STACK, (uint32_t) (address - stack_begin)};
+        }
+        persistent_memory_holder* const heap = global_non_owning_storage<persistent_memory_holder>::ptr;
+        if (heap != nullptr)
+        {
+            const uint8_t* const heap_begin = heap->get_pmem_ptr();
+            if (address >= heap_begin && address + size <= heap_begin + PMEM_HEAP_SIZE)
+            {
+                return tx_location{TARGET_HEAP, (uint32_t) (address - heap_begin)};
+            }
+        }
+        throw std::runtime_error("Transaction can write only to the persistent heap or to the persistent stack");
+    }
+
+    void check_size(uint64_t size)
+    {
+        if (size < 1 || size > 8)
+        {
+            throw std::runtime_error("Transaction cannot access value of size " + std::to_string(size));
+        }
+    }
+}
+
+const uint32_t TX_MAX_WRITES = (PMEM_STACK_SIZE - TX_LOG_OFFSET - HEADER_SIZE) / ENTRY_SIZE;
+
+void tx_begin()
+{
+    if (tx_active)
+    {
+        throw std::runtime_error("Transaction has already been begun");
+    }
+    tx_active = true;
+    tx_number_of_entries = 0;
+}
+
+void tx_write(uint8_t* address, std::vector<uint8_t> const& value)
+{
+    check_active();
+    check_size(value.size());
+    const tx_location location = get_location(address, value.size());
+    if (tx_number_of_entries == TX_MAX_WRITES)
+    {
+        throw std::runtime_error("Transaction cannot contain more than " + std::to_string(TX_MAX_WRITES) + " writes");
+    }
+    /*
+     * Entry isn't flushed until commit
+     */
+    uint8_t* const entry = get_entry(
+            get_log(*thread_local_non_owning_storage<persistent_memory_holder>::ptr),
+            tx_number_of_entries
+    );
+    std::memset(entry, 0, ENTRY_SIZE);
+    std::memcpy(entry + ENTRY_OFFSET, &location.offset, 4);
+    entry[ENTRY_TARGET] = location.target;
+    entry[ENTRY_VALUE_SIZE] = value.size();
+    std::memcpy(entry + ENTRY_VALUE, value.data(), value.size());
+    tx_number_of_entries++;
+}
+
+void tx_write_answer(std::vector<uint8_t> const& answer)
+{
+    check_active();
+    ram_stack const& r_stack = thread_local_owning_storage<ram_stack>::get_const_object();
+    if (r_stack.size() == 1)
+    {
+        throw std::runtime_error("Cannot return value from the first frame");
+    }
+    tx_write(
+            thread_local_non_owning_storage<persistent_memory_holder>::ptr->get_pmem_ptr() +
+            r_stack.get_answer_position(),
+            answer
+    );
+}
+
+std::vector<uint8_t> tx_read(const uint8_t* address, uint8_t size)
+{
+    check_active();
+    check_size(size);
+    const tx_location location = get_location(address, size);
+    std::vector<uint8_t> result(address, address + size);
+    /*
+     * Later writes override earlier ones, each write can cover only part of the value
+     */
+    uint8_t* const log = get_log(*thread_local_non_owning_storage<persistent_memory_holder>::ptr);
+    for (uint32_t entry_number = 0; entry_number < tx_number_of_entries; entry_number++)
+    {
+        const uint8_t* const entry = get_entry(log, entry_number);
+        if (entry[ENTRY_TARGET] != location.target)
+        {
+            continue;
+        }
+        uint32_t entry_offset;
+        std::memcpy(&entry_offset, entry + ENTRY_OFFSET, 4);
+        const uint64_t begin = std::max<uint64_t>(entry_offset, location.offset);
+        const uint64_t end = std::min<uint64_t>(entry_offset + entry[ENTRY_VALUE_SIZE], location.offset + size);
+        for (uint64_t cur_offset = begin; cur_offset < end; cur_offset++)
+        {
+            result[cur_offset - location.offset] = entry[ENTRY_VALUE + cur_offset - entry_offset];
+        }
+    }
+    return result;
+}
+
+void tx_commit()
+{
+    check_active();
+    tx_active = false;
+    if (tx_number_of_entries == 0)
+    {
+        return;
+    }
+    persistent_memory_holder& persistent_stack = *thread_local_non_owning_storage<persistent_memory_holder>::ptr;
+    uint8_t* const log = get_log(persistent_stack);
+    const uint64_t checksum = get_checksum(log, tx_number_of_entries);
+    std::memcpy(log + HEADER_CHECKSUM, &checksum, 8);
+    std::memcpy(log + HEADER_NUMBER_OF_ENTRIES, &tx_number_of_entries, 4);
+    /*
+     * Commit point: header and entries become durable together
+     */
+    pmem_do_flush_without_drain(log, HEADER_SIZE + tx_number_of_entries * ENTRY_SIZE, flush_site::TX_LOG);
+    pmem_do_drain();
+    apply_log(log, tx_number_of_entries, persistent_stack);
+}
+
+void tx_abort()
+{
+    check_active();
+    tx_active = false;
+}
+
+bool recover_transaction(persistent_memory_holder& persistent_stack)
+{
+    tx_active = false;
+    uint8_t* const log = get_log(persistent_stack);
+    uint32_t number_of_entries;
+    std::memcpy(&number_of_entries, log + HEADER_NUMBER_OF_ENTRIES, 4);
+    if (number_of_entries == 0)
+    {
+        return false;
+    }
+    uint64_t checksum;
+    std::memcpy(&checksum, log + HEADER_CHECKSUM, 8);
+    if (number_of_entries > TX_MAX_WRITES || checksum != get_checksum(log, number_of_entries))
+    {
+        /*
+         * Crash occurred before the log became durable: transaction hasn't changed memory
+         */
+        const uint32_t empty = 0;
+        std::memcpy(log + HEADER_NUMBER_OF_ENTRIES, &empty, 4);
+        pmem_do_flush(log + HEADER_NUMBER_OF_ENTRIES, 4, flush_site::TX_LOG);
+        return false;
+    }
+    apply_log(log, number_of_entries, persistent_stack);
+    return true;
+}
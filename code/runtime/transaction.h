@@ -0,0 +1,96 @@
+#ifndef DIPLOM_TRANSACTION_H
+#define DIPLOM_TRANSACTION_H
+
+#include <cstdint>
+#include <vector>
+#include "../persistent_memory/persistent_memory_holder.h"
+
+/*
+ * Durable transactions, which make several writes to the persistent heap (and to the answer memory of the current
+ * frame) atomic with respect to crashes. Transactions use per-thread redo log, which occupies the end of the file
+ * with persistent stack (see TX_LOG_OFFSET). Log starts with 16 bytes of header: 8 bytes of checksum
+ * of the transaction, 4 bytes of number of entries (0, if the log is empty) and 4 unused bytes.
+ * Header is followed by entries, each entry occupies 16 bytes: 4 bytes of offset of the written location (from the
+ * beginning of the heap or the stack), 1 byte of target (heap or stack), 1 byte of size of the written value,
+ * 2 unused bytes and 8 bytes of the value.
+ *
+ * tx_write only appends entry to the log, without flushing it, memory itself isn't changed until commit.
+ * tx_commit writes header with checksum of all entries and makes the whole log durable using single drain:
+ * log is committed, when both header and entries are durable, and since checksum of torn log doesn't match it's
+ * entries, after the crash it is impossible to mistake partially written log for the committed one.
+ * After that, the writes are applied to memory, which is made durable using the second drain, and then the log
+ * is cleared using the third drain. Clearing cannot share the second drain: the cleared header could become durable
+ * before the applied writes. Therefore each transaction costs three drains, regardless of the number of written
+ * locations (transaction without writes costs nothing).
+ *
+ * After the crash, do_restoration calls recover_transaction before any recovery function: committed log is replayed
+ * (writes are idempotent), and uncommitted log is discarded (memory hasn't been changed by it's transaction, so it is
+ * rolled back for free). Since answer of the function can be written by the same transaction (see tx_write_answer),
+ * recovery function can find out, whether it's transaction has been committed, by reading it's answer.
+ *
+ * Transactions don't provide isolation: they can be used only for locations, that are not concurrently
+ * accessed by other threads (or are protected by the caller), and locations, modified by transaction, must not be
+ * read by other threads until tx_commit returns.
+ */
+
+/**
+ * Maximal number of writes in single transaction.
+ */
+extern const uint32_t TX_MAX_WRITES;
+
+/**
+ * Begins new transaction in the caller thread.
+ * @throws std::runtime_error - if the caller thread has already begun transaction.
+ */
+void tx_begin();
+
+/**
+ * Adds write to the current transaction. Location must belong to the persistent heap or to the frames region
+ * of persistent stack of the caller thread. Value is written to memory only after commit.
+ * @param address - address of the location.
+ * @param value - value to write, from 1 to 8 bytes.
+ * @throws std::runtime_error - if there is no current transaction, size of the value is invalid, address doesn't
+ *                              belong to the heap or the stack, or transaction already has TX_MAX_WRITES writes.
+ */
+void tx_write(uint8_t* address, std::vector<uint8_t> const& value);
+
+/**
+ * Adds write of the answer of the current function to the current transaction (see write_answer).
+ * @param answer - answer of the function, from 1 to 8 bytes.
+ * @throws std::runtime_error - if there is no current transaction, size of the answer is invalid, current frame
+ *                              is the first frame of the stack, or transaction already has TX_MAX_WRITES writes.
+ */
+void tx_write_answer(std::vector<uint8_t> const& answer);
+
+/**
+ * Reads location, taking into account writes of the current transaction, that haven't been committed yet.
+ * @param address - address of the location.
+ * @param size - number of bytes to read, from 1 to 8.
+ * @return value of the location, as it will be after the commit, if no other writes are added.
+ * @throws std::runtime_error - if there is no current transaction, size is invalid or address doesn't belong
+ *                              to the heap or the stack.
+ */
+std::vector<uint8_t> tx_read(const uint8_t* address, uint8_t size);
+
+/**
+ * Commits the current transaction: makes all it's writes durable atomically and applies them to memory.
+ * @throws std::runtime_error - if there is no current transaction.
+ */
+void tx_commit();
+
+/**
+ * Aborts the current transaction: none of it's writes is applied.
+ * @throws std::runtime_error - if there is no current transaction.
+ */
+void tx_abort();
+
+/**
+ * Recovers redo log of persistent stack after the crash: replays log of committed transaction and discards
+ * log of uncommitted transaction. Transaction of the caller thread (if any) is forgotten. Is called by
+ * do_restoration before recovery of frames of the stack.
+ * @param persistent_stack - stack, which log should be recovered.
+ * @return true, if committed transaction has been replayed, false otherwise.
+ */
+bool recover_transaction(persistent_memory_holder& persistent_stack);
+
+#endif //DIPLOM_TRANSACTION_H
@@ -3,6 +3,7 @@
 
 #include <optional>
 #include <stdexcept>
+#include <utility>
 
 /**
  * Stores instances of some object of type T as global singleton object.
@@ -51,10 +52,20 @@ public:
 
     /**
      * Global storage  will store the object, that is passed as an argument.
+     * Object is moved to the storage, not copied.
      * @param object - object to store
      */
     static void set_object(T&& object);
 
+    /**
+     * Global storage will store the object, constructed in place from the specified arguments.
+     * @tparam Args - types of arguments of T constructor.
+     * @param args - arguments of T constructor.
+     * @return reference to the stored object.
+     */
+    template <typename... Args>
+    static T& emplace_object(Args&&... args);
+
     /**
      * Returns reference to the object, that is stored in the global storage.
      * @return object, that was an argument of the last call to set_object.
@@ -106,7 +117,14 @@ const T& global_storage<T>::get_const_object()
 template <typename T>
 void global_storage<T>::set_object(T&& object)
 {
-    object_opt.emplace(object);
+    object_opt.emplace(std::move(object));
+}
+
+template <typename T>
+template <typename... Args>
+T& global_storage<T>::emplace_object(Args&&... args)
+{
+    return object_opt.emplace(std::forward<Args>(args)...);
 }
 
 #endif //DIPLOM_GLOBAL_STORAGE_H
@@ -3,6 +3,7 @@
 
 #include <optional>
 #include <stdexcept>
+#include <utility>
 
 /**
  * Stores instances of some object of type T as thread local singleton object.
@@ -35,6 +36,23 @@ public:
      */
     static void set_object(const T& object);
 
+    /**
+     * Storage in the caller thread will store the object, that is passed as an argument.
+     * Object is moved to the storage, not copied.
+     * @param object - object to store
+     */
+    static void set_object(T&& object);
+
+    /**
+     * Storage in the caller thread will store the object, constructed in place
+     * from the specified arguments.
+     * @tparam Args - types of arguments of T constructor.
+     * @param args - arguments of T constructor.
+     * @return reference to the stored object.
+     */
+    template <typename... Args>
+    static T& emplace_object(Args&&... args);
+
     /**
      * Returns reference to the object, that is stored in the thread-local storage.
      * @return object, that was an argument of the last call to set_object in this thread.
@@ -57,6 +75,19 @@ void thread_local_owning_storage<T>::set_object(const T& object)
     object_opt.emplace(object);
 }
 
+template <typename T>
+void thread_local_owning_storage<T>::set_object(T&& object)
+{
+    object_opt.emplace(std::move(object));
+}
+
+template <typename T>
+template <typename... Args>
+T& thread_local_owning_storage<T>::emplace_object(Args&&... args)
+{
+    return object_opt.emplace(std::forward<Args>(args)...);
+}
+
 template <typename T>
 T& thread_local_owning_storage<T>::get_object()
 {
@@ -0,0 +1,159 @@
+#include "epoch_manager.h"
+#include "../model/cur_thread_id_holder.h"
+#include "../storage/global_non_owning_storage.h"
+#include "../storage/thread_local_owning_storage.h"
+#include <cassert>
+
+const uint32_t epoch_manager::RETIRE_BATCH_SIZE = 64;
+
+namespace
+{
+    const uint64_t ACTIVE_FLAG = 0x1;
+}
+
+epoch_manager::epoch_manager(node_pool& _pool, uint32_t _number_of_threads) :
+        pool(_pool),
+        global_epoch(0),
+        number_of_threads(_number_of_threads),
+        threads(new thread_state[_number_of_threads])
+{
+    for (uint32_t thread_number = 0; thread_number < number_of_threads; thread_number++)
+    {
+        threads[thread_number].announcement.store(0);
+        threads[thread_number].nesting = 0;
+        threads[thread_number].reclaim_threshold = RETIRE_BATCH_SIZE;
+    }
+}
+
+epoch_manager::thread_state& epoch_manager::get_thread_state()
+{
+    const uint32_t thread_number = thread_local_owning_storage<cur_thread_id_holder>::get_const_object().cur_thread_id;
+    assert(thread_number < number_of_threads);
+    return threads[thread_number];
+}
+
+void epoch_manager::enter()
+{
+    thread_state& state = get_thread_state();
+    state.nesting++;
+    if (state.nesting > 1)
+    {
+        return;
+    }
+    /*
+     * Announcement must be visible to other threads before any node is read, therefore it is sequentially consistent.
+     * If the epoch has been advanced before the announcement became visible, it is announced again.
+     */
+    uint64_t epoch;
+    do
+    {
+        epoch = global_epoch.load();
+        state.announcement.store((epoch << 1) | ACTIVE_FLAG, std::memory_order_seq_cst);
+    } while (global_epoch.load() != epoch);
+}
+
+void epoch_manager::exit()
+{
+    thread_state& state = get_thread_state();
+    assert(state.nesting > 0);
+    state.nesting--;
+    if (state.nesting == 0)
+    {
+        state.announcement.store(0, std::memory_order_release);
+    }
+}
+
+void epoch_manager::retire(uint32_t node_index)
+{
+    pool.retire_node(node_index);
+    thread_state& state = get_thread_state();
+    state.retired.push_back(retired_node{node_index, global_epoch.load()});
+    if (state.retired.size() >= state.reclaim_threshold)
+    {
+        reclaim();
+    }
+}
+
+void epoch_manager::try_advance()
+{
+    uint64_t epoch = global_epoch.load();
+    for (uint32_t thread_number = 0; thread_number < number_of_threads; thread_number++)
+    {
+        const uint64_t announcement = threads[thread_number].announcement.load();
+        if ((announcement & ACTIVE_FLAG) != 0 && (announcement >> 1) != epoch)
+        {
+            return;
+        }
+    }
+    /*
+     * Fails, if the epoch has already been advanced by other thread
+     */
+    global_epoch.compare_exchange_strong(epoch, epoch + 1);
+}
+
+uint64_t epoch_manager::reclaim()
+{
+    try_advance();
+    const uint64_t epoch = global_epoch.load();
+    thread_state& state = get_thread_state();
+    std::vector<uint32_t> freed;
+    std::vector<retired_node> still_retired;
+    for (retired_node const& node : state.retired)
+    {
+        if (node.epoch + 2 <= epoch)
+        {
+            freed.push_back(node.node_index);
+        }
+        else
+        {
+            still_retired.push_back(node);
+        }
+    }
+    if (!freed.empty())
+    {
+        pool.free_nodes(freed);
+    }
+    state.retired = std::move(still_retired);
+    state.reclaim_threshold = state.retired.size() + RETIRE_BATCH_SIZE;
+    return freed.size();
+}
+
+uint64_t epoch_manager::get_retired_count()
+{
+    return get_thread_state().retired.size();
+}
+
+uint64_t epoch_manager::get_epoch() const
+{
+    return global_epoch.load();
+}
+
+epoch_guard::epoch_guard() :
+        manager(global_non_owning_storage<epoch_manager>::ptr)
+{
+    if (manager != nullptr)
+    {
+        manager->enter();
+    }
+}
+
+epoch_guard::~epoch_guard()
+{
+    if (manager != nullptr)
+    {
+        manager->exit();
+    }
+}
+
+void reclaim_node(uint32_t node_index)
+{
+    epoch_manager* const manager = global_non_owning_storage<epoch_manager>::ptr;
+    if (manager != nullptr)
+    {
+        manager->retire(node_index);
+    }
+    else
+    {
+        global_non_owning_storage<node_pool>::ptr->free_node(node_index);
+    }
+}
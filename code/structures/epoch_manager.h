@@ -0,0 +1,151 @@
+#ifndef DIPLOM_EPOCH_MANAGER_H
+#define DIPLOM_EPOCH_MANAGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "node_pool.h"
+
+/**
+ * Epoch-based reclamation of nodes of node_pool. Operations of lock-free data structures access nodes inside
+ * critical sections (see epoch_guard), and node, that has been removed from the structure, is retired instead
+ * of being freed: it is freed only after each thread has left all critical sections, that could observe the node.
+ *
+ * Manager has global epoch, and each thread announces the epoch, which it has observed at the beginning of it's
+ * critical section. Global epoch is advanced, when all threads in critical sections have announced it. Node,
+ * retired in epoch e, can be accessed only by critical sections, that have begun in epochs e or e - 1,
+ * therefore it is freed, when global epoch becomes e + 2.
+ *
+ * Retired nodes are stored in per-thread lists in RAM and are freed in batches (after each RETIRE_BATCH_SIZE
+ * retired nodes), using single drain per batch. Retirement itself is durable: node is marked
+ * as retired in the pool, and the pool frees all retired nodes, when it is restored after the crash.
+ * Threads are identified by cur_thread_id_holder, each thread id must be used by a single thread at a time.
+ * Since there should be only one manager in the system, it is proposed to use this class with
+ * global_non_owning_storage<T>.
+ */
+struct epoch_manager
+{
+public:
+    /**
+     * Number of nodes, retired by the thread, after which the thread tries to free retired nodes.
+     */
+    static const uint32_t RETIRE_BATCH_SIZE;
+
+    /**
+     * Initializes manager.
+     * @param _pool - pool, nodes of which are reclaimed.
+     * @param number_of_threads - total number of threads.
+     */
+    epoch_manager(node_pool& _pool, uint32_t number_of_threads);
+
+    /**
+     * Begins critical section of the caller thread. Critical sections can be nested.
+     */
+    void enter();
+
+    /**
+     * Ends critical section of the caller thread.
+     */
+    void exit();
+
+    /**
+     * Retires node, which can no longer be reached from the data structure, but can still be accessed
+     * by concurrent critical sections. Can free nodes, retired by the caller thread earlier.
+     * @param node_index - index of allocated node.
+     */
+    void retire(uint32_t node_index);
+
+    /**
+     * Tries to advance global epoch and frees nodes, retired by the caller thread, that can no longer be accessed.
+     * @return number of freed nodes.
+     */
+    uint64_t reclaim();
+
+    /**
+     * Returns number of nodes, retired by the caller thread, that haven't been freed yet.
+     * @return number of nodes.
+     */
+    uint64_t get_retired_count();
+
+    [[nodiscard]] uint64_t get_epoch() const;
+
+private:
+    /**
+     * Node, retired in the epoch.
+     */
+    struct retired_node
+    {
+        uint32_t node_index;
+        uint64_t epoch;
+    };
+
+    /**
+     * State of the thread. Is aligned by cache line size, so that announcements of different threads are
+     * not located in the same cache line.
+     */
+    struct alignas(64) thread_state
+    {
+        /**
+         * <announced epoch, 1>, if the thread is in critical section, 0 otherwise.
+         */
+        std::atomic<uint64_t> announcement;
+        /**
+         * Following fields are accessed only by the thread itself
+         */
+        uint32_t nesting;
+        std::vector<retired_node> retired;
+        /**
+         * Size of the list, after which the thread tries to free retired nodes again. Nodes, that cannot be freed
+         * yet, stay in the list, and it isn't scanned again, until another batch is retired.
+         */
+        uint64_t reclaim_threshold;
+    };
+
+    /**
+     * Returns state of the caller thread.
+     * @return state of the thread.
+     */
+    thread_state& get_thread_state();
+
+    /**
+     * Advances global epoch, if all threads in critical sections have announced it.
+     */
+    void try_advance();
+
+    node_pool& pool;
+
+    std::atomic<uint64_t> global_epoch;
+
+    const uint32_t number_of_threads;
+
+    std::unique_ptr<thread_state[]> threads;
+};
+
+/**
+ * Critical section of the caller thread, that lasts until the guard is destroyed. Does nothing, if there is no
+ * manager in global_non_owning_storage<epoch_manager>.
+ */
+struct epoch_guard
+{
+public:
+    epoch_guard();
+
+    epoch_guard(epoch_guard const& other) = delete;
+
+    epoch_guard& operator=(epoch_guard const& other) = delete;
+
+    ~epoch_guard();
+
+private:
+    epoch_manager* const manager;
+};
+
+/**
+ * Reclaims node, which has been removed from data structure: retires it, if there is manager in
+ * global_non_owning_storage<epoch_manager>, and frees it immediately otherwise.
+ * @param node_index - index of allocated node of the pool from global_non_owning_storage<node_pool>.
+ */
+void reclaim_node(uint32_t node_index);
+
+#endif //DIPLOM_EPOCH_MANAGER_H
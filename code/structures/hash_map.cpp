@@ -0,0 +1,692 @@
+#include "hash_map.h"
+#include "structures_common.h"
+#include "node_pool.h"
+#include "epoch_manager.h"
+#include "../common/pmem_utils.h"
+#include "../common/constants_and_types.h"
+#include "../storage/global_storage.h"
+#include "../storage/global_non_owning_storage.h"
+#include "../persistent_memory/persistent_memory_holder.h"
+#include "../persistent_memory/pptr.h"
+#include "../model/total_thread_count_holder.h"
+#include "../runtime/answer.h"
+#include "../runtime/call.h"
+#include "../runtime/exec_task.h"
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
+
+const uint8_t MAP_ANSWER_DONE = 0x1;
+
+const uint8_t MAP_ANSWER_ABSENT = 0x0;
+
+const uint8_t MAP_ANSWER_NO_SPACE = 0x2;
+
+namespace
+{
+    /*
+     * Offsets of fields of the descriptor
+     */
+    const uint32_t ACTIVE_TABLE_OFFSET = 0;
+    const uint32_t OLDEST_TABLE_OFFSET = 4;
+    const uint32_t INITIAL_CAPACITY_OFFSET = 8;
+    const uint32_t NUMBER_OF_TABLES_OFFSET = 12;
+
+    /*
+     * Offset of key in the bucket
+     */
+    const uint32_t KEY_OFFSET = 8;
+
+    /*
+     * Offsets of fields of the node
+     */
+    const uint32_t VALUE_OFFSET = 0;
+    const uint32_t INCARNATION_OFFSET = 4;
+    const uint32_t USED_NODE_SIZE = 8;
+
+    /*
+     * Flags of reference, stored in the register of the bucket. Tag of the reference is the incarnation of the node.
+     */
+    const uint32_t SEALED_FLAG = 1u << 31;
+    const uint32_t DELETED_FLAG = 1u << 30;
+    const uint32_t INCARNATION_MASK = (1u << (30 - NODE_INDEX_BITS)) - 1;
+
+    /**
+     * Maximal number of buckets, probed by update, before the table is considered full.
+     */
+    const uint32_t MAX_PROBE = 16;
+
+    /**
+     * Fields and offsets of the descriptor of the map.
+     */
+    struct hash_map_descriptor
+    {
+        uint8_t* header;
+        uint64_t matrix;
+        uint64_t tables;
+        uint32_t initial_capacity;
+        uint32_t number_of_tables;
+
+        explicit hash_map_descriptor(uint64_t map_offset)
+        {
+            header = pptr<uint8_t>(map_offset).get();
+            matrix = map_offset + CACHE_LINE_SIZE;
+            tables = matrix + get_thread_matrix_size(
+                    global_storage<total_thread_count_holder>::get_const_object().total_thread_count
+            );
+            std::memcpy(&initial_capacity, header + INITIAL_CAPACITY_OFFSET, 4);
+            std::memcpy(&number_of_tables, header + NUMBER_OF_TABLES_OFFSET, 4);
+        }
+
+        uint32_t load_field(uint32_t field_offset) const
+        {
+            return __atomic_load_n((const uint32_t*) (header + field_offset), __ATOMIC_SEQ_CST);
+        }
+
+        /**
+         * Changes field from expected value to the new one, if it still contains expected value, and flushes it.
+         */
+        void advance_field(uint32_t field_offset, uint32_t expected_value, uint32_t new_value) const
+        {
+            __atomic_compare_exchange_n(
+                    (uint32_t*) (header + field_offset),
+                    &expected_value,
+                    new_value,
+                    false,
+                    __ATOMIC_SEQ_CST,
+                    __ATOMIC_SEQ_CST
+            );
+            pmem_do_flush(header + field_offset, 4);
+        }
+
+        uint32_t get_capacity(uint32_t table) const
+        {
+            return initial_capacity << table;
+        }
+
+        uint64_t get_bucket_offset(uint32_t table, uint32_t bucket) const
+        {
+            /*
+             * Tables 0..table-1 contain initial_capacity * (2^table - 1) buckets
+             */
+            return tables + ((uint64_t) initial_capacity * ((1ull << table) - 1) + bucket) * CACHE_LINE_SIZE;
+        }
+    };
+
+    uint64_t* get_key_ptr(uint64_t bucket_offset)
+    {
+        return pptr<uint64_t>(bucket_offset + KEY_OFFSET).get();
+    }
+
+    /**
+     * Finalizer of splitmix64, spreads keys with equal lower bits over the table.
+     */
+    uint64_t hash_key(uint64_t key)
+    {
+        key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+        key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+        return key ^ (key >> 31);
+    }
+
+    /**
+     * Searches bucket of the key in the table. Probing stops at the first empty bucket, which is claimed for
+     * the key, if it is among the first claim_limit probed buckets.
+     * @return offset of the bucket, or empty optional, if the key is absent and the bucket wasn't claimed.
+     */
+    std::optional<uint64_t> find_bucket(hash_map_descriptor const& descriptor,
+                                        uint32_t table,
+                                        uint64_t key,
+                                        uint32_t claim_limit)
+    {
+        const uint32_t capacity = descriptor.get_capacity(table);
+        const uint64_t hash = hash_key(key);
+        for (uint32_t i = 0; i < capacity; i++)
+        {
+            const uint64_t bucket_offset = descriptor.get_bucket_offset(table, (hash + i) & (capacity - 1));
+            uint64_t* const key_ptr = get_key_ptr(bucket_offset);
+            uint64_t cur_key = __atomic_load_n(key_ptr, __ATOMIC_SEQ_CST);
+            if (cur_key == 0)
+            {
+                if (i >= claim_limit)
+                {
+                    return std::nullopt;
+                }
+                /*
+                 * Key is persisted together with the register, when the bucket is written for the first time
+                 */
+                if (__atomic_compare_exchange_n(key_ptr, &cur_key, key, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+                {
+                    return bucket_offset;
+                }
+            }
+            if (cur_key == key)
+            {
+                return bucket_offset;
+            }
+            if (claim_limit > 0)
+            {
+                /*
+                 * Key of the passed bucket may have not been persisted yet by it's owner. If it is lost after
+                 * the crash, probing of lookups would stop before the key, that is inserted by the caller.
+                 */
+                pmem_do_flush(key_ptr, 8);
+            }
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * Seals the bucket, so that it's register can no longer be changed by updates.
+     * @return reference, stored in the register, without SEALED flag.
+     */
+    uint32_t seal_bucket(hash_map_descriptor const& descriptor, uint64_t bucket_offset)
+    {
+        while (true)
+        {
+            const uint32_t ref = read_var(bucket_offset);
+            if ((ref & SEALED_FLAG) != 0)
+            {
+                return ref & ~SEALED_FLAG;
+            }
+            do_helping_cas(bucket_offset, ref, ref | SEALED_FLAG, descriptor.matrix);
+        }
+    }
+
+    /**
+     * Moves bucket of the table to the next table.
+     * @return false, if there is no space for the key in the next table.
+     */
+    bool migrate_bucket(hash_map_descriptor const& descriptor, uint32_t table, uint64_t bucket_offset)
+    {
+        const uint32_t ref = seal_bucket(descriptor, bucket_offset);
+        /*
+         * Key is read after the bucket has been sealed, since empty bucket can be claimed and written
+         * until it is sealed
+         */
+        const uint64_t key = __atomic_load_n(get_key_ptr(bucket_offset), __ATOMIC_SEQ_CST);
+        if (key == 0 || ref == 0)
+        {
+            return true;
+        }
+        const std::optional<uint64_t> new_bucket_offset =
+                find_bucket(descriptor, table + 1, key, descriptor.get_capacity(table + 1));
+        if (!new_bucket_offset.has_value())
+        {
+            return false;
+        }
+        /*
+         * If the key has already been written to the next table, the written value is newer
+         */
+        do_helping_cas(new_bucket_offset.value(), 0, ref, descriptor.matrix);
+        return true;
+    }
+
+    /**
+     * Moves the key from the table to the next table, if it hasn't been moved yet.
+     * @return false, if there is no space for the key in the next table.
+     */
+    bool migrate_key(hash_map_descriptor const& descriptor, uint32_t table, uint64_t key)
+    {
+        const std::optional<uint64_t> bucket_offset = find_bucket(descriptor, table, key, 0);
+        if (!bucket_offset.has_value())
+        {
+            return true;
+        }
+        return migrate_bucket(descriptor, table, bucket_offset.value());
+    }
+
+    /**
+     * Moves all buckets of the table to the next table and makes the next table the oldest one.
+     * @return false, if some key couldn't be moved.
+     */
+    bool finish_migration(hash_map_descriptor const& descriptor, uint32_t table)
+    {
+        for (uint32_t i = 0; i < descriptor.get_capacity(table); i++)
+        {
+            if (!migrate_bucket(descriptor, table, descriptor.get_bucket_offset(table, i)))
+            {
+                return false;
+            }
+        }
+        descriptor.advance_field(OLDEST_TABLE_OFFSET, table, table + 1);
+        return true;
+    }
+
+    /**
+     * Makes room for the key, that cannot be inserted into the active table: finishes migration to the active
+     * table, if it is in progress, otherwise makes the next table active and moves all buckets to it.
+     * @return false, if the map cannot grow.
+     */
+    bool resize(hash_map_descriptor const& descriptor, uint32_t active_table)
+    {
+        const uint32_t oldest_table = descriptor.load_field(OLDEST_TABLE_OFFSET);
+        if (oldest_table < active_table)
+        {
+            return finish_migration(descriptor, oldest_table);
+        }
+        if (active_table + 1 >= descriptor.number_of_tables)
+        {
+            return false;
+        }
+        descriptor.advance_field(ACTIVE_TABLE_OFFSET, active_table, active_table + 1);
+        return finish_migration(descriptor, active_table);
+    }
+
+    /**
+     * Returns active table, after moving the key to it from the previous table, if migration is in progress.
+     * @return active table, or empty optional, if the key couldn't be moved.
+     */
+    std::optional<uint32_t> prepare_active_table(hash_map_descriptor const& descriptor, uint64_t key)
+    {
+        const uint32_t active_table = descriptor.load_field(ACTIVE_TABLE_OFFSET);
+        /*
+         * Active table can grow only after the migration to it has been finished,
+         * therefore only the previous table can contain keys, that haven't been moved
+         */
+        if (descriptor.load_field(OLDEST_TABLE_OFFSET) < active_table &&
+            !migrate_key(descriptor, active_table - 1, key))
+        {
+            return std::nullopt;
+        }
+        return active_table;
+    }
+
+    uint32_t load_node_field(uint32_t node_index, uint32_t field_offset)
+    {
+        const uint8_t* const node = global_non_owning_storage<node_pool>::ptr->get_node(node_index);
+        return __atomic_load_n((const uint32_t*) (node + field_offset), __ATOMIC_SEQ_CST);
+    }
+
+    /**
+     * Initializes allocated node, that is not reachable from the map yet.
+     * @return reference to the node.
+     */
+    uint32_t init_node(uint32_t node_index, uint32_t value)
+    {
+        uint8_t* const node = global_non_owning_storage<node_pool>::ptr->get_node(node_index);
+        const uint32_t incarnation = load_node_field(node_index, INCARNATION_OFFSET) + 1;
+        /*
+         * Incarnation is written before value, so that lookup, that has read the new value, sees the new incarnation
+         */
+        __atomic_store_n((uint32_t*) (node + INCARNATION_OFFSET), incarnation, __ATOMIC_SEQ_CST);
+        __atomic_store_n((uint32_t*) (node + VALUE_OFFSET), value, __ATOMIC_SEQ_CST);
+        pmem_do_flush(node, USED_NODE_SIZE);
+        return make_node_ref(incarnation & INCARNATION_MASK, node_index);
+    }
+
+    /**
+     * Reclaims node, replaced by the update. Concurrent lookups can still read it, therefore it is retired.
+     */
+    void free_replaced_node(uint32_t replaced_ref)
+    {
+        const uint32_t node_index = get_node_index(replaced_ref);
+        if (node_index != 0)
+        {
+            reclaim_node(node_index);
+        }
+    }
+
+    /**
+     * Writes answer of the update, that hasn't installed it's node, and frees the node.
+     */
+    void complete_without_node(uint8_t answer, uint32_t node_index)
+    {
+        write_answer(std::vector<uint8_t>({answer}));
+        global_non_owning_storage<node_pool>::ptr->free_node(node_index);
+    }
+
+    void map_put_common(const uint8_t* args, bool call_recover)
+    {
+        const epoch_guard guard;
+        uint64_t map_offset;
+        std::memcpy(&map_offset, args, 8);
+        uint64_t key;
+        std::memcpy(&key, args + 8, 8);
+        uint32_t value;
+        std::memcpy(&value, args + 16, 4);
+        const hash_map_descriptor descriptor(map_offset);
+
+        uint32_t node_index = 0;
+        std::optional<uint32_t> node_ref;
+        if (call_recover)
+        {
+            if (read_current_answer(1)[0] != PDS_NOT_COMPLETED)
+            {
+                /*
+                 * Answer has already been written
+                 */
+                return;
+            }
+            const operation_state state = parse_operation_state(read_answer(8));
+            if (state.status == 0x1)
+            {
+                /*
+                 * Node has been installed by the last CAS, replaced reference is stored in payload.
+                 * Replaced node is freed only after the answer is written.
+                 */
+                write_answer(std::vector<uint8_t>({MAP_ANSWER_DONE}));
+                free_replaced_node(state.payload);
+                return;
+            }
+            if (state.status == PDS_OUT_OF_NODES)
+            {
+                write_answer(std::vector<uint8_t>({MAP_ANSWER_NO_SPACE}));
+                return;
+            }
+            node_index = state.node_index;
+            if (state.status != PDS_NODE_ALLOCATED && node_index != 0)
+            {
+                /*
+                 * Node has been initialized before the first CAS and hasn't been installed
+                 */
+                node_ref = make_node_ref(load_node_field(node_index, INCARNATION_OFFSET) & INCARNATION_MASK,
+                                         node_index);
+            }
+        }
+
+        if (node_index == 0)
+        {
+            do_call("pds_alloc", nullptr, 0, make_operation_filler(PDS_NOT_COMPLETED, 0, 0), std::nullopt);
+            const operation_state state = parse_operation_state(read_answer(8));
+            if (state.status == PDS_OUT_OF_NODES)
+            {
+                write_answer(std::vector<uint8_t>({MAP_ANSWER_NO_SPACE}));
+                return;
+            }
+            node_index = state.node_index;
+        }
+        if (!node_ref.has_value())
+        {
+            node_ref = init_node(node_index, value);
+        }
+
+        while (true)
+        {
+            const std::optional<uint32_t> active_table = prepare_active_table(descriptor, key);
+            if (!active_table.has_value())
+            {
+                complete_without_node(MAP_ANSWER_NO_SPACE, node_index);
+                return;
+            }
+            const std::optional<uint64_t> bucket_offset =
+                    find_bucket(descriptor, active_table.value(), key, MAX_PROBE);
+            if (!bucket_offset.has_value())
+            {
+                if (!resize(descriptor, active_table.value()))
+                {
+                    complete_without_node(MAP_ANSWER_NO_SPACE, node_index);
+                    return;
+                }
+                continue;
+            }
+            const uint32_t cur_ref = read_var(bucket_offset.value());
+            if ((cur_ref & SEALED_FLAG) != 0)
+            {
+                /*
+                 * Table is no longer active
+                 */
+                continue;
+            }
+            if (do_recoverable_cas(
+                    bucket_offset.value(),
+                    cur_ref,
+                    node_ref.value(),
+                    descriptor.matrix,
+                    node_index,
+                    cur_ref
+            ))
+            {
+                /*
+                 * Answer is written before the node is freed, therefore node is never freed twice
+                 */
+                write_answer(std::vector<uint8_t>({MAP_ANSWER_DONE}));
+                free_replaced_node(cur_ref);
+                return;
+            }
+        }
+    }
+
+    void map_remove_common(const uint8_t* args, bool call_recover)
+    {
+        const epoch_guard guard;
+        uint64_t map_offset;
+        std::memcpy(&map_offset, args, 8);
+        uint64_t key;
+        std::memcpy(&key, args + 8, 8);
+        const hash_map_descriptor descriptor(map_offset);
+
+        if (call_recover)
+        {
+            if (read_current_answer(1)[0] != PDS_NOT_COMPLETED)
+            {
+                return;
+            }
+            if (parse_operation_state(read_answer(8)).status == 0x1)
+            {
+                /*
+                 * Key has been marked as deleted by the last CAS
+                 */
+                write_answer(std::vector<uint8_t>({MAP_ANSWER_DONE}));
+                return;
+            }
+        }
+
+        while (true)
+        {
+            const std::optional<uint32_t> active_table = prepare_active_table(descriptor, key);
+            if (!active_table.has_value())
+            {
+                write_answer(std::vector<uint8_t>({MAP_ANSWER_NO_SPACE}));
+                return;
+            }
+            const std::optional<uint64_t> bucket_offset = find_bucket(descriptor, active_table.value(), key, 0);
+            if (!bucket_offset.has_value())
+            {
+                write_answer(std::vector<uint8_t>({MAP_ANSWER_ABSENT}));
+                return;
+            }
+            const uint32_t cur_ref = read_var(bucket_offset.value());
+            if ((cur_ref & SEALED_FLAG) != 0)
+            {
+                continue;
+            }
+            if (cur_ref == 0 || (cur_ref & DELETED_FLAG) != 0)
+            {
+                write_answer(std::vector<uint8_t>({MAP_ANSWER_ABSENT}));
+                return;
+            }
+            /*
+             * Node of the removed value is kept until the key is updated, therefore deleted reference is unique
+             */
+            if (do_recoverable_cas(bucket_offset.value(), cur_ref, cur_ref | DELETED_FLAG, descriptor.matrix, 0, 0))
+            {
+                write_answer(std::vector<uint8_t>({MAP_ANSWER_DONE}));
+                return;
+            }
+        }
+    }
+
+    void check_key(uint64_t key)
+    {
+        if (key == 0)
+        {
+            throw std::runtime_error("Key 0 is reserved for empty buckets of hash map");
+        }
+    }
+}
+
+uint64_t get_hash_map_size(uint32_t number_of_threads, uint32_t initial_capacity, uint32_t number_of_tables)
+{
+    return CACHE_LINE_SIZE + get_thread_matrix_size(number_of_threads) +
+           (uint64_t) initial_capacity * ((1ull << number_of_tables) - 1) * CACHE_LINE_SIZE;
+}
+
+void init_hash_map(uint64_t map_offset, uint32_t initial_capacity, uint32_t number_of_tables)
+{
+    if (initial_capacity == 0 || (initial_capacity & (initial_capacity - 1)) != 0)
+    {
+        throw std::runtime_error("Initial capacity of hash map must be a power of two");
+    }
+    if (number_of_tables == 0)
+    {
+        throw std::runtime_error("Hash map must contain at least one table");
+    }
+    uint8_t* const header = pptr<uint8_t>(map_offset).get();
+    const uint64_t map_size = get_hash_map_size(
+            global_storage<total_thread_count_holder>::get_const_object().total_thread_count,
+            initial_capacity,
+            number_of_tables
+    );
+    /*
+     * Zero-filled thread matrix, keys and registers of all tables
+     */
+    std::memset(header, 0, map_size);
+    const uint32_t first_table = 0;
+    std::memcpy(header + ACTIVE_TABLE_OFFSET, &first_table, 4);
+    std::memcpy(header + OLDEST_TABLE_OFFSET, &first_table, 4);
+    std::memcpy(header + INITIAL_CAPACITY_OFFSET, &initial_capacity, 4);
+    std::memcpy(header + NUMBER_OF_TABLES_OFFSET, &number_of_tables, 4);
+    pmem_do_flush(header, map_size);
+}
+
+uint8_t hash_map_put(uint64_t map_offset, uint64_t key, uint32_t value)
+{
+    check_key(key);
+    uint8_t args[20];
+    std::memcpy(args, &map_offset, 8);
+    std::memcpy(args + 8, &key, 8);
+    std::memcpy(args + 16, &value, 4);
+    do_call(
+            "map_put",
+            args,
+            20,
+            answer_filler(&PDS_NOT_COMPLETED, 1),
+            make_operation_filler(PDS_NOT_COMPLETED, 0, 0)
+    );
+    return read_answer(1)[0];
+}
+
+uint8_t hash_map_remove(uint64_t map_offset, uint64_t key)
+{
+    check_key(key);
+    uint8_t args[16];
+    std::memcpy(args, &map_offset, 8);
+    std::memcpy(args + 8, &key, 8);
+    do_call(
+            "map_remove",
+            args,
+            16,
+            answer_filler(&PDS_NOT_COMPLETED, 1),
+            make_operation_filler(PDS_NOT_COMPLETED, 0, 0)
+    );
+    return read_answer(1)[0];
+}
+
+std::optional<uint32_t> hash_map_get(uint64_t map_offset, uint64_t key)
+{
+    const epoch_guard guard;
+    const hash_map_descriptor descriptor(map_offset);
+    while (true)
+    {
+        const uint32_t active_table = descriptor.load_field(ACTIVE_TABLE_OFFSET);
+        const uint32_t oldest_table = descriptor.load_field(OLDEST_TABLE_OFFSET);
+        if (oldest_table > active_table)
+        {
+            /*
+             * Map has been resized twice between the reads
+             */
+            continue;
+        }
+        /*
+         * Older table is checked only if the key hasn't been written to the newer one. In such case, the
+         * reference in the older table is current, even if the bucket has already been sealed.
+         */
+        bool retry = false;
+        std::optional<uint32_t> result;
+        for (uint32_t table = active_table + 1; table-- > oldest_table;)
+        {
+            const std::optional<uint64_t> bucket_offset = find_bucket(descriptor, table, key, 0);
+            if (!bucket_offset.has_value())
+            {
+                continue;
+            }
+            const uint32_t ref = read_var(bucket_offset.value()) & ~SEALED_FLAG;
+            if (ref == 0)
+            {
+                continue;
+            }
+            if ((ref & DELETED_FLAG) != 0)
+            {
+                break;
+            }
+            const uint32_t node_index = get_node_index(ref);
+            const uint32_t value = load_node_field(node_index, VALUE_OFFSET);
+            /*
+             * Node could have been replaced, freed and reused, while the value was read
+             */
+            const uint32_t incarnation = load_node_field(node_index, INCARNATION_OFFSET) & INCARNATION_MASK;
+            if (incarnation != (get_node_tag(ref) & INCARNATION_MASK))
+            {
+                retry = true;
+                break;
+            }
+            result = value;
+            break;
+        }
+        if (!retry)
+        {
+            return result;
+        }
+    }
+}
+
+std::vector<uint32_t> get_hash_map_nodes(uint64_t map_offset)
+{
+    const hash_map_descriptor descriptor(map_offset);
+    const uint32_t active_table = descriptor.load_field(ACTIVE_TABLE_OFFSET);
+    const uint32_t oldest_table = descriptor.load_field(OLDEST_TABLE_OFFSET);
+    std::vector<uint32_t> nodes;
+    /*
+     * Just like lookup, older table is taken into account only for keys, that haven't been written to newer ones
+     */
+    std::unordered_set<uint64_t> written_keys;
+    for (uint32_t table = active_table + 1; table-- > oldest_table;)
+    {
+        for (uint32_t bucket = 0; bucket < descriptor.get_capacity(table); bucket++)
+        {
+            const uint64_t bucket_offset = descriptor.get_bucket_offset(table, bucket);
+            const uint64_t key = __atomic_load_n(get_key_ptr(bucket_offset), __ATOMIC_SEQ_CST);
+            if (key == 0)
+            {
+                continue;
+            }
+            const uint32_t ref = read_var(bucket_offset) & ~SEALED_FLAG;
+            if (ref == 0 || !written_keys.insert(key).second)
+            {
+                continue;
+            }
+            nodes.push_back(get_node_index(ref));
+        }
+    }
+    return nodes;
+}
+
+void map_put(const uint8_t* args)
+{
+    map_put_common(args, false);
+}
+
+void map_put_recover(const uint8_t* args)
+{
+    map_put_common(args, true);
+}
+
+void map_remove(const uint8_t* args)
+{
+    map_remove_common(args, false);
+}
+
+void map_remove_recover(const uint8_t* args)
+{
+    map_remove_common(args, true);
+}
@@ -0,0 +1,157 @@
+#ifndef DIPLOM_HASH_MAP_H
+#define DIPLOM_HASH_MAP_H
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/*
+ * Recoverable lock-free hash map from 64-bit keys to 32-bit values, located in the persistent heap.
+ * Map uses open addressing with linear probing. Each bucket occupies a single cache line and contains
+ * RMW register (8 bytes), followed by 8 bytes of key. Key 0 marks empty bucket, therefore it cannot be used.
+ * Key is written to the bucket once, when the bucket is claimed, and is never changed. Since key and register
+ * belong to the same cache line, key is persisted by the flush of the first CAS of the register.
+ *
+ * Value of the register is a reference to a node of node_pool (stored in global_non_owning_storage<node_pool>),
+ * containing value of the key. Reference contains 15 bits of node index, 15 bits of node incarnation and two
+ * flags: DELETED (key has been removed, node still holds the last value) and SEALED (bucket has been moved
+ * to the next table). Reference 0 means, that value has never been written. Since each node is installed
+ * only once per incarnation, all values of all registers of the map are unique (until incarnation wraps around),
+ * therefore all registers share single thread matrix. Update installs new node and frees the replaced one,
+ * remove sets DELETED flag of the current reference without allocation.
+ *
+ * Map consists of descriptor and a sequence of tables, capacity of each next table is twice the capacity
+ * of the previous one. Descriptor contains number of the active table (where all updates are performed),
+ * number of the oldest table, that can contain up-to-date values, initial capacity and number of tables,
+ * followed by the thread matrix. Tables are located right after the descriptor.
+ * If key cannot be inserted into the active table within bounded number of probes, the next table becomes
+ * active (online resize). Buckets of the previous table are moved to the active table lazily (by updates
+ * of the same key) and eagerly (by the thread, that has performed resize, or by any thread, that needs
+ * to resize the active table again): the bucket is sealed, so it can no longer be updated, and it's reference
+ * is copied to the bucket of the same key in the active table, unless the latter has already been written.
+ *
+ * Lookup never writes to NVRAM: it searches the key in the tables from the active one to the oldest one
+ * and validates, that the node hasn't been reused (i.e. it's incarnation hasn't changed) while it's value was read.
+ * Note, that nodes can be leaked, if crash occurs inside pds_alloc or after update has written it's answer,
+ * but before it has freed the replaced node (or it's own node, if it couldn't be installed).
+ */
+
+/**
+ * Answer of update or remove: operation has been performed.
+ */
+extern const uint8_t MAP_ANSWER_DONE;
+
+/**
+ * Answer of remove: key is absent.
+ */
+extern const uint8_t MAP_ANSWER_ABSENT;
+
+/**
+ * Answer of update or remove: there is no space for the key in the map or no free node.
+ */
+extern const uint8_t MAP_ANSWER_NO_SPACE;
+
+/**
+ * Returns size of the map, including descriptor and all tables.
+ * @param number_of_threads - total number of threads.
+ * @param initial_capacity - number of buckets in the first table.
+ * @param number_of_tables - maximal number of tables.
+ * @return size of the map in bytes, multiple of cache line size.
+ */
+uint64_t get_hash_map_size(uint32_t number_of_threads, uint32_t initial_capacity, uint32_t number_of_tables);
+
+/**
+ * Initializes empty map. Must be called before any operation with the map.
+ * @param map_offset - offset of the map from the beginning of the persistent heap, aligned by cache line size.
+ *                     Map occupies get_hash_map_size bytes.
+ * @param initial_capacity - number of buckets in the first table, must be a power of two.
+ * @param number_of_tables - maximal number of tables, must be positive.
+ * @throws std::runtime_error - if initial capacity is not a power of two or number of tables is zero.
+ */
+void init_hash_map(uint64_t map_offset, uint32_t initial_capacity, uint32_t number_of_tables);
+
+/**
+ * Sets value of the key, calling map_put using do_call.
+ * @param map_offset - offset of the map.
+ * @param key - key, must not be 0.
+ * @param value - new value of the key.
+ * @return MAP_ANSWER_DONE or MAP_ANSWER_NO_SPACE.
+ * @throws std::runtime_error - if key is 0.
+ */
+uint8_t hash_map_put(uint64_t map_offset, uint64_t key, uint32_t value);
+
+/**
+ * Removes the key, calling map_remove using do_call.
+ * @param map_offset - offset of the map.
+ * @param key - key, must not be 0.
+ * @return MAP_ANSWER_DONE, MAP_ANSWER_ABSENT or MAP_ANSWER_NO_SPACE.
+ * @throws std::runtime_error - if key is 0.
+ */
+uint8_t hash_map_remove(uint64_t map_offset, uint64_t key);
+
+/**
+ * Returns current value of the key. Doesn't write to NVRAM and doesn't use persistent stack.
+ * @param map_offset - offset of the map.
+ * @param key - key.
+ * @return value of the key, or empty optional, if the key is absent.
+ */
+std::optional<uint32_t> hash_map_get(uint64_t map_offset, uint64_t key);
+
+/**
+ * Returns nodes, that hold current values (or the last values of removed keys) of the map. Node, referenced only
+ * by the bucket of older table, which key has been written to the newer one, is not returned, since it has already
+ * been replaced. Must not be called concurrently with operations of the map.
+ * @param map_offset - offset of descriptor of the map.
+ * @return indices of nodes.
+ */
+std::vector<uint32_t> get_hash_map_nodes(uint64_t map_offset);
+
+/**
+ * Update, that can be called by the system runtime using do_call. Must be called with answer filler {0xFF} and
+ * new answer filler <PDS_NOT_COMPLETED, 0, 0>. Writes 1 byte of answer: MAP_ANSWER_DONE or MAP_ANSWER_NO_SPACE.
+ * Args has the following structure:
+ * <ul>
+ *  <li>
+ *      8 bytes of offset of the map
+ *  </li>
+ *  <li>
+ *      8 bytes of key
+ *  </li>
+ *  <li>
+ *      4 bytes of value
+ *  </li>
+ * </ul>
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void map_put(const uint8_t* args);
+
+/**
+ * Recover version of map_put. Receives the same arguments, as map_put.
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void map_put_recover(const uint8_t* args);
+
+/**
+ * Remove, that can be called by the system runtime using do_call. Must be called with answer filler {0xFF} and
+ * new answer filler <PDS_NOT_COMPLETED, 0, 0>. Writes 1 byte of answer: MAP_ANSWER_DONE, MAP_ANSWER_ABSENT
+ * or MAP_ANSWER_NO_SPACE.
+ * Args has the following structure:
+ * <ul>
+ *  <li>
+ *      8 bytes of offset of the map
+ *  </li>
+ *  <li>
+ *      8 bytes of key
+ *  </li>
+ * </ul>
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void map_remove(const uint8_t* args);
+
+/**
+ * Recover version of map_remove. Receives the same arguments, as map_remove.
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void map_remove_recover(const uint8_t* args);
+
+#endif //DIPLOM_HASH_MAP_H
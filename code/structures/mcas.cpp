@@ -0,0 +1,574 @@
+#include "mcas.h"
+#include "structures_common.h"
+#include "node_pool.h"
+#include "../common/pmem_utils.h"
+#include "../common/constants_and_types.h"
+#include "../common/crash_injection.h"
+#include "../storage/global_storage.h"
+#include "../storage/global_non_owning_storage.h"
+#include "../storage/thread_local_owning_storage.h"
+#include "../persistent_memory/pptr.h"
+#include "../model/cur_thread_id_holder.h"
+#include "../model/total_thread_count_holder.h"
+#include "../runtime/answer.h"
+#include "../runtime/call.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+
+const uint32_t MCAS_MAX_WORDS = 3;
+
+const uint32_t MCAS_DESCRIPTOR_THREAD = std::numeric_limits<uint32_t>::max() - 1;
+
+const uint8_t MCAS_FAILED = 0x0;
+
+const uint8_t MCAS_SUCCEEDED = 0x1;
+
+const uint8_t MCAS_ABORTED = 0x2;
+
+const uint8_t MCAS_OUT_OF_NODES = 0x3;
+
+namespace
+{
+    /**
+     * Status of nested call: mcas_init has initialized the descriptor.
+     */
+    const uint8_t MCAS_DESCRIPTOR_READY = 0x4;
+
+    /*
+     * Statuses of the descriptor. Node, that is not used as descriptor (including zero-filled node), is FREE
+     */
+    const uint16_t STATUS_FREE = 0;
+    const uint16_t STATUS_UNDECIDED = 1;
+    const uint16_t STATUS_SUCCEEDED = 2;
+    const uint16_t STATUS_FAILED = 3;
+    const uint16_t STATUS_ABORTED = 4;
+
+    /*
+     * Layout of the descriptor
+     */
+    const uint32_t WORDS_OFFSET = 8;
+    const uint32_t WORD_SIZE = 16;
+
+    /*
+     * Size of single word in args of mcas
+     */
+    const uint32_t ARGS_WORD_SIZE = 24;
+
+    /**
+     * Thread id of register, that hasn't been changed by cas_internal since initialization or MCAS.
+     */
+    const uint32_t NO_THREAD = std::numeric_limits<uint32_t>::max();
+
+    uint64_t make_register_word(uint32_t thread_number, uint32_t value)
+    {
+        uint64_t word;
+        std::memcpy((uint8_t*) &word, &thread_number, 4);
+        std::memcpy((uint8_t*) &word + 4, &value, 4);
+        return word;
+    }
+
+    uint32_t get_register_thread(uint64_t word)
+    {
+        uint32_t thread_number;
+        std::memcpy(&thread_number, (const uint8_t*) &word, 4);
+        return thread_number;
+    }
+
+    uint32_t get_register_value(uint64_t word)
+    {
+        uint32_t value;
+        std::memcpy(&value, (const uint8_t*) &word + 4, 4);
+        return value;
+    }
+
+    struct descriptor_status
+    {
+        uint32_t tag;
+        uint16_t status;
+        uint16_t number_of_words;
+    };
+
+    uint64_t make_status_word(uint32_t tag, uint16_t status, uint16_t number_of_words)
+    {
+        uint64_t word;
+        std::memcpy((uint8_t*) &word, &tag, 4);
+        std::memcpy((uint8_t*) &word + 4, &status, 2);
+        std::memcpy((uint8_t*) &word + 6, &number_of_words, 2);
+        return word;
+    }
+
+    descriptor_status parse_status_word(uint64_t word)
+    {
+        descriptor_status result{};
+        std::memcpy(&result.tag, (const uint8_t*) &word, 4);
+        std::memcpy(&result.status, (const uint8_t*) &word + 4, 2);
+        std::memcpy(&result.number_of_words, (const uint8_t*) &word + 6, 2);
+        return result;
+    }
+
+    /**
+     * Tag of the descriptor must fit into tag of reference to node.
+     */
+    uint32_t get_next_tag(uint32_t tag)
+    {
+        return get_node_tag(make_node_ref(tag + 1, 0));
+    }
+
+    uint64_t* get_status_ptr(uint32_t node_index)
+    {
+        return (uint64_t*) global_non_owning_storage<node_pool>::ptr->get_node(node_index);
+    }
+
+    std::vector<mcas_word> parse_mcas_args(const uint8_t* args)
+    {
+        std::vector<mcas_word> words(args[0]);
+        for (uint32_t i = 0; i < words.size(); i++)
+        {
+            const uint8_t* const word_args = args + 1 + ARGS_WORD_SIZE * i;
+            std::memcpy(&words[i].var_offset, word_args, 8);
+            std::memcpy(&words[i].thread_matrix_offset, word_args + 8, 8);
+            std::memcpy(&words[i].expected_value, word_args + 16, 4);
+            std::memcpy(&words[i].new_value, word_args + 20, 4);
+        }
+        return words;
+    }
+
+    /**
+     * Returns final value of the register, described by the descriptor, if MCAS is decided, or the value,
+     * that the register has had before the install, if MCAS is undecided.
+     * @param ref - reference to the descriptor, read from the register.
+     * @param var_offset - offset of the register.
+     * @param status - status of the descriptor, read after the reference.
+     * @return value of the register, or empty optional, if the descriptor has been reused since
+     *         the reference has been read (in such case, register no longer contains the reference).
+     */
+    std::optional<uint32_t> get_described_value(uint32_t ref, uint64_t var_offset, descriptor_status const& status)
+    {
+        const uint64_t* const status_ptr = get_status_ptr(get_node_index(ref));
+        const uint32_t* const words = (const uint32_t*) ((const uint8_t*) status_ptr + WORDS_OFFSET);
+        std::optional<uint32_t> result;
+        for (uint32_t i = 0; i < std::min<uint32_t>(status.number_of_words, MCAS_MAX_WORDS); i++)
+        {
+            const uint32_t* const word = words + i * WORD_SIZE / 4;
+            if (__atomic_load_n(word, __ATOMIC_SEQ_CST) == var_offset)
+            {
+                result = __atomic_load_n(word + (status.status == STATUS_SUCCEEDED ? 3 : 2), __ATOMIC_SEQ_CST);
+                break;
+            }
+        }
+        /*
+         * Tag of reused descriptor is changed before it's words, therefore words, that have been read,
+         * belong to the referenced descriptor, if tag is still the same
+         */
+        if (parse_status_word(__atomic_load_n(status_ptr, __ATOMIC_SEQ_CST)).tag != get_node_tag(ref))
+        {
+            return {};
+        }
+        return result;
+    }
+
+    /**
+     * Installs the descriptor to the registers, decides status of MCAS and replaces the registers with their
+     * final values. Can be called again after the crash.
+     * @param node_index - index of the descriptor.
+     * @param tag - tag of the descriptor.
+     * @param words - words of MCAS, sorted by offsets of registers.
+     * @return final status of the descriptor.
+     */
+    uint16_t run_mcas(uint32_t node_index, uint32_t tag, std::vector<mcas_word> const& words)
+    {
+        uint8_t* const heap_base = get_heap_base();
+        uint64_t* const status_ptr = get_status_ptr(node_index);
+        const uint32_t cur_thread_number =
+                thread_local_owning_storage<cur_thread_id_holder>::get_const_object().cur_thread_id;
+        const uint32_t total_thread_number =
+                global_storage<total_thread_count_holder>::get_const_object().total_thread_count;
+        const uint64_t descriptor_word = make_register_word(MCAS_DESCRIPTOR_THREAD, make_node_ref(tag, node_index));
+        const uint64_t undecided = make_status_word(tag, STATUS_UNDECIDED, words.size());
+
+        bool all_installed = true;
+        for (mcas_word const& word : words)
+        {
+            uint64_t* const var = pptr<uint64_t>(word.var_offset).get(heap_base);
+            bool installed = false;
+            while (!installed)
+            {
+                /*
+                 * Status can be changed only by concurrent abort
+                 */
+                if (__atomic_load_n(status_ptr, __ATOMIC_SEQ_CST) != undecided)
+                {
+                    break;
+                }
+                uint64_t cur_word = __atomic_load_n(var, __ATOMIC_SEQ_CST);
+                if (cur_word == descriptor_word)
+                {
+                    /*
+                     * Descriptor has been installed before the crash
+                     */
+                    installed = true;
+                    break;
+                }
+                const uint32_t last_thread_number = get_register_thread(cur_word);
+                if (last_thread_number == MCAS_DESCRIPTOR_THREAD)
+                {
+                    help_mcas(var, cur_word);
+                    continue;
+                }
+                if (get_register_value(cur_word) != word.expected_value)
+                {
+                    uint64_t expected_status = undecided;
+                    __atomic_compare_exchange_n(
+                            status_ptr,
+                            &expected_status,
+                            make_status_word(tag, STATUS_FAILED, words.size()),
+                            false,
+                            __ATOMIC_SEQ_CST,
+                            __ATOMIC_SEQ_CST
+                    );
+                    break;
+                }
+                if (last_thread_number != NO_THREAD)
+                {
+                    /*
+                     * Notify thread, that has performed last successful CAS, just like cas_internal does
+                     */
+                    uint32_t* const thread_matrix = pptr<uint32_t>(word.thread_matrix_offset).get(heap_base);
+                    uint32_t* const notification = thread_matrix + last_thread_number * total_thread_number +
+                                                   cur_thread_number;
+                    __atomic_store_n(notification, get_register_value(cur_word), __ATOMIC_SEQ_CST);
+                    pmem_do_flush(notification, 4, flush_site::CAS_NOTIFICATION);
+                }
+                if (__atomic_compare_exchange_n(
+                        var,
+                        &cur_word,
+                        descriptor_word,
+                        false,
+                        __ATOMIC_SEQ_CST,
+                        __ATOMIC_SEQ_CST
+                ))
+                {
+                    /*
+                     * Install must be durable before status is decided
+                     */
+                    pmem_do_flush(var, 8, flush_site::CAS_VAR);
+                    installed = true;
+                }
+            }
+            if (!installed)
+            {
+                all_installed = false;
+                break;
+            }
+            CRASH_POINT("mcas:after_install");
+        }
+        if (all_installed)
+        {
+            uint64_t expected_status = undecided;
+            __atomic_compare_exchange_n(
+                    status_ptr,
+                    &expected_status,
+                    make_status_word(tag, STATUS_SUCCEEDED, words.size()),
+                    false,
+                    __ATOMIC_SEQ_CST,
+                    __ATOMIC_SEQ_CST
+            );
+        }
+        /*
+         * Status must be durable before any register is replaced with it's final value
+         */
+        pmem_do_flush(status_ptr, 8);
+        CRASH_POINT("mcas:after_decision");
+        const uint16_t status = parse_status_word(__atomic_load_n(status_ptr, __ATOMIC_SEQ_CST)).status;
+
+        for (mcas_word const& word : words)
+        {
+            uint64_t* const var = pptr<uint64_t>(word.var_offset).get(heap_base);
+            uint64_t cur_word = descriptor_word;
+            const uint32_t final_value = status == STATUS_SUCCEEDED ? word.new_value : word.expected_value;
+            if (__atomic_compare_exchange_n(
+                    var,
+                    &cur_word,
+                    make_register_word(NO_THREAD, final_value),
+                    false,
+                    __ATOMIC_SEQ_CST,
+                    __ATOMIC_SEQ_CST
+            ))
+            {
+                pmem_do_flush(var, 8, flush_site::CAS_VAR);
+            }
+        }
+        return status;
+    }
+
+    void mcas_common(const uint8_t* args, bool call_recover)
+    {
+        const std::vector<mcas_word> words = parse_mcas_args(args);
+        uint32_t node_index = 0;
+        std::optional<uint32_t> tag;
+        if (call_recover)
+        {
+            if (read_current_answer(1)[0] != PDS_NOT_COMPLETED)
+            {
+                /*
+                 * Answer has already been written
+                 */
+                return;
+            }
+            const operation_state state = parse_operation_state(read_answer(8));
+            if (state.status == PDS_OUT_OF_NODES)
+            {
+                write_answer(std::vector<uint8_t>({MCAS_OUT_OF_NODES}));
+                return;
+            }
+            if (state.status == MCAS_DESCRIPTOR_READY)
+            {
+                tag = state.payload;
+            }
+            /*
+             * Either descriptor hasn't been allocated yet (and node_index is 0), or it has been allocated,
+             * but mcas_init hasn't completed, or it is ready, and registers can already contain it
+             */
+            node_index = state.node_index;
+        }
+
+        if (node_index == 0)
+        {
+            do_call("pds_alloc", nullptr, 0, make_operation_filler(PDS_NOT_COMPLETED, 0, 0), std::nullopt);
+            const operation_state state = parse_operation_state(read_answer(8));
+            if (state.status == PDS_OUT_OF_NODES)
+            {
+                write_answer(std::vector<uint8_t>({MCAS_OUT_OF_NODES}));
+                return;
+            }
+            node_index = state.node_index;
+        }
+        if (!tag.has_value())
+        {
+            std::vector<uint8_t> init_args(4 + 1 + ARGS_WORD_SIZE * words.size());
+            std::memcpy(init_args.data(), &node_index, 4);
+            std::memcpy(init_args.data() + 4, args, init_args.size() - 4);
+            do_call(
+                    "mcas_init",
+                    init_args.data(),
+                    init_args.size(),
+                    make_operation_filler(PDS_NOT_COMPLETED, node_index, 0),
+                    std::nullopt
+            );
+            tag = parse_operation_state(read_answer(8)).payload;
+        }
+
+        const uint16_t status = run_mcas(node_index, tag.value(), words);
+        uint8_t answer = MCAS_FAILED;
+        if (status == STATUS_SUCCEEDED)
+        {
+            answer = MCAS_SUCCEEDED;
+        }
+        else if (status == STATUS_ABORTED)
+        {
+            answer = MCAS_ABORTED;
+        }
+        write_answer(std::vector<uint8_t>({answer}));
+
+        /*
+         * Answer is written before the descriptor is freed, therefore descriptor is never freed twice.
+         * Tag is kept, so that threads, that have read the reference, can find out, that the descriptor is no longer used
+         */
+        uint64_t* const status_ptr = get_status_ptr(node_index);
+        __atomic_store_n(status_ptr, make_status_word(tag.value(), STATUS_FREE, 0), __ATOMIC_SEQ_CST);
+        pmem_do_flush(status_ptr, 8);
+        global_non_owning_storage<node_pool>::ptr->free_node(node_index);
+    }
+
+    void mcas_init_common(const uint8_t* args)
+    {
+        uint32_t node_index;
+        std::memcpy(&node_index, args, 4);
+        const std::vector<mcas_word> words = parse_mcas_args(args + 4);
+
+        uint64_t* const status_ptr = get_status_ptr(node_index);
+        const uint32_t tag = get_next_tag(parse_status_word(__atomic_load_n(status_ptr, __ATOMIC_SEQ_CST)).tag);
+        /*
+         * Tag is changed before the words (see get_described_value)
+         */
+        __atomic_store_n(status_ptr, make_status_word(tag, STATUS_UNDECIDED, words.size()), __ATOMIC_SEQ_CST);
+        uint32_t* const descriptor_words = (uint32_t*) ((uint8_t*) status_ptr + WORDS_OFFSET);
+        for (uint32_t i = 0; i < words.size(); i++)
+        {
+            uint32_t* const descriptor_word = descriptor_words + i * WORD_SIZE / 4;
+            __atomic_store_n(descriptor_word, (uint32_t) words[i].var_offset, __ATOMIC_SEQ_CST);
+            __atomic_store_n(descriptor_word + 1, (uint32_t) words[i].thread_matrix_offset, __ATOMIC_SEQ_CST);
+            __atomic_store_n(descriptor_word + 2, words[i].expected_value, __ATOMIC_SEQ_CST);
+            __atomic_store_n(descriptor_word + 3, words[i].new_value, __ATOMIC_SEQ_CST);
+        }
+        pmem_do_flush(status_ptr, WORDS_OFFSET + WORD_SIZE * words.size());
+        write_answer(make_operation_state(MCAS_DESCRIPTOR_READY, node_index, tag));
+    }
+}
+
+uint8_t do_mcas(std::vector<mcas_word> words)
+{
+    if (words.empty() || words.size() > MCAS_MAX_WORDS)
+    {
+        throw std::runtime_error("MCAS must change from 1 to " + std::to_string(MCAS_MAX_WORDS) + " registers");
+    }
+    /*
+     * Registers are installed in the same order by all operations
+     */
+    std::sort(words.begin(), words.end(), [](mcas_word const& a, mcas_word const& b)
+    {
+        return a.var_offset < b.var_offset;
+    });
+    for (uint32_t i = 0; i < words.size(); i++)
+    {
+        if (i > 0 && words[i].var_offset == words[i - 1].var_offset)
+        {
+            throw std::runtime_error("Registers of MCAS must be different");
+        }
+        if (words[i].var_offset > std::numeric_limits<uint32_t>::max() ||
+            words[i].thread_matrix_offset > std::numeric_limits<uint32_t>::max())
+        {
+            throw std::runtime_error("Offsets of registers of MCAS must fit into 4 bytes");
+        }
+    }
+
+    std::vector<uint8_t> args(1 + ARGS_WORD_SIZE * words.size());
+    args[0] = words.size();
+    for (uint32_t i = 0; i < words.size(); i++)
+    {
+        uint8_t* const word_args = args.data() + 1 + ARGS_WORD_SIZE * i;
+        std::memcpy(word_args, &words[i].var_offset, 8);
+        std::memcpy(word_args + 8, &words[i].thread_matrix_offset, 8);
+        std::memcpy(word_args + 16, &words[i].expected_value, 4);
+        std::memcpy(word_args + 20, &words[i].new_value, 4);
+    }
+    do_call(
+            "mcas",
+            args.data(),
+            args.size(),
+            answer_filler(&PDS_NOT_COMPLETED, 1),
+            make_operation_filler(PDS_NOT_COMPLETED, 0, 0)
+    );
+    return read_answer(1)[0];
+}
+
+uint32_t read_register_value(const uint64_t* var)
+{
+    while (true)
+    {
+        const uint64_t word = __atomic_load_n(var, __ATOMIC_SEQ_CST);
+        if (get_register_thread(word) != MCAS_DESCRIPTOR_THREAD)
+        {
+            return get_register_value(word);
+        }
+        const uint32_t ref = get_register_value(word);
+        uint64_t* const status_ptr = get_status_ptr(get_node_index(ref));
+        const descriptor_status status = parse_status_word(__atomic_load_n(status_ptr, __ATOMIC_SEQ_CST));
+        if (status.tag != get_node_tag(ref) || status.status == STATUS_FREE)
+        {
+            /*
+             * Register has already been replaced with the final value
+             */
+            continue;
+        }
+        if (status.status == STATUS_SUCCEEDED)
+        {
+            /*
+             * New value can be returned only if it can't be lost after the crash
+             */
+            pmem_do_flush(status_ptr, 8);
+        }
+        const std::optional<uint32_t> value = get_described_value(ref, (const uint8_t*) var - get_heap_base(), status);
+        if (value.has_value())
+        {
+            return value.value();
+        }
+    }
+}
+
+uint64_t read_descriptor_status(uint64_t word)
+{
+    if (get_register_thread(word) != MCAS_DESCRIPTOR_THREAD)
+    {
+        return 0;
+    }
+    return __atomic_load_n(get_status_ptr(get_node_index(get_register_value(word))), __ATOMIC_SEQ_CST);
+}
+
+void help_mcas(uint64_t* var, uint64_t word)
+{
+    const uint32_t ref = get_register_value(word);
+    uint64_t* const status_ptr = get_status_ptr(get_node_index(ref));
+    uint64_t status_word = __atomic_load_n(status_ptr, __ATOMIC_SEQ_CST);
+    descriptor_status status = parse_status_word(status_word);
+    if (status.tag != get_node_tag(ref) || status.status == STATUS_FREE)
+    {
+        return;
+    }
+    if (status.status == STATUS_UNDECIDED)
+    {
+        const uint64_t aborted = make_status_word(status.tag, STATUS_ABORTED, status.number_of_words);
+        if (__atomic_compare_exchange_n(status_ptr, &status_word, aborted, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+        {
+            status_word = aborted;
+        }
+        /*
+         * If the abort has failed, status_word contains the status, decided by the owner
+         */
+        status = parse_status_word(status_word);
+        if (status.tag != get_node_tag(ref) || status.status == STATUS_FREE)
+        {
+            return;
+        }
+    }
+    pmem_do_flush(status_ptr, 8);
+
+    const std::optional<uint32_t> final_value =
+            get_described_value(ref, (const uint8_t*) var - get_heap_base(), status);
+    if (!final_value.has_value())
+    {
+        return;
+    }
+    uint64_t expected_word = word;
+    if (__atomic_compare_exchange_n(
+            var,
+            &expected_word,
+            make_register_word(NO_THREAD, final_value.value()),
+            false,
+            __ATOMIC_SEQ_CST,
+            __ATOMIC_SEQ_CST
+    ))
+    {
+        pmem_do_flush(var, 8, flush_site::CAS_VAR);
+    }
+}
+
+void mcas(const uint8_t* args)
+{
+    mcas_common(args, false);
+}
+
+void mcas_recover(const uint8_t* args)
+{
+    mcas_common(args, true);
+}
+
+void mcas_init(const uint8_t* args)
+{
+    mcas_init_common(args);
+}
+
+void mcas_init_recover(const uint8_t* args)
+{
+    if (read_current_answer(1)[0] != PDS_NOT_COMPLETED)
+    {
+        /*
+         * Answer has already been written
+         */
+        return;
+    }
+    mcas_init_common(args);
+}
@@ -0,0 +1,165 @@
+#ifndef DIPLOM_MCAS_H
+#define DIPLOM_MCAS_H
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * Recoverable multi-word CAS (in the style of PMwCAS), which atomically changes values of up to MCAS_MAX_WORDS
+ * RMW registers, located in the persistent heap. Registers must be modified only by cas_internal and MCAS.
+ *
+ * Operation is described by descriptor, which is a node of node_pool (stored in global_non_owning_storage<node_pool>)
+ * and contains:
+ * <ul>
+ *  <li>
+ *      8 bytes of status word: 4 bytes of tag of the descriptor, 2 bytes of status and 2 bytes of number of words
+ *  </li>
+ *  <li>
+ *      For each word: 4 bytes of offset of the register, 4 bytes of offset of it's thread matrix, 4 bytes of expected
+ *      value and 4 bytes of new value. Words are sorted by offsets of the registers.
+ *  </li>
+ * </ul>
+ * Tag is incremented each time the node is used as descriptor, therefore all references to the descriptor
+ * <tag, node index> are unique (until the tag wraps around).
+ *
+ * Owner of the descriptor installs it to the registers one by one in ascending order of their offsets: register,
+ * containing expected value, is replaced with <MCAS_DESCRIPTOR_THREAD, reference to the descriptor>, and the install
+ * is flushed. Before the install, thread, that has written the replaced value, is notified through the thread matrix,
+ * just like cas_internal does. Once all registers are installed, owner changes status from UNDECIDED to SUCCEEDED,
+ * or to FAILED, if some register doesn't contain expected value. Status is flushed, and then each register is
+ * replaced with <no thread, new value> (if MCAS has succeeded) or <no thread, expected value> (otherwise).
+ *
+ * Only the owner installs the descriptor. Any other thread, that needs to modify register, containing descriptor
+ * (cas_internal or other MCAS), helps it: if status is UNDECIDED, it aborts MCAS (changes status to ABORTED),
+ * flushes status and replaces the register with it's final value. Therefore MCAS can fail spuriously
+ * (with MCAS_ABORTED answer) because of concurrent operations with the same registers, and should be retried
+ * in such case. Reads (see read_register_value) never write to registers: logical value of register, containing
+ * descriptor, is new value, if status is SUCCEEDED, and expected value otherwise.
+ *
+ * After the crash, owner finds index and tag of the descriptor in the answer memory of it's frame and either
+ * continues installation (if status is still UNDECIDED) or replaces registers with their final values.
+ * Note, that descriptor can be leaked, if crash occurs inside pds_alloc or after MCAS has written it's answer,
+ * but before it has freed the descriptor.
+ */
+
+/**
+ * Maximal number of registers, that can be changed by single MCAS.
+ */
+extern const uint32_t MCAS_MAX_WORDS;
+
+/**
+ * Thread id, which is written to RMW register together with reference to descriptor of MCAS.
+ */
+extern const uint32_t MCAS_DESCRIPTOR_THREAD;
+
+/**
+ * Answer of MCAS: some register didn't contain expected value.
+ */
+extern const uint8_t MCAS_FAILED;
+
+/**
+ * Answer of MCAS: all registers have been changed.
+ */
+extern const uint8_t MCAS_SUCCEEDED;
+
+/**
+ * Answer of MCAS: operation has been aborted by concurrent operation, it can be retried.
+ */
+extern const uint8_t MCAS_ABORTED;
+
+/**
+ * Answer of MCAS: descriptor couldn't be allocated.
+ */
+extern const uint8_t MCAS_OUT_OF_NODES;
+
+/**
+ * Single word of MCAS.
+ */
+struct mcas_word
+{
+    /**
+     * Offset of RMW register from the beginning of the persistent heap.
+     */
+    uint64_t var_offset;
+    /**
+     * Offset of thread matrix of the register.
+     */
+    uint64_t thread_matrix_offset;
+    uint32_t expected_value;
+    uint32_t new_value;
+};
+
+/**
+ * Performs recoverable MCAS, calling mcas using do_call.
+ * @param words - words of MCAS, registers of which must be different.
+ * @return MCAS_SUCCEEDED, MCAS_FAILED, MCAS_ABORTED or MCAS_OUT_OF_NODES.
+ * @throws std::runtime_error - if number of words is zero or greater than MCAS_MAX_WORDS, registers are
+ *                              not different, or some offset doesn't fit into 4 bytes.
+ */
+uint8_t do_mcas(std::vector<mcas_word> words);
+
+/**
+ * Returns logical value of RMW register. If register contains descriptor of MCAS, value is determined by the status
+ * of the descriptor (status is flushed, if MCAS has succeeded). Doesn't write to registers.
+ * @param var - pointer to the register.
+ * @return value of the register.
+ */
+uint32_t read_register_value(const uint64_t* var);
+
+/**
+ * Returns status word of the descriptor, referenced by the word of RMW register. Status word changes each time
+ * the descriptor is decided or reused, therefore it can be used to detect changes of logical value of register,
+ * that contains the descriptor. Doesn't write to NVRAM.
+ * @param word - word, read from the register.
+ * @return status word of the descriptor, or 0, if the word doesn't contain descriptor.
+ */
+uint64_t read_descriptor_status(uint64_t word);
+
+/**
+ * Helps MCAS, descriptor of which has been read from the register: aborts it, if it is undecided, and replaces
+ * the register with it's final value. After return, register no longer contains the descriptor.
+ * @param var - pointer to the register.
+ * @param word - <MCAS_DESCRIPTOR_THREAD, reference to the descriptor>, read from the register.
+ */
+void help_mcas(uint64_t* var, uint64_t word);
+
+/**
+ * MCAS, that can be called by the system runtime using do_call. Must be called with answer filler
+ * {PDS_NOT_COMPLETED} and new answer filler <PDS_NOT_COMPLETED, 0, 0>. Writes 1 byte of answer: MCAS_SUCCEEDED,
+ * MCAS_FAILED, MCAS_ABORTED or MCAS_OUT_OF_NODES.
+ * Args has the following structure:
+ * <ul>
+ *  <li>
+ *      1 byte of number of words
+ *  </li>
+ *  <li>
+ *      For each word (in ascending order of offsets of registers): 8 bytes of offset of the register, 8 bytes
+ *      of offset of it's thread matrix, 4 bytes of expected value and 4 bytes of new value
+ *  </li>
+ * </ul>
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void mcas(const uint8_t* args);
+
+/**
+ * Recover version of mcas. Receives the same arguments, as mcas.
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void mcas_recover(const uint8_t* args);
+
+/**
+ * Initializes descriptor of MCAS, which is called by mcas using do_call. Writes 8 bytes of answer:
+ * <descriptor is ready, node index, tag> (see make_operation_state).
+ * Args contain 4 bytes of index of the node, followed by arguments of mcas.
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void mcas_init(const uint8_t* args);
+
+/**
+ * Recover version of mcas_init. If answer has already been written, does nothing. Otherwise, since no register
+ * can contain the descriptor yet, initializes it again.
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void mcas_init_recover(const uint8_t* args);
+
+#endif //DIPLOM_MCAS_H
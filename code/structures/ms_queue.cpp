@@ -0,0 +1,402 @@
+#include "ms_queue.h"
+#include "structures_common.h"
+#include "node_pool.h"
+#include "epoch_manager.h"
+#include "../common/pmem_utils.h"
+#include "../common/constants_and_types.h"
+#include "../storage/global_storage.h"
+#include "../storage/global_non_owning_storage.h"
+#include "../model/total_thread_count_holder.h"
+#include "../runtime/answer.h"
+#include "../runtime/call.h"
+#include "../runtime/exec_task.h"
+#include <cstring>
+
+namespace
+{
+    /*
+     * Offsets of fields of the node
+     */
+    const uint32_t NEXT_OFFSET = 0;
+    const uint32_t VALUE_OFFSET = 8;
+    const uint32_t INCARNATION_OFFSET = 12;
+    const uint32_t LINKED_TAG_OFFSET = 16;
+    const uint32_t USED_NODE_SIZE = 20;
+
+    /**
+     * Offsets of registers and thread matrices of the descriptor.
+     */
+    struct ms_queue_descriptor
+    {
+        uint64_t head;
+        uint64_t head_matrix;
+        uint64_t tail;
+        uint64_t tail_matrix;
+        uint64_t next_matrix;
+
+        explicit ms_queue_descriptor(uint64_t queue_offset)
+        {
+            const uint64_t matrix_size = get_thread_matrix_size(
+                    global_storage<total_thread_count_holder>::get_const_object().total_thread_count
+            );
+            head = queue_offset;
+            head_matrix = head + CACHE_LINE_SIZE;
+            tail = head_matrix + matrix_size;
+            tail_matrix = tail + CACHE_LINE_SIZE;
+            next_matrix = tail_matrix + matrix_size;
+        }
+    };
+
+    uint32_t load_node_field(uint32_t node_index, uint32_t field_offset)
+    {
+        const uint8_t* const node = global_non_owning_storage<node_pool>::ptr->get_node(node_index);
+        return __atomic_load_n((const uint32_t*) (node + field_offset), __ATOMIC_SEQ_CST);
+    }
+
+    /**
+     * Initializes allocated node, that is not reachable from the queue yet.
+     * @return new incarnation of the node.
+     */
+    uint32_t init_node(uint32_t node_index, uint32_t value)
+    {
+        uint8_t* const node = global_non_owning_storage<node_pool>::ptr->get_node(node_index);
+        const uint32_t incarnation = load_node_field(node_index, INCARNATION_OFFSET) + 1;
+        __atomic_store_n((uint32_t*) (node + VALUE_OFFSET), value, __ATOMIC_SEQ_CST);
+        __atomic_store_n((uint32_t*) (node + INCARNATION_OFFSET), incarnation, __ATOMIC_SEQ_CST);
+        __atomic_store_n(
+                (uint32_t*) (node + LINKED_TAG_OFFSET),
+                get_node_tag(make_node_ref(incarnation - 1, 0)),
+                __ATOMIC_SEQ_CST
+        );
+        pmem_do_flush(node + VALUE_OFFSET, USED_NODE_SIZE - VALUE_OFFSET);
+        /*
+         * Flushes next register
+         */
+        init_register(global_non_owning_storage<node_pool>::ptr->get_node_offset(node_index) + NEXT_OFFSET,
+                      make_node_ref(incarnation, 0));
+        return incarnation;
+    }
+
+    /**
+     * Returns true, if node of specified incarnation has been linked to the queue.
+     * Must be called only after linking CAS has failed or it's result is unknown.
+     */
+    bool is_linked(uint32_t node_index, uint32_t incarnation)
+    {
+        if (load_node_field(node_index, INCARNATION_OFFSET) != incarnation)
+        {
+            /*
+             * Node has been freed and reused, therefore it had been linked and dequeued
+             */
+            return true;
+        }
+        return load_node_field(node_index, LINKED_TAG_OFFSET) == get_node_tag(make_node_ref(incarnation, 0));
+    }
+
+    /**
+     * Marks node as linked, writing tag of reference to the node to it's linked tag.
+     */
+    void mark_linked(uint32_t node_ref)
+    {
+        uint8_t* const node = global_non_owning_storage<node_pool>::ptr->get_node(get_node_index(node_ref));
+        /*
+         * Tag can be changed only from the initial value of the same incarnation, therefore delayed thread
+         * cannot mark the node, if it has already been reused
+         */
+        uint32_t unlinked_tag = get_node_tag(make_node_ref(get_node_tag(node_ref) - 1, 0));
+        __atomic_compare_exchange_n(
+                (uint32_t*) (node + LINKED_TAG_OFFSET),
+                &unlinked_tag,
+                get_node_tag(node_ref),
+                false,
+                __ATOMIC_SEQ_CST,
+                __ATOMIC_SEQ_CST
+        );
+        pmem_do_flush(node + LINKED_TAG_OFFSET, 4);
+    }
+
+    /**
+     * Moves tail from the node, referenced by tail_ref, to the next node, marking the next node as linked.
+     */
+    void help_move_tail(ms_queue_descriptor const& descriptor, uint32_t tail_ref, uint32_t next_ref)
+    {
+        const uint32_t next_index = get_node_index(next_ref);
+        mark_linked(next_ref);
+        do_helping_cas(
+                descriptor.tail,
+                tail_ref,
+                make_node_ref(get_node_tag(tail_ref) + 1, next_index),
+                descriptor.tail_matrix
+        );
+    }
+
+    void ms_enqueue_common(const uint8_t* args, bool call_recover)
+    {
+        /*
+         * Dequeued dummy nodes are retired, so the tail and it's next link stay readable
+         */
+        const epoch_guard guard;
+        uint64_t queue_offset;
+        std::memcpy(&queue_offset, args, 8);
+        uint32_t value;
+        std::memcpy(&value, args + 8, 4);
+        const ms_queue_descriptor descriptor(queue_offset);
+        node_pool* const pool = global_non_owning_storage<node_pool>::ptr;
+
+        uint32_t node_index = 0;
+        uint32_t incarnation = 0;
+        bool initialized = false;
+        if (call_recover)
+        {
+            if (read_current_answer(1)[0] != PDS_NOT_COMPLETED)
+            {
+                /*
+                 * Answer has already been written
+                 */
+                return;
+            }
+            const operation_state state = parse_operation_state(read_answer(8));
+            if (state.status == 0x1)
+            {
+                /*
+                 * Node has been linked by the last CAS. Tail will be moved by other operations.
+                 */
+                write_answer(std::vector<uint8_t>({0x1}));
+                return;
+            }
+            if (state.status == PDS_OUT_OF_NODES)
+            {
+                write_answer(std::vector<uint8_t>({0x0}));
+                return;
+            }
+            node_index = state.node_index;
+            if (state.status != PDS_NODE_ALLOCATED && node_index != 0)
+            {
+                /*
+                 * Node has been initialized, incarnation of the node is stored in payload.
+                 * If the last CAS failed, it could have been performed before the crash and then overwritten
+                 * (see ms_queue.h).
+                 */
+                incarnation = state.payload;
+                initialized = true;
+                if (state.status == 0x0 && is_linked(node_index, incarnation))
+                {
+                    write_answer(std::vector<uint8_t>({0x1}));
+                    return;
+                }
+            }
+        }
+
+        if (node_index == 0)
+        {
+            do_call("pds_alloc", nullptr, 0, make_operation_filler(PDS_NOT_COMPLETED, 0, 0), std::nullopt);
+            const operation_state state = parse_operation_state(read_answer(8));
+            if (state.status == PDS_OUT_OF_NODES)
+            {
+                write_answer(std::vector<uint8_t>({0x0}));
+                return;
+            }
+            node_index = state.node_index;
+        }
+        if (!initialized)
+        {
+            incarnation = init_node(node_index, value);
+        }
+
+        const uint32_t node_ref = make_node_ref(incarnation, node_index);
+        while (true)
+        {
+            const uint32_t tail_ref = read_var(descriptor.tail);
+            const uint32_t tail_index = get_node_index(tail_ref);
+            const uint64_t tail_next_offset = pool->get_node_offset(tail_index) + NEXT_OFFSET;
+            const uint32_t next_ref = read_var(tail_next_offset);
+            if (tail_ref != read_var(descriptor.tail))
+            {
+                continue;
+            }
+            if (get_node_index(next_ref) != 0)
+            {
+                /*
+                 * Tail is lagging behind
+                 */
+                help_move_tail(descriptor, tail_ref, next_ref);
+                continue;
+            }
+            if (do_recoverable_cas(
+                    tail_next_offset,
+                    next_ref,
+                    node_ref,
+                    descriptor.next_matrix,
+                    node_index,
+                    incarnation
+            ))
+            {
+                help_move_tail(descriptor, tail_ref, node_ref);
+                break;
+            }
+        }
+        write_answer(std::vector<uint8_t>({0x1}));
+    }
+
+    void ms_dequeue_common(const uint8_t* args, bool call_recover)
+    {
+        const epoch_guard guard;
+        uint64_t queue_offset;
+        std::memcpy(&queue_offset, args, 8);
+        const ms_queue_descriptor descriptor(queue_offset);
+        node_pool* const pool = global_non_owning_storage<node_pool>::ptr;
+
+        if (call_recover)
+        {
+            if (read_current_answer(1)[0] != PDS_NOT_COMPLETED)
+            {
+                return;
+            }
+            const operation_state state = parse_operation_state(read_answer(8));
+            if (state.status == 0x1)
+            {
+                /*
+                 * Head has been moved by the last CAS. Previous dummy node hasn't been freed yet,
+                 * since it is freed only after the answer is written.
+                 */
+                write_answer(make_operation_state(0x1, 0, state.payload));
+                reclaim_node(state.node_index);
+                return;
+            }
+        }
+
+        while (true)
+        {
+            const uint32_t head_ref = read_var(descriptor.head);
+            const uint32_t tail_ref = read_var(descriptor.tail);
+            const uint32_t head_index = get_node_index(head_ref);
+            const uint32_t next_ref = read_var(pool->get_node_offset(head_index) + NEXT_OFFSET);
+            if (head_ref != read_var(descriptor.head))
+            {
+                continue;
+            }
+            const uint32_t next_index = get_node_index(next_ref);
+            if (head_index == get_node_index(tail_ref))
+            {
+                if (next_index == 0)
+                {
+                    write_answer(std::vector<uint8_t>({0x0}));
+                    return;
+                }
+                /*
+                 * Head cannot pass the tail
+                 */
+                help_move_tail(descriptor, tail_ref, next_ref);
+                continue;
+            }
+            if (next_index == 0)
+            {
+                continue;
+            }
+            /*
+             * Next node can be dequeued and reused concurrently, in such case CAS fails, because tag of the head
+             * has been changed
+             */
+            const uint32_t value = load_node_field(next_index, VALUE_OFFSET);
+            if (do_recoverable_cas(
+                    descriptor.head,
+                    head_ref,
+                    make_node_ref(get_node_tag(head_ref) + 1, next_index),
+                    descriptor.head_matrix,
+                    head_index,
+                    value
+            ))
+            {
+                /*
+                 * Answer is written before the node is freed, therefore node is never freed twice
+                 */
+                write_answer(make_operation_state(0x1, 0, value));
+                reclaim_node(head_index);
+                return;
+            }
+        }
+    }
+}
+
+uint64_t get_ms_queue_size(uint32_t number_of_threads)
+{
+    return 2 * CACHE_LINE_SIZE + 3 * get_thread_matrix_size(number_of_threads);
+}
+
+void init_ms_queue(uint64_t queue_offset)
+{
+    const ms_queue_descriptor descriptor(queue_offset);
+    const uint32_t dummy_index = global_non_owning_storage<node_pool>::ptr->allocate_node();
+    const uint32_t incarnation = init_node(dummy_index, 0);
+    mark_linked(make_node_ref(incarnation, dummy_index));
+    init_register(descriptor.head, make_node_ref(0, dummy_index));
+    init_register(descriptor.tail, make_node_ref(0, dummy_index));
+}
+
+bool ms_queue_enqueue(uint64_t queue_offset, uint32_t value)
+{
+    uint8_t args[12];
+    std::memcpy(args, &queue_offset, 8);
+    std::memcpy(args + 8, &value, 4);
+    do_call(
+            "ms_enqueue",
+            args,
+            12,
+            answer_filler(&PDS_NOT_COMPLETED, 1),
+            make_operation_filler(PDS_NOT_COMPLETED, 0, 0)
+    );
+    return read_answer(1)[0] == 0x1;
+}
+
+std::optional<uint32_t> ms_queue_dequeue(uint64_t queue_offset)
+{
+    uint8_t args[8];
+    std::memcpy(args, &queue_offset, 8);
+    do_call(
+            "ms_dequeue",
+            args,
+            8,
+            answer_filler(&PDS_NOT_COMPLETED, 1),
+            make_operation_filler(PDS_NOT_COMPLETED, 0, 0)
+    );
+    const std::vector<uint8_t> answer = read_answer(8);
+    if (answer[0] != 0x1)
+    {
+        return std::nullopt;
+    }
+    return parse_operation_state(answer).payload;
+}
+
+std::vector<uint32_t> get_ms_queue_nodes(uint64_t queue_offset)
+{
+    const ms_queue_descriptor descriptor(queue_offset);
+    node_pool* const pool = global_non_owning_storage<node_pool>::ptr;
+    std::vector<uint32_t> nodes;
+    uint32_t cur = get_node_index(read_var(descriptor.head));
+    while (cur != 0)
+    {
+        nodes.push_back(cur);
+        cur = get_node_index(read_var(pool->get_node_offset(cur) + NEXT_OFFSET));
+    }
+    return nodes;
+}
+
+void ms_enqueue(const uint8_t* args)
+{
+    ms_enqueue_common(args, false);
+}
+
+void ms_enqueue_recover(const uint8_t* args)
+{
+    ms_enqueue_common(args, true);
+}
+
+void ms_dequeue(const uint8_t* args)
+{
+    ms_dequeue_common(args, false);
+}
+
+void ms_dequeue_recover(const uint8_t* args)
+{
+    ms_dequeue_common(args, true);
+}
@@ -0,0 +1,115 @@
+#ifndef DIPLOM_MS_QUEUE_H
+#define DIPLOM_MS_QUEUE_H
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/*
+ * Recoverable lock-free Michael-Scott queue, located in the persistent heap. Queue consists of descriptor and nodes,
+ * allocated from node_pool (stored in global_non_owning_storage<node_pool>). First node of the queue is a dummy node.
+ * Descriptor is located at offset, aligned by cache line size, and contains:
+ * <ul>
+ *  <li>
+ *      RMW register with reference to the head (see structures_common.h), followed by it's thread matrix
+ *  </li>
+ *  <li>
+ *      RMW register with reference to the tail, followed by it's thread matrix
+ *  </li>
+ *  <li>
+ *      Thread matrix, shared by next registers of all nodes
+ *  </li>
+ * </ul>
+ * Node contains RMW register with reference to the next node (8 bytes), 4 bytes of value, 4 bytes of incarnation
+ * (number of times the node was allocated) and 4 bytes of linked tag. Null reference to the next node contains
+ * incarnation as tag, therefore next register of reused node never contains it's previous values.
+ *
+ * Enqueue and dequeue are detectable. Since next register of the node is overwritten, when the node is reused,
+ * enqueue cannot detect success of linking CAS by the register alone. Instead, each thread, that moves the tail
+ * to the node, first writes tag of reference to the node (i.e. it's incarnation) to the linked tag.
+ * Node can be freed only after head has passed it, and head can pass the node only after tail has passed it,
+ * therefore if the next register of the predecessor was overwritten, either the node is marked as linked,
+ * or it has been reused and has another incarnation.
+ * Tail is moved using CAS without a frame (do_helping_cas), because any thread can complete the move.
+ * Note, that nodes can be leaked, if crash occurs inside pds_alloc or after dequeue has written it's answer,
+ * but before it has freed the previous dummy node.
+ */
+
+/**
+ * Returns size of descriptor of the queue.
+ * @param number_of_threads - total number of threads.
+ * @return size of descriptor in bytes, multiple of cache line size.
+ */
+uint64_t get_ms_queue_size(uint32_t number_of_threads);
+
+/**
+ * Initializes empty queue: allocates dummy node and points both head and tail to it. Must be called
+ * before any operation with the queue.
+ * @param queue_offset - offset of descriptor of the queue from the beginning of the persistent heap,
+ *                       aligned by cache line size. Thread matrices of the descriptor must be zero-filled.
+ * @throws std::runtime_error - if dummy node cannot be allocated.
+ */
+void init_ms_queue(uint64_t queue_offset);
+
+/**
+ * Enqueues value to the queue, calling ms_enqueue using do_call.
+ * @param queue_offset - offset of descriptor of the queue.
+ * @param value - value to enqueue.
+ * @return true, if value was enqueued, false, if node couldn't be allocated.
+ */
+bool ms_queue_enqueue(uint64_t queue_offset, uint32_t value);
+
+/**
+ * Dequeues value from the queue, calling ms_dequeue using do_call.
+ * @param queue_offset - offset of descriptor of the queue.
+ * @return value from the head of the queue, or empty optional, if the queue was empty.
+ */
+std::optional<uint32_t> ms_queue_dequeue(uint64_t queue_offset);
+
+/**
+ * Returns nodes of the queue, including the dummy node. Must not be called concurrently with operations
+ * of the queue.
+ * @param queue_offset - offset of descriptor of the queue.
+ * @return indices of nodes from the head to the tail of the queue.
+ */
+std::vector<uint32_t> get_ms_queue_nodes(uint64_t queue_offset);
+
+/**
+ * Enqueue, that can be called by the system runtime using do_call. Must be called with answer filler {0xFF} and
+ * new answer filler <PDS_NOT_COMPLETED, 0, 0>. Writes 1 byte of answer: 0x1, if value was enqueued, 0x0,
+ * if node couldn't be allocated.
+ * Args has the following structure:
+ * <ul>
+ *  <li>
+ *      8 bytes of offset of descriptor of the queue
+ *  </li>
+ *  <li>
+ *      4 bytes of value
+ *  </li>
+ * </ul>
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void ms_enqueue(const uint8_t* args);
+
+/**
+ * Recover version of ms_enqueue. Receives the same arguments, as ms_enqueue.
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void ms_enqueue_recover(const uint8_t* args);
+
+/**
+ * Dequeue, that can be called by the system runtime using do_call. Must be called with answer filler {0xFF} and
+ * new answer filler <PDS_NOT_COMPLETED, 0, 0>. Writes 8 bytes of answer <0x1, 0, value>, if value was dequeued,
+ * or 1 byte of answer 0x0, if the queue was empty.
+ * Args contain 8 bytes of offset of descriptor of the queue.
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void ms_dequeue(const uint8_t* args);
+
+/**
+ * Recover version of ms_dequeue. Receives the same arguments, as ms_dequeue.
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void ms_dequeue_recover(const uint8_t* args);
+
+#endif //DIPLOM_MS_QUEUE_H
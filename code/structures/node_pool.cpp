@@ -0,0 +1,83 @@
+#include "node_pool.h"
+#include "../common/constants_and_types.h"
+#include <stdexcept>
+#include <string>
+
+const uint32_t node_pool::NODE_SIZE = 64;
+
+const uint64_t node_pool::MAX_NODES = (1u << 15) - 1;
+
+namespace
+{
+    uint64_t check_node_pool_params(uint64_t region_offset, uint64_t max_nodes)
+    {
+        if (region_offset % CACHE_LINE_SIZE != 0)
+        {
+            throw std::runtime_error("Region of nodes must be aligned by cache line size");
+        }
+        if (max_nodes > node_pool::MAX_NODES)
+        {
+            throw std::runtime_error(
+                    "Pool cannot contain more than " + std::to_string(node_pool::MAX_NODES) + " nodes"
+            );
+        }
+        return max_nodes;
+    }
+}
+
+node_pool::node_pool(uint8_t* _heap_ptr, uint64_t _region_offset, uint64_t max_nodes, bool init_new) :
+        heap_ptr(_heap_ptr),
+        region_offset(_region_offset),
+        allocator(
+                _heap_ptr + _region_offset,
+                NODE_SIZE - 1,
+                check_node_pool_params(_region_offset, max_nodes),
+                init_new
+        )
+{}
+
+uint32_t node_pool::allocate_node()
+{
+    return (allocator.pmem_alloc() - get_node(0)) / NODE_SIZE;
+}
+
+void node_pool::free_node(uint32_t node_index)
+{
+    allocator.pmem_free(get_node(node_index));
+}
+
+void node_pool::free_nodes(std::vector<uint32_t> const& node_indices)
+{
+    std::vector<uint8_t*> nodes;
+    nodes.reserve(node_indices.size());
+    for (const uint32_t node_index : node_indices)
+    {
+        nodes.push_back(get_node(node_index));
+    }
+    allocator.pmem_free_batch(nodes);
+}
+
+void node_pool::retire_node(uint32_t node_index)
+{
+    allocator.pmem_retire(get_node(node_index));
+}
+
+bool node_pool::is_allocated(uint32_t node_index)
+{
+    return allocator.is_allocated(get_node(node_index));
+}
+
+uint8_t* node_pool::get_node(uint32_t node_index) const
+{
+    return heap_ptr + get_node_offset(node_index);
+}
+
+uint64_t node_pool::get_node_offset(uint32_t node_index) const
+{
+    return region_offset + (uint64_t) node_index * NODE_SIZE;
+}
+
+pmem_allocator& node_pool::get_allocator()
+{
+    return allocator;
+}
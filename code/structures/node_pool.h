@@ -0,0 +1,102 @@
+#ifndef DIPLOM_NODE_POOL_H
+#define DIPLOM_NODE_POOL_H
+
+#include <cstdint>
+#include <vector>
+#include "../allocation/pmem_allocator.h"
+
+/**
+ * Pool of nodes of persistent data structures, located in the persistent heap. Each node is a block
+ * of pmem_allocator, which, together with it's allocation marker, occupies exactly one cache line,
+ * therefore the first 8 bytes of each node can be used as RMW register.
+ * Nodes are identified by indices (index of allocator block), which fit into 15 bits, so that reference
+ * to a node together with version tag fits into the value of single RMW register.
+ * Index 0 is never given to user (first block of the allocator is reserved), therefore it is used as null reference.
+ * Since there should be only one pool in the system, it is proposed to use this class with
+ * global_non_owning_storage<T>.
+ */
+struct node_pool
+{
+public:
+    /**
+     * Size of the node, including allocation marker (last byte of the node).
+     */
+    static const uint32_t NODE_SIZE;
+
+    /**
+     * Maximal number of nodes, indices of which can be encoded in 15 bits.
+     */
+    static const uint64_t MAX_NODES;
+
+    /**
+     * Initializes pool. If init_new is true, initializes new pool, otherwise restores state of the pool
+     * before the crash (or end of the work).
+     * @param _heap_ptr - pointer to the beginning of the persistent heap.
+     * @param _region_offset - offset of the region of nodes from the beginning of the heap, aligned by cache line size.
+     * @param max_nodes - maximal number of nodes, not greater than MAX_NODES. Region should contain
+     *                    max_nodes + 1 nodes.
+     * @param init_new - if true, initializes pool from the ground up, otherwise restores pool state.
+     * @throws std::runtime_error - if region offset is not aligned or max_nodes is greater than MAX_NODES.
+     */
+    node_pool(uint8_t* _heap_ptr, uint64_t _region_offset, uint64_t max_nodes, bool init_new);
+
+    /**
+     * Allocates single node.
+     * @return index of allocated node, which is never 0.
+     * @throws std::runtime_error - if all nodes have already been allocated.
+     */
+    uint32_t allocate_node();
+
+    /**
+     * Frees single node.
+     * @param node_index - index of allocated node.
+     */
+    void free_node(uint32_t node_index);
+
+    /**
+     * Frees several nodes, making them free durably using single drain.
+     * @param node_indices - indices of allocated (or retired) nodes.
+     */
+    void free_nodes(std::vector<uint32_t> const& node_indices);
+
+    /**
+     * Marks node as retired: it isn't given to other users until it is freed, and it is freed when the pool is
+     * restored after the crash (see pmem_allocator::pmem_retire).
+     * @param node_index - index of allocated node.
+     */
+    void retire_node(uint32_t node_index);
+
+    /**
+     * Returns true, if node has been allocated and hasn't been freed yet.
+     * @param node_index - index of node.
+     * @return true, if node is allocated, false otherwise.
+     */
+    bool is_allocated(uint32_t node_index);
+
+    /**
+     * Returns pointer to the first byte of the node.
+     * @param node_index - index of node.
+     * @return pointer to the node.
+     */
+    [[nodiscard]] uint8_t* get_node(uint32_t node_index) const;
+
+    /**
+     * Returns offset of the first byte of the node from the beginning of the persistent heap.
+     * @param node_index - index of node.
+     * @return offset of the node.
+     */
+    [[nodiscard]] uint64_t get_node_offset(uint32_t node_index) const;
+
+    /**
+     * Returns allocator of nodes, so that leaked nodes can be collected (see heap_collector).
+     * @return allocator, which block numbers are indices of nodes.
+     */
+    pmem_allocator& get_allocator();
+
+private:
+    uint8_t* const heap_ptr;
+    const uint64_t region_offset;
+    pmem_allocator allocator;
+};
+
+#endif //DIPLOM_NODE_POOL_H
@@ -0,0 +1,729 @@
+#include "skip_list.h"
+#include "structures_common.h"
+#include "node_pool.h"
+#include "epoch_manager.h"
+#include "../common/pmem_utils.h"
+#include "../common/constants_and_types.h"
+#include "../storage/global_non_owning_storage.h"
+#include "../storage/thread_local_owning_storage.h"
+#include "../persistent_memory/persistent_memory_holder.h"
+#include "../persistent_memory/pptr.h"
+#include "../model/cur_thread_id_holder.h"
+#include "../runtime/answer.h"
+#include "../runtime/call.h"
+#include <cstring>
+#include <random>
+
+const uint8_t SKIP_LIST_DONE = 0x1;
+
+const uint8_t SKIP_LIST_KEY_EXISTS = 0x0;
+
+const uint8_t SKIP_LIST_KEY_ABSENT = 0x0;
+
+const uint8_t SKIP_LIST_OUT_OF_NODES = 0x2;
+
+namespace
+{
+    /*
+     * Offsets of fields of the node. Head node has the same layout, but only next words are used.
+     */
+    const uint32_t NEXT_OFFSET = 0;
+    const uint32_t KEY_OFFSET = 8;
+    const uint32_t VALUE_OFFSET = 16;
+    const uint32_t REMOVER_OFFSET = 20;
+    const uint32_t HEIGHT_OFFSET = 24;
+    const uint32_t UPPER_OFFSET = 28;
+
+    /**
+     * Maximal number of levels, including the bottom one. Each level is 4 times sparser, than the previous one.
+     */
+    const uint32_t MAX_LEVEL = 8;
+    const uint32_t INCARNATION_OFFSET = UPPER_OFFSET + 4 * (MAX_LEVEL - 1);
+    const uint32_t USED_NODE_SIZE = INCARNATION_OFFSET + 4;
+
+    /*
+     * Upper link contains index of the node in the low 16 bits and incarnation of the node in the high 16 bits
+     */
+    const uint32_t LINK_INDEX_MASK = 0xFFFF;
+    const uint32_t LINK_INCARNATION_SHIFT = 16;
+
+    /*
+     * Flags of next word of the bottom level
+     */
+    const uint64_t DIRTY_FLAG = 1ull << 62;
+    const uint64_t MARK_FLAG = 1ull << 63;
+    const uint64_t INDEX_MASK = 0xFFFFFFFF;
+
+    uint8_t* get_node_ptr(uint32_t node_index)
+    {
+        return global_non_owning_storage<node_pool>::ptr->get_node(node_index);
+    }
+
+    uint8_t* get_head_ptr(uint64_t list_offset)
+    {
+        return pptr<uint8_t>(list_offset).get();
+    }
+
+    uint64_t load_next(const uint8_t* node)
+    {
+        return __atomic_load_n((const uint64_t*) (node + NEXT_OFFSET), __ATOMIC_SEQ_CST);
+    }
+
+    bool cas_next(uint8_t* node, uint64_t expected_next, uint64_t new_next)
+    {
+        return __atomic_compare_exchange_n(
+                (uint64_t*) (node + NEXT_OFFSET),
+                &expected_next,
+                new_next,
+                false,
+                __ATOMIC_SEQ_CST,
+                __ATOMIC_SEQ_CST
+        );
+    }
+
+    uint32_t get_link_index(uint32_t link)
+    {
+        return link & LINK_INDEX_MASK;
+    }
+
+    uint32_t load_incarnation(const uint8_t* node)
+    {
+        return __atomic_load_n((const uint32_t*) (node + INCARNATION_OFFSET), __ATOMIC_SEQ_CST);
+    }
+
+    uint32_t make_link(uint32_t node_index)
+    {
+        return (load_incarnation(get_node_ptr(node_index)) << LINK_INCARNATION_SHIFT) | node_index;
+    }
+
+    /**
+     * Returns true, if the upper link points to the same incarnation of the node, i.e. the node hasn't been
+     * retired since the link has been created. Since node can be freed only after the caller's epoch_guard
+     * is left, the node can be read, if this check succeeds.
+     */
+    bool is_link_valid(uint32_t link)
+    {
+        return load_incarnation(get_node_ptr(get_link_index(link))) << LINK_INCARNATION_SHIFT ==
+               (link & ~LINK_INDEX_MASK);
+    }
+
+    uint32_t load_upper(const uint8_t* node, uint32_t level)
+    {
+        return __atomic_load_n((const uint32_t*) (node + UPPER_OFFSET + 4 * (level - 1)), __ATOMIC_SEQ_CST);
+    }
+
+    void store_upper(uint8_t* node, uint32_t level, uint32_t next_index)
+    {
+        __atomic_store_n((uint32_t*) (node + UPPER_OFFSET + 4 * (level - 1)), next_index, __ATOMIC_SEQ_CST);
+    }
+
+    bool cas_upper(uint8_t* node, uint32_t level, uint32_t expected_index, uint32_t new_index)
+    {
+        return __atomic_compare_exchange_n(
+                (uint32_t*) (node + UPPER_OFFSET + 4 * (level - 1)),
+                &expected_index,
+                new_index,
+                false,
+                __ATOMIC_SEQ_CST,
+                __ATOMIC_SEQ_CST
+        );
+    }
+
+    uint64_t get_key(const uint8_t* node)
+    {
+        uint64_t key;
+        std::memcpy(&key, node + KEY_OFFSET, 8);
+        return key;
+    }
+
+    uint32_t get_value(const uint8_t* node)
+    {
+        uint32_t value;
+        std::memcpy(&value, node + VALUE_OFFSET, 4);
+        return value;
+    }
+
+    bool is_marked(const uint8_t* node)
+    {
+        return (load_next(node) & MARK_FLAG) != 0;
+    }
+
+    /**
+     * Flushes next word of the bottom level, if it hasn't been flushed yet.
+     */
+    void flush_next(uint8_t* node, uint64_t next)
+    {
+        if ((next & DIRTY_FLAG) != 0)
+        {
+            pmem_do_flush(node + NEXT_OFFSET, 8);
+        }
+    }
+
+    /**
+     * Flushes next word of the bottom level, if it hasn't been flushed yet, and clears it's DIRTY flag.
+     */
+    void persist_next(uint8_t* node, uint64_t next)
+    {
+        if ((next & DIRTY_FLAG) != 0)
+        {
+            pmem_do_flush(node + NEXT_OFFSET, 8);
+            cas_next(node, next, next & ~DIRTY_FLAG);
+        }
+    }
+
+    /**
+     * Result of search of the key: predecessor and successor of the key on each level.
+     * Predecessors on the upper levels can be marked.
+     */
+    struct search_result
+    {
+        uint8_t* preds[MAX_LEVEL];
+        /*
+         * Index of the successor on the bottom level, links to the successors on the upper levels
+         */
+        uint32_t succs[MAX_LEVEL];
+        /*
+         * Next word of the predecessor on the bottom level, index of succs[0] without flags
+         */
+        uint64_t pred_next;
+    };
+
+    /**
+     * Searches the key, unlinking marked nodes and flushing links, that haven't been flushed yet.
+     * Successor on each level is the first node with key, that is not less than the key (or 0).
+     */
+    void search(uint8_t* head, uint64_t key, search_result& result)
+    {
+        while (true)
+        {
+            uint8_t* pred = head;
+            for (uint32_t level = MAX_LEVEL - 1; level > 0; level--)
+            {
+                uint32_t cur = load_upper(pred, level);
+                while (cur != 0)
+                {
+                    if (!is_link_valid(cur))
+                    {
+                        /*
+                         * Node has been retired and can be reused, therefore it's successor is unknown,
+                         * and the rest of the level is dropped (upper levels are only hints)
+                         */
+                        cas_upper(pred, level, cur, 0);
+                        cur = load_upper(pred, level);
+                        continue;
+                    }
+                    uint8_t* const cur_node = get_node_ptr(get_link_index(cur));
+                    if (is_marked(cur_node))
+                    {
+                        cas_upper(pred, level, cur, load_upper(cur_node, level));
+                        cur = load_upper(pred, level);
+                        continue;
+                    }
+                    if (get_key(cur_node) >= key)
+                    {
+                        break;
+                    }
+                    pred = cur_node;
+                    cur = load_upper(pred, level);
+                }
+                result.preds[level] = pred;
+                result.succs[level] = cur;
+            }
+
+            bool restart = false;
+            while (true)
+            {
+                const uint64_t pred_next = load_next(pred);
+                if ((pred_next & MARK_FLAG) != 0)
+                {
+                    /*
+                     * Next word of the marked node can no longer be changed
+                     */
+                    restart = true;
+                    break;
+                }
+                if ((pred_next & DIRTY_FLAG) != 0)
+                {
+                    persist_next(pred, pred_next);
+                    continue;
+                }
+                const uint32_t cur = pred_next & INDEX_MASK;
+                if (cur == 0)
+                {
+                    result.preds[0] = pred;
+                    result.succs[0] = 0;
+                    result.pred_next = pred_next;
+                    return;
+                }
+                uint8_t* const cur_node = get_node_ptr(cur);
+                const uint64_t cur_next = load_next(cur_node);
+                if ((cur_next & MARK_FLAG) != 0)
+                {
+                    /*
+                     * Mark and the next link of the removed node are flushed before the node is unlinked,
+                     * so that insert of the node could be detected after the crash
+                     */
+                    persist_next(cur_node, cur_next);
+                    cas_next(pred, pred_next, (cur_next & INDEX_MASK) | DIRTY_FLAG);
+                    continue;
+                }
+                if (get_key(cur_node) >= key)
+                {
+                    result.preds[0] = pred;
+                    result.succs[0] = cur;
+                    result.pred_next = pred_next;
+                    return;
+                }
+                pred = cur_node;
+            }
+            if (!restart)
+            {
+                return;
+            }
+        }
+    }
+
+    /**
+     * Returns index of the first node, that is not marked and has key, that is not less than the key (or 0).
+     * Marked nodes are passed without unlinking, skip list is not modified.
+     */
+    uint32_t find_first_not_less(uint8_t* head, uint64_t key)
+    {
+        uint8_t* pred = head;
+        for (uint32_t level = MAX_LEVEL - 1; level > 0; level--)
+        {
+            uint32_t cur = load_upper(pred, level);
+            while (cur != 0 && is_link_valid(cur))
+            {
+                uint8_t* const cur_node = get_node_ptr(get_link_index(cur));
+                if (is_marked(cur_node))
+                {
+                    cur = load_upper(cur_node, level);
+                    continue;
+                }
+                if (get_key(cur_node) >= key)
+                {
+                    break;
+                }
+                pred = cur_node;
+                cur = load_upper(pred, level);
+            }
+        }
+
+        uint64_t next = load_next(pred);
+        flush_next(pred, next);
+        uint32_t cur = next & INDEX_MASK;
+        while (cur != 0)
+        {
+            uint8_t* const cur_node = get_node_ptr(cur);
+            next = load_next(cur_node);
+            flush_next(cur_node, next);
+            if ((next & MARK_FLAG) == 0 && get_key(cur_node) >= key)
+            {
+                return cur;
+            }
+            cur = next & INDEX_MASK;
+        }
+        return 0;
+    }
+
+    uint32_t get_random_height()
+    {
+        thread_local std::mt19937 generator(std::random_device{}());
+        uint32_t height = 1;
+        while (height < MAX_LEVEL && (generator() & 3) == 0)
+        {
+            height++;
+        }
+        return height;
+    }
+
+    /**
+     * Initializes allocated node, that is not reachable from the skip list yet.
+     */
+    void init_node(uint32_t node_index, uint64_t key, uint32_t value)
+    {
+        uint8_t* const node = get_node_ptr(node_index);
+        /*
+         * Incarnation is kept, so that links to the previous incarnations of the node remain invalid
+         */
+        std::memset(node, 0, INCARNATION_OFFSET);
+        std::memcpy(node + KEY_OFFSET, &key, 8);
+        std::memcpy(node + VALUE_OFFSET, &value, 4);
+        const uint32_t height = get_random_height();
+        std::memcpy(node + HEIGHT_OFFSET, &height, 4);
+        pmem_do_flush(node, USED_NODE_SIZE);
+    }
+
+    /**
+     * Returns true, if the node, allocated by insert, has been linked to the bottom level.
+     * Must be called only by the thread, that has allocated the node.
+     */
+    bool is_linked(uint8_t* head, uint64_t key, uint32_t node_index)
+    {
+        search_result result{};
+        search(head, key, result);
+        if (result.succs[0] == node_index)
+        {
+            return true;
+        }
+        /*
+         * Node is marked only after it has been linked. Linked node can be reused only after it has been retired
+         * by it's remover, which happens not earlier, than insert of the node is completed, unless the crash
+         * has occurred
+         */
+        return is_marked(get_node_ptr(node_index));
+    }
+
+    /**
+     * Links node, that has been linked to the bottom level, to the upper levels. Stops, if the node is removed.
+     */
+    void link_upper_levels(uint8_t* head, uint64_t key, uint32_t node_index)
+    {
+        uint8_t* const node = get_node_ptr(node_index);
+        uint32_t height;
+        std::memcpy(&height, node + HEIGHT_OFFSET, 4);
+        /*
+         * Link is made before the node is checked to be unmarked, therefore, if the node is removed and retired
+         * concurrently, the link is invalidated by the retirement
+         */
+        const uint32_t node_link = make_link(node_index);
+        search_result result{};
+        for (uint32_t level = 1; level < height; level++)
+        {
+            while (true)
+            {
+                if (is_marked(node))
+                {
+                    return;
+                }
+                search(head, key, result);
+                if (get_link_index(result.succs[level]) == node_index)
+                {
+                    break;
+                }
+                store_upper(node, level, result.succs[level]);
+                if (cas_upper(result.preds[level], level, result.succs[level], node_link))
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    /**
+     * Reclaims node, that has been removed by the caller thread and unlinked from the bottom level.
+     * Node can still be reachable by stale upper links, therefore it's incarnation is changed durably before
+     * the node is retired, so that such links are never followed after the node is reused.
+     */
+    void reclaim_removed_node(uint32_t node_index)
+    {
+        uint8_t* const node = get_node_ptr(node_index);
+        __atomic_add_fetch((uint32_t*) (node + INCARNATION_OFFSET), 1, __ATOMIC_SEQ_CST);
+        pmem_do_flush(node + INCARNATION_OFFSET, 4);
+        reclaim_node(node_index);
+    }
+
+    void skip_insert_common(const uint8_t* args, bool call_recover)
+    {
+        const epoch_guard guard;
+        uint64_t list_offset;
+        std::memcpy(&list_offset, args, 8);
+        uint64_t key;
+        std::memcpy(&key, args + 8, 8);
+        uint32_t value;
+        std::memcpy(&value, args + 16, 4);
+        uint8_t* const head = get_head_ptr(list_offset);
+
+        uint32_t node_index = 0;
+        if (call_recover)
+        {
+            if (read_current_answer(1)[0] != PDS_NOT_COMPLETED)
+            {
+                /*
+                 * Answer has already been written
+                 */
+                return;
+            }
+            const operation_state state = parse_operation_state(read_answer(8));
+            if (state.status == PDS_OUT_OF_NODES)
+            {
+                write_answer(std::vector<uint8_t>({SKIP_LIST_OUT_OF_NODES}));
+                return;
+            }
+            if (state.status == PDS_NODE_ALLOCATED)
+            {
+                node_index = state.node_index;
+                if (is_linked(head, key, node_index))
+                {
+                    link_upper_levels(head, key, node_index);
+                    write_answer(std::vector<uint8_t>({SKIP_LIST_DONE}));
+                    return;
+                }
+            }
+        }
+
+        if (node_index == 0)
+        {
+            do_call("pds_alloc", nullptr, 0, make_operation_filler(PDS_NOT_COMPLETED, 0, 0), std::nullopt);
+            const operation_state state = parse_operation_state(read_answer(8));
+            if (state.status == PDS_OUT_OF_NODES)
+            {
+                write_answer(std::vector<uint8_t>({SKIP_LIST_OUT_OF_NODES}));
+                return;
+            }
+            node_index = state.node_index;
+        }
+        init_node(node_index, key, value);
+
+        uint8_t* const node = get_node_ptr(node_index);
+        search_result result{};
+        while (true)
+        {
+            search(head, key, result);
+            const uint32_t succ = result.succs[0];
+            if (succ != 0 && get_key(get_node_ptr(succ)) == key)
+            {
+                /*
+                 * Answer is written before the node is freed, therefore node is never freed twice
+                 */
+                write_answer(std::vector<uint8_t>({SKIP_LIST_KEY_EXISTS}));
+                global_non_owning_storage<node_pool>::ptr->free_node(node_index);
+                return;
+            }
+            __atomic_store_n((uint64_t*) (node + NEXT_OFFSET), (uint64_t) succ, __ATOMIC_SEQ_CST);
+            pmem_do_flush(node + NEXT_OFFSET, 8);
+            if (cas_next(result.preds[0], result.pred_next, node_index | DIRTY_FLAG))
+            {
+                persist_next(result.preds[0], node_index | DIRTY_FLAG);
+                break;
+            }
+        }
+        link_upper_levels(head, key, node_index);
+        write_answer(std::vector<uint8_t>({SKIP_LIST_DONE}));
+    }
+
+    void skip_remove_common(const uint8_t* args, bool call_recover)
+    {
+        const epoch_guard guard;
+        uint64_t list_offset;
+        std::memcpy(&list_offset, args, 8);
+        uint64_t key;
+        std::memcpy(&key, args + 8, 8);
+        uint8_t* const head = get_head_ptr(list_offset);
+
+        search_result result{};
+        if (call_recover)
+        {
+            if (read_current_answer(1)[0] != PDS_NOT_COMPLETED)
+            {
+                return;
+            }
+            const operation_state state = parse_operation_state(read_answer(8));
+            if (state.status == 0x1)
+            {
+                /*
+                 * Node has been marked by the caller thread, search unlinks it from the bottom level
+                 */
+                search(head, key, result);
+                write_answer(std::vector<uint8_t>({SKIP_LIST_DONE}));
+                reclaim_removed_node(state.node_index);
+                return;
+            }
+        }
+
+        while (true)
+        {
+            search(head, key, result);
+            const uint32_t cur = result.succs[0];
+            if (cur == 0 || get_key(get_node_ptr(cur)) != key)
+            {
+                write_answer(std::vector<uint8_t>({SKIP_LIST_KEY_ABSENT}));
+                return;
+            }
+            uint8_t mark_args[4];
+            std::memcpy(mark_args, &cur, 4);
+            do_call("skip_mark", mark_args, 4, make_operation_filler(PDS_NOT_COMPLETED, cur, 0), std::nullopt);
+            if (read_answer(1)[0] == 0x1)
+            {
+                /*
+                 * Search, that has begun after the mark, unlinks the node from the bottom level
+                 * (or passes the link, that has unlinked it, and flushes it), and only the remover reclaims the node.
+                 * Answer is written before the node is reclaimed, therefore node is never reclaimed twice
+                 */
+                search(head, key, result);
+                write_answer(std::vector<uint8_t>({SKIP_LIST_DONE}));
+                reclaim_removed_node(cur);
+                return;
+            }
+            /*
+             * Node has been removed by another thread
+             */
+        }
+    }
+
+    void skip_mark_common(const uint8_t* args, bool call_recover)
+    {
+        if (call_recover && read_current_answer(1)[0] != PDS_NOT_COMPLETED)
+        {
+            return;
+        }
+        const epoch_guard guard;
+        uint32_t node_index;
+        std::memcpy(&node_index, args, 4);
+        uint8_t* const node = get_node_ptr(node_index);
+
+        const uint32_t remover =
+                thread_local_owning_storage<cur_thread_id_holder>::get_const_object().cur_thread_id + 1;
+        uint32_t no_remover = 0;
+        __atomic_compare_exchange_n(
+                (uint32_t*) (node + REMOVER_OFFSET),
+                &no_remover,
+                remover,
+                false,
+                __ATOMIC_SEQ_CST,
+                __ATOMIC_SEQ_CST
+        );
+        pmem_do_flush(node + REMOVER_OFFSET, 4);
+        const bool is_remover = __atomic_load_n((uint32_t*) (node + REMOVER_OFFSET), __ATOMIC_SEQ_CST) == remover;
+
+        /*
+         * Any thread, that has tried to remove the node, helps to mark it, so that it could retry after that
+         */
+        while (true)
+        {
+            const uint64_t next = load_next(node);
+            if ((next & MARK_FLAG) != 0 || cas_next(node, next, next | MARK_FLAG | DIRTY_FLAG))
+            {
+                break;
+            }
+        }
+        persist_next(node, load_next(node));
+        write_answer(std::vector<uint8_t>({is_remover ? (uint8_t) 0x1 : (uint8_t) 0x0}));
+    }
+}
+
+uint64_t get_skip_list_size()
+{
+    return CACHE_LINE_SIZE;
+}
+
+void init_skip_list(uint64_t list_offset)
+{
+    uint8_t* const head = get_head_ptr(list_offset);
+    std::memset(head, 0, get_skip_list_size());
+    pmem_do_flush(head, get_skip_list_size());
+}
+
+uint8_t skip_list_insert(uint64_t list_offset, uint64_t key, uint32_t value)
+{
+    uint8_t args[20];
+    std::memcpy(args, &list_offset, 8);
+    std::memcpy(args + 8, &key, 8);
+    std::memcpy(args + 16, &value, 4);
+    do_call(
+            "skip_insert",
+            args,
+            20,
+            answer_filler(&PDS_NOT_COMPLETED, 1),
+            make_operation_filler(PDS_NOT_COMPLETED, 0, 0)
+    );
+    return read_answer(1)[0];
+}
+
+uint8_t skip_list_remove(uint64_t list_offset, uint64_t key)
+{
+    uint8_t args[16];
+    std::memcpy(args, &list_offset, 8);
+    std::memcpy(args + 8, &key, 8);
+    do_call(
+            "skip_remove",
+            args,
+            16,
+            answer_filler(&PDS_NOT_COMPLETED, 1),
+            make_operation_filler(PDS_NOT_COMPLETED, 0, 0)
+    );
+    return read_answer(1)[0];
+}
+
+std::optional<uint32_t> skip_list_get(uint64_t list_offset, uint64_t key)
+{
+    const epoch_guard guard;
+    const uint32_t node_index = find_first_not_less(get_head_ptr(list_offset), key);
+    if (node_index == 0)
+    {
+        return std::nullopt;
+    }
+    const uint8_t* const node = get_node_ptr(node_index);
+    if (get_key(node) != key)
+    {
+        return std::nullopt;
+    }
+    return get_value(node);
+}
+
+std::vector<std::pair<uint64_t, uint32_t>> skip_list_scan(uint64_t list_offset, uint64_t from, uint64_t to)
+{
+    const epoch_guard guard;
+    std::vector<std::pair<uint64_t, uint32_t>> entries;
+    uint32_t cur = find_first_not_less(get_head_ptr(list_offset), from);
+    while (cur != 0)
+    {
+        uint8_t* const cur_node = get_node_ptr(cur);
+        const uint64_t next = load_next(cur_node);
+        flush_next(cur_node, next);
+        const uint64_t key = get_key(cur_node);
+        if (key > to)
+        {
+            break;
+        }
+        if ((next & MARK_FLAG) == 0)
+        {
+            entries.emplace_back(key, get_value(cur_node));
+        }
+        cur = next & INDEX_MASK;
+    }
+    return entries;
+}
+
+std::vector<uint32_t> get_skip_list_nodes(uint64_t list_offset)
+{
+    std::vector<uint32_t> nodes;
+    uint32_t cur = load_next(get_head_ptr(list_offset)) & INDEX_MASK;
+    while (cur != 0)
+    {
+        nodes.push_back(cur);
+        cur = load_next(get_node_ptr(cur)) & INDEX_MASK;
+    }
+    return nodes;
+}
+
+void skip_insert(const uint8_t* args)
+{
+    skip_insert_common(args, false);
+}
+
+void skip_insert_recover(const uint8_t* args)
+{
+    skip_insert_common(args, true);
+}
+
+void skip_remove(const uint8_t* args)
+{
+    skip_remove_common(args, false);
+}
+
+void skip_remove_recover(const uint8_t* args)
+{
+    skip_remove_common(args, true);
+}
+
+void skip_mark(const uint8_t* args)
+{
+    skip_mark_common(args, false);
+}
+
+void skip_mark_recover(const uint8_t* args)
+{
+    skip_mark_common(args, true);
+}
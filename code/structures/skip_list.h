@@ -0,0 +1,196 @@
+#ifndef DIPLOM_SKIP_LIST_H
+#define DIPLOM_SKIP_LIST_H
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/*
+ * Recoverable lock-free skip list, which maps 64-bit keys to 32-bit values in ascending order of keys.
+ * Skip list consists of head node, located at offset, aligned by cache line size, and nodes, allocated
+ * from node_pool (stored in global_non_owning_storage<node_pool>). Value of the key is set once, when
+ * the key is inserted.
+ *
+ * Node contains:
+ * <ul>
+ *  <li>
+ *      8 bytes of next word of the bottom level: index of the next node, DIRTY flag (link hasn't been flushed yet)
+ *      and MARK flag (node has been removed, next word can no longer be changed)
+ *  </li>
+ *  <li>
+ *      8 bytes of key and 4 bytes of value
+ *  </li>
+ *  <li>
+ *      4 bytes of remover: id of the thread, that removes the node, plus 1 (0, if the node hasn't been removed)
+ *  </li>
+ *  <li>
+ *      4 bytes of height and 4 bytes of link to the next node on each upper level: index of the node
+ *      and low 16 bits of it's incarnation
+ *  </li>
+ *  <li>
+ *      4 bytes of incarnation, which is changed, when the node is retired
+ *  </li>
+ * </ul>
+ *
+ * Bottom level is a Harris list and is the only durable part of the structure: key is present, iff it's node is
+ * reachable by the bottom level and is not marked. Each link is CAS'ed together with DIRTY flag, and every thread,
+ * that observes DIRTY flag, flushes the link before using it, therefore no operation can depend on a link,
+ * that can be lost after the crash. Upper levels are only hints for the search: they are linked after the bottom
+ * level without flushes, and marked nodes are unlinked from them lazily, therefore structure of the skip list
+ * doesn't need to be rebuilt after the crash.
+ *
+ * Insert is detectable, since node can be marked only after it has been linked: after the crash, insert searches
+ * for it's node or checks it's mark. Remove first writes it's thread id to the remover of the node (in nested call
+ * skip_mark), which determines the single successful remove of the node, and then marks the node.
+ * After the node is marked, the remover searches it's key, which unlinks the node from the bottom level, and retires
+ * the node (see reclaim_node), so that it is freed after all concurrent operations, which run inside epoch_guard,
+ * have finished. Marked node can still be reachable by upper links, since they are not marked, and concurrent
+ * unlinking of adjacent nodes can restore such link. Therefore incarnation of the node is changed before it is
+ * retired, and link, which incarnation doesn't match the node, is never followed: the rest of it's level is dropped
+ * instead. Nodes can be leaked, if crash occurs inside pds_alloc, after the failed insert has written it's answer,
+ * but before it has freed it's node, or after the remove has written it's answer, but before it has retired the node.
+ */
+
+/**
+ * Answer of insert or remove: key has been inserted or removed.
+ */
+extern const uint8_t SKIP_LIST_DONE;
+
+/**
+ * Answer of insert: key is already present.
+ */
+extern const uint8_t SKIP_LIST_KEY_EXISTS;
+
+/**
+ * Answer of remove: key is absent.
+ */
+extern const uint8_t SKIP_LIST_KEY_ABSENT;
+
+/**
+ * Answer of insert: node couldn't be allocated.
+ */
+extern const uint8_t SKIP_LIST_OUT_OF_NODES;
+
+/**
+ * Returns size of head node of the skip list.
+ * @return size of head node in bytes, multiple of cache line size.
+ */
+uint64_t get_skip_list_size();
+
+/**
+ * Initializes empty skip list. Must be called before any operation with the skip list.
+ * @param list_offset - offset of head node of the skip list from the beginning of the persistent heap,
+ *                      aligned by cache line size.
+ */
+void init_skip_list(uint64_t list_offset);
+
+/**
+ * Inserts key with the value, calling skip_insert using do_call.
+ * @param list_offset - offset of head node of the skip list.
+ * @param key - key to insert.
+ * @param value - value of the key.
+ * @return SKIP_LIST_DONE, SKIP_LIST_KEY_EXISTS or SKIP_LIST_OUT_OF_NODES.
+ */
+uint8_t skip_list_insert(uint64_t list_offset, uint64_t key, uint32_t value);
+
+/**
+ * Removes key, calling skip_remove using do_call.
+ * @param list_offset - offset of head node of the skip list.
+ * @param key - key to remove.
+ * @return SKIP_LIST_DONE or SKIP_LIST_KEY_ABSENT.
+ */
+uint8_t skip_list_remove(uint64_t list_offset, uint64_t key);
+
+/**
+ * Returns value of the key. Doesn't use persistent stack and doesn't modify the skip list.
+ * @param list_offset - offset of head node of the skip list.
+ * @param key - key.
+ * @return value of the key, or empty optional, if the key is absent.
+ */
+std::optional<uint32_t> skip_list_get(uint64_t list_offset, uint64_t key);
+
+/**
+ * Returns keys from the range [from, to] with their values in ascending order of keys. Doesn't use persistent
+ * stack and doesn't modify the skip list. Scan is not atomic: each returned key has been present at some moment
+ * during the scan, and each key, that has been present during the whole scan, is returned.
+ * @param list_offset - offset of head node of the skip list.
+ * @param from - lower bound of the range (inclusive).
+ * @param to - upper bound of the range (inclusive).
+ * @return pairs <key, value>.
+ */
+std::vector<std::pair<uint64_t, uint32_t>> skip_list_scan(uint64_t list_offset, uint64_t from, uint64_t to);
+
+/**
+ * Returns nodes, linked to the bottom level of the skip list, including marked ones, that haven't been unlinked yet.
+ * Must not be called concurrently with operations of the skip list.
+ * @param list_offset - offset of head node of the skip list.
+ * @return indices of nodes in ascending order of their keys.
+ */
+std::vector<uint32_t> get_skip_list_nodes(uint64_t list_offset);
+
+/**
+ * Insert, that can be called by the system runtime using do_call. Must be called with answer filler {0xFF} and
+ * new answer filler <PDS_NOT_COMPLETED, 0, 0>. Writes 1 byte of answer: SKIP_LIST_DONE, SKIP_LIST_KEY_EXISTS
+ * or SKIP_LIST_OUT_OF_NODES.
+ * Args has the following structure:
+ * <ul>
+ *  <li>
+ *      8 bytes of offset of head node of the skip list
+ *  </li>
+ *  <li>
+ *      8 bytes of key
+ *  </li>
+ *  <li>
+ *      4 bytes of value
+ *  </li>
+ * </ul>
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void skip_insert(const uint8_t* args);
+
+/**
+ * Recover version of skip_insert. Receives the same arguments, as skip_insert.
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void skip_insert_recover(const uint8_t* args);
+
+/**
+ * Remove, that can be called by the system runtime using do_call. Must be called with answer filler {0xFF} and
+ * new answer filler <PDS_NOT_COMPLETED, 0, 0>. Writes 1 byte of answer: SKIP_LIST_DONE or SKIP_LIST_KEY_ABSENT.
+ * Args has the following structure:
+ * <ul>
+ *  <li>
+ *      8 bytes of offset of head node of the skip list
+ *  </li>
+ *  <li>
+ *      8 bytes of key
+ *  </li>
+ * </ul>
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void skip_remove(const uint8_t* args);
+
+/**
+ * Recover version of skip_remove. Receives the same arguments, as skip_remove.
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void skip_remove_recover(const uint8_t* args);
+
+/**
+ * Tries to become the remover of the node and marks the node, which is called by skip_remove using do_call.
+ * Writes 1 byte of answer: 0x1, if the caller thread is the remover of the node, 0x0 otherwise.
+ * Node is marked in both cases.
+ * Args contain 4 bytes of index of the node.
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void skip_mark(const uint8_t* args);
+
+/**
+ * Recover version of skip_mark. If answer has already been written, does nothing. Otherwise,
+ * since remover of the node never changes, acts as skip_mark.
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void skip_mark_recover(const uint8_t* args);
+
+#endif //DIPLOM_SKIP_LIST_H
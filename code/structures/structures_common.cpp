@@ -0,0 +1,201 @@
+#include "structures_common.h"
+#include "node_pool.h"
+#include "treiber_stack.h"
+#include "ms_queue.h"
+#include "hash_map.h"
+#include "skip_list.h"
+#include "mcas.h"
+#include "../cas/cas.h"
+#include "../common/pmem_utils.h"
+#include "../common/constants_and_types.h"
+#include "../storage/global_storage.h"
+#include "../storage/global_non_owning_storage.h"
+#include "../storage/thread_local_owning_storage.h"
+#include "../persistent_memory/persistent_memory_holder.h"
+#include "../persistent_memory/pptr.h"
+#include "../model/cur_thread_id_holder.h"
+#include "../model/total_thread_count_holder.h"
+#include "../runtime/answer.h"
+#include "../runtime/call.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+const uint32_t NODE_INDEX_BITS = 15;
+
+const uint8_t PDS_NOT_COMPLETED = 0xFF;
+
+const uint8_t PDS_NODE_ALLOCATED = 0x2;
+
+const uint8_t PDS_OUT_OF_NODES = 0x3;
+
+uint32_t make_node_ref(uint32_t tag, uint32_t node_index)
+{
+    return (tag << NODE_INDEX_BITS) | node_index;
+}
+
+uint32_t get_node_index(uint32_t node_ref)
+{
+    return node_ref & ((1u << NODE_INDEX_BITS) - 1);
+}
+
+uint32_t get_node_tag(uint32_t node_ref)
+{
+    return node_ref >> NODE_INDEX_BITS;
+}
+
+uint64_t get_thread_matrix_size(uint32_t number_of_threads)
+{
+    return get_cache_line_aligned_address((uint64_t) number_of_threads * number_of_threads * 4);
+}
+
+void init_register(uint64_t var_offset, uint32_t value)
+{
+    uint8_t* const var = pptr<uint8_t>(var_offset).get();
+    uint64_t initial_thread_number_and_value;
+    uint8_t* const initial_thread_number_and_value_ptr = (uint8_t*) &initial_thread_number_and_value;
+    const uint32_t initial_thread_number = std::numeric_limits<uint32_t>::max();
+    std::memcpy(initial_thread_number_and_value_ptr, &initial_thread_number, 4);
+    std::memcpy(initial_thread_number_and_value_ptr + 4, &value, 4);
+    __atomic_store_n((uint64_t*) var, initial_thread_number_and_value, __ATOMIC_SEQ_CST);
+    pmem_do_flush(var, 8);
+}
+
+answer_filler make_operation_filler(uint8_t status, uint32_t node_index, uint32_t payload)
+{
+    uint8_t state[8] = {status, 0};
+    const uint16_t short_node_index = node_index;
+    std::memcpy(state + 2, &short_node_index, 2);
+    std::memcpy(state + 4, &payload, 4);
+    return answer_filler(state, 8);
+}
+
+std::vector<uint8_t> make_operation_state(uint8_t status, uint32_t node_index, uint32_t payload)
+{
+    const answer_filler state = make_operation_filler(status, node_index, payload);
+    return std::vector<uint8_t>(state.begin(), state.end());
+}
+
+operation_state parse_operation_state(std::vector<uint8_t> const& state)
+{
+    uint16_t short_node_index;
+    std::memcpy(&short_node_index, state.data() + 2, 2);
+    uint32_t payload;
+    std::memcpy(&payload, state.data() + 4, 4);
+    return operation_state{state[0], short_node_index, payload};
+}
+
+bool do_recoverable_cas(uint64_t var_offset,
+                        uint32_t expected_value,
+                        uint32_t new_value,
+                        uint64_t thread_matrix_offset,
+                        uint32_t node_index,
+                        uint32_t payload)
+{
+    uint8_t args[24];
+    std::memcpy(args, &var_offset, 8);
+    std::memcpy(args + 8, &expected_value, 4);
+    std::memcpy(args + 12, &new_value, 4);
+    std::memcpy(args + 16, &thread_matrix_offset, 8);
+    do_call("cas", args, 24, make_operation_filler(PDS_NOT_COMPLETED, node_index, payload), std::nullopt);
+    return read_answer(1)[0] == 0x1;
+}
+
+void do_helping_cas(uint64_t var_offset, uint32_t expected_value, uint32_t new_value, uint64_t thread_matrix_offset)
+{
+    uint8_t* const heap_base = get_heap_base();
+    cas_internal(
+            pptr<uint64_t>(var_offset).get(heap_base),
+            expected_value,
+            new_value,
+            thread_local_owning_storage<cur_thread_id_holder>::get_const_object().cur_thread_id,
+            global_storage<total_thread_count_holder>::get_const_object().total_thread_count,
+            pptr<uint32_t>(thread_matrix_offset).get(heap_base)
+    );
+}
+
+namespace
+{
+    /*
+     * Operations, answer memory of which contains state of the operation (see structures_common.h)
+     */
+    const std::string_view NODE_OPERATIONS[] = {
+            "treiber_push",
+            "treiber_pop",
+            "ms_enqueue",
+            "ms_dequeue",
+            "map_put",
+            "map_remove",
+            "skip_insert",
+            "skip_remove",
+            "mcas",
+            "mcas_init"
+    };
+
+    void pds_alloc_common()
+    {
+        uint32_t node_index;
+        try
+        {
+            node_index = global_non_owning_storage<node_pool>::ptr->allocate_node();
+        }
+        catch (std::runtime_error const&)
+        {
+            write_answer(make_operation_state(PDS_OUT_OF_NODES, 0, 0));
+            return;
+        }
+        write_answer(make_operation_state(PDS_NODE_ALLOCATED, node_index, 0));
+    }
+}
+
+void pds_alloc(const uint8_t*)
+{
+    pds_alloc_common();
+}
+
+void pds_alloc_recover(const uint8_t*)
+{
+    if (read_current_answer(1)[0] != PDS_NOT_COMPLETED)
+    {
+        /*
+         * Answer has already been written
+         */
+        return;
+    }
+    pds_alloc_common();
+}
+
+std::optional<uint32_t> get_operation_node_index(positioned_frame const& frame, const uint8_t* stack_ptr)
+{
+    const std::string_view function_name = frame.get_frame().get_function_name();
+    if (std::find(std::begin(NODE_OPERATIONS), std::end(NODE_OPERATIONS), function_name) ==
+        std::end(NODE_OPERATIONS))
+    {
+        return std::nullopt;
+    }
+    const std::vector<uint8_t> state(stack_ptr + frame.get_position(), stack_ptr + frame.get_position() + 8);
+    const uint32_t node_index = parse_operation_state(state).node_index;
+    if (node_index == 0)
+    {
+        return std::nullopt;
+    }
+    return node_index;
+}
+
+void register_structure_functions(function_address_holder& func_map)
+{
+    func_map.funcs["cas"] = {cas, cas_recover};
+    func_map.funcs["pds_alloc"] = {pds_alloc, pds_alloc_recover};
+    func_map.funcs["treiber_push"] = {treiber_push, treiber_push_recover};
+    func_map.funcs["treiber_pop"] = {treiber_pop, treiber_pop_recover};
+    func_map.funcs["ms_enqueue"] = {ms_enqueue, ms_enqueue_recover};
+    func_map.funcs["ms_dequeue"] = {ms_dequeue, ms_dequeue_recover};
+    func_map.funcs["map_put"] = {map_put, map_put_recover};
+    func_map.funcs["map_remove"] = {map_remove, map_remove_recover};
+    func_map.funcs["skip_insert"] = {skip_insert, skip_insert_recover};
+    func_map.funcs["skip_remove"] = {skip_remove, skip_remove_recover};
+    func_map.funcs["skip_mark"] = {skip_mark, skip_mark_recover};
+    func_map.funcs["mcas"] = {mcas, mcas_recover};
+    func_map.funcs["mcas_init"] = {mcas_init, mcas_init_recover};
+}
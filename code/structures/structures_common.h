@@ -0,0 +1,199 @@
+#ifndef DIPLOM_STRUCTURES_COMMON_H
+#define DIPLOM_STRUCTURES_COMMON_H
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "../frame/positioned_frame.h"
+#include "../model/function_address_holder.h"
+
+/*
+ * Recoverable data structures keep references to nodes in values of RMW registers. Reference is
+ * 32-bit value <tag, node index>: lower 15 bits contain index of the node in node_pool,
+ * upper 17 bits contain version tag. Tag is incremented by each successful CAS of the register, therefore
+ * values of the register are unique (until the tag wraps around), which protects from ABA problem and
+ * allows recoverable CAS to detect it's own successful CAS using thread matrix.
+ *
+ * Each operation of the data structures is a function, called using do_call, that stores it's progress in the
+ * answer memory of it's own frame, where it's nested calls (pds_alloc and cas) write their answers.
+ * This memory has the following structure:
+ * <ul>
+ *  <li>
+ *      1 byte of status: either PDS_NOT_COMPLETED, answer of the last cas (0x0 or 0x1),
+ *      PDS_NODE_ALLOCATED or PDS_OUT_OF_NODES
+ *  </li>
+ *  <li>
+ *      1 unused byte
+ *  </li>
+ *  <li>
+ *      2 bytes of index of the node, that is inserted or removed by the operation (0, if there is no such node yet)
+ *  </li>
+ *  <li>
+ *      4 bytes of operation-specific payload
+ *  </li>
+ * </ul>
+ * Status and payload are written by the operation as answer filler before each nested call.
+ *
+ * Nodes, removed from the data structures, are reclaimed using reclaim_node (see epoch_manager), and operations,
+ * that read nodes, which can be removed concurrently, run inside epoch_guard.
+ */
+
+/**
+ * Number of bits of node index in reference to node.
+ */
+extern const uint32_t NODE_INDEX_BITS;
+
+/**
+ * Nested call has not completed yet. Also, operations of data structures are called with this answer filler,
+ * therefore recover version of operation can find out, whether it's answer has already been written.
+ */
+extern const uint8_t PDS_NOT_COMPLETED;
+
+/**
+ * pds_alloc has allocated node, index of which is written to the answer.
+ */
+extern const uint8_t PDS_NODE_ALLOCATED;
+
+/**
+ * pds_alloc couldn't allocate node, because all nodes of the pool have already been allocated.
+ */
+extern const uint8_t PDS_OUT_OF_NODES;
+
+/**
+ * Builds reference to node.
+ * @param tag - version tag, only lower 17 bits are used.
+ * @param node_index - index of node in node_pool.
+ * @return reference to the node.
+ */
+uint32_t make_node_ref(uint32_t tag, uint32_t node_index);
+
+/**
+ * @param node_ref - reference to node.
+ * @return index of the node, 0 if the reference is null.
+ */
+uint32_t get_node_index(uint32_t node_ref);
+
+/**
+ * @param node_ref - reference to node.
+ * @return version tag of the reference.
+ */
+uint32_t get_node_tag(uint32_t node_ref);
+
+/**
+ * Returns size of thread matrix of single RMW register, aligned by cache line size.
+ * @param number_of_threads - total number of threads.
+ * @return size of thread matrix in bytes.
+ */
+uint64_t get_thread_matrix_size(uint32_t number_of_threads);
+
+/**
+ * Writes <no thread, value> to RMW register, located in the persistent heap, and flushes it. Must not be called
+ * concurrently with CAS of the register.
+ * @param var_offset - offset of the register from the beginning of the persistent heap.
+ * @param value - value of the register.
+ */
+void init_register(uint64_t var_offset, uint32_t value);
+
+/**
+ * State of data structure operation, stored in the answer memory of it's frame (see above).
+ */
+struct operation_state
+{
+    uint8_t status;
+    uint32_t node_index;
+    uint32_t payload;
+};
+
+/**
+ * Parses state of data structure operation.
+ * @param state - 8 bytes of answer memory.
+ * @return parsed state.
+ */
+operation_state parse_operation_state(std::vector<uint8_t> const& state);
+
+/**
+ * Builds answer filler of data structure operation (see above).
+ * @param status - status of nested call.
+ * @param node_index - index of the node, that is inserted or removed by the operation.
+ * @param payload - operation-specific payload.
+ * @return 8 bytes of answer filler.
+ */
+std::vector<uint8_t> make_operation_state(uint8_t status, uint32_t node_index, uint32_t payload);
+
+/**
+ * Same as make_operation_state, but builds state, that is stored without heap allocation.
+ * Is used as answer filler of do_call.
+ * @param status - status of nested call.
+ * @param node_index - index of the node, that is inserted or removed by the operation.
+ * @param payload - operation-specific payload.
+ * @return 8 bytes of answer filler.
+ */
+answer_filler make_operation_filler(uint8_t status, uint32_t node_index, uint32_t payload);
+
+/**
+ * Performs recoverable CAS of RMW register, located in the persistent heap, using do_call. Before the call,
+ * answer memory of the current frame is filled with <PDS_NOT_COMPLETED, node_index, payload>, so that
+ * after the crash operation could find out it's state.
+ * @param var_offset - offset of the register from the beginning of the persistent heap.
+ * @param expected_value - expected value of the register.
+ * @param new_value - new value of the register.
+ * @param thread_matrix_offset - offset of thread matrix of the register.
+ * @param node_index - index of the node, that is inserted or removed by the operation (or 0).
+ * @param payload - operation-specific payload.
+ * @return true, if CAS was successful, false otherwise.
+ */
+bool do_recoverable_cas(uint64_t var_offset,
+                        uint32_t expected_value,
+                        uint32_t new_value,
+                        uint64_t thread_matrix_offset,
+                        uint32_t node_index,
+                        uint32_t payload);
+
+/**
+ * Performs CAS of RMW register without a frame of cas. Such CAS is not detectable and can only be used
+ * to help other operations (for example, to move tail of the queue), when result of the CAS doesn't matter.
+ * @param var_offset - offset of the register from the beginning of the persistent heap.
+ * @param expected_value - expected value of the register.
+ * @param new_value - new value of the register.
+ * @param thread_matrix_offset - offset of thread matrix of the register.
+ */
+void do_helping_cas(uint64_t var_offset, uint32_t expected_value, uint32_t new_value, uint64_t thread_matrix_offset);
+
+/**
+ * Allocates node from the pool, stored in global_non_owning_storage<node_pool>. Writes 8 bytes of answer:
+ * <PDS_NODE_ALLOCATED, node index, 0> if node was allocated and <PDS_OUT_OF_NODES, 0, 0> otherwise.
+ * Must be called with answer filler <PDS_NOT_COMPLETED, 0, 0>.
+ * Takes no arguments.
+ * Note, that if crash occurs after the node was allocated, but before the answer was written, the node is leaked
+ * (such nodes are freed by heap_collector, see get_operation_node_index).
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void pds_alloc(const uint8_t* args);
+
+/**
+ * Recover version of pds_alloc. If answer has already been written, does nothing, otherwise allocates node.
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void pds_alloc_recover(const uint8_t* args);
+
+/**
+ * Returns index of the node, that is used by operation of data structure (or MCAS), executed in the frame: node,
+ * that the operation inserts or removes, or descriptor of MCAS. Such node can be unreachable from the data structure,
+ * but it is still used by the operation, therefore, together with nodes of data structures (see
+ * get_treiber_stack_nodes, get_ms_queue_nodes, get_hash_map_nodes and get_skip_list_nodes), it is a root
+ * for the collection of nodes (see heap_collector).
+ * @param frame - frame of the persistent stack.
+ * @param stack_ptr - pointer to the beginning of the persistent stack, containing the frame.
+ * @return index of the node, or empty optional, if the frame isn't a frame of operation of data structure,
+ *         or the operation doesn't use any node yet.
+ */
+std::optional<uint32_t> get_operation_node_index(positioned_frame const& frame, const uint8_t* stack_ptr);
+
+/**
+ * Registers operations of all recoverable data structures (and functions, that are called by them) in
+ * the mapping of function addresses.
+ * @param func_map - mapping from function name to function addresses.
+ */
+void register_structure_functions(function_address_holder& func_map);
+
+#endif //DIPLOM_STRUCTURES_COMMON_H
@@ -0,0 +1,241 @@
+#include "treiber_stack.h"
+#include "structures_common.h"
+#include "node_pool.h"
+#include "epoch_manager.h"
+#include "../common/pmem_utils.h"
+#include "../common/constants_and_types.h"
+#include "../storage/global_non_owning_storage.h"
+#include "../runtime/answer.h"
+#include "../runtime/call.h"
+#include "../runtime/exec_task.h"
+#include <cstring>
+
+namespace
+{
+    /*
+     * Offsets of fields of the node
+     */
+    const uint32_t NEXT_OFFSET = 0;
+    const uint32_t VALUE_OFFSET = 8;
+
+    uint64_t get_thread_matrix_offset(uint64_t stack_offset)
+    {
+        return stack_offset + CACHE_LINE_SIZE;
+    }
+
+    void treiber_push_common(const uint8_t* args, bool call_recover)
+    {
+        uint64_t stack_offset;
+        std::memcpy(&stack_offset, args, 8);
+        uint32_t value;
+        std::memcpy(&value, args + 8, 4);
+
+        uint32_t node_index = 0;
+        if (call_recover)
+        {
+            if (read_current_answer(1)[0] != PDS_NOT_COMPLETED)
+            {
+                /*
+                 * Answer has already been written
+                 */
+                return;
+            }
+            const operation_state state = parse_operation_state(read_answer(8));
+            if (state.status == 0x1)
+            {
+                /*
+                 * Node has been pushed by the last CAS
+                 */
+                write_answer(std::vector<uint8_t>({0x1}));
+                return;
+            }
+            if (state.status == PDS_OUT_OF_NODES)
+            {
+                write_answer(std::vector<uint8_t>({0x0}));
+                return;
+            }
+            /*
+             * Either node hasn't been allocated yet (and node_index is 0), or it has been allocated,
+             * but hasn't been pushed. Push can be continued.
+             */
+            node_index = state.node_index;
+        }
+
+        if (node_index == 0)
+        {
+            do_call("pds_alloc", nullptr, 0, make_operation_filler(PDS_NOT_COMPLETED, 0, 0), std::nullopt);
+            const operation_state state = parse_operation_state(read_answer(8));
+            if (state.status == PDS_OUT_OF_NODES)
+            {
+                write_answer(std::vector<uint8_t>({0x0}));
+                return;
+            }
+            node_index = state.node_index;
+        }
+
+        uint8_t* const node = global_non_owning_storage<node_pool>::ptr->get_node(node_index);
+        __atomic_store_n((uint32_t*) (node + VALUE_OFFSET), value, __ATOMIC_SEQ_CST);
+        while (true)
+        {
+            const uint32_t top_ref = read_var(stack_offset);
+            /*
+             * Node is not reachable yet, therefore it can be modified
+             */
+            __atomic_store_n((uint32_t*) (node + NEXT_OFFSET), get_node_index(top_ref), __ATOMIC_SEQ_CST);
+            pmem_do_flush(node, VALUE_OFFSET + 4);
+            if (do_recoverable_cas(
+                    stack_offset,
+                    top_ref,
+                    make_node_ref(get_node_tag(top_ref) + 1, node_index),
+                    get_thread_matrix_offset(stack_offset),
+                    node_index,
+                    0
+            ))
+            {
+                break;
+            }
+        }
+        write_answer(std::vector<uint8_t>({0x1}));
+    }
+
+    void treiber_pop_common(const uint8_t* args, bool call_recover)
+    {
+        /*
+         * Popped node is retired, therefore the top node can be read, even if it is popped concurrently
+         */
+        const epoch_guard guard;
+        uint64_t stack_offset;
+        std::memcpy(&stack_offset, args, 8);
+        node_pool* const pool = global_non_owning_storage<node_pool>::ptr;
+
+        if (call_recover)
+        {
+            if (read_current_answer(1)[0] != PDS_NOT_COMPLETED)
+            {
+                return;
+            }
+            const operation_state state = parse_operation_state(read_answer(8));
+            if (state.status == 0x1)
+            {
+                /*
+                 * Node has been popped by the last CAS. Since node is freed only after the answer is written,
+                 * it hasn't been freed yet.
+                 */
+                write_answer(make_operation_state(0x1, 0, state.payload));
+                reclaim_node(state.node_index);
+                return;
+            }
+        }
+
+        while (true)
+        {
+            const uint32_t top_ref = read_var(stack_offset);
+            const uint32_t top_index = get_node_index(top_ref);
+            if (top_index == 0)
+            {
+                write_answer(std::vector<uint8_t>({0x0}));
+                return;
+            }
+            /*
+             * Node can be popped and reused concurrently, in such case CAS fails, because tag of the top
+             * has been changed
+             */
+            uint8_t* const node = pool->get_node(top_index);
+            const uint32_t next_index = __atomic_load_n((uint32_t*) (node + NEXT_OFFSET), __ATOMIC_SEQ_CST);
+            const uint32_t value = __atomic_load_n((uint32_t*) (node + VALUE_OFFSET), __ATOMIC_SEQ_CST);
+            if (do_recoverable_cas(
+                    stack_offset,
+                    top_ref,
+                    make_node_ref(get_node_tag(top_ref) + 1, next_index),
+                    get_thread_matrix_offset(stack_offset),
+                    top_index,
+                    value
+            ))
+            {
+                /*
+                 * Answer is written before the node is freed, therefore node is never freed twice
+                 */
+                write_answer(make_operation_state(0x1, 0, value));
+                reclaim_node(top_index);
+                return;
+            }
+        }
+    }
+}
+
+uint64_t get_treiber_stack_size(uint32_t number_of_threads)
+{
+    return CACHE_LINE_SIZE + get_thread_matrix_size(number_of_threads);
+}
+
+void init_treiber_stack(uint64_t stack_offset)
+{
+    init_register(stack_offset, make_node_ref(0, 0));
+}
+
+bool treiber_stack_push(uint64_t stack_offset, uint32_t value)
+{
+    uint8_t args[12];
+    std::memcpy(args, &stack_offset, 8);
+    std::memcpy(args + 8, &value, 4);
+    do_call(
+            "treiber_push",
+            args,
+            12,
+            answer_filler(&PDS_NOT_COMPLETED, 1),
+            make_operation_filler(PDS_NOT_COMPLETED, 0, 0)
+    );
+    return read_answer(1)[0] == 0x1;
+}
+
+std::optional<uint32_t> treiber_stack_pop(uint64_t stack_offset)
+{
+    uint8_t args[8];
+    std::memcpy(args, &stack_offset, 8);
+    do_call(
+            "treiber_pop",
+            args,
+            8,
+            answer_filler(&PDS_NOT_COMPLETED, 1),
+            make_operation_filler(PDS_NOT_COMPLETED, 0, 0)
+    );
+    const std::vector<uint8_t> answer = read_answer(8);
+    if (answer[0] != 0x1)
+    {
+        return std::nullopt;
+    }
+    return parse_operation_state(answer).payload;
+}
+
+std::vector<uint32_t> get_treiber_stack_nodes(uint64_t stack_offset)
+{
+    std::vector<uint32_t> nodes;
+    uint32_t cur = get_node_index(read_var(stack_offset));
+    while (cur != 0)
+    {
+        nodes.push_back(cur);
+        const uint8_t* const node = global_non_owning_storage<node_pool>::ptr->get_node(cur);
+        cur = __atomic_load_n((const uint32_t*) (node + NEXT_OFFSET), __ATOMIC_SEQ_CST);
+    }
+    return nodes;
+}
+
+void treiber_push(const uint8_t* args)
+{
+    treiber_push_common(args, false);
+}
+
+void treiber_push_recover(const uint8_t* args)
+{
+    treiber_push_common(args, true);
+}
+
+void treiber_pop(const uint8_t* args)
+{
+    treiber_pop_common(args, false);
+}
+
+void treiber_pop_recover(const uint8_t* args)
+{
+    treiber_pop_common(args, true);
+}
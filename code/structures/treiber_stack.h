@@ -0,0 +1,95 @@
+#ifndef DIPLOM_TREIBER_STACK_H
+#define DIPLOM_TREIBER_STACK_H
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/*
+ * Recoverable lock-free Treiber stack, located in the persistent heap. Stack consists of descriptor and nodes,
+ * allocated from node_pool (stored in global_non_owning_storage<node_pool>).
+ * Descriptor is located at offset, aligned by cache line size, and contains RMW register with reference
+ * to the top node (see structures_common.h), followed by thread matrix of the register.
+ * Node contains 4 bytes of index of the next node, 4 unused bytes and 4 bytes of value.
+ * Push and pop are detectable: after the crash, recover version of the operation finds out, whether
+ * it has taken effect, and either writes it's answer or completes the operation.
+ * Note, that nodes can be leaked, if crash occurs inside pds_alloc or after pop has written it's answer,
+ * but before it has freed the node.
+ */
+
+/**
+ * Returns size of descriptor of the stack.
+ * @param number_of_threads - total number of threads.
+ * @return size of descriptor in bytes, multiple of cache line size.
+ */
+uint64_t get_treiber_stack_size(uint32_t number_of_threads);
+
+/**
+ * Initializes empty stack. Must be called before any operation with the stack.
+ * @param stack_offset - offset of descriptor of the stack from the beginning of the persistent heap,
+ *                       aligned by cache line size. Thread matrix of the descriptor must be zero-filled.
+ */
+void init_treiber_stack(uint64_t stack_offset);
+
+/**
+ * Pushes value to the stack, calling treiber_push using do_call.
+ * @param stack_offset - offset of descriptor of the stack.
+ * @param value - value to push.
+ * @return true, if value was pushed, false, if node couldn't be allocated.
+ */
+bool treiber_stack_push(uint64_t stack_offset, uint32_t value);
+
+/**
+ * Pops value from the stack, calling treiber_pop using do_call.
+ * @param stack_offset - offset of descriptor of the stack.
+ * @return value from the top of the stack, or empty optional, if the stack was empty.
+ */
+std::optional<uint32_t> treiber_stack_pop(uint64_t stack_offset);
+
+/**
+ * Returns nodes of the stack. Must not be called concurrently with operations of the stack, e.g. it is called
+ * after restoration to find nodes, that are still used (see heap_collector).
+ * @param stack_offset - offset of descriptor of the stack.
+ * @return indices of nodes from the top to the bottom of the stack.
+ */
+std::vector<uint32_t> get_treiber_stack_nodes(uint64_t stack_offset);
+
+/**
+ * Push, that can be called by the system runtime using do_call. Must be called with answer filler {0xFF} and
+ * new answer filler <PDS_NOT_COMPLETED, 0, 0>. Writes 1 byte of answer: 0x1, if value was pushed, 0x0,
+ * if node couldn't be allocated.
+ * Args has the following structure:
+ * <ul>
+ *  <li>
+ *      8 bytes of offset of descriptor of the stack
+ *  </li>
+ *  <li>
+ *      4 bytes of value
+ *  </li>
+ * </ul>
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void treiber_push(const uint8_t* args);
+
+/**
+ * Recover version of treiber_push. Receives the same arguments, as treiber_push.
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void treiber_push_recover(const uint8_t* args);
+
+/**
+ * Pop, that can be called by the system runtime using do_call. Must be called with answer filler {0xFF} and
+ * new answer filler <PDS_NOT_COMPLETED, 0, 0>. Writes 8 bytes of answer <0x1, 0, value>, if value was popped,
+ * or 1 byte of answer 0x0, if the stack was empty.
+ * Args contain 8 bytes of offset of descriptor of the stack.
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void treiber_pop(const uint8_t* args);
+
+/**
+ * Recover version of treiber_pop. Receives the same arguments, as treiber_pop.
+ * @param args - arguments of function, marshalled to byte array.
+ */
+void treiber_pop_recover(const uint8_t* args);
+
+#endif //DIPLOM_TREIBER_STACK_H
@@ -4,6 +4,7 @@
 #include <cstring>
 #include <limits>
 #include "code/common/pmem_utils.h"
+#include "code/common/crash_injection.h"
 #include "code/storage/global_storage.h"
 #include "code/storage/global_non_owning_storage.h"
 #include "code/storage/thread_local_owning_storage.h"
@@ -16,42 +17,264 @@
 #include "code/frame/stack_frame.h"
 #include <thread>
 #include <functional>
-#include "code/blocking_queue/blocking_queue.h"
 #include "code/model/total_thread_count_holder.h"
 #include "code/model/cur_thread_id_holder.h"
 #include "code/model/tasks.h"
 #include "code/allocation/pmem_allocator.h"
+#include "code/allocation/root_directory.h"
+#include "code/allocation/heap_collector.h"
 #include "code/model/function_address_holder.h"
 #include "code/runtime/exec_task.h"
 #include "code/runtime/restoration.h"
+#include "code/runtime/parallel_restoration.h"
 #include "code/runtime/call.h"
-#include <variant>
-#include "code/common/variant_utils.h"
+#include "code/model/heap_layout.h"
+#include "code/model/load_config.h"
+#include "code/load/load_generator.h"
+#include "code/metrics/runtime_metrics.h"
+#include "code/metrics/metrics_export.h"
+#include "code/metrics/flush_profiler.h"
+#include "code/structures/node_pool.h"
+#include "code/structures/epoch_manager.h"
+#include "code/structures/structures_common.h"
+#include <algorithm>
+#include <chrono>
+#include <unordered_set>
+
+/**
+ * Prints throughput and latency of tasks of a single type in fixed format, so it can be
+ * compared across builds.
+ * @param type_name - name of the task type.
+ * @param report - throughput and latency of tasks of the type.
+ */
+void print_task_type_report(std::string const& type_name, task_type_report const& report)
+{
+    std::cout << "type=" << type_name
+              << " completed=" << report.completed
+              << " ops_per_sec=" << report.ops_per_second
+              << " p50_us=" << std::chrono::duration<double, std::micro>(report.p50).count()
+              << " p99_us=" << std::chrono::duration<double, std::micro>(report.p99).count()
+              << " p999_us=" << std::chrono::duration<double, std::micro>(report.p999).count()
+              << std::endl;
+}
+
+/**
+ * Runs load, described by load config, using specified persistent and RAM stacks, and prints
+ * the results. Each of the stacks should contain the first frame (frame of the main function
+ * of the worker thread) only. System should be running in execution mode.
+ * @param config - parameters of the load.
+ * @param layout - layout of the heap.
+ * @param persistent_stacks - persistent stacks of worker threads.
+ * @param ram_stacks - RAM representations of persistent stacks.
+ * @param heap_holder - persistent heap.
+ * @param allocator - allocator of answer locations.
+ */
+void run_execution(load_config const& config,
+                   heap_layout const& layout,
+                   std::vector<persistent_memory_holder>& persistent_stacks,
+                   std::vector<ram_stack>& ram_stacks,
+                   persistent_memory_holder& heap_holder,
+                   pmem_allocator& allocator)
+{
+    std::cerr << "Starting execution" << std::endl;
+    const load_report report = run_load(config, layout, persistent_stacks, ram_stacks, heap_holder, allocator);
+    print_task_type_report("cas", report.cas);
+    print_task_type_report("read", report.read);
+    std::cout << "successful_cas=" << report.successful_cas
+              << " dropped=" << report.dropped
+              << " elapsed_us=" << std::chrono::duration_cast<std::chrono::microseconds>(report.elapsed).count()
+              << std::endl;
+}
 
-void read_var(uint64_t var_offset)
+/**
+ * Frees answer locations, that have been leaked by the previous run of the system: load generator of the previous
+ * run has been lost together with answer locations of tasks, that it had allocated, therefore the only answer
+ * locations, that are still used, are locations of tasks, that are being executed in frames of the stacks.
+ * Must be called before execution is started.
+ * @param allocator - allocator of answer locations.
+ * @param heap_holder - persistent heap.
+ * @param ram_stacks - RAM representations of persistent stacks of all worker threads.
+ */
+void collect_leaked_answers(pmem_allocator& allocator,
+                            persistent_memory_holder& heap_holder,
+                            std::vector<ram_stack> const& ram_stacks)
 {
-    const uint8_t* pmem_start_address = global_non_owning_storage<persistent_memory_holder>::ptr->get_pmem_ptr();
-    const uint64_t* var = (uint64_t*) (pmem_start_address + var_offset);
-    uint64_t last_thread_number_and_cur_value = __atomic_load_n(var, __ATOMIC_SEQ_CST);
-    const uint8_t* const last_thread_number_and_cur_value_ptr = (const uint8_t*) &last_thread_number_and_cur_value;
-    uint32_t cur_value;
-    std::memcpy(&cur_value, last_thread_number_and_cur_value_ptr + 4, 4);
-    uint32_t cur_thread_id = thread_local_owning_storage<cur_thread_id_holder>::get_const_object().cur_thread_id;
-    std::string msg = "register value = " + std::to_string(cur_value) +
-                      ", cur thread id = " + std::to_string(cur_thread_id) + "\n";
-    std::cerr << msg;
+    std::unordered_set<uint64_t> roots;
+    for (ram_stack const& stack : ram_stacks)
+    {
+        for (uint32_t frame_number = 0; frame_number < stack.size(); frame_number++)
+        {
+            const std::optional<uint64_t> answer_offset =
+                    get_task_answer_offset(stack.get_frame(frame_number).get_frame());
+            if (answer_offset.has_value())
+            {
+                roots.insert(answer_offset.value());
+            }
+        }
+    }
+    heap_collector collector(allocator, heap_holder.get_pmem_ptr(), std::move(roots), true);
+    collector.run(std::max(1u, std::thread::hardware_concurrency()));
+    const heap_collection_report report = collector.get_report();
+    std::cerr << "Heap collection finished: " << report.leaked_offsets.size() << " leaked answer locations freed, "
+              << report.live_blocks << " answer locations are in use" << std::endl;
+    std::cerr << "heap_collection_time_us="
+              << std::chrono::duration_cast<std::chrono::microseconds>(report.duration).count() << std::endl;
+}
+
+/**
+ * Prints runtime metrics, aggregated over all threads, to stdout.
+ * @param metrics_format - either json or prometheus. If empty, nothing is printed.
+ */
+void print_metrics(std::string const& metrics_format)
+{
+    if (metrics_format == "json")
+    {
+        std::cout << metrics_to_json(collect_metrics()) << std::endl;
+    }
+    else if (metrics_format == "prometheus")
+    {
+        std::cout << metrics_to_prometheus(collect_metrics());
+    }
+}
+
+/**
+ * Prints summary of persistence traffic by flush sites to stderr, if FLUSH_PROFILING is defined.
+ */
+void print_flush_profile()
+{
+#ifdef FLUSH_PROFILING
+    std::cerr << "Flush profile:" << std::endl << format_flush_profile(get_flush_profile());
+#endif
+}
+
+/**
+ * Parses optional arguments of the form --name=value.
+ * @param argc - number of arguments.
+ * @param argv - arguments. Optional arguments start from the first_option-th argument.
+ * @param first_option - index of the first optional argument.
+ * @param config - load config, that is filled with parsed values.
+ * @param number_of_vars - number of RMW registers, that is filled with parsed value.
+ * @param metrics_format - format of runtime metrics, that are printed before exit (json or prometheus),
+ *                         is filled with parsed value.
+ * @throws std::runtime_error - if some of the arguments is unknown or has invalid value.
+ */
+void parse_options(int argc,
+                   char** argv,
+                   int first_option,
+                   load_config& config,
+                   uint32_t& number_of_vars,
+                   std::string& metrics_format)
+{
+    for (int i = first_option; i < argc; i++)
+    {
+        const std::string option = argv[i];
+        const size_t separator = option.find('=');
+        if (option.rfind("--", 0) != 0 || separator == std::string::npos)
+        {
+            throw std::runtime_error("Option must have form --name=value: " + option);
+        }
+        const std::string name = option.substr(2, separator - 2);
+        const std::string value = option.substr(separator + 1);
+        if (name == "duration_s")
+        {
+            config.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::duration<double>(std::stod(value))
+            );
+        }
+        else if (name == "rate")
+        {
+            config.arrival_rate = std::stod(value);
+        }
+        else if (name == "cas_ratio")
+        {
+            config.cas_ratio = std::stod(value);
+        }
+        else if (name == "zipf")
+        {
+            config.zipf_exponent = std::stod(value);
+        }
+        else if (name == "numa")
+        {
+            if (value == "1")
+            {
+                config.topology = numa_topology::detect();
+            }
+            else if (value != "0")
+            {
+                throw std::runtime_error("numa must be either 0 or 1");
+            }
+        }
+        else if (name == "group_commit_us")
+        {
+            config.group_commit_interval = std::chrono::microseconds(std::stoull(value));
+        }
+        else if (name == "seed")
+        {
+            config.seed = std::stoull(value);
+        }
+        else if (name == "vars")
+        {
+            number_of_vars = std::stoul(value);
+        }
+        else if (name == "flush")
+        {
+            if (value == "msync")
+            {
+                set_flush_backend(flush_backend::MSYNC);
+            }
+            else if (value == "persist")
+            {
+                set_flush_backend(flush_backend::PERSIST);
+            }
+            else if (value == "none")
+            {
+                set_flush_backend(flush_backend::NONE);
+            }
+            else
+            {
+                throw std::runtime_error("flush must be either msync, persist or none");
+            }
+        }
+        else if (name == "metrics")
+        {
+#ifndef RUNTIME_METRICS
+            throw std::runtime_error("Runtime is built without RUNTIME_METRICS, metrics cannot be printed");
+#endif
+            if (value != "json" && value != "prometheus")
+            {
+                throw std::runtime_error("metrics must be either json or prometheus");
+            }
+            metrics_format = value;
+        }
+        else
+        {
+            throw std::runtime_error("Unknown option: " + name);
+        }
+    }
 }
 
 int main(int argc, char** argv)
 {
-    if (argc != 6)
+    if (argc < 6)
     {
         std::cerr << "Args: "
                      "<number of threads> "
-                     "<exec/recover> "
+                     "<exec/recover/recover_and_exec> "
                      "<init_heap/recover_heap> "
                      "<path to heap> "
-                     "<path to stacks>" << std::endl;
+                     "<path to stacks> "
+                     "[--duration_s=<seconds>] "
+                     "[--rate=<tasks per second>] "
+                     "[--cas_ratio=<0..1>] "
+                     "[--zipf=<exponent>] "
+                     "[--vars=<number of registers>] "
+                     "[--seed=<seed>] "
+                     "[--flush=<msync/persist/none>] "
+                     "[--group_commit_us=<commit interval, 0 to disable; unacknowledged tasks may have been applied "
+                     "after the crash>] "
+                     "[--numa=<0/1>] "
+                     "[--metrics=<json/prometheus>]" << std::endl;
+        std::cerr << "Number of threads and number of registers must be the same after restart" << std::endl;
         return EXIT_FAILURE;
     }
     uint32_t number_of_threads = std::stoi(argv[1]);
@@ -60,30 +283,55 @@ int main(int argc, char** argv)
     std::string path_to_heap = argv[4];
     std::string path_to_stacks = argv[5];
 
+    load_config config;
+    uint32_t number_of_vars = 1;
+    std::string metrics_format;
+    try
+    {
+        parse_options(argc, argv, 6, config, number_of_vars, metrics_format);
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+#ifdef CRASH_INJECTION
+    /*
+     * Crash injection is armed by the torture harness
+     */
+    arm_crash_injection_from_env();
+#endif
 
     /*
      * Write total number of threads
      */
-    global_storage<total_thread_count_holder>::set_object(total_thread_count_holder(number_of_threads));
+    global_storage<total_thread_count_holder>::emplace_object(number_of_threads);
 
     /*
      * Init mapping: function name -> (function address, recover function address)
      */
     function_address_holder func_map;
     func_map.funcs["exec_task"] = {exec_task, exec_task_recover};
-    func_map.funcs["cas"] = {cas, cas_recover};
-    global_storage<function_address_holder>::set_object(func_map);
+    /*
+     * Registers cas together with operations of persistent data structures
+     */
+    register_structure_functions(func_map);
+    /*
+     * Volatile functions are called without persistent frames
+     */
+    func_map.volatile_funcs["snapshot_read"] = snapshot_read;
+    global_storage<function_address_holder>::set_object(std::move(func_map));
 
     /*
-     * Get address of RMW register and thread matrix
+     * Get addresses of RMW registers and thread matrices
      */
-    const uint64_t var_offset = get_cache_line_aligned_address(2000);
-    const uint64_t thread_matrix_offset = get_cache_line_aligned_address(3000);
+    const heap_layout layout(number_of_threads, number_of_vars);
 
     bool heap_exists;
     if (allocator_mode == "init_heap")
     {
-        if (execution_mode == "recover")
+        if (execution_mode == "recover" || execution_mode == "recover_and_exec")
         {
             /*
              * If mode is recover, heap should have been inited in previous execution
@@ -110,26 +358,54 @@ int main(int argc, char** argv)
     global_non_owning_storage<persistent_memory_holder>::ptr = &heap_holder;
 
     /*
-     * If heap hasn't been initialized, init thread matrix and RMW register
+     * Write header of new heap or check, that existing heap has been created with the same layout
      */
-    if (!heap_exists)
+    std::optional<root_directory> directory;
+    try
     {
-        uint64_t initial_thread_number_and_initial_value;
-        uint8_t* initial_thread_number_and_initial_value_ptr = (uint8_t*) &initial_thread_number_and_initial_value;
-        uint32_t initial_thread_number = std::numeric_limits<uint32_t>::max();
-        uint32_t initial_value = 42;
-        std::memcpy(initial_thread_number_and_initial_value_ptr, &initial_thread_number, 4);
-        std::memcpy(initial_thread_number_and_initial_value_ptr + 4, &initial_value, 4);
+        directory.emplace(heap_holder.get_pmem_ptr(), layout, !heap_exists);
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    global_non_owning_storage<root_directory>::ptr = &*directory;
 
-        std::memcpy(heap_holder.get_pmem_ptr() + var_offset, &initial_thread_number_and_initial_value, 8);
-        pmem_do_flush(heap_holder.get_pmem_ptr() + var_offset, 8);
+    /*
+     * If heap hasn't been initialized, init RMW registers (thread matrices of new heap are zero-filled)
+     */
+    if (!heap_exists)
+    {
+        init_vars(layout, heap_holder);
     }
 
     /*
      * If heap doesn't exist (heap_exists == false), init new allocator (init_new = true)
      * If heap already exists (heap_exists == true), recover allocator state allocator (init_new = false)
      */
-    pmem_allocator allocator(heap_holder.get_pmem_ptr(), 1, 1000, !heap_exists);
+    pmem_allocator allocator(
+            heap_holder.get_pmem_ptr(),
+            heap_layout::ANSWER_BLOCK_SIZE,
+            layout.get_allocator_max_border(),
+            !heap_exists
+    );
+
+    /*
+     * Pool of nodes of persistent data structures occupies the rest of the heap
+     */
+    node_pool nodes(
+            heap_holder.get_pmem_ptr(),
+            layout.get_nodes_offset(),
+            std::min(layout.get_nodes_max_border(), node_pool::MAX_NODES),
+            !heap_exists
+    );
+    global_non_owning_storage<node_pool>::ptr = &nodes;
+    /*
+     * Nodes, retired before the crash, have already been freed by the pool
+     */
+    epoch_manager reclamation(nodes, number_of_threads);
+    global_non_owning_storage<epoch_manager>::ptr = &reclamation;
 
     if (execution_mode == "exec")
     {
@@ -157,156 +433,18 @@ int main(int argc, char** argv)
         }
 
         /*
-         * All stacks have been initialized
-         */
-        std::cerr << "Starting execution" << std::endl;
-
-        /*
-         * Init queue with tasks
-         */
-        blocking_queue<std::variant<cas_task, read_task>> tasks_queue;
-
-        /*
-         * Init worker threads
-         */
-        std::vector<std::thread> threads;
-        for (uint32_t cur_thread_number = 0; cur_thread_number < number_of_threads; cur_thread_number++)
-        {
-            std::function<void()> main_thread_function = [
-                    cur_thread_number,
-                    &persistent_stacks,
-                    &ram_stacks,
-                    &tasks_queue
-            ]()
-            {
-                thread_local_owning_storage<ram_stack>::set_object(ram_stacks[cur_thread_number]);
-                thread_local_non_owning_storage<persistent_memory_holder>::ptr = &persistent_stacks[cur_thread_number];
-                thread_local_owning_storage<cur_thread_id_holder>::set_object(cur_thread_id_holder(cur_thread_number));
-
-#pragma clang diagnostic push
-#pragma ide diagnostic ignored "EndlessLoop"
-                /*
-                 * Main loop: get task from queue and execute it
-                 */
-                while (true)
-                {
-                    std::variant<cas_task, read_task> cur_task = tasks_queue.take();
-                    std::visit(
-                            make_visitor(
-                                    [](const cas_task& cur_cas_task)
-                                    {
-                                        /*
-                                         * Serialize CAS args
-                                         */
-                                        std::vector<uint8_t> args(33);
-                                        uint64_t cur_offset = 0;
-
-                                        /*
-                                         * Write 1 byte of task type
-                                         */
-                                        std::memcpy(args.data() + cur_offset, &cas_task::CAS_TYPE, 1);
-                                        cur_offset += 1;
-
-                                        /*
-                                         * Write 8 bytes of answer offset
-                                         */
-                                        std::memcpy(args.data() + cur_offset, &cur_cas_task.answer_offset, 8);
-                                        cur_offset += 8;
-
-                                        /*
-                                         * Write 8 bytes of variable offset
-                                         */
-                                        std::memcpy(args.data() + cur_offset, &cur_cas_task.var_offset, 8);
-                                        cur_offset += 8;
-
-                                        /*
-                                         * Write 4 bytes of expected value
-                                         */
-                                        std::memcpy(args.data() + cur_offset, &cur_cas_task.expected_value, 4);
-                                        cur_offset += 4;
-
-                                        /*
-                                         * Write 4 bytes of new value
-                                         */
-                                        std::memcpy(args.data() + cur_offset, &cur_cas_task.new_value, 4);
-                                        cur_offset += 4;
-
-                                        /*
-                                         * Write 8 bytes of thread matrix offset
-                                         */
-                                        std::memcpy(
-                                                args.data() + cur_offset,
-                                                &cur_cas_task.thread_matrix_offset,
-                                                8
-                                        );
-
-                                        /*
-                                         * Wait for CAS completion and continue
-                                         */
-                                        do_call(
-                                                "exec_task",
-                                                args,
-                                                std::optional<std::vector<uint8_t>>(),
-                                                std::make_optional(std::vector<uint8_t>({0xFF}))
-                                        );
-                                    },
-                                    [](const read_task& cur_read_task)
-                                    {
-                                        read_var(cur_read_task.var_offset);
-                                    }
-                            ),
-                            cur_task
-                    );
-                }
-#pragma clang diagnostic pop
-            };
-            threads.emplace_back(main_thread_function);
-        }
-
-        /*
-         * In main thread: add some tasks to worker queue
-         */
-        std::vector<std::variant<cas_task, read_task>> tasks(
-                {
-                        cas_task(var_offset,
-                                 42,
-                                 24,
-                                 allocator.pmem_alloc() - heap_holder.get_pmem_ptr(),
-                                 thread_matrix_offset),
-                        cas_task(var_offset,
-                                 42,
-                                 53,
-                                 allocator.pmem_alloc() - heap_holder.get_pmem_ptr(),
-                                 thread_matrix_offset),
-                        cas_task(var_offset,
-                                 24,
-                                 117,
-                                 allocator.pmem_alloc() - heap_holder.get_pmem_ptr(),
-                                 thread_matrix_offset),
-                        cas_task(var_offset,
-                                 53,
-                                 48,
-                                 allocator.pmem_alloc() - heap_holder.get_pmem_ptr(),
-                                 thread_matrix_offset),
-                        read_task(var_offset),
-                        read_task(var_offset)
-                }
-        );
-        for (const std::variant<cas_task, read_task>& cur_task: tasks)
-        {
-            tasks_queue.push(cur_task);
-        }
-
-
-        /*
-         * Wait for worker threads termination (i.e. wait infinitely)
+         * All stacks have been initialized. If the heap has been used before, stacks of the previous run are lost,
+         * together with all tasks, which answer locations are still allocated.
          */
-        for (std::thread& cur_thread: threads)
+        if (heap_exists)
         {
-            cur_thread.join();
+            collect_leaked_answers(allocator, heap_holder, ram_stacks);
         }
+        run_execution(config, layout, persistent_stacks, ram_stacks, heap_holder, allocator);
+        print_metrics(metrics_format);
+        print_flush_profile();
     }
-    else if (execution_mode == "recover")
+    else if (execution_mode == "recover" || execution_mode == "recover_and_exec")
     {
         global_storage<system_mode>::set_object(system_mode::RECOVERY);
 
@@ -326,32 +464,60 @@ int main(int argc, char** argv)
         std::cerr << "Starting restoration" << std::endl;
 
         /*
-         * Init restoration threads
+         * Restore stacks using bounded pool of restoration threads
          */
-        std::vector<std::thread> threads;
-        for (uint32_t cur_thread_number = 0; cur_thread_number < number_of_threads; cur_thread_number++)
-        {
-            std::function<void()> restoration_thread_function = [cur_thread_number, &persistent_stacks]()
-            {
-                thread_local_non_owning_storage<persistent_memory_holder>::ptr = &persistent_stacks[cur_thread_number];
-                thread_local_owning_storage<cur_thread_id_holder>::set_object(cur_thread_id_holder(cur_thread_number));
-                do_restoration(persistent_stacks[cur_thread_number]);
-            };
-            threads.emplace_back(restoration_thread_function);
-        }
+        const uint32_t number_of_restoration_threads = std::max(
+                1u,
+                std::min(number_of_threads, std::thread::hardware_concurrency())
+        );
+        uint32_t number_of_restored_stacks = 0;
+        std::vector<ram_stack> ram_stacks;
+        restoration_report report = do_parallel_restoration(
+                persistent_stacks,
+                ram_stacks,
+                number_of_restoration_threads,
+                [&number_of_restored_stacks, number_of_threads](stack_restoration_report const& stack_report)
+                {
+                    number_of_restored_stacks++;
+                    std::cerr << "Restored stack " << stack_report.stack_number
+                              << " (" << number_of_restored_stacks << "/" << number_of_threads << "): "
+                              << stack_report.restored_frames << " frames in "
+                              << std::chrono::duration_cast<std::chrono::microseconds>(stack_report.duration).count()
+                              << " us" << std::endl;
+                }
+        );
 
         /*
-         * Wait for worker threads termination (i.e. for the end of restoration)
+         * Total recovery time is printed in fixed format, so it can be tracked across releases
+         */
+        std::cerr << "Restoration finished: "
+                  << report.get_total_restored_frames() << " frames restored" << std::endl;
+        std::cerr << "total_recovery_time_us="
+                  << std::chrono::duration_cast<std::chrono::microseconds>(report.total_duration).count()
+                  << std::endl;
+        /*
+         * Restored tasks have written their answers, but nobody waits for them anymore
          */
-        for (std::thread& cur_thread: threads)
+        collect_leaked_answers(allocator, heap_holder, ram_stacks);
+        if (execution_mode == "recover")
         {
-            cur_thread.join();
+            print_metrics(metrics_format);
+            print_flush_profile();
+            return EXIT_SUCCESS;
         }
-        return EXIT_SUCCESS;
+
+        /*
+         * All stacks have been restored and contain only first frame, so execution can be
+         * continued with the same stacks and heap without restarting the process
+         */
+        global_storage<system_mode>::set_object(system_mode::EXECUTION);
+        run_execution(config, layout, persistent_stacks, ram_stacks, heap_holder, allocator);
+        print_metrics(metrics_format);
+        print_flush_profile();
     }
     else
     {
-        std::cerr << "system mode must be either exec or recover" << std::endl;
+        std::cerr << "system mode must be either exec, recover or recover_and_exec" << std::endl;
         return EXIT_FAILURE;
     }
 
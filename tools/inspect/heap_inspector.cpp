@@ -0,0 +1,171 @@
+#include "heap_inspector.h"
+#include <exception>
+#include <sstream>
+#include "../../code/model/heap_layout.h"
+
+namespace
+{
+    /**
+     * Scans allocation markers of the region from the first block till the heap end.
+     * @param heap_ptr - pointer to the beginning of the heap.
+     * @param region - region, which name, offset, block size and maximal border are set.
+     * @param dump_blocks - if true, allocated blocks are collected.
+     * @param violations - vector, to which violations of the region are added.
+     */
+    void inspect_region(const uint8_t* heap_ptr,
+                        region_inspection& region,
+                        bool dump_blocks,
+                        std::vector<std::string>& violations)
+    {
+        const uint8_t* const region_ptr = heap_ptr + region.offset;
+        for (uint64_t block_num = 0; block_num <= region.max_border; block_num++)
+        {
+            const block_state state = pmem_allocator::read_block_state(region_ptr, region.block_size, block_num);
+            if (state == block_state::INVALID)
+            {
+                violations.push_back(
+                        "Block " + std::to_string(block_num) + " of " + region.name + " region has invalid marker"
+                );
+                return;
+            }
+            /*
+             * Block 0 is never given to user
+             */
+            if (block_num != 0)
+            {
+                if (state == block_state::FREED)
+                {
+                    region.freed_blocks++;
+                }
+                else
+                {
+                    region.allocated_blocks++;
+                    if (state == block_state::RETIRED || state == block_state::RETIRED_HEAP_END)
+                    {
+                        region.retired_blocks++;
+                    }
+                    if (dump_blocks)
+                    {
+                        region.blocks.push_back(inspected_block{
+                                block_num,
+                                region.offset + block_num * (region.block_size + 1),
+                                state
+                        });
+                    }
+                }
+            }
+            if (state == block_state::HEAP_END || state == block_state::RETIRED_HEAP_END)
+            {
+                region.allocation_border = block_num;
+                return;
+            }
+        }
+        violations.push_back("Heap end of " + region.name + " region is not found before the maximal border");
+    }
+
+    std::string get_state_name(block_state state)
+    {
+        switch (state)
+        {
+            case block_state::ALLOCATED:
+                return "allocated";
+            case block_state::RETIRED:
+                return "retired";
+            case block_state::HEAP_END:
+                return "heap_end";
+            case block_state::RETIRED_HEAP_END:
+                return "retired_heap_end";
+            case block_state::FREED:
+                return "freed";
+            default:
+                return "invalid";
+        }
+    }
+}
+
+heap_inspection inspect_heap(const uint8_t* heap_ptr, bool dump_blocks)
+{
+    heap_inspection inspection{};
+    inspection.header = root_directory::read_header(heap_ptr);
+    if (!inspection.header.has_value())
+    {
+        inspection.violations.emplace_back("Heap doesn't contain root directory");
+        return inspection;
+    }
+    /*
+     * Layout cannot be computed, if the header is corrupted
+     */
+    std::optional<heap_layout> layout;
+    try
+    {
+        layout.emplace(inspection.header->number_of_threads, inspection.header->number_of_vars);
+    }
+    catch (std::exception const& e)
+    {
+        inspection.violations.emplace_back(std::string("Heap header is invalid: ") + e.what());
+        return inspection;
+    }
+
+    inspection.regions.push_back(region_inspection{
+            "answers", 0, heap_layout::ANSWER_BLOCK_SIZE, layout->get_allocator_max_border()
+    });
+    inspection.regions.push_back(region_inspection{
+            "root_directory",
+            heap_layout::get_root_directory_offset(),
+            heap_layout::ROOT_ENTRY_BLOCK_SIZE,
+            layout->get_root_directory_max_border()
+    });
+    inspection.regions.push_back(region_inspection{
+            "nodes", layout->get_nodes_offset(), heap_layout::NODE_BLOCK_SIZE, layout->get_nodes_max_border()
+    });
+    for (region_inspection& region : inspection.regions)
+    {
+        inspect_region(heap_ptr, region, dump_blocks, inspection.violations);
+    }
+    if (inspection.regions[0].retired_blocks != 0)
+    {
+        inspection.violations.push_back(
+                std::to_string(inspection.regions[0].retired_blocks) + " answer locations are retired"
+        );
+    }
+    inspection.objects = root_directory::read_objects(heap_ptr, *layout);
+    return inspection;
+}
+
+std::string format_heap_inspection(heap_inspection const& inspection)
+{
+    std::ostringstream out;
+    out << "heap:";
+    if (inspection.header.has_value())
+    {
+        out << " threads=" << inspection.header->number_of_threads
+            << " vars=" << inspection.header->number_of_vars;
+    }
+    out << "\n";
+    for (region_inspection const& region : inspection.regions)
+    {
+        out << "  region " << region.name
+            << " offset=" << region.offset
+            << " block_size=" << region.block_size
+            << " max_border=" << region.max_border
+            << " border=" << (region.allocation_border.has_value() ?
+                              std::to_string(region.allocation_border.value()) : "none")
+            << " allocated=" << region.allocated_blocks
+            << " retired=" << region.retired_blocks
+            << " freed=" << region.freed_blocks << "\n";
+        for (inspected_block const& block : region.blocks)
+        {
+            out << "    block " << block.block_num << " offset=" << block.offset
+                << " " << get_state_name(block.state) << "\n";
+        }
+    }
+    for (named_object const& object : inspection.objects)
+    {
+        out << "  object " << object.name << " offset=" << object.offset << " size=" << object.size << "\n";
+    }
+    for (std::string const& violation : inspection.violations)
+    {
+        out << "  violation: " << violation << "\n";
+    }
+    return out.str();
+}
@@ -0,0 +1,103 @@
+#ifndef DIPLOM_HEAP_INSPECTOR_H
+#define DIPLOM_HEAP_INSPECTOR_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "../../code/allocation/pmem_allocator.h"
+#include "../../code/allocation/root_directory.h"
+
+/**
+ * Allocated (or retired) block of the allocator region.
+ */
+struct inspected_block
+{
+    uint64_t block_num;
+    /**
+     * Offset of the first byte of the block from the beginning of the heap.
+     */
+    uint64_t offset;
+    block_state state;
+};
+
+/**
+ * Statistics of the region of the heap, managed by single pmem_allocator.
+ */
+struct region_inspection
+{
+    std::string name;
+
+    /**
+     * Offset of the region from the beginning of the heap.
+     */
+    uint64_t offset = 0;
+
+    uint32_t block_size = 0;
+
+    uint64_t max_border = 0;
+
+    /**
+     * Number of the block with heap end marker, empty optional if it hasn't been found.
+     */
+    std::optional<uint64_t> allocation_border = std::nullopt;
+
+    /**
+     * Numbers of allocated, retired and freed blocks before the heap end (allocated blocks include retired ones).
+     */
+    uint64_t allocated_blocks = 0;
+    uint64_t retired_blocks = 0;
+    uint64_t freed_blocks = 0;
+
+    /**
+     * Allocated blocks, only if they have been requested.
+     */
+    std::vector<inspected_block> blocks = {};
+};
+
+/**
+ * Result of inspection of the persistent heap.
+ */
+struct heap_inspection
+{
+    /**
+     * Header of the heap, empty optional, if the heap doesn't contain root directory.
+     */
+    std::optional<heap_header> header;
+
+    /**
+     * Regions of the answer allocator, of the root directory and of the node pool.
+     */
+    std::vector<region_inspection> regions;
+
+    /**
+     * Committed objects of the root directory.
+     */
+    std::vector<named_object> objects;
+
+    /**
+     * Descriptions of violated invariants of the heap, empty if the heap is consistent.
+     */
+    std::vector<std::string> violations;
+};
+
+/**
+ * Reads heap header and allocation markers of all allocator regions of the heap (see heap_layout) without modifying
+ * the heap, and validates invariants of the regions: each block before the heap end is allocated, retired or freed,
+ * and the heap end lies not after the maximal allocation border. Answer locations are never retired, therefore
+ * retired blocks of the answer allocator are violations as well.
+ * @param heap_ptr - pointer to the beginning of mapping of the heap (PMEM_HEAP_SIZE bytes).
+ * @param dump_blocks - if true, allocated blocks of each region are collected.
+ * @return statistics of the regions, objects of the root directory and violations.
+ */
+heap_inspection inspect_heap(const uint8_t* heap_ptr, bool dump_blocks);
+
+/**
+ * Formats inspection of the heap: layout parameters from the header, one line per region with it's statistics,
+ * optionally followed by one line per allocated block, named objects and violations.
+ * @param inspection - inspection of the heap.
+ * @return formatted inspection, each line is terminated with line feed.
+ */
+std::string format_heap_inspection(heap_inspection const& inspection);
+
+#endif //DIPLOM_HEAP_INSPECTOR_H
@@ -0,0 +1,284 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <optional>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <cctype>
+#include "heap_inspector.h"
+#include "stack_inspector.h"
+#include "../../code/common/constants_and_types.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+
+/**
+ * Parameters of the inspection.
+ */
+struct inspect_config
+{
+    std::optional<std::string> path_to_heap;
+    /**
+     * Stack files, given one by one or found in stack directories.
+     */
+    std::vector<std::string> stack_paths;
+    uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+    /**
+     * If true, allocated blocks of each region of the heap are printed.
+     */
+    bool dump_blocks = false;
+    /**
+     * If true, only stacks with violations are printed.
+     */
+    bool quiet = false;
+};
+
+/**
+ * Result of inspection of single stack file.
+ */
+struct stack_result
+{
+    std::string output;
+    uint64_t frames = 0;
+    bool violated = false;
+};
+
+/**
+ * Returns stack files of the directory (files named stack_<thread number>, as they are created by the runtime),
+ * ordered by thread number.
+ * @param path_to_stacks - path to the directory.
+ * @return paths to the stack files.
+ */
+std::vector<std::string> find_stacks(std::string const& path_to_stacks)
+{
+    std::vector<std::pair<uint64_t, std::string>> numbered_stacks;
+    const std::string prefix = "stack_";
+    for (std::filesystem::directory_entry const& entry : std::filesystem::directory_iterator(path_to_stacks))
+    {
+        const std::string file_name = entry.path().filename().string();
+        if (!entry.is_regular_file() || file_name.rfind(prefix, 0) != 0 || file_name.size() == prefix.size() ||
+            !std::all_of(file_name.begin() + prefix.size(), file_name.end(), ::isdigit))
+        {
+            continue;
+        }
+        numbered_stacks.emplace_back(std::stoull(file_name.substr(prefix.size())), entry.path().string());
+    }
+    std::sort(numbered_stacks.begin(), numbered_stacks.end());
+    std::vector<std::string> result;
+    for (auto& [number, path] : numbered_stacks)
+    {
+        result.push_back(std::move(path));
+    }
+    return result;
+}
+
+/**
+ * Maps stack file for reading, decodes and validates it.
+ * @param path - path to the stack file.
+ * @return formatted inspection of the stack.
+ */
+stack_result inspect_stack_file(std::string const& path)
+{
+    stack_result result;
+    try
+    {
+        const persistent_memory_holder persistent_stack(path, true, PMEM_STACK_SIZE, true);
+        const stack_inspection inspection = inspect_stack(persistent_stack.get_pmem_ptr());
+        result.output = format_stack_inspection(inspection, path);
+        result.frames = inspection.frames.size();
+        result.violated = !inspection.violations.empty();
+    }
+    catch (std::exception const& e)
+    {
+        result.output = "stack " + path + ": cannot be inspected: " + e.what() + "\n";
+        result.violated = true;
+    }
+    return result;
+}
+
+/**
+ * Inspects stack files using pool of threads: each thread repeatedly takes the next file, that hasn't been
+ * inspected yet.
+ * @param stack_paths - paths to stack files.
+ * @param number_of_threads - maximal number of threads, must be positive.
+ * @return results of inspection in the same order, as paths.
+ */
+std::vector<stack_result> inspect_stack_files(std::vector<std::string> const& stack_paths, uint32_t number_of_threads)
+{
+    std::vector<stack_result> results(stack_paths.size());
+    std::atomic<uint64_t> next_stack(0);
+    const auto inspect_stacks = [&stack_paths, &results, &next_stack]()
+    {
+        while (true)
+        {
+            const uint64_t stack_number = next_stack.fetch_add(1);
+            if (stack_number >= stack_paths.size())
+            {
+                return;
+            }
+            results[stack_number] = inspect_stack_file(stack_paths[stack_number]);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (uint32_t thread_number = 1; thread_number < std::min<uint64_t>(number_of_threads, stack_paths.size());
+         thread_number++)
+    {
+        threads.emplace_back(inspect_stacks);
+    }
+    inspect_stacks();
+    for (std::thread& cur_thread: threads)
+    {
+        cur_thread.join();
+    }
+    return results;
+}
+
+/**
+ * Parses value of boolean option.
+ * @param name - name of the option.
+ * @param value - either 0 or 1.
+ * @return parsed value.
+ * @throws std::runtime_error - if value is neither 0 nor 1.
+ */
+bool parse_flag(std::string const& name, std::string const& value)
+{
+    if (value != "0" && value != "1")
+    {
+        throw std::runtime_error(name + " must be either 0 or 1");
+    }
+    return value == "1";
+}
+
+/**
+ * Parses arguments of the form --name=value.
+ * @param argc - number of arguments.
+ * @param argv - arguments, all of them are optional.
+ * @param config - config, that is filled with parsed values.
+ * @throws std::runtime_error - if some of the arguments is unknown or has invalid value, or there is nothing
+ *                              to inspect.
+ */
+void parse_inspect_options(int argc, char** argv, inspect_config& config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string option = argv[i];
+        const size_t separator = option.find('=');
+        if (option.rfind("--", 0) != 0 || separator == std::string::npos)
+        {
+            throw std::runtime_error("Option must have form --name=value: " + option);
+        }
+        const std::string name = option.substr(2, separator - 2);
+        const std::string value = option.substr(separator + 1);
+        if (name == "heap")
+        {
+            config.path_to_heap = value;
+        }
+        else if (name == "stacks")
+        {
+            for (std::string& path : find_stacks(value))
+            {
+                config.stack_paths.push_back(std::move(path));
+            }
+        }
+        else if (name == "stack")
+        {
+            config.stack_paths.push_back(value);
+        }
+        else if (name == "threads")
+        {
+            config.threads = std::stoul(value);
+        }
+        else if (name == "blocks")
+        {
+            config.dump_blocks = parse_flag(name, value);
+        }
+        else if (name == "quiet")
+        {
+            config.quiet = parse_flag(name, value);
+        }
+        else
+        {
+            throw std::runtime_error("Unknown option: " + name);
+        }
+    }
+    if (config.threads == 0)
+    {
+        throw std::runtime_error("Number of threads must be positive");
+    }
+    if (!config.path_to_heap.has_value() && config.stack_paths.empty())
+    {
+        throw std::runtime_error("Neither heap nor stacks are specified");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    inspect_config config;
+    try
+    {
+        parse_inspect_options(argc, argv, config);
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << "Args: "
+                     "[--heap=<path to heap>] "
+                     "[--stacks=<directory with stack files>] "
+                     "[--stack=<path to stack file>] "
+                     "[--threads=<number of inspection threads>] "
+                     "[--blocks=<0/1, print allocated blocks>] "
+                     "[--quiet=<0/1, print only stacks with violations>]" << std::endl;
+        std::cerr << "Files are opened for reading only, exit code is non-zero, if some invariant is violated"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    uint64_t heap_violations = 0;
+    if (config.path_to_heap.has_value())
+    {
+        try
+        {
+            const persistent_memory_holder heap(config.path_to_heap.value(), true, PMEM_HEAP_SIZE, true);
+            const heap_inspection inspection = inspect_heap(heap.get_pmem_ptr(), config.dump_blocks);
+            heap_violations = inspection.violations.size();
+            if (!config.quiet || heap_violations != 0)
+            {
+                std::cout << format_heap_inspection(inspection);
+            }
+        }
+        catch (std::exception const& e)
+        {
+            std::cout << "heap " << config.path_to_heap.value() << ": cannot be inspected: " << e.what() << std::endl;
+            heap_violations = 1;
+        }
+    }
+
+    uint64_t total_frames = 0;
+    uint64_t violated_stacks = 0;
+    for (stack_result const& result : inspect_stack_files(config.stack_paths, config.threads))
+    {
+        total_frames += result.frames;
+        if (result.violated)
+        {
+            violated_stacks++;
+        }
+        if (!config.quiet || result.violated)
+        {
+            std::cout << result.output;
+        }
+    }
+
+    /*
+     * Summary is printed in fixed format, so it can be parsed by scripts
+     */
+    std::cout << "stacks=" << config.stack_paths.size()
+              << " frames=" << total_frames
+              << " violated_stacks=" << violated_stacks
+              << " heap_violations=" << heap_violations
+              << " inspection_time_us=" << std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - start).count()
+              << std::endl;
+    return violated_stacks == 0 && heap_violations == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,185 @@
+#include "stack_inspector.h"
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+#include <optional>
+#include "../../code/common/constants_and_types.h"
+#include "../../code/common/pmem_utils.h"
+
+namespace
+{
+    /**
+     * Decodes single frame, checking, that all it's fields lie in the frames region of the stack.
+     * @param stack_mem - pointer to the beginning of mapping of the stack.
+     * @param frame_offset - offset of the frame.
+     * @return decoded frame, or empty optional, if the frame crosses the end of the frames region.
+     */
+    std::optional<inspected_frame> decode_frame(const uint8_t* stack_mem, uint64_t frame_offset)
+    {
+        inspected_frame frame{};
+        frame.offset = frame_offset;
+        uint64_t cur_offset = frame_offset;
+        /*
+         * Answer, previous frame offset and function name length
+         */
+        if (cur_offset + 18 > TX_LOG_OFFSET)
+        {
+            return {};
+        }
+        frame.answer = stack_mem + cur_offset;
+        cur_offset += 8;
+        std::memcpy(&frame.previous_frame_offset, stack_mem + cur_offset, 8);
+        cur_offset += 8;
+        uint16_t function_name_len;
+        std::memcpy(&function_name_len, stack_mem + cur_offset, 2);
+        cur_offset += 2;
+        /*
+         * Function name and args length
+         */
+        if (cur_offset + function_name_len + 2 > TX_LOG_OFFSET)
+        {
+            return {};
+        }
+        frame.function_name = std::string_view((const char*) stack_mem + cur_offset, function_name_len);
+        cur_offset += function_name_len;
+        std::memcpy(&frame.args_size, stack_mem + cur_offset, 2);
+        cur_offset += 2;
+        /*
+         * Args and end marker
+         */
+        if (cur_offset + frame.args_size + 1 > TX_LOG_OFFSET)
+        {
+            return {};
+        }
+        frame.args = stack_mem + cur_offset;
+        cur_offset += frame.args_size;
+        frame.end_marker = stack_mem[cur_offset];
+        return frame;
+    }
+
+    /**
+     * Returns offset of the first byte after the frame, from which the next frame starts.
+     */
+    uint64_t get_next_frame_offset(inspected_frame const& frame)
+    {
+        return get_cache_line_aligned_address(
+                frame.offset + 8 + 8 + 2 + frame.function_name.size() + 2 + frame.args_size + 1
+        );
+    }
+
+    void write_hex(std::ostringstream& out, const uint8_t* bytes, uint64_t size)
+    {
+        out << std::hex << std::setfill('0');
+        for (uint64_t i = 0; i < size; i++)
+        {
+            out << std::setw(2) << (uint32_t) bytes[i];
+        }
+        out << std::dec << std::setfill(' ');
+    }
+
+    /**
+     * Checks stack header against decoded frames. Since the header is updated after the end marker, it can describe
+     * the stack before the last operation: either without the last pushed frame, or with the frame, that has
+     * just been removed.
+     */
+    void check_header(stack_inspection& inspection)
+    {
+        if (inspection.header_frame_count == 0)
+        {
+            inspection.notes.emplace_back("Stack header isn't maintained");
+            return;
+        }
+        const uint32_t frame_count = inspection.frames.size();
+        const inspected_frame& top = inspection.frames.back();
+        if (inspection.header_frame_count == frame_count && inspection.header_top_offset == top.offset)
+        {
+            return;
+        }
+        const bool push_not_recorded = frame_count > 1 &&
+                                       inspection.header_frame_count == frame_count - 1 &&
+                                       inspection.header_top_offset == inspection.frames[frame_count - 2].offset;
+        const bool pop_not_recorded = inspection.header_frame_count == frame_count + 1 &&
+                                      inspection.header_top_offset == get_next_frame_offset(top);
+        if (push_not_recorded || pop_not_recorded)
+        {
+            inspection.notes.emplace_back("Stack header is outdated by the last operation");
+            return;
+        }
+        inspection.violations.push_back(
+                "Stack header (" + std::to_string(inspection.header_frame_count) + " frames, last frame at " +
+                std::to_string(inspection.header_top_offset) + ") doesn't describe the stack (" +
+                std::to_string(frame_count) + " frames, last frame at " + std::to_string(top.offset) + ")"
+        );
+    }
+}
+
+stack_inspection inspect_stack(const uint8_t* stack_mem)
+{
+    stack_inspection inspection{};
+    std::memcpy(&inspection.header_frame_count, stack_mem, 4);
+    std::memcpy(&inspection.header_top_offset, stack_mem + 4, 4);
+
+    uint64_t cur_offset = get_cache_line_aligned_address(STACK_HEADER_SIZE);
+    uint64_t expected_previous_offset = NO_PREVIOUS_FRAME;
+    while (true)
+    {
+        const std::optional<inspected_frame> frame = decode_frame(stack_mem, cur_offset);
+        if (!frame.has_value())
+        {
+            inspection.violations.push_back(
+                    "Frame at " + std::to_string(cur_offset) + " crosses the end of the frames region"
+            );
+            break;
+        }
+        inspection.frames.push_back(*frame);
+        if (frame->previous_frame_offset != expected_previous_offset)
+        {
+            inspection.violations.push_back(
+                    "Frame at " + std::to_string(cur_offset) + " is linked with frame at " +
+                    std::to_string(frame->previous_frame_offset) + " instead of " +
+                    std::to_string(expected_previous_offset)
+            );
+        }
+        if (frame->end_marker == STACK_END_MARKER)
+        {
+            check_header(inspection);
+            break;
+        }
+        if (frame->end_marker != FRAME_END_MARKER)
+        {
+            inspection.violations.push_back(
+                    "Frame at " + std::to_string(cur_offset) + " has invalid end marker " +
+                    std::to_string(frame->end_marker)
+            );
+            break;
+        }
+        expected_previous_offset = cur_offset;
+        cur_offset = get_next_frame_offset(*frame);
+    }
+    return inspection;
+}
+
+std::string format_stack_inspection(stack_inspection const& inspection, std::string const& stack_name)
+{
+    std::ostringstream out;
+    out << "stack " << stack_name << ": " << inspection.frames.size() << " frames, header "
+        << inspection.header_frame_count << " frames, last frame at " << inspection.header_top_offset << "\n";
+    for (inspected_frame const& frame : inspection.frames)
+    {
+        out << "  frame offset=" << frame.offset << " function=" << frame.function_name << " args=";
+        write_hex(out, frame.args, frame.args_size);
+        out << " answer=";
+        write_hex(out, frame.answer, 8);
+        out << " end=" << (frame.end_marker == STACK_END_MARKER ? "stack" :
+                           frame.end_marker == FRAME_END_MARKER ? "frame" : "invalid") << "\n";
+    }
+    for (std::string const& note : inspection.notes)
+    {
+        out << "  note: " << note << "\n";
+    }
+    for (std::string const& violation : inspection.violations)
+    {
+        out << "  violation: " << violation << "\n";
+    }
+    return out.str();
+}
@@ -0,0 +1,86 @@
+#ifndef DIPLOM_STACK_INSPECTOR_H
+#define DIPLOM_STACK_INSPECTOR_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Frame of the persistent stack, decoded directly from the memory mapping of the stack.
+ * Function name and args point into the mapping, therefore frame is valid, while the stack is mapped.
+ */
+struct inspected_frame
+{
+    /**
+     * Offset of the frame from the beginning of the stack.
+     */
+    uint64_t offset;
+
+    /**
+     * 8 bytes of the answer slot of the frame.
+     */
+    const uint8_t* answer;
+
+    uint64_t previous_frame_offset;
+
+    std::string_view function_name;
+
+    const uint8_t* args;
+
+    uint16_t args_size;
+
+    uint8_t end_marker;
+};
+
+/**
+ * Result of inspection of single persistent stack.
+ */
+struct stack_inspection
+{
+    /**
+     * Number of frames and offset of the last frame, as they are recorded in the stack header
+     * (number of frames is 0, if the header isn't maintained).
+     */
+    uint32_t header_frame_count;
+    uint32_t header_top_offset;
+
+    /**
+     * Frames of the stack from the first one to the last one (i.e. to the frame, terminated with stack end marker),
+     * or to the first frame, that cannot be decoded.
+     */
+    std::vector<inspected_frame> frames;
+
+    /**
+     * Informational notes, that are not violations (e.g. stack header, outdated by single operation,
+     * which is corrected by read_stack).
+     */
+    std::vector<std::string> notes;
+
+    /**
+     * Descriptions of violated invariants of the stack, empty if the stack is consistent.
+     */
+    std::vector<std::string> violations;
+};
+
+/**
+ * Decodes frames of the persistent stack from the first one, without copying them, and validates invariants
+ * of the stack: each frame lies in the frames region of the stack (before TX_LOG_OFFSET), each frame is terminated
+ * with either frame end marker or stack end marker, each frame is linked with the previous one, and stack header
+ * describes the stack (or is outdated by at most one operation). Decoding is bounded by the frames region,
+ * therefore arbitrary (e.g. corrupted) stack can be inspected.
+ * @param stack_mem - pointer to the beginning of mapping of the persistent stack (PMEM_STACK_SIZE bytes).
+ * @return decoded frames, notes and violations.
+ */
+stack_inspection inspect_stack(const uint8_t* stack_mem);
+
+/**
+ * Formats inspection of the stack: one line per frame with offset, function name, args and answer slot (in hex),
+ * and end marker, followed by notes and violations.
+ * @param inspection - inspection of the stack.
+ * @param stack_name - name of the stack (e.g. path to the file), is printed in the first line.
+ * @return formatted inspection, each line is terminated with line feed.
+ */
+std::string format_stack_inspection(stack_inspection const& inspection, std::string const& stack_name);
+
+#endif //DIPLOM_STACK_INSPECTOR_H
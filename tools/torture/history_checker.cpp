@@ -0,0 +1,118 @@
+#include "history_checker.h"
+#include <cstdio>
+#include <set>
+
+std::optional<cas_record> parse_cas_record(std::string const& line)
+{
+    unsigned long long var_offset;
+    unsigned int expected_value;
+    unsigned int new_value;
+    unsigned int thread_id;
+    int result;
+    const int parsed = std::sscanf(
+            line.c_str(),
+            "CAS: var_offset = %llu, expected_value = %u, new_value = %u, thread id = %u, result = %d",
+            &var_offset, &expected_value, &new_value, &thread_id, &result
+    );
+    if (parsed != 5)
+    {
+        return std::optional<cas_record>();
+    }
+    return cas_record{var_offset, expected_value, new_value, thread_id, result != 0};
+}
+
+std::vector<std::string> check_cas_history(std::vector<cas_record> const& records,
+                                           std::map<uint64_t, uint32_t> const& final_values,
+                                           uint32_t initial_value)
+{
+    std::vector<std::string> violations;
+
+    /*
+     * Each CAS is identified by it's register and it's unique new value
+     */
+    std::map<std::pair<uint64_t, uint32_t>, cas_record> unique_records;
+    for (cas_record const& record : records)
+    {
+        const std::pair<uint64_t, uint32_t> key(record.var_offset, record.new_value);
+        auto it = unique_records.find(key);
+        if (it == unique_records.end())
+        {
+            unique_records.emplace(key, record);
+        }
+        else if (it->second.result != record.result ||
+                 it->second.expected_value != record.expected_value ||
+                 it->second.thread_id != record.thread_id)
+        {
+            violations.push_back(
+                    "CAS to " + std::to_string(record.new_value) + " on register " +
+                    std::to_string(record.var_offset) + " was logged with different results"
+            );
+        }
+    }
+
+    for (auto const& [var_offset, final_value] : final_values)
+    {
+        /*
+         * next_values[x] == y, if successful CAS changed x to y
+         */
+        std::map<uint32_t, uint32_t> next_values;
+        std::set<uint32_t> failed_values;
+        for (auto const& [key, record] : unique_records)
+        {
+            if (key.first != var_offset)
+            {
+                continue;
+            }
+            if (!record.result)
+            {
+                failed_values.insert(record.new_value);
+                continue;
+            }
+            if (!next_values.emplace(record.expected_value, record.new_value).second)
+            {
+                violations.push_back(
+                        "Value " + std::to_string(record.expected_value) + " of register " +
+                        std::to_string(var_offset) + " was changed by several successful CAS operations"
+                );
+            }
+        }
+
+        /*
+         * Follow the chain from the initial value
+         */
+        uint32_t cur_value = initial_value;
+        uint64_t chain_length = 0;
+        std::set<uint32_t> installed_values({initial_value});
+        while (next_values.count(cur_value) == 1 && chain_length < next_values.size())
+        {
+            cur_value = next_values.at(cur_value);
+            installed_values.insert(cur_value);
+            chain_length++;
+        }
+        if (chain_length != next_values.size())
+        {
+            violations.push_back(
+                    "Successful CAS operations on register " + std::to_string(var_offset) +
+                    " don't form a single chain from the initial value"
+            );
+        }
+        if (cur_value != final_value)
+        {
+            violations.push_back(
+                    "Register " + std::to_string(var_offset) + " contains " + std::to_string(final_value) +
+                    ", but the last successful CAS installed " + std::to_string(cur_value)
+            );
+        }
+        for (uint32_t failed_value : failed_values)
+        {
+            if (installed_values.count(failed_value) == 1 || failed_value == final_value)
+            {
+                violations.push_back(
+                        "CAS to " + std::to_string(failed_value) + " on register " + std::to_string(var_offset) +
+                        " reported failure, but it's value was installed"
+                );
+            }
+        }
+    }
+    return violations;
+}
@@ -0,0 +1,54 @@
+#ifndef DIPLOM_HISTORY_CHECKER_H
+#define DIPLOM_HISTORY_CHECKER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <optional>
+
+/**
+ * Single completed CAS, as it is logged by the runtime (when CAS_TEST is defined).
+ */
+struct cas_record
+{
+    uint64_t var_offset;
+    uint32_t expected_value;
+    uint32_t new_value;
+    uint32_t thread_id;
+    bool result;
+};
+
+/**
+ * Parses line of the runtime log.
+ * @param line - line of the log.
+ * @return CAS record, if the line describes completed CAS, empty optional otherwise.
+ */
+std::optional<cas_record> parse_cas_record(std::string const& line);
+
+/**
+ * Checks, that history of CAS operations on RMW registers is linearizable. All new values of CAS operations
+ * must be unique. The same CAS can be logged several times (for example, before the crash and after the recovery),
+ * but it must have the same result each time. For each register checks, that:
+ * <ul>
+ *  <li>
+ *      Successful CAS operations form a single chain of values from the initial value to the final value
+ *      of the register, i.e. each value was changed by at most one successful CAS and each successful CAS
+ *      changed the value, that was installed by the previous CAS in the chain.
+ *  </li>
+ *  <li>
+ *      No CAS, that reported failure, has installed it's new value.
+ *  </li>
+ * </ul>
+ * Note, that CAS operations, that haven't been logged (because they were lost by the crash before
+ * they started), must not have changed the registers.
+ * @param records - all logged CAS operations.
+ * @param final_values - final value of each register, by register offset.
+ * @param initial_value - initial value of all registers.
+ * @return descriptions of all found violations, empty vector if history is linearizable.
+ */
+std::vector<std::string> check_cas_history(std::vector<cas_record> const& records,
+                                           std::map<uint64_t, uint32_t> const& final_values,
+                                           uint32_t initial_value);
+
+#endif //DIPLOM_HISTORY_CHECKER_H
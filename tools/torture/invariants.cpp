@@ -0,0 +1,87 @@
+#include "invariants.h"
+#include <cstring>
+#include <limits>
+#include <exception>
+#include "../../code/persistent_stack/persistent_stack.h"
+#include "../../code/allocation/pmem_allocator.h"
+
+std::vector<std::string> check_restored_stack(persistent_memory_holder const& persistent_stack,
+                                              uint32_t stack_number)
+{
+    const std::string stack_name = "Stack " + std::to_string(stack_number);
+    try
+    {
+        const ram_stack stack = read_stack(persistent_stack);
+        if (stack.size() != 1)
+        {
+            return {stack_name + " contains " + std::to_string(stack.size()) + " frames after the recovery"};
+        }
+        if (stack.get_last_frame().get_frame().get_function_name() != "main_function")
+        {
+            return {stack_name + " doesn't start with the frame of the main function"};
+        }
+    }
+    catch (std::exception const& e)
+    {
+        return {stack_name + " cannot be read: " + e.what()};
+    }
+    return {};
+}
+
+std::vector<std::string> check_allocator_region(persistent_memory_holder const& heap, heap_layout const& layout)
+{
+    const uint8_t* const heap_ptr = heap.get_pmem_ptr();
+    for (uint64_t cur_block_num = 0; cur_block_num <= layout.get_allocator_max_border(); cur_block_num++)
+    {
+        const block_state state = pmem_allocator::read_block_state(
+                heap_ptr,
+                heap_layout::ANSWER_BLOCK_SIZE,
+                cur_block_num
+        );
+        /*
+         * Answer locations are freed immediately and are never retired
+         */
+        if (state == block_state::RETIRED || state == block_state::RETIRED_HEAP_END)
+        {
+            return {"Block " + std::to_string(cur_block_num) + " is retired"};
+        }
+        if (state == block_state::HEAP_END)
+        {
+            return {};
+        }
+        if (state == block_state::INVALID)
+        {
+            return {"Block " + std::to_string(cur_block_num) + " has invalid allocation marker"};
+        }
+    }
+    return {"Heap end is not found before the maximal allocation border"};
+}
+
+std::vector<std::string> check_registers(persistent_memory_holder const& heap,
+                                         heap_layout const& layout,
+                                         uint32_t number_of_threads,
+                                         std::map<uint64_t, uint32_t>& values)
+{
+    std::vector<std::string> violations;
+    const uint8_t* const heap_ptr = heap.get_pmem_ptr();
+    for (uint32_t i = 0; i < layout.get_number_of_vars(); i++)
+    {
+        const uint64_t var_offset = layout.get_var_offset(i);
+        /*
+         * 4 bytes of thread id and 4 bytes of value
+         */
+        uint32_t last_thread_number;
+        uint32_t cur_value;
+        std::memcpy(&last_thread_number, heap_ptr + var_offset, 4);
+        std::memcpy(&cur_value, heap_ptr + var_offset + 4, 4);
+        if (last_thread_number >= number_of_threads && last_thread_number != std::numeric_limits<uint32_t>::max())
+        {
+            violations.push_back(
+                    "Register " + std::to_string(var_offset) + " contains invalid thread id " +
+                    std::to_string(last_thread_number)
+            );
+        }
+        values[var_offset] = cur_value;
+    }
+    return violations;
+}
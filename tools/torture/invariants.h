@@ -0,0 +1,45 @@
+#ifndef DIPLOM_INVARIANTS_H
+#define DIPLOM_INVARIANTS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+#include "../../code/model/heap_layout.h"
+
+/**
+ * Checks, that persistent stack is completely restored, i.e. it contains the first frame
+ * (frame of the main function of the worker thread) only.
+ * @param persistent_stack - persistent stack after the recovery.
+ * @param stack_number - number of the stack, is used in violation descriptions.
+ * @return descriptions of all found violations, empty vector if stack is restored.
+ */
+std::vector<std::string> check_restored_stack(persistent_memory_holder const& persistent_stack,
+                                              uint32_t stack_number);
+
+/**
+ * Checks, that allocator region of the heap is consistent, i.e. each block before the heap end
+ * is marked either as allocated or as freed (answer locations are never retired), and heap end is located before
+ * the maximal allocation border.
+ * @param heap - persistent heap.
+ * @param layout - layout of the heap.
+ * @return descriptions of all found violations, empty vector if allocator region is consistent.
+ */
+std::vector<std::string> check_allocator_region(persistent_memory_holder const& heap, heap_layout const& layout);
+
+/**
+ * Checks, that each RMW register contains id of existing thread or no thread id (if register has never
+ * been changed) and collects values of the registers.
+ * @param heap - persistent heap.
+ * @param layout - layout of the heap.
+ * @param number_of_threads - number of worker threads.
+ * @param values - filled with values of the registers, by register offset.
+ * @return descriptions of all found violations, empty vector if registers are consistent.
+ */
+std::vector<std::string> check_registers(persistent_memory_holder const& heap,
+                                         heap_layout const& layout,
+                                         uint32_t number_of_threads,
+                                         std::map<uint64_t, uint32_t>& values);
+
+#endif //DIPLOM_INVARIANTS_H
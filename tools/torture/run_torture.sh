@@ -0,0 +1,12 @@
+#!/bin/bash
+# Builds the runtime with CAS logging and crash injection (without CAS delays) and runs the torture harness.
+# Usage: run_torture.sh <build dir> <work dir> [additional harness flags]
+# Example: run_torture.sh /tmp/torture_build /tmp/torture_work --iterations=5000 --threads=8
+set -e
+SOURCE_DIR=$(cd "$(dirname "$0")/../.." && pwd)
+BUILD_DIR=$1
+WORK_DIR=$2
+shift 2
+cmake -S "$SOURCE_DIR" -B "$BUILD_DIR" -DCAS_TEST=ON -DCAS_TEST_DELAY=OFF -DCRASH_INJECTION=ON
+cmake --build "$BUILD_DIR" --target Diplom Diplom_torture -j"$(nproc)"
+"$BUILD_DIR/tools/Diplom_torture" "$BUILD_DIR/Diplom" "$WORK_DIR" "$@"
@@ -0,0 +1,476 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <optional>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <cstring>
+#include <csignal>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include "history_checker.h"
+#include "invariants.h"
+#include "../../code/common/constants_and_types.h"
+#include "../../code/model/heap_layout.h"
+#include "../../code/persistent_memory/persistent_memory_holder.h"
+
+/**
+ * Parameters of the torture run.
+ */
+struct torture_config
+{
+    std::string path_to_runtime;
+    std::string work_dir;
+    uint64_t iterations = 1000;
+    uint32_t threads = 4;
+    uint32_t vars = 2;
+    double duration_s = 0.2;
+    double rate = 2000;
+    double cas_ratio = 0.8;
+    /**
+     * Crash countdown of execution run is chosen uniformly from [1, max_crash_after].
+     */
+    uint64_t max_crash_after = 2000;
+    /**
+     * Probability of injecting one more crash into each recovery run.
+     */
+    double recovery_crash_probability = 0.3;
+    /**
+     * Maximal number of recovery runs after single crash of execution run.
+     */
+    uint32_t max_recovery_attempts = 10;
+    uint64_t seed = 42;
+};
+
+/**
+ * Result of single run of the runtime.
+ */
+struct run_result
+{
+    /**
+     * True, if the run was killed by injected crash.
+     */
+    bool crashed;
+    /**
+     * Exit code of the run, if the run wasn't killed.
+     */
+    int exit_code;
+    std::chrono::nanoseconds wall_time;
+};
+
+/**
+ * Runs the runtime in a child process and waits for it's completion.
+ * @param args - arguments of the runtime (without path to the runtime itself).
+ * @param crash_after - crash countdown, that is passed to the runtime, if present.
+ * @param log_path - path to the file, to which stderr of the runtime is appended.
+ * @param config - parameters of the torture run.
+ * @return result of the run.
+ * @throws std::runtime_error - if child process cannot be started.
+ */
+run_result run_runtime(std::vector<std::string> const& args,
+                       std::optional<uint64_t> crash_after,
+                       std::string const& log_path,
+                       torture_config const& config)
+{
+    std::vector<std::string> full_args({config.path_to_runtime});
+    full_args.insert(full_args.end(), args.begin(), args.end());
+    std::vector<char*> argv;
+    for (std::string& arg : full_args)
+    {
+        argv.push_back(arg.data());
+    }
+    argv.push_back(nullptr);
+    const std::string crash_after_value = crash_after.has_value() ? std::to_string(*crash_after) : "";
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const pid_t pid = fork();
+    if (pid == -1)
+    {
+        throw std::runtime_error("Cannot fork: " + std::string(std::strerror(errno)));
+    }
+    if (pid == 0)
+    {
+        /*
+         * Child process: redirect output and start the runtime
+         */
+        const int log_fd = open(log_path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+        const int null_fd = open("/dev/null", O_WRONLY);
+        if (log_fd == -1 || null_fd == -1)
+        {
+            _exit(127);
+        }
+        dup2(log_fd, STDERR_FILENO);
+        dup2(null_fd, STDOUT_FILENO);
+        if (crash_after.has_value())
+        {
+            setenv("DIPLOM_CRASH_AFTER", crash_after_value.c_str(), 1);
+        }
+        else
+        {
+            unsetenv("DIPLOM_CRASH_AFTER");
+        }
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) == -1)
+    {
+        throw std::runtime_error("Cannot wait for the runtime: " + std::string(std::strerror(errno)));
+    }
+    const std::chrono::nanoseconds wall_time = std::chrono::steady_clock::now() - start;
+    if (WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL)
+    {
+        return run_result{true, 0, wall_time};
+    }
+    return run_result{false, WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status), wall_time};
+}
+
+/**
+ * Reads all lines of the file.
+ * @param path - path to the file.
+ * @return lines of the file.
+ */
+std::vector<std::string> read_lines(std::string const& path)
+{
+    std::ifstream input(path);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(input, line))
+    {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+/**
+ * Returns value of the last line of the log of the form prefix + value.
+ * @param lines - lines of the log.
+ * @param prefix - prefix of the line.
+ * @return value, if such line exists, empty optional otherwise.
+ */
+std::optional<std::string> find_last_value(std::vector<std::string> const& lines, std::string const& prefix)
+{
+    for (auto it = lines.rbegin(); it != lines.rend(); ++it)
+    {
+        if (it->rfind(prefix, 0) == 0)
+        {
+            return it->substr(prefix.size());
+        }
+    }
+    return std::optional<std::string>();
+}
+
+/**
+ * Prints mean, median, 99th percentile and maximum of the durations in microseconds.
+ * @param name - name of the measured value.
+ * @param durations - measured durations, in microseconds.
+ */
+void print_duration_stats(std::string const& name, std::vector<uint64_t> durations)
+{
+    if (durations.empty())
+    {
+        std::cout << name << ": no samples" << std::endl;
+        return;
+    }
+    std::sort(durations.begin(), durations.end());
+    uint64_t sum = 0;
+    for (uint64_t duration : durations)
+    {
+        sum += duration;
+    }
+    /*
+     * Nearest-rank percentiles
+     */
+    const uint64_t p50 = durations[(durations.size() - 1) / 2];
+    const uint64_t p99 = durations[(durations.size() * 99 + 99) / 100 - 1];
+    std::cout << name
+              << ": samples=" << durations.size()
+              << " mean_us=" << sum / durations.size()
+              << " p50_us=" << p50
+              << " p99_us=" << p99
+              << " max_us=" << durations.back()
+              << std::endl;
+}
+
+/**
+ * Parses arguments of the form --name=value.
+ * @param argc - number of arguments.
+ * @param argv - arguments. Optional arguments start from the third argument.
+ * @param config - config, that is filled with parsed values.
+ * @throws std::runtime_error - if some of the arguments is unknown.
+ */
+void parse_torture_options(int argc, char** argv, torture_config& config)
+{
+    for (int i = 3; i < argc; i++)
+    {
+        const std::string option = argv[i];
+        const size_t separator = option.find('=');
+        if (option.rfind("--", 0) != 0 || separator == std::string::npos)
+        {
+            throw std::runtime_error("Option must have form --name=value: " + option);
+        }
+        const std::string name = option.substr(2, separator - 2);
+        const std::string value = option.substr(separator + 1);
+        if (name == "iterations")
+        {
+            config.iterations = std::stoull(value);
+        }
+        else if (name == "threads")
+        {
+            config.threads = std::stoul(value);
+        }
+        else if (name == "vars")
+        {
+            config.vars = std::stoul(value);
+        }
+        else if (name == "duration_s")
+        {
+            config.duration_s = std::stod(value);
+        }
+        else if (name == "rate")
+        {
+            config.rate = std::stod(value);
+        }
+        else if (name == "cas_ratio")
+        {
+            config.cas_ratio = std::stod(value);
+        }
+        else if (name == "max_crash_after")
+        {
+            config.max_crash_after = std::stoull(value);
+        }
+        else if (name == "recovery_crash_probability")
+        {
+            config.recovery_crash_probability = std::stod(value);
+        }
+        else if (name == "seed")
+        {
+            config.seed = std::stoull(value);
+        }
+        else
+        {
+            throw std::runtime_error("Unknown option: " + name);
+        }
+    }
+    if (config.threads == 0 || config.vars == 0 || config.max_crash_after == 0)
+    {
+        throw std::runtime_error("Number of threads, number of vars and max crash countdown must be positive");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "Args: "
+                     "<path to runtime, built with CAS_TEST and CRASH_INJECTION> "
+                     "<work dir> "
+                     "[--iterations=<number>] "
+                     "[--threads=<number>] "
+                     "[--vars=<number>] "
+                     "[--duration_s=<seconds>] "
+                     "[--rate=<tasks per second>] "
+                     "[--cas_ratio=<0..1>] "
+                     "[--max_crash_after=<number of crash points>] "
+                     "[--recovery_crash_probability=<0..1>] "
+                     "[--seed=<seed>]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    torture_config config;
+    config.path_to_runtime = argv[1];
+    config.work_dir = argv[2];
+    try
+    {
+        parse_torture_options(argc, argv, config);
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const heap_layout layout(config.threads, config.vars);
+    const std::string path_to_heap = config.work_dir + "/heap";
+    const std::string path_to_stacks = config.work_dir + "/stacks";
+    const std::string log_path = config.work_dir + "/log";
+    const std::vector<std::string> common_options({
+            "--duration_s=" + std::to_string(config.duration_s),
+            "--rate=" + std::to_string(config.rate),
+            "--cas_ratio=" + std::to_string(config.cas_ratio),
+            "--vars=" + std::to_string(config.vars)
+    });
+
+    std::mt19937_64 generator(config.seed);
+    std::uniform_int_distribution<uint64_t> crash_after_distribution(1, config.max_crash_after);
+    std::uniform_real_distribution<double> probability_distribution(0., 1.);
+
+    uint64_t crashed_iterations = 0;
+    uint64_t crashes_during_initialization = 0;
+    uint64_t crashes_during_recovery = 0;
+    uint64_t violated_iterations = 0;
+    std::map<std::string, uint64_t> crashes_by_site;
+    std::vector<uint64_t> recovery_times;
+    std::vector<uint64_t> recovery_wall_times;
+
+    for (uint64_t iteration = 0; iteration < config.iterations; iteration++)
+    {
+        std::filesystem::remove_all(config.work_dir);
+        std::filesystem::create_directories(path_to_stacks);
+
+        std::vector<std::string> exec_args({
+                std::to_string(config.threads), "exec", "init_heap", path_to_heap, path_to_stacks,
+                "--seed=" + std::to_string(iteration)
+        });
+        exec_args.insert(exec_args.end(), common_options.begin(), common_options.end());
+        const run_result exec_result = run_runtime(exec_args, crash_after_distribution(generator), log_path, config);
+
+        std::vector<std::string> violations;
+        if (exec_result.crashed)
+        {
+            const std::vector<std::string> exec_log = read_lines(log_path);
+            crashes_by_site[find_last_value(exec_log, "crash_injection site=").value_or("unknown")]++;
+            if (std::find(exec_log.begin(), exec_log.end(), "Starting execution") == exec_log.end())
+            {
+                /*
+                 * Crash occurred, while persistent stacks were being created. Runtime cannot be recovered
+                 * from such crash, since there is nothing to recover
+                 */
+                crashes_during_initialization++;
+                continue;
+            }
+            crashed_iterations++;
+
+            std::vector<std::string> recover_args({
+                    std::to_string(config.threads), "recover", "recover_heap", path_to_heap, path_to_stacks
+            });
+            recover_args.insert(recover_args.end(), common_options.begin(), common_options.end());
+            bool recovered = false;
+            for (uint32_t attempt = 0; attempt < config.max_recovery_attempts && !recovered; attempt++)
+            {
+                /*
+                 * The last attempt is never crashed, so the recovery always completes
+                 */
+                std::optional<uint64_t> recovery_crash_after;
+                if (attempt + 1 < config.max_recovery_attempts &&
+                    probability_distribution(generator) < config.recovery_crash_probability)
+                {
+                    recovery_crash_after = std::uniform_int_distribution<uint64_t>(1, 20)(generator);
+                }
+                const run_result recover_result = run_runtime(recover_args, recovery_crash_after, log_path, config);
+                if (recover_result.crashed)
+                {
+                    crashes_during_recovery++;
+                    crashes_by_site[
+                            find_last_value(read_lines(log_path), "crash_injection site=").value_or("unknown")
+                    ]++;
+                    continue;
+                }
+                if (recover_result.exit_code != 0)
+                {
+                    violations.push_back("Recovery exited with code " + std::to_string(recover_result.exit_code));
+                    break;
+                }
+                recovered = true;
+                recovery_wall_times.push_back(
+                        std::chrono::duration_cast<std::chrono::microseconds>(recover_result.wall_time).count()
+                );
+                const std::optional<std::string> recovery_time =
+                        find_last_value(read_lines(log_path), "total_recovery_time_us=");
+                if (recovery_time.has_value())
+                {
+                    recovery_times.push_back(std::stoull(*recovery_time));
+                }
+            }
+            if (!recovered && violations.empty())
+            {
+                violations.push_back("Recovery hasn't completed");
+            }
+        }
+        else if (exec_result.exit_code != 0)
+        {
+            violations.push_back("Execution exited with code " + std::to_string(exec_result.exit_code));
+        }
+
+        if (violations.empty())
+        {
+            /*
+             * Check invariants of recovered (or completely executed) system
+             */
+            std::vector<persistent_memory_holder> persistent_stacks;
+            for (uint32_t i = 0; i < config.threads; i++)
+            {
+                persistent_stacks.emplace_back(path_to_stacks + "/stack_" + std::to_string(i), true, PMEM_STACK_SIZE);
+                for (std::string& violation : check_restored_stack(persistent_stacks.back(), i))
+                {
+                    violations.push_back(std::move(violation));
+                }
+            }
+            const persistent_memory_holder heap(path_to_heap, true, PMEM_HEAP_SIZE);
+            for (std::string& violation : check_allocator_region(heap, layout))
+            {
+                violations.push_back(std::move(violation));
+            }
+            std::map<uint64_t, uint32_t> final_values;
+            for (std::string& violation : check_registers(heap, layout, config.threads, final_values))
+            {
+                violations.push_back(std::move(violation));
+            }
+
+            std::vector<cas_record> records;
+            for (std::string const& line : read_lines(log_path))
+            {
+                std::optional<cas_record> record = parse_cas_record(line);
+                if (record.has_value())
+                {
+                    records.push_back(*record);
+                }
+            }
+            /*
+             * Registers are initialized with 42 by the runtime
+             */
+            for (std::string& violation : check_cas_history(records, final_values, 42))
+            {
+                violations.push_back(std::move(violation));
+            }
+        }
+
+        if (!violations.empty())
+        {
+            violated_iterations++;
+            std::cout << "Iteration " << iteration << " failed:" << std::endl;
+            for (std::string const& violation : violations)
+            {
+                std::cout << "    " << violation << std::endl;
+            }
+            /*
+             * Keep the state of the first failed iteration for investigation
+             */
+            if (violated_iterations == 1)
+            {
+                const std::string failed_dir = config.work_dir + "_failed";
+                std::filesystem::remove_all(failed_dir);
+                std::filesystem::copy(config.work_dir, failed_dir, std::filesystem::copy_options::recursive);
+            }
+        }
+    }
+
+    std::cout << "iterations=" << config.iterations
+              << " crashed=" << crashed_iterations
+              << " crashed_during_initialization=" << crashes_during_initialization
+              << " crashed_during_recovery=" << crashes_during_recovery
+              << " failed=" << violated_iterations << std::endl;
+    for (auto const& [site, crashes] : crashes_by_site)
+    {
+        std::cout << "site=" << site << " crashes=" << crashes << std::endl;
+    }
+    print_duration_stats("total_recovery_time", recovery_times);
+    print_duration_stats("recovery_process_wall_time", recovery_wall_times);
+    return violated_iterations == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}